@@ -23,6 +23,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "decorations/decoratedclient.h"
 #include "decorations/decorationpalette.h"
 #include "decorations/decorationbridge.h"
+#include "composite.h"
 #include "cursor.h"
 #include "effects.h"
 #include "focuschain.h"
@@ -824,9 +825,42 @@ QSize AbstractClient::minSize() const
 
 void AbstractClient::updateMoveResize(const QPointF &currentGlobalCursor)
 {
+    // whatever is still queued is older than this position
+    m_moveResize.updatePending = false;
     handleMoveResize(pos(), currentGlobalCursor.toPoint());
 }
 
+void AbstractClient::queueMoveResize(const QPointF &currentGlobalCursor, quint32 time)
+{
+    m_moveResize.predictor.addSample(currentGlobalCursor, time);
+    Compositor *compositor = Compositor::self();
+    if (!compositor || !compositor->isActive()) {
+        updateMoveResize(currentGlobalCursor);
+        return;
+    }
+    m_moveResize.updatePending = true;
+    compositor->scheduleRepaint();
+}
+
+void AbstractClient::applyPendingMoveResize(qint64 presentationDelay)
+{
+    if (!m_moveResize.updatePending) {
+        return;
+    }
+    const QPointF latest = m_moveResize.predictor.latest();
+    if (!isMove() || !options->isMoveResizePrediction()) {
+        updateMoveResize(latest);
+        return;
+    }
+    const QPointF predicted = m_moveResize.predictor.predict(presentationDelay);
+    updateMoveResize(predicted);
+    if (predicted != latest) {
+        // revisit with the next frame, so that the window settles where the pointer stopped
+        m_moveResize.updatePending = true;
+        Compositor::self()->scheduleRepaint();
+    }
+}
+
 bool AbstractClient::hasStrut() const
 {
     return false;
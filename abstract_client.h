@@ -25,6 +25,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "rules.h"
 #include "tabgroup.h"
 #include "cursor.h"
+#include "move_resize_predictor.h"
 
 #include <memory>
 
@@ -563,6 +564,18 @@ public:
     void growVertical();
     void shrinkVertical();
     void updateMoveResize(const QPointF &currentGlobalCursor);
+    /**
+     * Records the pointer position of an interactive move/resize reported at @p time.
+     * While compositing the window follows it only with applyPendingMoveResize() right
+     * before the next frame is painted, otherwise it is updated immediately.
+     **/
+    void queueMoveResize(const QPointF &currentGlobalCursor, quint32 time);
+    /**
+     * Updates the window to the newest pointer position queued since the last frame.
+     * If enabled, a move follows the position the pointer is expected to have when the
+     * frame is shown in @p presentationDelay nanoseconds.
+     **/
+    void applyPendingMoveResize(qint64 presentationDelay);
     /**
      * Ends move resize when all pointer buttons are up again.
      **/
@@ -1196,6 +1209,8 @@ private:
         CursorShape cursor = Qt::ArrowCursor;
         int startScreen = 0;
         QTimer *delayedTimer = nullptr;
+        MoveResizePredictor predictor;
+        bool updatePending = false;
     } m_moveResize;
 
     struct {
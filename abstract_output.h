@@ -83,7 +83,7 @@ public:
     /*
      * Current refresh rate in 1/ms
      */
-    int refreshRate() const;
+    virtual int refreshRate() const;
 
     bool isInternal() const {
         return m_internal;
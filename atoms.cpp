@@ -49,6 +49,7 @@ Atoms::Atoms()
     , kde_net_wm_frame_strut(QByteArrayLiteral("_KDE_NET_WM_FRAME_STRUT"))
     , net_wm_sync_request_counter(QByteArrayLiteral("_NET_WM_SYNC_REQUEST_COUNTER"))
     , net_wm_sync_request(QByteArrayLiteral("_NET_WM_SYNC_REQUEST"))
+    , net_wm_frame_drawn(QByteArrayLiteral("_NET_WM_FRAME_DRAWN"))
     , kde_net_wm_shadow(QByteArrayLiteral("_KDE_NET_WM_SHADOW"))
     , kde_net_wm_tab_group(QByteArrayLiteral("_KDE_NET_WM_TAB_GROUP"))
     , kde_first_in_window_list(QByteArrayLiteral("_KDE_FIRST_IN_WINDOWLIST"))
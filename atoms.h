@@ -58,6 +58,7 @@ public:
     Xcb::Atom kde_net_wm_frame_strut;
     Xcb::Atom net_wm_sync_request_counter;
     Xcb::Atom net_wm_sync_request;
+    Xcb::Atom net_wm_frame_drawn;
     Xcb::Atom kde_net_wm_shadow;
     Xcb::Atom kde_net_wm_tab_group;
     Xcb::Atom kde_first_in_window_list;
@@ -0,0 +1,476 @@
+/********************************************************************
+KWin - the KDE window manager
+This file is part of the KDE project.
+
+Copyright (C) 2019 KWin-lowlatency developers
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "kwin_wayland_test.h"
+#include "abstract_output.h"
+#include "composite.h"
+#include "effect_builtins.h"
+#include "effects.h"
+#include "platform.h"
+#include "screens.h"
+#include "shell_client.h"
+#include "virtualdesktops.h"
+#include "wayland_server.h"
+#include "workspace.h"
+
+#include <KConfigGroup>
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <limits>
+
+#include <linux/input.h>
+#include <time.h>
+
+using namespace KWin;
+
+/*
+ * Drives kwin_wayland on the virtual platform with synthetic clients through a few scripted
+ * scenarios and reports how long the frames took as JSON. Each client is a separate process
+ * running the syntheticclient helper on the Qt Wayland platform, so the buffers go through
+ * shared memory the same way as for real applications. The load is configured with
+ * environment variables:
+ *
+ * KWIN_BENCHMARK_WINDOWS       number of windows, default 10
+ * KWIN_BENCHMARK_CLIENT_RATE   frames per second each window renders, default 60
+ * KWIN_BENCHMARK_DAMAGE        "full" or "partial" damage per client frame, default full
+ * KWIN_BENCHMARK_SUBSURFACES   number of windows with a subsurface, default 2
+ * KWIN_BENCHMARK_POPUPS        number of windows with a popup, default 1
+ * KWIN_BENCHMARK_TRANSLUCENT   number of translucent windows, default 2
+ * KWIN_BENCHMARK_DURATION      milliseconds per scenario, default 2000
+ * KWIN_BENCHMARK_OUTPUT        file the JSON report is written to, default stdout
+ *
+ * The scene is QPainter unless KWIN_COMPOSE says otherwise, use KWIN_COMPOSE=O2 together
+ * with LIBGL_ALWAYS_SOFTWARE=1 for llvmpipe. The display runs at KWIN_VIRTUAL_REFRESH_RATE.
+ */
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_compositor_benchmark-0");
+
+static qint64 monotonicTime()
+{
+    // the clock of the presentation times of the virtual outputs
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static qint64 threadCpuTime()
+{
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return qint64(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+static qint64 processCpuTime()
+{
+    timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return qint64(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+static int configValue(const char *name, int defaultValue)
+{
+    bool ok = false;
+    const int value = qEnvironmentVariableIntValue(name, &ok);
+    return ok ? value : defaultValue;
+}
+
+/**
+ * Measures the frames of the compositor. It goes first in the effect chain, so its
+ * prePaintScreen starts and its postPaintScreen ends the painting of a frame.
+ **/
+class FrameMonitor : public Effect
+{
+    Q_OBJECT
+public:
+    struct Frame {
+        qint64 start;
+        qint64 duration;
+        qint64 cpuTime;
+    };
+
+    int requestedEffectChainPosition() const override {
+        return std::numeric_limits<int>::min();
+    }
+
+    void prePaintScreen(ScreenPrePaintData &data, int time) override {
+        m_start = monotonicTime();
+        m_cpuStart = threadCpuTime();
+        effects->prePaintScreen(data, time);
+    }
+    void postPaintScreen() override {
+        effects->postPaintScreen();
+        if (m_recording) {
+            m_frames << Frame{m_start, monotonicTime() - m_start, threadCpuTime() - m_cpuStart};
+        }
+    }
+
+    void setRecording(bool recording) {
+        m_recording = recording;
+        if (recording) {
+            m_frames.clear();
+        }
+    }
+    const QVector<Frame> &frames() const {
+        return m_frames;
+    }
+
+private:
+    bool m_recording = false;
+    qint64 m_start = 0;
+    qint64 m_cpuStart = 0;
+    QVector<Frame> m_frames;
+};
+
+/**
+ * A client process which renders new content at a fixed rate.
+ **/
+struct SyntheticWindow
+{
+    QProcess *process = nullptr;
+    ShellClient *client = nullptr;
+};
+
+class CompositorBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void benchmarkIdle();
+    void benchmarkMove();
+    void benchmarkAltTab();
+    void benchmarkPresentWindows();
+    void benchmarkDesktopSwitch();
+
+private:
+    bool createWindows();
+    bool loadEffect(BuiltInEffect effect);
+    void runScenario(const QString &name, int stepInterval, const std::function<void(int)> &step);
+
+    QVector<SyntheticWindow> m_windows;
+    FrameMonitor *m_monitor = nullptr;
+    bool m_partialDamage = false;
+    QJsonObject m_scenarios;
+};
+
+void CompositorBenchmark::initTestCase()
+{
+    qRegisterMetaType<KWin::ShellClient*>();
+    qRegisterMetaType<KWin::AbstractClient*>();
+    qRegisterMetaType<KWin::Effect*>();
+    QSignalSpy workspaceCreatedSpy(kwinApp(), &Application::workspaceCreated);
+    QVERIFY(workspaceCreatedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1920, 1080));
+    QVERIFY(waylandServer()->init(s_socketName.toLocal8Bit()));
+
+    // only the effects the scenarios use, they get loaded on demand
+    auto config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    Test::disableAllEffects(config);
+    config->group("TabBox").writeEntry("ShowTabBox", false);
+    config->sync();
+    kwinApp()->setConfig(config);
+
+    if (!qEnvironmentVariableIsSet("KWIN_COMPOSE")) {
+        qputenv("KWIN_COMPOSE", QByteArrayLiteral("Q"));
+    }
+    qputenv("KWIN_EFFECTS_FORCE_ANIMATIONS", QByteArrayLiteral("1"));
+    qputenv("KWIN_XKB_DEFAULT_KEYMAP", QByteArrayLiteral("1"));
+
+    kwinApp()->start();
+    QVERIFY(workspaceCreatedSpy.wait());
+    QVERIFY(Compositor::self());
+    waylandServer()->initWorkspace();
+
+    // frames are shown at simulated vblanks, so missed frames can be counted
+    QVERIFY(QMetaObject::invokeMethod(kwinApp()->platform(), "setPageFlipSimulation", Qt::DirectConnection,
+                                      Q_ARG(bool, true), Q_ARG(int, 0), Q_ARG(int, 0)));
+
+    auto *monitor = new FrameMonitor;
+    QVERIFY(Test::injectEffect(monitor, QStringLiteral("framemonitor")));
+    m_monitor = monitor;
+
+    QVERIFY(createWindows());
+}
+
+void CompositorBenchmark::cleanupTestCase()
+{
+    for (SyntheticWindow &window : m_windows) {
+        window.process->terminate();
+        if (!window.process->waitForFinished()) {
+            window.process->kill();
+            window.process->waitForFinished();
+        }
+        delete window.process;
+        window.process = nullptr;
+    }
+
+    QJsonObject report;
+    report.insert(QStringLiteral("compositor"), QString::fromLocal8Bit(qgetenv("KWIN_COMPOSE")));
+    report.insert(QStringLiteral("refreshRate"), double(screens()->refreshRate(0)));
+    report.insert(QStringLiteral("windows"), m_windows.count());
+    report.insert(QStringLiteral("clientRate"), configValue("KWIN_BENCHMARK_CLIENT_RATE", 60));
+    report.insert(QStringLiteral("damage"), m_partialDamage ? QStringLiteral("partial") : QStringLiteral("full"));
+    report.insert(QStringLiteral("subsurfaces"), configValue("KWIN_BENCHMARK_SUBSURFACES", 2));
+    report.insert(QStringLiteral("popups"), configValue("KWIN_BENCHMARK_POPUPS", 1));
+    report.insert(QStringLiteral("translucent"), configValue("KWIN_BENCHMARK_TRANSLUCENT", 2));
+    report.insert(QStringLiteral("scenarios"), m_scenarios);
+    const QByteArray json = QJsonDocument(report).toJson();
+
+    const QString path = QString::fromLocal8Bit(qgetenv("KWIN_BENCHMARK_OUTPUT"));
+    if (path.isEmpty()) {
+        fputs(json.constData(), stdout);
+    } else {
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        file.write(json);
+    }
+
+}
+
+bool CompositorBenchmark::loadEffect(BuiltInEffect effect)
+{
+    auto *e = static_cast<EffectsHandlerImpl*>(effects);
+    const QString name = BuiltInEffects::nameForEffect(effect);
+    return e->isEffectLoaded(name) || e->loadEffect(name);
+}
+
+bool CompositorBenchmark::createWindows()
+{
+    const QString helper = QFINDTESTDATA(QStringLiteral("syntheticclient"));
+    if (helper.isEmpty()) {
+        return false;
+    }
+    const int count = configValue("KWIN_BENCHMARK_WINDOWS", 10);
+    const int clientRate = qMax(1, configValue("KWIN_BENCHMARK_CLIENT_RATE", 60));
+    const int subSurfaces = configValue("KWIN_BENCHMARK_SUBSURFACES", 2);
+    const int popups = configValue("KWIN_BENCHMARK_POPUPS", 1);
+    const int translucent = configValue("KWIN_BENCHMARK_TRANSLUCENT", 2);
+    m_partialDamage = qgetenv("KWIN_BENCHMARK_DAMAGE") == QByteArrayLiteral("partial");
+
+    QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+    environment.insert(QStringLiteral("QT_QPA_PLATFORM"), QStringLiteral("wayland"));
+    environment.insert(QStringLiteral("QT_WAYLAND_DISABLE_WINDOWDECORATION"), QStringLiteral("1"));
+    environment.insert(QStringLiteral("WAYLAND_DISPLAY"), s_socketName);
+
+    const QRect area = screens()->geometry(0);
+    const QSize size(area.width() / 3, area.height() / 3);
+    for (int i = 0; i < count; ++i) {
+        QStringList arguments{QStringLiteral("--rate"), QString::number(clientRate),
+                              QStringLiteral("--width"), QString::number(size.width()),
+                              QStringLiteral("--height"), QString::number(size.height())};
+        if (m_partialDamage) {
+            arguments << QStringLiteral("--partial");
+        }
+        if (i < translucent) {
+            arguments << QStringLiteral("--translucent");
+        }
+        if (i < subSurfaces) {
+            arguments << QStringLiteral("--child");
+        }
+        const bool hasPopup = i < popups;
+        if (hasPopup) {
+            arguments << QStringLiteral("--popup");
+        }
+
+        QSignalSpy shellClientAddedSpy(waylandServer(), &WaylandServer::shellClientAdded);
+        if (!shellClientAddedSpy.isValid()) {
+            return false;
+        }
+        SyntheticWindow window;
+        window.process = new QProcess();
+        window.process->setProcessEnvironment(environment);
+        window.process->setProcessChannelMode(QProcess::ForwardedChannels);
+        window.process->setProgram(helper);
+        window.process->setArguments(arguments);
+        window.process->start();
+        // added to the list right away, so that cleanupTestCase terminates it
+        m_windows << window;
+        if (!window.process->waitForStarted()) {
+            return false;
+        }
+
+        // the popup is shown after its parent
+        const int expected = hasPopup ? 2 : 1;
+        while (shellClientAddedSpy.count() < expected) {
+            if (!shellClientAddedSpy.wait()) {
+                return false;
+            }
+        }
+        window.client = shellClientAddedSpy.first().first().value<ShellClient*>();
+        if (!window.client || window.client->isPopupWindow()) {
+            return false;
+        }
+        m_windows.last().client = window.client;
+        // cascade them, so they overlap each other
+        window.client->move(area.topLeft() + QPoint(i * 40 % (area.width() - size.width()), i * 30 % (area.height() - size.height())));
+    }
+    return true;
+}
+
+static QJsonObject percentiles(QVector<qint64> values)
+{
+    QJsonObject result;
+    if (values.isEmpty()) {
+        return result;
+    }
+    std::sort(values.begin(), values.end());
+    auto at = [&values] (double percentile) {
+        const int index = qMin(values.count() - 1, int(percentile * values.count()));
+        return values.at(index) / 1000000.0;
+    };
+    qint64 sum = 0;
+    for (qint64 value : qAsConst(values)) {
+        sum += value;
+    }
+    result.insert(QStringLiteral("mean"), sum / 1000000.0 / values.count());
+    result.insert(QStringLiteral("p50"), at(0.5));
+    result.insert(QStringLiteral("p90"), at(0.9));
+    result.insert(QStringLiteral("p99"), at(0.99));
+    result.insert(QStringLiteral("max"), values.last() / 1000000.0);
+    return result;
+}
+
+void CompositorBenchmark::runScenario(const QString &name, int stepInterval, const std::function<void(int)> &step)
+{
+    AbstractOutput *output = kwinApp()->platform()->enabledOutputs().first();
+    QSignalSpy pageFlippedSpy(output, SIGNAL(pageFlipped(quint64,qint64)));
+    QVERIFY(pageFlippedSpy.isValid());
+
+    QTimer stepTimer;
+    int stepCount = 0;
+    stepTimer.setInterval(stepInterval);
+    connect(&stepTimer, &QTimer::timeout, this, [&step, &stepCount] { step(stepCount++); });
+
+    const qint64 processCpuStart = processCpuTime();
+    m_monitor->setRecording(true);
+    stepTimer.start();
+    step(stepCount++);
+    QTest::qWait(configValue("KWIN_BENCHMARK_DURATION", 2000));
+    stepTimer.stop();
+    m_monitor->setRecording(false);
+    const qint64 processCpu = processCpuTime() - processCpuStart;
+
+    const QVector<FrameMonitor::Frame> &frames = m_monitor->frames();
+    QVERIFY(!frames.isEmpty());
+    QVector<qint64> frameTimes;
+    QVector<qint64> cpuTimes;
+    for (const FrameMonitor::Frame &frame : frames) {
+        frameTimes << frame.duration;
+        cpuTimes << frame.cpuTime;
+    }
+
+    // each frame is shown with the next page flip, it is late if that is not the first vblank after it started
+    const qint64 interval = Q_INT64_C(1000000000000) / output->refreshRate();
+    QVector<qint64> presentIntervals;
+    int missedFrames = 0;
+    int frame = 0;
+    for (int i = 1; i < pageFlippedSpy.count(); ++i) {
+        const quint64 previousSequence = pageFlippedSpy.at(i - 1).at(0).value<quint64>();
+        const qint64 previousTime = pageFlippedSpy.at(i - 1).at(1).value<qint64>();
+        const quint64 sequence = pageFlippedSpy.at(i).at(0).value<quint64>();
+        const qint64 time = pageFlippedSpy.at(i).at(1).value<qint64>();
+        presentIntervals << time - previousTime;
+        while (frame < frames.count() && frames.at(frame).start < previousTime) {
+            ++frame;
+        }
+        if (frame < frames.count() && frames.at(frame).start < time) {
+            const quint64 expected = previousSequence + (frames.at(frame).start - previousTime) / interval + 1;
+            if (sequence > expected) {
+                missedFrames += int(sequence - expected);
+            }
+        }
+    }
+
+    QJsonObject result;
+    result.insert(QStringLiteral("frames"), frames.count());
+    result.insert(QStringLiteral("frameTime"), percentiles(frameTimes));
+    result.insert(QStringLiteral("cpuPerFrame"), percentiles(cpuTimes));
+    result.insert(QStringLiteral("processCpuPerFrame"), processCpu / 1000000.0 / frames.count());
+    result.insert(QStringLiteral("presentInterval"), percentiles(presentIntervals));
+    result.insert(QStringLiteral("missedFrames"), missedFrames);
+    m_scenarios.insert(name, result);
+}
+
+void CompositorBenchmark::benchmarkIdle()
+{
+    // only the clients render
+    runScenario(QStringLiteral("idle"), 1000, [] (int) {});
+}
+
+void CompositorBenchmark::benchmarkMove()
+{
+    // the window on top moves in circles, like it is dragged around
+    ShellClient *client = m_windows.last().client;
+    const QPoint origin = client->pos();
+    runScenario(QStringLiteral("move"), 16, [client, origin] (int step) {
+        const qreal angle = step * 0.1;
+        client->move(origin + QPoint(qRound(200 * std::cos(angle)), qRound(200 * std::sin(angle))));
+    });
+    client->move(origin);
+}
+
+void CompositorBenchmark::benchmarkAltTab()
+{
+    // hold Alt and press Tab every few frames
+    quint32 timestamp = 0;
+    kwinApp()->platform()->keyboardKeyPressed(KEY_LEFTALT, timestamp++);
+    runScenario(QStringLiteral("alttab"), 150, [&timestamp] (int) {
+        kwinApp()->platform()->keyboardKeyPressed(KEY_TAB, timestamp++);
+        kwinApp()->platform()->keyboardKeyReleased(KEY_TAB, timestamp++);
+    });
+    kwinApp()->platform()->keyboardKeyReleased(KEY_LEFTALT, timestamp++);
+}
+
+void CompositorBenchmark::benchmarkPresentWindows()
+{
+    // toggle present windows, it animates every window in and out
+    QVERIFY(loadEffect(BuiltInEffect::PresentWindows));
+    Effect *presentWindows = static_cast<EffectsHandlerImpl*>(effects)->findEffect(BuiltInEffects::nameForEffect(BuiltInEffect::PresentWindows));
+    QVERIFY(presentWindows);
+    runScenario(QStringLiteral("presentwindows"), 500, [presentWindows] (int) {
+        QMetaObject::invokeMethod(presentWindows, "toggleActive");
+    });
+    QMetaObject::invokeMethod(presentWindows, "setActive", Q_ARG(bool, false));
+    static_cast<EffectsHandlerImpl*>(effects)->unloadEffect(BuiltInEffects::nameForEffect(BuiltInEffect::PresentWindows));
+}
+
+void CompositorBenchmark::benchmarkDesktopSwitch()
+{
+    // slide between two desktops
+    QVERIFY(loadEffect(BuiltInEffect::Slide));
+    VirtualDesktopManager *manager = VirtualDesktopManager::self();
+    manager->setCount(2);
+    runScenario(QStringLiteral("desktopswitch"), 400, [manager] (int step) {
+        manager->setCurrent(uint(step % 2 + 1));
+    });
+    manager->setCurrent(1);
+    manager->setCount(1);
+    static_cast<EffectsHandlerImpl*>(effects)->unloadEffect(BuiltInEffects::nameForEffect(BuiltInEffect::Slide));
+}
+
+WAYLANDTEST_MAIN(CompositorBenchmark)
+#include "compositor_benchmark.moc"
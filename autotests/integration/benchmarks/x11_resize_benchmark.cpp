@@ -0,0 +1,332 @@
+/********************************************************************
+KWin - the KDE window manager
+This file is part of the KDE project.
+
+Copyright (C) 2019 KWin-lowlatency developers
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include <QByteArray>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSize>
+#include <QVector>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+
+#include <stdio.h>
+
+#include <poll.h>
+
+#include <xcb/xcb.h>
+#include <xcb/sync.h>
+
+/*
+ * Measures how long a resize step of an X11 window takes until the compositor showed it.
+ * It is a client of a running KWin X11 session, e.g. with the GLX backend, not a test.
+ *
+ * The window implements the extended _NET_WM_SYNC_REQUEST protocol. Every step resizes
+ * the window, waits until the window manager configured it, draws the new size and waits
+ * for the _NET_WM_FRAME_DRAWN of that frame. The time from the resize request to the
+ * acknowledgement is reported as JSON. The load is configured with environment variables:
+ *
+ * KWIN_BENCHMARK_STEPS     number of resize steps, default 200
+ * KWIN_BENCHMARK_OUTPUT    file the JSON report is written to, default stdout
+ */
+
+static const int s_timeout = 1000; // ms to wait for the compositor in each step
+
+static qint64 monotonicTime()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static int configValue(const char *name, int defaultValue)
+{
+    bool ok = false;
+    const int value = qEnvironmentVariableIntValue(name, &ok);
+    return ok ? value : defaultValue;
+}
+
+static QJsonObject percentiles(QVector<qint64> values)
+{
+    QJsonObject result;
+    if (values.isEmpty()) {
+        return result;
+    }
+    std::sort(values.begin(), values.end());
+    auto at = [&values] (double percentile) {
+        const int index = qMin(values.count() - 1, int(percentile * values.count()));
+        return values.at(index) / 1000000.0;
+    };
+    qint64 sum = 0;
+    for (qint64 value : qAsConst(values)) {
+        sum += value;
+    }
+    result.insert(QStringLiteral("mean"), sum / 1000000.0 / values.count());
+    result.insert(QStringLiteral("p50"), at(0.5));
+    result.insert(QStringLiteral("p90"), at(0.9));
+    result.insert(QStringLiteral("p99"), at(0.99));
+    result.insert(QStringLiteral("max"), values.last() / 1000000.0);
+    return result;
+}
+
+static xcb_atom_t internAtom(xcb_connection_t *c, const QByteArray &name)
+{
+    xcb_intern_atom_reply_t *reply = xcb_intern_atom_reply(c, xcb_intern_atom(c, false, name.length(), name.constData()), nullptr);
+    if (!reply) {
+        return XCB_ATOM_NONE;
+    }
+    const xcb_atom_t atom = reply->atom;
+    free(reply);
+    return atom;
+}
+
+static xcb_sync_int64_t syncValue(quint64 value)
+{
+    return xcb_sync_int64_t{int32_t(value >> 32), uint32_t(value & 0xffffffff)};
+}
+
+class ResizeBenchmark
+{
+public:
+    ResizeBenchmark();
+    ~ResizeBenchmark();
+
+    bool init();
+    bool step(const QSize &size, qint64 *duration);
+
+private:
+    /**
+     * Handles the events until @p done returns true, @returns false after a timeout.
+     **/
+    bool dispatchUntil(const std::function<bool()> &done);
+    void handleEvent(xcb_generic_event_t *event);
+    void drawFrame();
+
+    xcb_connection_t *m_connection;
+    xcb_window_t m_window = XCB_WINDOW_NONE;
+    xcb_gcontext_t m_gc = XCB_NONE;
+    xcb_sync_counter_t m_basicCounter = XCB_NONE;
+    xcb_sync_counter_t m_extendedCounter = XCB_NONE;
+    xcb_atom_t m_protocols = XCB_ATOM_NONE;
+    xcb_atom_t m_syncRequest = XCB_ATOM_NONE;
+    xcb_atom_t m_frameDrawn = XCB_ATOM_NONE;
+    QSize m_size = QSize(400, 300);
+    bool m_mapped = false;
+    quint64 m_frame = 0;
+    quint64 m_drawnFrame = 0;
+    quint64 m_syncRequestValue = 0;
+    bool m_syncRequestPending = false;
+};
+
+ResizeBenchmark::ResizeBenchmark()
+    : m_connection(xcb_connect(nullptr, nullptr))
+{
+}
+
+ResizeBenchmark::~ResizeBenchmark()
+{
+    if (!xcb_connection_has_error(m_connection)) {
+        if (m_window != XCB_WINDOW_NONE) {
+            xcb_destroy_window(m_connection, m_window);
+        }
+        if (m_basicCounter != XCB_NONE) {
+            xcb_sync_destroy_counter(m_connection, m_basicCounter);
+            xcb_sync_destroy_counter(m_connection, m_extendedCounter);
+        }
+        xcb_flush(m_connection);
+    }
+    xcb_disconnect(m_connection);
+}
+
+bool ResizeBenchmark::init()
+{
+    if (xcb_connection_has_error(m_connection)) {
+        return false;
+    }
+    xcb_sync_initialize_reply_t *sync = xcb_sync_initialize_reply(m_connection,
+        xcb_sync_initialize(m_connection, XCB_SYNC_MAJOR_VERSION, XCB_SYNC_MINOR_VERSION), nullptr);
+    if (!sync) {
+        return false;
+    }
+    free(sync);
+    m_protocols = internAtom(m_connection, QByteArrayLiteral("WM_PROTOCOLS"));
+    m_syncRequest = internAtom(m_connection, QByteArrayLiteral("_NET_WM_SYNC_REQUEST"));
+    m_frameDrawn = internAtom(m_connection, QByteArrayLiteral("_NET_WM_FRAME_DRAWN"));
+    const xcb_atom_t syncRequestCounter = internAtom(m_connection, QByteArrayLiteral("_NET_WM_SYNC_REQUEST_COUNTER"));
+
+    const xcb_screen_t *screen = xcb_setup_roots_iterator(xcb_get_setup(m_connection)).data;
+    m_window = xcb_generate_id(m_connection);
+    const uint32_t values[] = {
+        screen->black_pixel,
+        XCB_EVENT_MASK_STRUCTURE_NOTIFY | XCB_EVENT_MASK_EXPOSURE
+    };
+    xcb_create_window(m_connection, XCB_COPY_FROM_PARENT, m_window, screen->root,
+                      0, 0, m_size.width(), m_size.height(), 0,
+                      XCB_WINDOW_CLASS_INPUT_OUTPUT, XCB_COPY_FROM_PARENT,
+                      XCB_CW_BACK_PIXEL | XCB_CW_EVENT_MASK, values);
+    m_gc = xcb_generate_id(m_connection);
+    xcb_create_gc(m_connection, m_gc, m_window, 0, nullptr);
+
+    m_basicCounter = xcb_generate_id(m_connection);
+    xcb_sync_create_counter(m_connection, m_basicCounter, syncValue(0));
+    m_extendedCounter = xcb_generate_id(m_connection);
+    xcb_sync_create_counter(m_connection, m_extendedCounter, syncValue(0));
+    const xcb_sync_counter_t counters[] = {m_basicCounter, m_extendedCounter};
+    xcb_change_property(m_connection, XCB_PROP_MODE_REPLACE, m_window, syncRequestCounter,
+                        XCB_ATOM_CARDINAL, 32, 2, counters);
+    xcb_change_property(m_connection, XCB_PROP_MODE_REPLACE, m_window, m_protocols,
+                        XCB_ATOM_ATOM, 32, 1, &m_syncRequest);
+
+    xcb_map_window(m_connection, m_window);
+    xcb_flush(m_connection);
+    if (!dispatchUntil([this] { return m_mapped; })) {
+        return false;
+    }
+    // the first frame makes the window shown
+    drawFrame();
+    return dispatchUntil([this] { return m_drawnFrame == m_frame; });
+}
+
+bool ResizeBenchmark::dispatchUntil(const std::function<bool()> &done)
+{
+    const qint64 deadline = monotonicTime() + qint64(s_timeout) * 1000000;
+    while (!done()) {
+        while (xcb_generic_event_t *event = xcb_poll_for_event(m_connection)) {
+            handleEvent(event);
+            free(event);
+        }
+        if (done()) {
+            break;
+        }
+        if (xcb_connection_has_error(m_connection)) {
+            return false;
+        }
+        const qint64 remaining = (deadline - monotonicTime()) / 1000000;
+        if (remaining <= 0) {
+            return false;
+        }
+        pollfd fd = {xcb_get_file_descriptor(m_connection), POLLIN, 0};
+        poll(&fd, 1, int(remaining));
+    }
+    return true;
+}
+
+void ResizeBenchmark::handleEvent(xcb_generic_event_t *event)
+{
+    switch (event->response_type & ~0x80) {
+    case XCB_MAP_NOTIFY:
+        m_mapped = true;
+        break;
+    case XCB_CONFIGURE_NOTIFY: {
+        const auto *configure = reinterpret_cast<xcb_configure_notify_event_t*>(event);
+        m_size = QSize(configure->width, configure->height);
+        if (m_syncRequestPending) {
+            // the configure the window manager asked for is handled
+            xcb_sync_set_counter(m_connection, m_basicCounter, syncValue(m_syncRequestValue));
+            xcb_flush(m_connection);
+            m_syncRequestPending = false;
+        }
+        break;
+    }
+    case XCB_CLIENT_MESSAGE: {
+        const auto *message = reinterpret_cast<xcb_client_message_event_t*>(event);
+        if (message->type == m_frameDrawn) {
+            m_drawnFrame = quint64(message->data.data32[0]) | (quint64(message->data.data32[1]) << 32);
+        } else if (message->type == m_protocols && message->data.data32[0] == m_syncRequest) {
+            m_syncRequestValue = quint64(message->data.data32[2]) | (quint64(message->data.data32[3]) << 32);
+            m_syncRequestPending = true;
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void ResizeBenchmark::drawFrame()
+{
+    // odd while drawing, even once the frame is complete
+    xcb_sync_set_counter(m_connection, m_extendedCounter, syncValue(++m_frame));
+    const uint32_t color = (m_frame * 0x10101) & 0xffffff;
+    xcb_change_gc(m_connection, m_gc, XCB_GC_FOREGROUND, &color);
+    const xcb_rectangle_t rect = {0, 0, uint16_t(m_size.width()), uint16_t(m_size.height())};
+    xcb_poly_fill_rectangle(m_connection, m_window, m_gc, 1, &rect);
+    xcb_sync_set_counter(m_connection, m_extendedCounter, syncValue(++m_frame));
+    xcb_flush(m_connection);
+}
+
+bool ResizeBenchmark::step(const QSize &size, qint64 *duration)
+{
+    const qint64 start = monotonicTime();
+    const uint32_t values[] = {uint32_t(size.width()), uint32_t(size.height())};
+    xcb_configure_window(m_connection, m_window, XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT, values);
+    xcb_flush(m_connection);
+    if (!dispatchUntil([this, size] { return m_size == size; })) {
+        return false;
+    }
+    drawFrame();
+    if (!dispatchUntil([this] { return m_drawnFrame == m_frame; })) {
+        return false;
+    }
+    *duration = monotonicTime() - start;
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    Q_UNUSED(argc)
+    Q_UNUSED(argv)
+    ResizeBenchmark benchmark;
+    if (!benchmark.init()) {
+        qCritical("The window did not get shown, does the window manager support _NET_WM_FRAME_DRAWN?");
+        return 1;
+    }
+
+    // grows and shrinks the window like an interactive resize, a new size in every step
+    QVector<qint64> durations;
+    int timeouts = 0;
+    const int steps = configValue("KWIN_BENCHMARK_STEPS", 200);
+    for (int i = 0; i < steps; ++i) {
+        const int offset = (i % 50 < 25 ? i % 25 : 25 - i % 25) * 16;
+        qint64 duration = 0;
+        if (benchmark.step(QSize(400 + offset, 300 + offset / 2), &duration)) {
+            durations << duration;
+        } else {
+            ++timeouts;
+        }
+    }
+
+    QJsonObject result;
+    result.insert(QStringLiteral("steps"), durations.count());
+    result.insert(QStringLiteral("timeouts"), timeouts);
+    result.insert(QStringLiteral("resizeStep"), percentiles(durations));
+    const QByteArray json = QJsonDocument(result).toJson();
+
+    const QString path = QString::fromLocal8Bit(qgetenv("KWIN_BENCHMARK_OUTPUT"));
+    if (path.isEmpty()) {
+        fputs(json.constData(), stdout);
+    } else {
+        QFile file(path);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            return 1;
+        }
+        file.write(json);
+    }
+    return timeouts == steps ? 1 : 0;
+}
@@ -0,0 +1,290 @@
+/********************************************************************
+KWin - the KDE window manager
+This file is part of the KDE project.
+
+Copyright (C) 2019 KWin-lowlatency developers
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "kwin_wayland_test.h"
+#include "composite.h"
+#include "effectloader.h"
+#include "effects.h"
+#include "platform.h"
+#include "scene.h"
+#include "wayland_server.h"
+#include "effect_builtins.h"
+
+#include "blurshader.h"
+
+#include <kwinglplatform.h>
+#include <kwinglutils.h>
+
+#include <KConfigGroup>
+
+using namespace KWin;
+static const QString s_socketName = QStringLiteral("wayland_test_effects_blur_compute-0");
+static const QSize s_textureSize(512, 512);
+
+class BlurComputeTest : public QObject
+{
+Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testMatchesFragmentShader_data();
+    void testMatchesFragmentShader();
+    void benchmarkBlur_data();
+    void benchmarkBlur();
+
+private:
+    void createTextures(int iterations);
+    void runFragmentShaders(int iterations, float offset);
+    void runComputeShaders(int iterations, float offset);
+    void clearTextures();
+    QImage readResult();
+
+    QScopedPointer<BlurShader> m_shader;
+    QVector<GLTexture> m_textures;
+    QVector<GLRenderTarget*> m_renderTargets;
+};
+
+void BlurComputeTest::initTestCase()
+{
+    qRegisterMetaType<KWin::Effect*>();
+    QSignalSpy workspaceCreatedSpy(kwinApp(), &Application::workspaceCreated);
+    QVERIFY(workspaceCreatedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName.toLocal8Bit()));
+
+    // disable all effects - we don't want to have it interact with the rendering
+    auto config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    KConfigGroup plugins(config, QStringLiteral("Plugins"));
+    ScriptedEffectLoader loader;
+    const auto builtinNames = BuiltInEffects::availableEffectNames() << loader.listOfKnownEffects();
+    for (QString name : builtinNames) {
+        plugins.writeEntry(name + QStringLiteral("Enabled"), false);
+    }
+
+    config->sync();
+    kwinApp()->setConfig(config);
+
+    // llvmpipe provides compute shaders since Mesa 20
+    qputenv("LIBGL_ALWAYS_SOFTWARE", "1");
+    qputenv("KWIN_COMPOSE", QByteArrayLiteral("O2"));
+    kwinApp()->start();
+    QVERIFY(workspaceCreatedSpy.wait());
+    QVERIFY(Compositor::self());
+
+    auto scene = KWin::Compositor::self()->scene();
+    QVERIFY(scene);
+    QCOMPARE(scene->compositingType(), KWin::OpenGL2Compositing);
+}
+
+void BlurComputeTest::init()
+{
+    QVERIFY(effects->makeOpenGLContextCurrent());
+    if (!GLPlatform::instance()->supports(ComputeShaders)) {
+        QSKIP("The OpenGL implementation does not support compute shaders");
+    }
+    m_shader.reset(new BlurShader);
+    QVERIFY(m_shader->isValid());
+    QVERIFY(m_shader->isComputeValid());
+}
+
+void BlurComputeTest::cleanup()
+{
+    qDeleteAll(m_renderTargets);
+    m_renderTargets.clear();
+    m_textures.clear();
+    m_shader.reset();
+    effects->doneOpenGLContextCurrent();
+}
+
+void BlurComputeTest::createTextures(int iterations)
+{
+    // a pattern with hard edges and gradients, which shows every misplaced sample
+    QImage image(s_textureSize, QImage::Format_ARGB32_Premultiplied);
+    for (int y = 0; y < image.height(); ++y) {
+        QRgb *line = reinterpret_cast<QRgb*>(image.scanLine(y));
+        for (int x = 0; x < image.width(); ++x) {
+            const bool checker = ((x / 16) + (y / 16)) % 2;
+            line[x] = qRgb(checker ? 255 : x / 2, (y * 255) / image.height(), (x ^ y) & 0xff);
+        }
+    }
+
+    m_textures << GLTexture(image);
+    for (int i = 1; i <= iterations; ++i) {
+        m_textures << GLTexture(GL_RGBA8, s_textureSize / (1 << i));
+        m_textures.last().setFilter(GL_LINEAR);
+        m_textures.last().setWrapMode(GL_CLAMP_TO_EDGE);
+        m_renderTargets << new GLRenderTarget(m_textures.last());
+        QVERIFY(m_renderTargets.last()->valid());
+    }
+    m_textures.first().setFilter(GL_LINEAR);
+    m_textures.first().setWrapMode(GL_CLAMP_TO_EDGE);
+}
+
+void BlurComputeTest::runFragmentShaders(int iterations, float offset)
+{
+    // one quad covering every texture, uploaded like BlurEffect::uploadRegion does
+    GLVertexBuffer *vbo = GLVertexBuffer::streamingBuffer();
+    QVector2D *map = static_cast<QVector2D*>(vbo->map((iterations + 1) * 6 * sizeof(QVector2D)));
+    for (int i = 0; i <= iterations; ++i) {
+        const QSizeF size = s_textureSize / (1 << i);
+        *(map++) = QVector2D(size.width(), 0);
+        *(map++) = QVector2D(0, 0);
+        *(map++) = QVector2D(0, size.height());
+        *(map++) = QVector2D(0, size.height());
+        *(map++) = QVector2D(size.width(), size.height());
+        *(map++) = QVector2D(size.width(), 0);
+    }
+    vbo->unmap();
+    const GLVertexAttrib layout[] = {
+        { VA_Position, 2, GL_FLOAT, 0 },
+        { VA_TexCoord, 2, GL_FLOAT, 0 }
+    };
+    vbo->setAttribLayout(layout, 2, sizeof(QVector2D));
+    vbo->bindArrays();
+
+    auto pass = [this, vbo, offset] (BlurShader::SampleType type, int source, int target) {
+        QMatrix4x4 projection;
+        projection.ortho(0, m_textures[target].width(), m_textures[target].height(), 0, 0, 65535);
+        GLRenderTarget::pushRenderTarget(m_renderTargets[target - 1]);
+        m_shader->bind(type);
+        m_shader->setModelViewProjectionMatrix(projection);
+        m_shader->setTargetTextureSize(m_textures[target].size());
+        m_shader->setOffset(offset);
+        m_textures[source].bind();
+        vbo->draw(GL_TRIANGLES, 6 * target, 6);
+        m_shader->unbind();
+        GLRenderTarget::popRenderTarget();
+    };
+    for (int i = 1; i <= iterations; ++i) {
+        pass(BlurShader::DownSampleType, i - 1, i);
+    }
+    for (int i = iterations - 1; i >= 1; --i) {
+        pass(BlurShader::UpSampleType, i + 1, i);
+    }
+
+    vbo->unbindArrays();
+}
+
+void BlurComputeTest::runComputeShaders(int iterations, float offset)
+{
+    for (int i = 1; i <= iterations; ++i) {
+        m_shader->compute(BlurShader::DownSampleType, m_textures[i - 1], m_textures[i], {QRect(QPoint(0, 0), m_textures[i].size())}, offset);
+    }
+    for (int i = iterations - 1; i >= 1; --i) {
+        m_shader->compute(BlurShader::UpSampleType, m_textures[i + 1], m_textures[i], {QRect(QPoint(0, 0), m_textures[i].size())}, offset);
+    }
+}
+
+void BlurComputeTest::clearTextures()
+{
+    // the input is opaque, so a transparent sentinel cannot be a blur result
+    glClearColor(1.0, 0.0, 1.0, 0.0);
+    for (GLRenderTarget *renderTarget : qAsConst(m_renderTargets)) {
+        GLRenderTarget::pushRenderTarget(renderTarget);
+        glClear(GL_COLOR_BUFFER_BIT);
+        GLRenderTarget::popRenderTarget();
+    }
+    glClearColor(0.0, 0.0, 0.0, 0.0);
+}
+
+QImage BlurComputeTest::readResult()
+{
+    // the blur result is the first downsampled texture, which gets upscaled onto the screen
+    QImage result(m_textures[1].size(), QImage::Format_RGBA8888);
+    GLRenderTarget::pushRenderTarget(m_renderTargets.first());
+    glReadPixels(0, 0, result.width(), result.height(), GL_RGBA, GL_UNSIGNED_BYTE, result.bits());
+    GLRenderTarget::popRenderTarget();
+    return result;
+}
+
+void BlurComputeTest::testMatchesFragmentShader_data()
+{
+    QTest::addColumn<int>("iterations");
+    QTest::addColumn<float>("offset");
+
+    // the offsets of BlurEffect::initBlurStrengthValues
+    QTest::newRow("1") << 1 << 1.5f;
+    QTest::newRow("2") << 2 << 2.5f;
+    QTest::newRow("3") << 3 << 4.0f;
+    QTest::newRow("4") << 4 << 6.0f;
+}
+
+void BlurComputeTest::testMatchesFragmentShader()
+{
+    QFETCH(int, iterations);
+    QFETCH(float, offset);
+    createTextures(iterations);
+
+    runFragmentShaders(iterations, offset);
+    const QImage expected = readResult();
+    // the compute path must not see anything of the fragment path
+    clearTextures();
+    QVERIFY(readResult() != expected);
+    runComputeShaders(iterations, offset);
+    const QImage result = readResult();
+    QCOMPARE(glGetError(), GLenum(GL_NO_ERROR));
+
+    // every pixel has to be written by the compute shaders
+    for (int y = 0; y < result.height(); ++y) {
+        const uchar *resultLine = result.constScanLine(y);
+        for (int x = 0; x < result.width(); ++x) {
+            QVERIFY2(resultLine[x * 4 + 3] != 0, qPrintable(QStringLiteral("pixel %1,%2 not written").arg(x).arg(y)));
+        }
+    }
+
+    // both paths use the same texture filtering, allow for rounding of the
+    // render target and the image store
+    int maxDifference = 0;
+    for (int y = 0; y < result.height(); ++y) {
+        const uchar *resultLine = result.constScanLine(y);
+        const uchar *expectedLine = expected.constScanLine(y);
+        for (int x = 0; x < result.width() * 4; ++x) {
+            maxDifference = qMax(maxDifference, qAbs(int(resultLine[x]) - int(expectedLine[x])));
+        }
+    }
+    QVERIFY2(maxDifference <= 1, qPrintable(QStringLiteral("maximum difference %1").arg(maxDifference)));
+}
+
+void BlurComputeTest::benchmarkBlur_data()
+{
+    QTest::addColumn<bool>("compute");
+
+    QTest::newRow("fragment") << false;
+    QTest::newRow("compute") << true;
+}
+
+void BlurComputeTest::benchmarkBlur()
+{
+    QFETCH(bool, compute);
+    createTextures(4);
+
+    QBENCHMARK {
+        if (compute) {
+            runComputeShaders(4, 6.0f);
+        } else {
+            runFragmentShaders(4, 6.0f);
+        }
+        glFinish();
+    }
+}
+
+WAYLANDTEST_MAIN(BlurComputeTest)
+#include "blur_compute_test.moc"
@@ -0,0 +1,263 @@
+/********************************************************************
+KWin - the KDE window manager
+This file is part of the KDE project.
+
+Copyright (C) 2019 KWin-lowlatency developers
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "kwin_wayland_test.h"
+#include "composite.h"
+#include "effects.h"
+#include "platform.h"
+#include "shell_client.h"
+#include "wayland_server.h"
+#include "workspace.h"
+
+#include <KWayland/Client/shell.h>
+#include <KWayland/Client/surface.h>
+
+using namespace KWin;
+
+static const QString s_socketName = QStringLiteral("wayland_test_effects_chain-0");
+
+/**
+ * Effect which is interested either in all windows or in the given ones. It counts
+ * the per window methods it is invoked for, and passes them on unless it is the sink
+ * at the end of the chain, which keeps the scene from painting anything.
+ **/
+class ChainEffect : public Effect
+{
+    Q_OBJECT
+public:
+    ChainEffect(int position, bool sink)
+        : m_position(position)
+        , m_sink(sink)
+    {
+    }
+
+    bool isActiveForWindow(const EffectWindow *w) const override {
+        return m_allWindows || m_windows.contains(w);
+    }
+    int requestedEffectChainPosition() const override {
+        return m_position;
+    }
+
+    void prePaintWindow(EffectWindow *w, WindowPrePaintData &data, int time) override {
+        m_calls++;
+        if (!m_sink) {
+            effects->prePaintWindow(w, data, time);
+        }
+    }
+    void paintWindow(EffectWindow *w, int mask, QRegion region, WindowPaintData &data) override {
+        m_calls++;
+        if (!m_sink) {
+            effects->paintWindow(w, mask, region, data);
+        }
+    }
+    void postPaintWindow(EffectWindow *w) override {
+        m_calls++;
+        if (!m_sink) {
+            effects->postPaintWindow(w);
+        }
+    }
+
+    void setWindows(const QVector<const EffectWindow*> &windows) {
+        m_allWindows = false;
+        m_windows = windows;
+    }
+    int calls() const {
+        return m_calls;
+    }
+    void resetCalls() {
+        m_calls = 0;
+    }
+
+private:
+    int m_position;
+    bool m_sink;
+    bool m_allWindows = true;
+    QVector<const EffectWindow*> m_windows;
+    int m_calls = 0;
+};
+
+class EffectChainTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testPruning();
+    void benchmarkChain_data();
+    void benchmarkChain();
+
+private:
+    ChainEffect *loadEffect(int position, bool sink = false);
+    QVector<EffectWindow*> createWindows(int count);
+    void paintWindows(const QVector<EffectWindow*> &windows);
+};
+
+void EffectChainTest::initTestCase()
+{
+    qRegisterMetaType<KWin::ShellClient*>();
+    qRegisterMetaType<KWin::Effect*>();
+    QSignalSpy workspaceCreatedSpy(kwinApp(), &Application::workspaceCreated);
+    QVERIFY(workspaceCreatedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName.toLocal8Bit()));
+
+    // only the effects of the test are in the chain
+    auto config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    Test::disableAllEffects(config);
+    config->sync();
+    kwinApp()->setConfig(config);
+
+    qputenv("KWIN_COMPOSE", QByteArrayLiteral("Q"));
+    kwinApp()->start();
+    QVERIFY(workspaceCreatedSpy.wait());
+    QVERIFY(Compositor::self());
+    waylandServer()->initWorkspace();
+}
+
+void EffectChainTest::init()
+{
+    QVERIFY(Test::setupWaylandConnection());
+}
+
+void EffectChainTest::cleanup()
+{
+    Test::destroyWaylandConnection();
+    auto *e = static_cast<EffectsHandlerImpl*>(effects);
+    while (!e->loadedEffects().isEmpty()) {
+        const QString effect = e->loadedEffects().first();
+        e->unloadEffect(effect);
+        QVERIFY(!e->isEffectLoaded(effect));
+    }
+}
+
+ChainEffect *EffectChainTest::loadEffect(int position, bool sink)
+{
+    auto *effect = new ChainEffect(position, sink);
+    if (!Test::injectEffect(effect, QStringLiteral("chain%1").arg(position))) {
+        return nullptr;
+    }
+    return effect;
+}
+
+QVector<EffectWindow*> EffectChainTest::createWindows(int count)
+{
+    using namespace KWayland::Client;
+    QVector<EffectWindow*> windows;
+    for (int i = 0; i < count; ++i) {
+        Surface *surface = Test::createSurface(Test::waylandCompositor());
+        if (!surface) {
+            break;
+        }
+        ShellSurface *shellSurface = Test::createShellSurface(surface, surface);
+        if (!shellSurface) {
+            break;
+        }
+        ShellClient *client = Test::renderAndWaitForShown(surface, QSize(50, 50), Qt::blue);
+        if (!client) {
+            break;
+        }
+        windows << client->effectWindow();
+    }
+    return windows;
+}
+
+void EffectChainTest::paintWindows(const QVector<EffectWindow*> &windows)
+{
+    // the per window part of a frame, without anything reaching the scene
+    static_cast<EffectsHandlerImpl*>(effects)->startPaint();
+    for (EffectWindow *w : windows) {
+        WindowPrePaintData prePaintData;
+        prePaintData.mask = 0;
+        effects->prePaintWindow(w, prePaintData, 0);
+        WindowPaintData paintData(w);
+        effects->paintWindow(w, 0, infiniteRegion(), paintData);
+        effects->postPaintWindow(w);
+    }
+}
+
+void EffectChainTest::testPruning()
+{
+    const QVector<EffectWindow*> windows = createWindows(3);
+    QCOMPARE(windows.count(), 3);
+
+    ChainEffect *first = loadEffect(10);
+    QVERIFY(first);
+    ChainEffect *idle = loadEffect(20);
+    QVERIFY(idle);
+    ChainEffect *all = loadEffect(30);
+    QVERIFY(all);
+    ChainEffect *sink = loadEffect(100, true);
+    QVERIFY(sink);
+    first->setWindows({windows.at(1)});
+    idle->setWindows({});
+
+    paintWindows(windows);
+    // an effect sees only the windows it is interested in, the chain goes on behind it for the others
+    QCOMPARE(first->calls(), 3);
+    QCOMPARE(idle->calls(), 0);
+    QCOMPARE(all->calls(), 9);
+    QCOMPARE(sink->calls(), 9);
+
+    // the interest is asked for again with the next frame
+    first->resetCalls();
+    idle->resetCalls();
+    idle->setWindows({windows.at(0), windows.at(2)});
+    paintWindows(windows);
+    QCOMPARE(first->calls(), 3);
+    QCOMPARE(idle->calls(), 6);
+
+    // unloading an effect rebuilds the chains without it
+    static_cast<EffectsHandlerImpl*>(effects)->unloadEffect(QStringLiteral("chain10"));
+    sink->resetCalls();
+    paintWindows(windows);
+    QCOMPARE(sink->calls(), 9);
+}
+
+void EffectChainTest::benchmarkChain_data()
+{
+    QTest::addColumn<bool>("pruned");
+
+    QTest::newRow("interested in all windows") << false;
+    QTest::newRow("interested in one window") << true;
+}
+
+void EffectChainTest::benchmarkChain()
+{
+    // 30 effects which are active, but each of them animates a single window at most
+    QFETCH(bool, pruned);
+    const QVector<EffectWindow*> windows = createWindows(200);
+    QCOMPARE(windows.count(), 200);
+    for (int i = 0; i < 30; ++i) {
+        ChainEffect *effect = loadEffect(i + 1);
+        QVERIFY(effect);
+        if (pruned) {
+            effect->setWindows({windows.at(i)});
+        }
+    }
+    QVERIFY(loadEffect(100, true));
+
+    QBENCHMARK {
+        paintWindows(windows);
+    }
+}
+
+WAYLANDTEST_MAIN(EffectChainTest)
+#include "effect_chain_test.moc"
@@ -0,0 +1,145 @@
+/********************************************************************
+KWin - the KDE window manager
+This file is part of the KDE project.
+
+Copyright (C) 2019 KWin-lowlatency developers
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include <QCommandLineParser>
+#include <QGuiApplication>
+#include <QPainter>
+#include <QRasterWindow>
+#include <QTimer>
+
+/**
+ * A window which renders new content at a fixed rate, either all of it or a moving
+ * square. It is used to put a client load on the compositor.
+ **/
+class Window : public QRasterWindow
+{
+    Q_OBJECT
+public:
+    explicit Window(const QColor &color, bool partialDamage, QWindow *parent = nullptr);
+    virtual ~Window();
+
+    void renderFrame();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    QRect changedRect() const;
+
+    QColor m_color;
+    bool m_partialDamage;
+    int m_frame = 0;
+};
+
+Window::Window(const QColor &color, bool partialDamage, QWindow *parent)
+    : QRasterWindow(parent)
+    , m_color(color)
+    , m_partialDamage(partialDamage)
+{
+    if (color.alpha() != 255) {
+        QSurfaceFormat format;
+        format.setAlphaBufferSize(8);
+        setFormat(format);
+    }
+}
+
+Window::~Window() = default;
+
+QRect Window::changedRect() const
+{
+    const int side = qMin(64, qMin(width(), height()));
+    if (!m_partialDamage || side == 0) {
+        return QRect(0, 0, width(), height());
+    }
+    return QRect(m_frame * 8 % qMax(1, width() - side), m_frame * 4 % qMax(1, height() - side), side, side);
+}
+
+void Window::renderFrame()
+{
+    ++m_frame;
+    update(changedRect());
+}
+
+void Window::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event)
+    QPainter p(this);
+    p.setCompositionMode(QPainter::CompositionMode_Source);
+    if (m_frame == 0) {
+        p.fillRect(0, 0, width(), height(), m_color);
+        return;
+    }
+    p.fillRect(changedRect(), QColor::fromHsv(m_frame * 7 % 360, 255, 255, m_color.alpha()));
+}
+
+int main(int argc, char *argv[])
+{
+    QGuiApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    QCommandLineOption rateOption(QStringLiteral("rate"), QStringLiteral("Frames per second"), QStringLiteral("fps"), QStringLiteral("60"));
+    QCommandLineOption widthOption(QStringLiteral("width"), QStringLiteral("Width of the window"), QStringLiteral("width"), QStringLiteral("640"));
+    QCommandLineOption heightOption(QStringLiteral("height"), QStringLiteral("Height of the window"), QStringLiteral("height"), QStringLiteral("360"));
+    QCommandLineOption partialOption(QStringLiteral("partial"), QStringLiteral("Damage only a moving square per frame"));
+    QCommandLineOption translucentOption(QStringLiteral("translucent"), QStringLiteral("Render with half opacity"));
+    QCommandLineOption childOption(QStringLiteral("child"), QStringLiteral("Add a child window, a subsurface on Wayland"));
+    QCommandLineOption popupOption(QStringLiteral("popup"), QStringLiteral("Open a popup"));
+    parser.addOptions({rateOption, widthOption, heightOption, partialOption, translucentOption, childOption, popupOption});
+    parser.process(app);
+
+    const bool partialDamage = parser.isSet(partialOption);
+    const QSize size(parser.value(widthOption).toInt(), parser.value(heightOption).toInt());
+    QScopedPointer<Window> w(new Window(parser.isSet(translucentOption) ? QColor(0, 0, 255, 128) : QColor(Qt::darkGray), partialDamage));
+    w->setGeometry(QRect(QPoint(0, 0), size));
+
+    Window *child = nullptr;
+    if (parser.isSet(childOption)) {
+        child = new Window(Qt::darkGreen, false, w.data());
+        child->setGeometry(QRect(QPoint(size.width() / 4, size.height() / 4), size / 2));
+        child->show();
+    }
+    w->show();
+
+    QScopedPointer<Window> popup;
+    if (parser.isSet(popupOption)) {
+        popup.reset(new Window(Qt::white, false));
+        popup->setFlags(Qt::Popup);
+        popup->setTransientParent(w.data());
+        popup->setGeometry(QRect(QPoint(10, 10), QSize(200, 150)));
+        // the popup needs a mapped parent
+        QTimer::singleShot(0, popup.data(), [&popup] { popup->show(); });
+    }
+
+    QTimer timer;
+    timer.setTimerType(Qt::PreciseTimer);
+    timer.setInterval(1000 / qMax(1, parser.value(rateOption).toInt()));
+    QObject::connect(&timer, &QTimer::timeout, w.data(),
+        [&w, child] {
+            w->renderFrame();
+            if (child) {
+                child->renderFrame();
+            }
+        }
+    );
+    timer.start();
+
+    return app.exec();
+}
+
+#include "syntheticclient.moc"
@@ -22,6 +22,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "../../main.h"
 
+// KDE
+#include <KSharedConfig>
 // Qt
 #include <QtTest>
 
@@ -45,6 +47,7 @@ class ShadowManager;
 class Shell;
 class ShellSurface;
 class ShmPool;
+class SubCompositor;
 class Surface;
 class XdgDecorationManager;
 }
@@ -54,6 +57,7 @@ namespace KWin
 {
 
 class AbstractClient;
+class Effect;
 class ShellClient;
 
 class WaylandTestApplication : public Application
@@ -92,6 +96,7 @@ enum class AdditionalWaylandInterface {
     AppMenu = 1 << 6,
     ShadowManager = 1 << 7,
     XdgDecoration = 1 << 8,
+    SubCompositor = 1 << 9,
 };
 Q_DECLARE_FLAGS(AdditionalWaylandInterfaces, AdditionalWaylandInterface)
 /**
@@ -112,6 +117,7 @@ void destroyWaylandConnection();
 
 KWayland::Client::ConnectionThread *waylandConnection();
 KWayland::Client::Compositor *waylandCompositor();
+KWayland::Client::SubCompositor *waylandSubCompositor();
 KWayland::Client::ShadowManager *waylandShadowManager();
 KWayland::Client::Shell *waylandShell();
 KWayland::Client::ShmPool *waylandShmPool();
@@ -182,6 +188,19 @@ bool lockScreen();
  * @returns @c true if the screen could be unlocked, @c false otherwise
  **/
 bool unlockScreen();
+
+/**
+ * Disables all built-in and scripted effects in the Plugins group of @p config, so
+ * that only the effects a test loads itself are in the effect chain.
+ **/
+void disableAllEffects(const KSharedConfigPtr &config);
+
+/**
+ * Adds @p effect to the effect chain under @p name, bypassing the plugin lookup.
+ * If the effect could not be added it gets deleted.
+ * @returns @c true if the effect got loaded, @c false otherwise
+ **/
+bool injectEffect(Effect *effect, const QString &name);
 }
 
 }
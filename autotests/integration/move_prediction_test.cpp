@@ -0,0 +1,152 @@
+/********************************************************************
+KWin - the KDE window manager
+This file is part of the KDE project.
+
+Copyright (C) 2019 KWin-lowlatency developers
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "kwin_wayland_test.h"
+#include "composite.h"
+#include "cursor.h"
+#include "options.h"
+#include "platform.h"
+#include "shell_client.h"
+#include "wayland_server.h"
+#include "workspace.h"
+
+#include <KWayland/Client/shell.h>
+#include <KWayland/Client/surface.h>
+
+#include <linux/input.h>
+
+using namespace KWin;
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_move_prediction-0");
+
+class MovePredictionTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testCoalesce();
+    void testReleaseFlushes();
+
+private:
+    ShellClient *startMove();
+};
+
+void MovePredictionTest::initTestCase()
+{
+    qRegisterMetaType<KWin::ShellClient*>();
+    qRegisterMetaType<KWin::AbstractClient*>();
+    QSignalSpy workspaceCreatedSpy(kwinApp(), &Application::workspaceCreated);
+    QVERIFY(workspaceCreatedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName.toLocal8Bit()));
+    kwinApp()->setConfig(KSharedConfig::openConfig(QString(), KConfig::SimpleConfig));
+
+    kwinApp()->start();
+    QVERIFY(workspaceCreatedSpy.wait());
+    QVERIFY(Compositor::self());
+    waylandServer()->initWorkspace();
+}
+
+void MovePredictionTest::init()
+{
+    QVERIFY(Test::setupWaylandConnection());
+    options->setMoveResizePrediction(false);
+}
+
+void MovePredictionTest::cleanup()
+{
+    if (AbstractClient *c = workspace()->getMovingClient()) {
+        c->keyPressEvent(Qt::Key_Escape);
+    }
+    Test::destroyWaylandConnection();
+}
+
+ShellClient *MovePredictionTest::startMove()
+{
+    using namespace KWayland::Client;
+    Surface *surface = Test::createSurface(Test::waylandCompositor());
+    if (!surface) {
+        return nullptr;
+    }
+    ShellSurface *shellSurface = Test::createShellSurface(surface, surface);
+    if (!shellSurface) {
+        return nullptr;
+    }
+    ShellClient *client = Test::renderAndWaitForShown(surface, QSize(100, 50), Qt::blue);
+    if (!client) {
+        return nullptr;
+    }
+    client->move(QPoint(300, 300));
+    Cursor::setPos(client->geometry().center());
+    workspace()->slotWindowMove();
+    if (workspace()->getMovingClient() != client) {
+        return nullptr;
+    }
+    return client;
+}
+
+void MovePredictionTest::testCoalesce()
+{
+    // all motion between two frames results in a single move to the newest position
+    ShellClient *c = startMove();
+    QVERIFY(c);
+    QSignalSpy stepSpy(c, &AbstractClient::clientStepUserMovedResized);
+    QVERIFY(stepSpy.isValid());
+
+    const QPoint startPos = c->pos();
+    const QPoint cursorPos = Cursor::pos();
+    quint32 timestamp = 1;
+    for (int i = 1; i <= 5; ++i) {
+        kwinApp()->platform()->pointerMotion(cursorPos + QPoint(i * 2, i), timestamp++);
+    }
+    QCOMPARE(stepSpy.count(), 0);
+    QCOMPARE(c->pos(), startPos);
+
+    QVERIFY(stepSpy.wait());
+    QCOMPARE(stepSpy.count(), 1);
+    QCOMPARE(c->pos(), startPos + QPoint(10, 5));
+
+    c->keyPressEvent(Qt::Key_Enter);
+    QVERIFY(!workspace()->getMovingClient());
+}
+
+void MovePredictionTest::testReleaseFlushes()
+{
+    // ending the move places the window at the last reported position, even before the next frame
+    options->setMoveResizePrediction(true);
+    ShellClient *c = startMove();
+    QVERIFY(c);
+
+    const QPoint startPos = c->pos();
+    const QPoint cursorPos = Cursor::pos();
+    quint32 timestamp = 1;
+    kwinApp()->platform()->pointerMotion(cursorPos + QPoint(5, 0), timestamp);
+    timestamp += 5;
+    kwinApp()->platform()->pointerMotion(cursorPos + QPoint(10, 0), timestamp++);
+    kwinApp()->platform()->pointerButtonPressed(BTN_LEFT, timestamp++);
+    kwinApp()->platform()->pointerButtonReleased(BTN_LEFT, timestamp++);
+    QVERIFY(!workspace()->getMovingClient());
+    QCOMPARE(c->pos(), startPos + QPoint(10, 0));
+}
+
+WAYLANDTEST_MAIN(MovePredictionTest)
+#include "move_prediction_test.moc"
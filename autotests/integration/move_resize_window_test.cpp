@@ -551,6 +551,8 @@ void MoveResizeWindowTest::testClientSideMove()
     const int dragDistance = QApplication::startDragDistance();
     // Why?
     kwinApp()->platform()->pointerMotion(startPoint + QPoint(dragDistance, dragDistance) + QPoint(6, 6), timestamp++);
+    // the window follows the pointer with the next frame
+    QVERIFY(clientMoveStepSpy.wait());
     QCOMPARE(clientMoveStepSpy.count(), 1);
 
     // and release again
@@ -662,6 +664,7 @@ void MoveResizeWindowTest::testNetMove()
 
     // let's move a step
     Cursor::setPos(Cursor::pos() + QPoint(10, 10));
+    QVERIFY(moveStepSpy.wait());
     QCOMPARE(moveStepSpy.count(), 1);
     QCOMPARE(moveStepSpy.first().last().toRect(), origGeo.translated(10, 10));
 
@@ -0,0 +1,159 @@
+/********************************************************************
+KWin - the KDE window manager
+This file is part of the KDE project.
+
+Copyright (C) 2019 KWin-lowlatency developers
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "kwin_wayland_test.h"
+#include "composite.h"
+#include "platform.h"
+#include "shell_client.h"
+#include "wayland_server.h"
+#include "workspace.h"
+
+#include <KWayland/Client/shell.h>
+#include <KWayland/Client/surface.h>
+
+using namespace KWin;
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_occlusion-0");
+
+class OcclusionTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testCovered();
+    void testPartiallyCovered();
+    void testTranslucentCover();
+    void testMinimized();
+
+private:
+    ShellClient *createClient(const QRect &geometry, QImage::Format format = QImage::Format_RGB32);
+};
+
+void OcclusionTest::initTestCase()
+{
+    qRegisterMetaType<KWin::ShellClient*>();
+    QSignalSpy workspaceCreatedSpy(kwinApp(), &Application::workspaceCreated);
+    QVERIFY(workspaceCreatedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName.toLocal8Bit()));
+
+    kwinApp()->setConfig(KSharedConfig::openConfig(QString(), KConfig::SimpleConfig));
+    qputenv("KWIN_COMPOSE", QByteArrayLiteral("Q"));
+
+    kwinApp()->start();
+    QVERIFY(workspaceCreatedSpy.wait());
+    QVERIFY(Compositor::self());
+    waylandServer()->initWorkspace();
+}
+
+void OcclusionTest::init()
+{
+    QVERIFY(Test::setupWaylandConnection());
+}
+
+void OcclusionTest::cleanup()
+{
+    Test::destroyWaylandConnection();
+}
+
+ShellClient *OcclusionTest::createClient(const QRect &geometry, QImage::Format format)
+{
+    using namespace KWayland::Client;
+    Surface *surface = Test::createSurface(Test::waylandCompositor());
+    if (!surface) {
+        return nullptr;
+    }
+    ShellSurface *shellSurface = Test::createShellSurface(surface, surface);
+    if (!shellSurface) {
+        return nullptr;
+    }
+    ShellClient *client = Test::renderAndWaitForShown(surface, geometry.size(), Qt::blue, format);
+    if (client) {
+        client->move(geometry.topLeft());
+    }
+    return client;
+}
+
+void OcclusionTest::testCovered()
+{
+    ShellClient *bottom = createClient(QRect(50, 50, 100, 100));
+    QVERIFY(bottom);
+    ShellClient *top = createClient(QRect(0, 0, 200, 200));
+    QVERIFY(top);
+    QTRY_VERIFY(bottom->isOccluded());
+    QVERIFY(!top->isOccluded());
+
+    // exposing the window makes it visible again with the next frame
+    top->move(QPoint(500, 500));
+    QTRY_VERIFY(!bottom->isOccluded());
+    QVERIFY(!top->isOccluded());
+
+    workspace()->raiseClient(bottom);
+    top->move(QPoint(0, 0));
+    QTRY_COMPARE(Compositor::self()->pendingRepaints(), QRegion());
+    QVERIFY(!bottom->isOccluded());
+    QVERIFY(!top->isOccluded());
+}
+
+void OcclusionTest::testPartiallyCovered()
+{
+    // a window covered by the union of several windows is occluded
+    ShellClient *bottom = createClient(QRect(0, 0, 200, 100));
+    QVERIFY(bottom);
+    ShellClient *left = createClient(QRect(0, 0, 100, 100));
+    QVERIFY(left);
+    ShellClient *right = createClient(QRect(100, 0, 100, 100));
+    QVERIFY(right);
+    QTRY_VERIFY(bottom->isOccluded());
+
+    right->move(QPoint(101, 0));
+    QTRY_VERIFY(!bottom->isOccluded());
+}
+
+void OcclusionTest::testTranslucentCover()
+{
+    // a translucent window does not occlude what is below it
+    ShellClient *bottom = createClient(QRect(50, 50, 100, 100));
+    QVERIFY(bottom);
+    ShellClient *top = createClient(QRect(0, 0, 200, 200), QImage::Format_ARGB32);
+    QVERIFY(top);
+    QTRY_COMPARE(Compositor::self()->pendingRepaints(), QRegion());
+    QVERIFY(!bottom->isOccluded());
+}
+
+void OcclusionTest::testMinimized()
+{
+    // a window which is not painted is left out of the occlusion tracking
+    ShellClient *bottom = createClient(QRect(0, 0, 100, 100));
+    QVERIFY(bottom);
+    ShellClient *top = createClient(QRect(0, 0, 200, 200));
+    QVERIFY(top);
+    QTRY_VERIFY(bottom->isOccluded());
+
+    bottom->minimize();
+    QTRY_VERIFY(!bottom->isOccluded());
+    QTRY_COMPARE(Compositor::self()->pendingRepaints(), QRegion());
+    QVERIFY(!bottom->isOccluded());
+}
+
+WAYLANDTEST_MAIN(OcclusionTest)
+#include "occlusion_test.moc"
@@ -0,0 +1,254 @@
+/********************************************************************
+KWin - the KDE window manager
+This file is part of the KDE project.
+
+Copyright (C) 2019 KWin-lowlatency developers
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "kwin_wayland_test.h"
+#include "composite.h"
+#include "effects.h"
+#include "platform.h"
+#include "shell_client.h"
+#include "wayland_server.h"
+#include "workspace.h"
+
+#include <KWayland/Client/shell.h>
+#include <KWayland/Client/surface.h>
+
+#include <QElapsedTimer>
+
+using namespace KWin;
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_restack_repaint-0");
+
+/**
+ * Measures how long the compositor takes to paint a frame. It goes first in the effect
+ * chain, so its prePaintScreen starts and its postPaintScreen ends the painting.
+ **/
+class FrameTimer : public Effect
+{
+    Q_OBJECT
+public:
+    int requestedEffectChainPosition() const override {
+        return std::numeric_limits<int>::min();
+    }
+
+    void prePaintScreen(ScreenPrePaintData &data, int time) override {
+        m_timer.start();
+        effects->prePaintScreen(data, time);
+    }
+    void postPaintScreen() override {
+        effects->postPaintScreen();
+        emit framePainted(m_timer.nsecsElapsed());
+    }
+
+Q_SIGNALS:
+    void framePainted(qint64 duration);
+
+private:
+    QElapsedTimer m_timer;
+};
+
+class RestackRepaintTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testRaise();
+    void testLower();
+    void testRaiseTopmost();
+    void testNoOverlap();
+    void testForced();
+    void benchmarkRaiseLower_data();
+    void benchmarkRaiseLower();
+
+private:
+    ShellClient *createClient(const QRect &geometry);
+    void waitForIdleCompositor();
+
+    FrameTimer *m_frameTimer = nullptr;
+};
+
+void RestackRepaintTest::initTestCase()
+{
+    qRegisterMetaType<KWin::ShellClient*>();
+    QSignalSpy workspaceCreatedSpy(kwinApp(), &Application::workspaceCreated);
+    QVERIFY(workspaceCreatedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName.toLocal8Bit()));
+
+    kwinApp()->setConfig(KSharedConfig::openConfig(QString(), KConfig::SimpleConfig));
+    qputenv("KWIN_COMPOSE", QByteArrayLiteral("Q"));
+
+    kwinApp()->start();
+    QVERIFY(workspaceCreatedSpy.wait());
+    QVERIFY(Compositor::self());
+    waylandServer()->initWorkspace();
+
+    m_frameTimer = new FrameTimer;
+    QVERIFY(Test::injectEffect(m_frameTimer, QStringLiteral("frametimer")));
+}
+
+void RestackRepaintTest::init()
+{
+    QVERIFY(Test::setupWaylandConnection());
+}
+
+void RestackRepaintTest::cleanup()
+{
+    Test::destroyWaylandConnection();
+}
+
+ShellClient *RestackRepaintTest::createClient(const QRect &geometry)
+{
+    using namespace KWayland::Client;
+    Surface *surface = Test::createSurface(Test::waylandCompositor());
+    if (!surface) {
+        return nullptr;
+    }
+    ShellSurface *shellSurface = Test::createShellSurface(surface, surface);
+    if (!shellSurface) {
+        return nullptr;
+    }
+    ShellClient *client = Test::renderAndWaitForShown(surface, geometry.size(), Qt::blue);
+    if (client) {
+        client->move(geometry.topLeft());
+    }
+    return client;
+}
+
+void RestackRepaintTest::waitForIdleCompositor()
+{
+    // everything from mapping and moving the windows has to be painted
+    QTRY_VERIFY(Compositor::self()->pendingRepaints().isEmpty());
+}
+
+void RestackRepaintTest::testRaise()
+{
+    // raising a window repaints only where it overlaps the windows it moved above
+    ShellClient *bottom = createClient(QRect(0, 0, 100, 100));
+    QVERIFY(bottom);
+    ShellClient *top = createClient(QRect(50, 50, 100, 100));
+    QVERIFY(top);
+    ShellClient *unrelated = createClient(QRect(500, 500, 100, 100));
+    QVERIFY(unrelated);
+    QCOMPARE(workspace()->stackingOrder(), (ToplevelList{bottom, top, unrelated}));
+    waitForIdleCompositor();
+
+    workspace()->raiseClient(bottom);
+    QCOMPARE(workspace()->stackingOrder(), (ToplevelList{top, unrelated, bottom}));
+    QCOMPARE(Compositor::self()->pendingRepaints(), QRegion(50, 50, 50, 50));
+}
+
+void RestackRepaintTest::testLower()
+{
+    ShellClient *bottom = createClient(QRect(0, 0, 100, 100));
+    QVERIFY(bottom);
+    ShellClient *middle = createClient(QRect(80, 0, 100, 100));
+    QVERIFY(middle);
+    ShellClient *top = createClient(QRect(0, 80, 100, 100));
+    QVERIFY(top);
+    waitForIdleCompositor();
+
+    workspace()->lowerClient(top);
+    QCOMPARE(workspace()->stackingOrder(), (ToplevelList{top, bottom, middle}));
+    QCOMPARE(Compositor::self()->pendingRepaints(), QRegion(0, 80, 100, 20));
+}
+
+void RestackRepaintTest::testRaiseTopmost()
+{
+    // raising the topmost window does not change what is visible
+    ShellClient *bottom = createClient(QRect(0, 0, 100, 100));
+    QVERIFY(bottom);
+    ShellClient *top = createClient(QRect(50, 50, 100, 100));
+    QVERIFY(top);
+    waitForIdleCompositor();
+
+    workspace()->raiseClient(top);
+    QCOMPARE(workspace()->stackingOrder(), (ToplevelList{bottom, top}));
+    QVERIFY(Compositor::self()->pendingRepaints().isEmpty());
+}
+
+void RestackRepaintTest::testNoOverlap()
+{
+    ShellClient *first = createClient(QRect(0, 0, 100, 100));
+    QVERIFY(first);
+    ShellClient *second = createClient(QRect(200, 200, 100, 100));
+    QVERIFY(second);
+    waitForIdleCompositor();
+
+    workspace()->raiseClient(first);
+    QCOMPARE(workspace()->stackingOrder(), (ToplevelList{second, first}));
+    QVERIFY(Compositor::self()->pendingRepaints().isEmpty());
+}
+
+void RestackRepaintTest::testForced()
+{
+    // a forced restack may change what is shown without changing the order
+    ShellClient *client = createClient(QRect(0, 0, 100, 100));
+    QVERIFY(client);
+    waitForIdleCompositor();
+
+    workspace()->forceRestacking();
+    workspace()->updateStackingOrder();
+    QCOMPARE(workspace()->stackingOrder(), (ToplevelList{client}));
+    QCOMPARE(Compositor::self()->pendingRepaints(), QRegion(0, 0, 1280, 1024));
+}
+
+void RestackRepaintTest::benchmarkRaiseLower_data()
+{
+    QTest::addColumn<int>("count");
+
+    QTest::newRow("10") << 10;
+    QTest::newRow("50") << 50;
+}
+
+void RestackRepaintTest::benchmarkRaiseLower()
+{
+    // measures the composited frame following each restack, which paints the repaint
+    // region the restack caused
+    QFETCH(int, count);
+    QVector<ShellClient*> clients;
+    for (int i = 0; i < count; ++i) {
+        clients << createClient(QRect(QPoint((i % 10) * 100, (i / 10) * 100), QSize(200, 200)));
+        QVERIFY(clients.last());
+    }
+    ShellClient *client = clients.at(count / 2);
+    waitForIdleCompositor();
+
+    QSignalSpy framePaintedSpy(m_frameTimer, &FrameTimer::framePainted);
+    QVERIFY(framePaintedSpy.isValid());
+    const int rounds = 20;
+    qint64 total = 0;
+    for (int i = 0; i < rounds; ++i) {
+        if (i % 2) {
+            workspace()->lowerClient(client);
+        } else {
+            workspace()->raiseClient(client);
+        }
+        QVERIFY(!Compositor::self()->pendingRepaints().isEmpty());
+        QVERIFY(framePaintedSpy.wait());
+        total += framePaintedSpy.last().first().toLongLong();
+        waitForIdleCompositor();
+    }
+    QTest::setBenchmarkResult(total / 1000000.0 / rounds, QTest::WalltimeMilliseconds);
+}
+
+WAYLANDTEST_MAIN(RestackRepaintTest)
+#include "restack_repaint_test.moc"
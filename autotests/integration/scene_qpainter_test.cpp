@@ -24,6 +24,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "cursor.h"
 #include "effects.h"
 #include "platform.h"
+#include "screens.h"
 #include "shell_client.h"
 #include "wayland_server.h"
 #include "effect_builtins.h"
@@ -59,6 +60,8 @@ private Q_SLOTS:
     void testWindowScaled();
     void testCompositorRestart_data();
     void testCompositorRestart();
+    void testTranslucentWindow();
+    void benchmarkTranslucentWindows();
     void testX11Window();
 };
 
@@ -306,6 +309,69 @@ void SceneQPainterTest::testCompositorRestart()
     QCOMPARE(referenceImage, *scene->qpainterRenderBuffer());
 }
 
+void SceneQPainterTest::testTranslucentWindow()
+{
+    // this test verifies that a translucent window without shadow is painted with the opacity applied
+    KWin::Cursor::setPos(400, 400);
+    using namespace KWayland::Client;
+    QVERIFY(Test::setupWaylandConnection());
+    QScopedPointer<Surface> s(Test::createSurface());
+    QScopedPointer<ShellSurface> ss(Test::createShellSurface(s.data()));
+    ShellClient *client = Test::renderAndWaitForShown(s.data(), QSize(200, 300), Qt::blue);
+    QVERIFY(client);
+    QCOMPARE(client->pos(), QPoint(0, 0));
+    QVERIFY(!client->shadow());
+
+    auto scene = KWin::Compositor::self()->scene();
+    QVERIFY(scene);
+    QSignalSpy frameRenderedSpy(scene, &Scene::frameRendered);
+    QVERIFY(frameRenderedSpy.isValid());
+    client->setOpacity(0.5);
+    QVERIFY(frameRenderedSpy.wait());
+
+    QImage window(QSize(200, 300), QImage::Format_ARGB32);
+    window.fill(Qt::blue);
+    QImage referenceImage(QSize(1280, 1024), QImage::Format_RGB32);
+    referenceImage.fill(Qt::black);
+    QPainter painter(&referenceImage);
+    painter.setOpacity(0.5);
+    painter.drawImage(QPoint(0, 0), window);
+    painter.setOpacity(1.0);
+    const QImage cursorImage = kwinApp()->platform()->softwareCursor();
+    QVERIFY(!cursorImage.isNull());
+    painter.drawImage(QPoint(400, 400) - kwinApp()->platform()->softwareCursorHotspot(), cursorImage);
+    QCOMPARE(referenceImage, *scene->qpainterRenderBuffer());
+}
+
+void SceneQPainterTest::benchmarkTranslucentWindows()
+{
+    // full frames with 20 translucent, overlapping windows
+    using namespace KWayland::Client;
+    QVERIFY(Test::setupWaylandConnection());
+    QVector<QSharedPointer<Surface>> surfaces;
+    QVector<QSharedPointer<ShellSurface>> shellSurfaces;
+    ToplevelList windows;
+    for (int i = 0; i < 20; ++i) {
+        QSharedPointer<Surface> s(Test::createSurface());
+        QVERIFY(s);
+        QSharedPointer<ShellSurface> ss(Test::createShellSurface(s.data()));
+        QVERIFY(ss);
+        ShellClient *client = Test::renderAndWaitForShown(s.data(), QSize(400, 300), QColor::fromHsv(i * 18, 255, 255));
+        QVERIFY(client);
+        client->move(QPoint((i % 5) * 200, (i / 5) * 150));
+        client->setOpacity(0.8);
+        surfaces << s;
+        shellSurfaces << ss;
+        windows << client;
+    }
+
+    auto scene = KWin::Compositor::self()->scene();
+    QVERIFY(scene);
+    QBENCHMARK {
+        scene->paint(screens()->geometry(), windows);
+    }
+}
+
 struct XcbConnectionDeleter
 {
     static inline void cleanup(xcb_connection_t *pointer)
@@ -0,0 +1,224 @@
+/********************************************************************
+KWin - the KDE window manager
+This file is part of the KDE project.
+
+Copyright (C) 2019 KWin-lowlatency developers
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "kwin_wayland_test.h"
+#include "composite.h"
+#include "cursor.h"
+#include "effect_builtins.h"
+#include "effectloader.h"
+#include "platform.h"
+#include "scene.h"
+#include "screens.h"
+#include "shell_client.h"
+#include "wayland_server.h"
+#include "workspace.h"
+
+#include <KConfigGroup>
+
+#include <KWayland/Client/shell.h>
+#include <KWayland/Client/surface.h>
+
+#include <QThread>
+
+using namespace KWin;
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_scene_qpainter_tiled-0");
+
+class SceneQPainterTiledTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testCompare_data();
+    void testCompare();
+    void benchmarkPaint_data();
+    void benchmarkPaint();
+
+private:
+    void createWindows();
+    bool setThreads(int threads);
+    QImage renderFrame();
+};
+
+void SceneQPainterTiledTest::initTestCase()
+{
+    qRegisterMetaType<KWin::ShellClient*>();
+    qRegisterMetaType<KWin::AbstractClient*>();
+    QSignalSpy workspaceCreatedSpy(kwinApp(), &Application::workspaceCreated);
+    QVERIFY(workspaceCreatedSpy.isValid());
+    // a 4K screen, that's where software compositing struggles most
+    kwinApp()->platform()->setInitialWindowSize(QSize(3840, 2160));
+    QVERIFY(waylandServer()->init(s_socketName.toLocal8Bit()));
+
+    // disable all effects - we don't want to have it interact with the rendering
+    auto config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    KConfigGroup plugins(config, QStringLiteral("Plugins"));
+    ScriptedEffectLoader loader;
+    const auto builtinNames = BuiltInEffects::availableEffectNames() << loader.listOfKnownEffects();
+    for (const QString &name : builtinNames) {
+        plugins.writeEntry(name + QStringLiteral("Enabled"), false);
+    }
+    config->sync();
+    kwinApp()->setConfig(config);
+
+    qputenv("KWIN_COMPOSE", QByteArrayLiteral("Q"));
+    qunsetenv("KWIN_QPAINTER_THREADS");
+
+    kwinApp()->start();
+    QVERIFY(workspaceCreatedSpy.wait());
+    QVERIFY(Compositor::self());
+    waylandServer()->initWorkspace();
+}
+
+void SceneQPainterTiledTest::init()
+{
+    QVERIFY(Test::setupWaylandConnection());
+    KWin::Cursor::setPos(QPoint(1000, 700));
+}
+
+void SceneQPainterTiledTest::cleanup()
+{
+    Test::destroyWaylandConnection();
+    QVERIFY(setThreads(0));
+}
+
+void SceneQPainterTiledTest::createWindows()
+{
+    // windows which overlap each other and the borders of the tiles, some of them translucent
+    using namespace KWayland::Client;
+    struct {
+        QRect geometry;
+        QColor color;
+        qreal opacity;
+    } const windows[] = {
+        { QRect(0, 0, 3840, 2160), Qt::darkGray, 1.0 },
+        { QRect(100, 100, 1000, 700), Qt::blue, 1.0 },
+        { QRect(250, 255, 513, 301), QColor(255, 0, 0, 128), 1.0 },
+        { QRect(700, 500, 1300, 900), Qt::green, 0.6 },
+        { QRect(3500, 1900, 700, 500), Qt::yellow, 1.0 },
+        { QRect(1023, 1023, 3, 3), Qt::white, 0.3 }
+    };
+    for (const auto &window : windows) {
+        Surface *surface = Test::createSurface(Test::waylandCompositor());
+        QVERIFY(surface);
+        ShellSurface *shellSurface = Test::createShellSurface(surface, surface);
+        QVERIFY(shellSurface);
+        ShellClient *client = Test::renderAndWaitForShown(surface, window.geometry.size(), window.color);
+        QVERIFY(client);
+        client->move(window.geometry.topLeft());
+        client->setOpacity(window.opacity);
+    }
+}
+
+bool SceneQPainterTiledTest::setThreads(int threads)
+{
+    // the scene picks the mode up when it is created
+    if (threads > 0) {
+        qputenv("KWIN_QPAINTER_THREADS", QByteArray::number(threads));
+    } else {
+        qunsetenv("KWIN_QPAINTER_THREADS");
+    }
+    QSignalSpy sceneCreatedSpy(Compositor::self(), &Compositor::sceneCreated);
+    if (!sceneCreatedSpy.isValid()) {
+        return false;
+    }
+    Compositor::self()->slotReinitialize();
+    if (sceneCreatedSpy.isEmpty() && !sceneCreatedSpy.wait()) {
+        return false;
+    }
+    return Compositor::self()->scene() != nullptr;
+}
+
+QImage SceneQPainterTiledTest::renderFrame()
+{
+    Scene *scene = Compositor::self()->scene();
+    QSignalSpy frameRenderedSpy(scene, &Scene::frameRendered);
+    Compositor::self()->addRepaintFull();
+    if (!frameRenderedSpy.wait()) {
+        return QImage();
+    }
+    return scene->qpainterRenderBuffer()->copy();
+}
+
+void SceneQPainterTiledTest::testCompare_data()
+{
+    QTest::addColumn<int>("threads");
+
+    QTest::newRow("2 threads") << 2;
+    QTest::newRow("4 threads") << 4;
+    QTest::newRow("7 threads") << 7;
+}
+
+void SceneQPainterTiledTest::testCompare()
+{
+    // the tiled rasterization has to produce exactly the same frame as the single threaded one
+    createWindows();
+    if (QTest::currentTestFailed()) {
+        return;
+    }
+
+    const QImage reference = renderFrame();
+    QVERIFY(!reference.isNull());
+
+    QFETCH(int, threads);
+    QVERIFY(setThreads(threads));
+    const QImage tiled = renderFrame();
+    QVERIFY(!tiled.isNull());
+    QCOMPARE(tiled, reference);
+}
+
+void SceneQPainterTiledTest::benchmarkPaint_data()
+{
+    QTest::addColumn<int>("threads");
+
+    QTest::newRow("single threaded") << 0;
+    QTest::newRow("2 threads") << 2;
+    QTest::newRow("4 threads") << 4;
+    QTest::newRow("ideal thread count") << QThread::idealThreadCount();
+}
+
+void SceneQPainterTiledTest::benchmarkPaint()
+{
+    QFETCH(int, threads);
+    QVERIFY(setThreads(threads));
+    createWindows();
+    if (QTest::currentTestFailed()) {
+        return;
+    }
+    QVERIFY(!renderFrame().isNull());
+
+    // full frames, the virtual platform repaints the whole screen
+    Scene *scene = Compositor::self()->scene();
+    ToplevelList windows;
+    const ToplevelList stackingOrder = workspace()->xStackingOrder();
+    for (Toplevel *t : stackingOrder) {
+        if (t->readyForPainting()) {
+            windows << t;
+        }
+    }
+    QBENCHMARK {
+        scene->paint(screens()->geometry(), windows);
+    }
+}
+
+WAYLANDTEST_MAIN(SceneQPainterTiledTest)
+#include "scene_qpainter_tiled_test.moc"
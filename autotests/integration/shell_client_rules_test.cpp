@@ -29,6 +29,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <KWayland/Client/surface.h>
 #include <KWayland/Client/xdgshell.h>
 
+#include <QFileInfo>
+
 using namespace KWin;
 using namespace KWayland::Client;
 
@@ -64,6 +66,9 @@ private Q_SLOTS:
     void testOpacityActive_data();
     void testOpacityActive();
     void testMatchAfterNameChange();
+    void testMatchPriority();
+    void benchmarkFind_data();
+    void benchmarkFind();
 };
 
 void TestShellClientRules::initTestCase()
@@ -450,5 +455,121 @@ void TestShellClientRules::testMatchAfterNameChange()
     QCOMPARE(c->keepAbove(), true);
 }
 
+void TestShellClientRules::testMatchPriority()
+{
+    // rules limited to a single window class and all other rules are looked up separately,
+    // they still have to apply in the order of the config
+    const QByteArray completeClass = QFileInfo(QCoreApplication::applicationFilePath()).fileName().toUtf8()
+        + QByteArrayLiteral(" org.kde.foo");
+    struct {
+        QByteArray wmclass;
+        int match;
+        bool complete;
+        QString property;
+        bool value;
+    } const rules[] = {
+        { QByteArrayLiteral("kde.fo"), 2, false, QStringLiteral("skippager"), true },
+        { QByteArrayLiteral("org.kde.foo"), 1, false, QStringLiteral("skiptaskbar"), true },
+        { QByteArrayLiteral("kde"), 2, false, QStringLiteral("skippager"), false },
+        { QByteArrayLiteral("org.kde.foo"), 1, false, QStringLiteral("skiptaskbar"), false },
+        { QByteArrayLiteral("^org\\.kde\\.f.o$"), 3, false, QStringLiteral("skipswitcher"), true },
+        { QByteArrayLiteral("org.kde.bar"), 1, false, QStringLiteral("above"), true },
+        { completeClass, 1, true, QStringLiteral("below"), true },
+    };
+
+    KSharedConfig::Ptr config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    config->group("General").writeEntry("count", int(sizeof(rules) / sizeof(rules[0])));
+    for (uint i = 0; i < sizeof(rules) / sizeof(rules[0]); ++i) {
+        auto group = config->group(QString::number(i + 1));
+        group.writeEntry("wmclass", rules[i].wmclass);
+        group.writeEntry("wmclassmatch", rules[i].match);
+        group.writeEntry("wmclasscomplete", rules[i].complete);
+        group.writeEntry(rules[i].property, rules[i].value);
+        group.writeEntry(rules[i].property + QStringLiteral("rule"), 2);
+    }
+    config->sync();
+
+    RuleBook::self()->setConfig(config);
+    workspace()->slotReconfigure();
+
+    QScopedPointer<Surface> surface(Test::createSurface());
+    QScopedPointer<XdgShellSurface> shellSurface(Test::createXdgShellV6Surface(surface.data()));
+    shellSurface->setAppId(QByteArrayLiteral("org.kde.foo"));
+
+    auto c = Test::renderAndWaitForShown(surface.data(), QSize(100, 50), Qt::blue);
+    QVERIFY(c);
+    QTRY_COMPARE(c->resourceClass(), QByteArrayLiteral("org.kde.foo"));
+    QTRY_VERIFY(c->keepBelow());
+    QVERIFY(c->skipPager());
+    QVERIFY(c->skipTaskbar());
+    QVERIFY(c->skipSwitcher());
+    QVERIFY(!c->keepAbove());
+}
+
+void TestShellClientRules::benchmarkFind_data()
+{
+    QTest::addColumn<bool>("ignoreTemporary");
+
+    // managing a window and re-evaluating after e.g. a title change
+    QTest::newRow("manage") << false;
+    QTest::newRow("reevaluate") << true;
+}
+
+void TestShellClientRules::benchmarkFind()
+{
+    // 500 rules, mostly for a single window class as created by the kcm
+    KSharedConfig::Ptr config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    config->group("General").writeEntry("count", 500);
+    for (int i = 0; i < 500; ++i) {
+        auto group = config->group(QString::number(i + 1));
+        switch (i % 10) {
+        case 8:
+            group.writeEntry("wmclass", QStringLiteral("app%1x").arg(i));
+            group.writeEntry("wmclassmatch", 2);
+            break;
+        case 9:
+            group.writeEntry("wmclass", QStringLiteral("^org\\.kde\\.other%1$").arg(i));
+            group.writeEntry("wmclassmatch", 3);
+            break;
+        default:
+            group.writeEntry("wmclass", QStringLiteral("org.kde.app%1").arg(i));
+            group.writeEntry("wmclassmatch", 1);
+            break;
+        }
+        group.writeEntry("title", QStringLiteral("Window %1").arg(i));
+        group.writeEntry("titlematch", i % 2 ? 2 : 0);
+        group.writeEntry("skippager", true);
+        group.writeEntry("skippagerrule", 2);
+    }
+    config->sync();
+
+    RuleBook::self()->setConfig(config);
+    workspace()->slotReconfigure();
+
+    QVector<Surface *> surfaces;
+    QVector<XdgShellSurface *> shellSurfaces;
+    QVector<AbstractClient *> clients;
+    for (int i = 0; i < 10; ++i) {
+        surfaces << Test::createSurface();
+        shellSurfaces << Test::createXdgShellV6Surface(surfaces.last());
+        shellSurfaces.last()->setAppId(QStringLiteral("org.kde.app%1").arg(i).toUtf8());
+        clients << Test::renderAndWaitForShown(surfaces.last(), QSize(100, 50), Qt::blue);
+        QVERIFY(clients.last());
+    }
+
+    // 1000 windows against 500 rules
+    QFETCH(bool, ignoreTemporary);
+    QBENCHMARK {
+        for (int i = 0; i < 100; ++i) {
+            for (AbstractClient *c : qAsConst(clients)) {
+                RuleBook::self()->find(c, ignoreTemporary);
+            }
+        }
+    }
+
+    qDeleteAll(shellSurfaces);
+    qDeleteAll(surfaces);
+}
+
 WAYLANDTEST_MAIN(TestShellClientRules)
 #include "shell_client_rules_test.moc"
@@ -62,6 +62,8 @@ private Q_SLOTS:
     void testKeepAbove();
     void testKeepBelow();
 
+    void benchmarkRestackDeepTransients_data();
+    void benchmarkRestackDeepTransients();
 };
 
 void StackingOrderTest::initTestCase()
@@ -907,5 +909,60 @@ void StackingOrderTest::testKeepBelow()
     QCOMPARE(workspace()->stackingOrder(), (ToplevelList{clientB, clientA}));
 }
 
+void StackingOrderTest::benchmarkRestackDeepTransients_data()
+{
+    QTest::addColumn<int>("depth");
+
+    // 500 windows each, in chains of nested transients
+    QTest::newRow("500 windows, depth 1") << 1;
+    QTest::newRow("500 windows, depth 10") << 10;
+    QTest::newRow("500 windows, depth 50") << 50;
+}
+
+void StackingOrderTest::benchmarkRestackDeepTransients()
+{
+    // Measures the constrained stacking order for many windows with deeply nested transients.
+    QFETCH(int, depth);
+    const int chains = 500 / depth;
+
+    QVector<ShellClient *> roots;
+    QVector<ShellClient *> leaves;
+    for (int i = 0; i < chains; ++i) {
+        KWayland::Client::Surface *parentSurface = nullptr;
+        for (int j = 0; j < depth; ++j) {
+            KWayland::Client::Surface *surface =
+                Test::createSurface(Test::waylandCompositor());
+            QVERIFY(surface);
+            KWayland::Client::ShellSurface *shellSurface =
+                Test::createShellSurface(surface, surface);
+            QVERIFY(shellSurface);
+            if (parentSurface) {
+                shellSurface->setTransient(parentSurface, QPoint(0, 0));
+            }
+            ShellClient *client = Test::renderAndWaitForShown(surface, QSize(64, 64), Qt::blue);
+            QVERIFY(client);
+            if (j == 0) {
+                roots << client;
+            }
+            parentSurface = surface;
+            if (j == depth - 1) {
+                leaves << client;
+            }
+        }
+    }
+    QCOMPARE(workspace()->stackingOrder().count(), chains * depth);
+
+    // lowering the root of a chain keeps all its transients above it
+    ShellClient *root = roots.last();
+    ShellClient *leaf = leaves.last();
+    QBENCHMARK {
+        workspace()->lowerClient(root);
+        workspace()->raiseClient(leaf);
+    }
+    const ToplevelList stacking = workspace()->stackingOrder();
+    QVERIFY(stacking.last() == leaf);
+    QVERIFY(stacking.indexOf(root) <= stacking.indexOf(leaf));
+}
+
 WAYLANDTEST_MAIN(StackingOrderTest)
 #include "stacking_order_test.moc"
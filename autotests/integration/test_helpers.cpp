@@ -18,6 +18,9 @@ You should have received a copy of the GNU General Public License
 along with this program.  If not, see <http://www.gnu.org/licenses/>.
 *********************************************************************/
 #include "kwin_wayland_test.h"
+#include "effect_builtins.h"
+#include "effectloader.h"
+#include "effects.h"
 #include "shell_client.h"
 #include "screenlockerwatcher.h"
 #include "wayland_server.h"
@@ -35,6 +38,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <KWayland/Client/shadow.h>
 #include <KWayland/Client/shell.h>
 #include <KWayland/Client/shm_pool.h>
+#include <KWayland/Client/subcompositor.h>
 #include <KWayland/Client/output.h>
 #include <KWayland/Client/surface.h>
 #include <KWayland/Client/appmenu.h>
@@ -45,6 +49,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 //screenlocker
 #include <KScreenLocker/KsldApp>
 
+#include <KConfigGroup>
+
 #include <QThread>
 
 // system
@@ -63,6 +69,7 @@ static struct {
     ConnectionThread *connection = nullptr;
     EventQueue *queue = nullptr;
     Compositor *compositor = nullptr;
+    SubCompositor *subCompositor = nullptr;
     ServerSideDecorationManager *decoration = nullptr;
     ShadowManager *shadowManager = nullptr;
     Shell *shell = nullptr;
@@ -220,6 +227,13 @@ bool setupWaylandConnection(AdditionalWaylandInterfaces flags)
             return false;
         }
     }
+    if (flags.testFlag(AdditionalWaylandInterface::SubCompositor)) {
+        s_waylandConnection.subCompositor = registry->createSubCompositor(registry->interface(Registry::Interface::SubCompositor).name,
+                                                                          registry->interface(Registry::Interface::SubCompositor).version);
+        if (!s_waylandConnection.subCompositor->isValid()) {
+            return false;
+        }
+    }
     if (flags.testFlag(AdditionalWaylandInterface::XdgDecoration)) {
         s_waylandConnection.xdgDecoration = registry->createXdgDecorationManager(registry->interface(Registry::Interface::XdgDecorationUnstableV1).name, registry->interface(Registry::Interface::XdgDecorationUnstableV1).version);
         if (!s_waylandConnection.xdgDecoration->isValid()) {
@@ -234,6 +248,8 @@ void destroyWaylandConnection()
 {
     delete s_waylandConnection.compositor;
     s_waylandConnection.compositor = nullptr;
+    delete s_waylandConnection.subCompositor;
+    s_waylandConnection.subCompositor = nullptr;
     delete s_waylandConnection.windowManagement;
     s_waylandConnection.windowManagement = nullptr;
     delete s_waylandConnection.plasmaShell;
@@ -292,6 +308,11 @@ Compositor *waylandCompositor()
     return s_waylandConnection.compositor;
 }
 
+SubCompositor *waylandSubCompositor()
+{
+    return s_waylandConnection.subCompositor;
+}
+
 ShadowManager *waylandShadowManager()
 {
     return s_waylandConnection.shadowManager;
@@ -602,5 +623,32 @@ bool unlockScreen()
     return true;
 }
 
+void disableAllEffects(const KSharedConfigPtr &config)
+{
+    KConfigGroup plugins(config, QStringLiteral("Plugins"));
+    ScriptedEffectLoader loader;
+    const auto builtinNames = BuiltInEffects::availableEffectNames() << loader.listOfKnownEffects();
+    for (const QString &name : builtinNames) {
+        plugins.writeEntry(name + QStringLiteral("Enabled"), false);
+    }
+}
+
+bool injectEffect(Effect *effect, const QString &name)
+{
+    // the effect loader is private API, the same way as in the scripted effects test
+    const auto children = effects->children();
+    for (QObject *child : children) {
+        if (qstrcmp(child->metaObject()->className(), "KWin::EffectLoader") == 0) {
+            QMetaObject::invokeMethod(child, "effectLoaded", Q_ARG(KWin::Effect*, effect), Q_ARG(QString, name));
+            break;
+        }
+    }
+    if (!static_cast<EffectsHandlerImpl*>(effects)->isEffectLoaded(name)) {
+        delete effect;
+        return false;
+    }
+    return true;
+}
+
 }
 }
@@ -0,0 +1,152 @@
+/********************************************************************
+KWin - the KDE window manager
+This file is part of the KDE project.
+
+Copyright (C) 2019 KWin-lowlatency developers
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "kwin_wayland_test.h"
+#include "composite.h"
+#include "cursor.h"
+#include "effect_builtins.h"
+#include "effectloader.h"
+#include "platform.h"
+#include "scene.h"
+#include "shell_client.h"
+#include "wayland_server.h"
+
+#include <KConfigGroup>
+
+#include <KWayland/Client/surface.h>
+#include <KWayland/Client/xdgshell.h>
+
+#include <QPainter>
+
+using namespace KWin;
+using namespace KWayland::Client;
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_virtual_buffer_age-0");
+
+// the part of the screen the window moves in, away from the cursor
+static const QRect s_windowArea(0, 0, 800, 600);
+// a pixel which is never damaged
+static const QPoint s_marker(1000, 100);
+
+class VirtualBufferAgeTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanup();
+
+    void testMovingWindow_data();
+    void testMovingWindow();
+};
+
+void VirtualBufferAgeTest::initTestCase()
+{
+    qRegisterMetaType<KWin::ShellClient*>();
+    QSignalSpy workspaceCreatedSpy(kwinApp(), &Application::workspaceCreated);
+    QVERIFY(workspaceCreatedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName.toLocal8Bit()));
+
+    // disable all effects - we don't want to have it interact with the rendering
+    auto config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    KConfigGroup plugins(config, QStringLiteral("Plugins"));
+    ScriptedEffectLoader loader;
+    const auto builtinNames = BuiltInEffects::availableEffectNames() << loader.listOfKnownEffects();
+    for (const QString &name : builtinNames) {
+        plugins.writeEntry(name + QStringLiteral("Enabled"), false);
+    }
+    config->sync();
+    kwinApp()->setConfig(config);
+
+    qputenv("KWIN_COMPOSE", QByteArrayLiteral("Q"));
+
+    kwinApp()->start();
+    QVERIFY(workspaceCreatedSpy.wait());
+    QVERIFY(Compositor::self());
+    waylandServer()->initWorkspace();
+}
+
+void VirtualBufferAgeTest::cleanup()
+{
+    Test::destroyWaylandConnection();
+    QVERIFY(QMetaObject::invokeMethod(kwinApp()->platform(), "setEmulatedBufferAge", Qt::DirectConnection, Q_ARG(int, 0)));
+}
+
+void VirtualBufferAgeTest::testMovingWindow_data()
+{
+    QTest::addColumn<int>("bufferAge");
+
+    QTest::newRow("full repaint") << 0;
+    QTest::newRow("1") << 1;
+    QTest::newRow("2") << 2;
+    QTest::newRow("3") << 3;
+}
+
+void VirtualBufferAgeTest::testMovingWindow()
+{
+    // a moving window leaves no trace in any of the reused back buffers,
+    // while the parts of the screen which are not damaged are not repainted
+    QFETCH(int, bufferAge);
+    QVERIFY(QMetaObject::invokeMethod(kwinApp()->platform(), "setEmulatedBufferAge", Qt::DirectConnection, Q_ARG(int, bufferAge)));
+    KWin::Cursor::setPos(1200, 1000);
+
+    Scene *scene = Compositor::self()->scene();
+    QVERIFY(scene);
+    QSignalSpy frameRenderedSpy(scene, &Scene::frameRendered);
+    QVERIFY(frameRenderedSpy.isValid());
+    Compositor::self()->addRepaintFull();
+    QVERIFY(frameRenderedSpy.wait());
+
+    QVERIFY(Test::setupWaylandConnection());
+    QScopedPointer<Surface> surface(Test::createSurface());
+    QScopedPointer<XdgShellSurface> shellSurface(Test::createXdgShellStableSurface(surface.data()));
+    ShellClient *client = Test::renderAndWaitForShown(surface.data(), QSize(100, 100), Qt::blue);
+    QVERIFY(client);
+
+    // the marker is only in the current back buffer, after the frames in between it shows again
+    QImage *buffer = scene->qpainterRenderBuffer();
+    buffer->setPixelColor(s_marker, Qt::green);
+    frameRenderedSpy.clear();
+    const int frames = qMax(bufferAge, 1);
+
+    QPoint position(0, 0);
+    for (int i = 0; i < 12; ++i) {
+        position += QPoint(37, 23);
+        client->move(position);
+        QVERIFY(frameRenderedSpy.wait());
+
+        QImage referenceImage(s_windowArea.size(), QImage::Format_RGB32);
+        referenceImage.fill(Qt::black);
+        QPainter painter(&referenceImage);
+        painter.fillRect(QRect(position, QSize(100, 100)), Qt::blue);
+        painter.end();
+        QCOMPARE(scene->qpainterRenderBuffer()->copy(s_windowArea), referenceImage);
+
+        if (frameRenderedSpy.count() % frames == 0) {
+            const QColor expected = bufferAge == 0 ? QColor(Qt::black) : QColor(Qt::green);
+            QCOMPARE(scene->qpainterRenderBuffer()->pixelColor(s_marker), expected);
+        }
+    }
+
+    shellSurface.reset();
+    QVERIFY(Test::waitForWindowDestroyed(client));
+}
+
+WAYLANDTEST_MAIN(VirtualBufferAgeTest)
+#include "virtual_buffer_age_test.moc"
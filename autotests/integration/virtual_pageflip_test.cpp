@@ -0,0 +1,166 @@
+/********************************************************************
+KWin - the KDE window manager
+This file is part of the KDE project.
+
+Copyright (C) 2019 KWin-lowlatency developers
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "kwin_wayland_test.h"
+#include "abstract_output.h"
+#include "composite.h"
+#include "effect_builtins.h"
+#include "effectloader.h"
+#include "platform.h"
+#include "screens.h"
+#include "wayland_server.h"
+
+#include <KConfigGroup>
+
+using namespace KWin;
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_virtual_pageflip-0");
+
+// 50 Hz, a refresh interval of exactly 20 ms
+static const qint64 s_vblankInterval = 20000000;
+
+class VirtualPageFlipTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanup();
+
+    void testRefreshRate();
+    void testPresentationTime_data();
+    void testPresentationTime();
+    void testFramePacing();
+
+private:
+    bool setPageFlipSimulation(bool enabled, int jitter = 0, int missedFlipInterval = 0);
+};
+
+void VirtualPageFlipTest::initTestCase()
+{
+    QSignalSpy workspaceCreatedSpy(kwinApp(), &Application::workspaceCreated);
+    QVERIFY(workspaceCreatedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QMetaObject::invokeMethod(kwinApp()->platform(), "setVirtualOutputs", Qt::DirectConnection,
+                              Q_ARG(int, 1),
+                              Q_ARG(QVector<QRect>, QVector<QRect>{QRect(0, 0, 1280, 1024)}),
+                              Q_ARG(QVector<int>, QVector<int>{1}),
+                              Q_ARG(QVector<int>, QVector<int>{50000}));
+    QVERIFY(waylandServer()->init(s_socketName.toLocal8Bit()));
+
+    // disable all effects, they must not schedule repaints on their own
+    auto config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    KConfigGroup plugins(config, QStringLiteral("Plugins"));
+    ScriptedEffectLoader loader;
+    const auto builtinNames = BuiltInEffects::availableEffectNames() << loader.listOfKnownEffects();
+    for (const QString &name : builtinNames) {
+        plugins.writeEntry(name + QStringLiteral("Enabled"), false);
+    }
+    config->sync();
+    kwinApp()->setConfig(config);
+
+    qputenv("KWIN_COMPOSE", QByteArrayLiteral("Q"));
+
+    kwinApp()->start();
+    QVERIFY(workspaceCreatedSpy.wait());
+    QVERIFY(Compositor::self());
+    waylandServer()->initWorkspace();
+}
+
+void VirtualPageFlipTest::cleanup()
+{
+    QVERIFY(setPageFlipSimulation(false));
+}
+
+bool VirtualPageFlipTest::setPageFlipSimulation(bool enabled, int jitter, int missedFlipInterval)
+{
+    return QMetaObject::invokeMethod(kwinApp()->platform(), "setPageFlipSimulation", Qt::DirectConnection,
+                                     Q_ARG(bool, enabled), Q_ARG(int, jitter), Q_ARG(int, missedFlipInterval));
+}
+
+void VirtualPageFlipTest::testRefreshRate()
+{
+    const auto outputs = kwinApp()->platform()->enabledOutputs();
+    QCOMPARE(outputs.count(), 1);
+    QCOMPARE(outputs.first()->refreshRate(), 50000);
+    QCOMPARE(screens()->refreshRate(0), 50.0f);
+}
+
+void VirtualPageFlipTest::testPresentationTime_data()
+{
+    QTest::addColumn<int>("jitter");
+    QTest::addColumn<int>("missedFlipInterval");
+    QTest::addColumn<quint64>("minimumVBlanks");
+
+    QTest::newRow("on time") << 0 << 0 << quint64(1);
+    QTest::newRow("jitter") << 5000 << 0 << quint64(1);
+    QTest::newRow("every flip missed") << 0 << 1 << quint64(2);
+    QTest::newRow("every flip missed, jitter") << 5000 << 1 << quint64(2);
+}
+
+void VirtualPageFlipTest::testPresentationTime()
+{
+    // frames are shown at vblanks only, whatever the jitter of the events is
+    QFETCH(int, jitter);
+    QFETCH(int, missedFlipInterval);
+    QFETCH(quint64, minimumVBlanks);
+    QVERIFY(setPageFlipSimulation(true, jitter, missedFlipInterval));
+
+    AbstractOutput *output = kwinApp()->platform()->enabledOutputs().first();
+    QSignalSpy pageFlippedSpy(output, SIGNAL(pageFlipped(quint64,qint64)));
+    QVERIFY(pageFlippedSpy.isValid());
+    for (int i = 0; i < 10; ++i) {
+        Compositor::self()->addRepaintFull();
+        QVERIFY(pageFlippedSpy.wait());
+    }
+    QCOMPARE(pageFlippedSpy.count(), 10);
+
+    for (int i = 1; i < pageFlippedSpy.count(); ++i) {
+        const quint64 sequence = pageFlippedSpy.at(i).at(0).value<quint64>();
+        const quint64 previousSequence = pageFlippedSpy.at(i - 1).at(0).value<quint64>();
+        const qint64 time = pageFlippedSpy.at(i).at(1).value<qint64>();
+        const qint64 previousTime = pageFlippedSpy.at(i - 1).at(1).value<qint64>();
+        QVERIFY(sequence >= previousSequence + minimumVBlanks);
+        QCOMPARE(time - previousTime, qint64(sequence - previousSequence) * s_vblankInterval);
+    }
+}
+
+void VirtualPageFlipTest::testFramePacing()
+{
+    // while a page flip is pending the compositor does not start another frame,
+    // so a continuously repainting scene does not run faster than the display
+    QVERIFY(setPageFlipSimulation(true));
+    AbstractOutput *output = kwinApp()->platform()->enabledOutputs().first();
+    QSignalSpy pageFlippedSpy(output, SIGNAL(pageFlipped(quint64,qint64)));
+    QVERIFY(pageFlippedSpy.isValid());
+    QMetaObject::Connection repaint = connect(output, SIGNAL(pageFlipped(quint64,qint64)),
+                                              Compositor::self(), SLOT(addRepaintFull()));
+    Compositor::self()->addRepaintFull();
+    QVERIFY(pageFlippedSpy.wait());
+    QTest::qWait(500);
+    disconnect(repaint);
+
+    QVERIFY(pageFlippedSpy.count() > 1);
+    const quint64 first = pageFlippedSpy.first().at(0).value<quint64>();
+    const quint64 last = pageFlippedSpy.last().at(0).value<quint64>();
+    // at most one frame per vblank
+    QVERIFY(last - first >= quint64(pageFlippedSpy.count() - 1));
+}
+
+WAYLANDTEST_MAIN(VirtualPageFlipTest)
+#include "virtual_pageflip_test.moc"
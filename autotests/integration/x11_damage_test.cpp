@@ -0,0 +1,242 @@
+/********************************************************************
+KWin - the KDE window manager
+This file is part of the KDE project.
+
+Copyright (C) 2019 KWin-lowlatency developers
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "kwin_wayland_test.h"
+#include "client.h"
+#include "composite.h"
+#include "effects.h"
+#include "platform.h"
+#include "wayland_server.h"
+#include "workspace.h"
+#include "xcbutils.h"
+
+#include <xcb/xcb.h>
+#include <xcb/damage.h>
+
+using namespace KWin;
+static const QString s_socketName = QStringLiteral("wayland_test_x11_damage-0");
+
+struct XcbConnectionDeleter
+{
+    static inline void cleanup(xcb_connection_t *pointer)
+    {
+        xcb_disconnect(pointer);
+    }
+};
+
+/**
+ * Reports the damage of the watched window whenever a frame is about to paint it.
+ **/
+class DamageMonitor : public Effect
+{
+    Q_OBJECT
+public:
+    void setWindow(Toplevel *window) {
+        m_window = window;
+    }
+
+    void prePaintWindow(EffectWindow *w, WindowPrePaintData &data, int time) override {
+        if (m_window && static_cast<EffectWindowImpl *>(w)->window() == m_window) {
+            emit windowPrePainted(m_window->damage());
+        }
+        effects->prePaintWindow(w, data, time);
+    }
+
+Q_SIGNALS:
+    void windowPrePainted(const QRegion &damage);
+
+private:
+    QPointer<Toplevel> m_window;
+};
+
+class X11DamageTest : public QObject
+{
+Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testBatching();
+    void testMergeSmallUpdates();
+    void testOccludedDamageSpam();
+
+private:
+    Client *createClient(const QSize &size = QSize(200, 200));
+    void sendDamage(Client *client, const QRect &area);
+
+    QScopedPointer<xcb_connection_t, XcbConnectionDeleter> m_connection;
+    DamageMonitor *m_damageMonitor = nullptr;
+};
+
+void X11DamageTest::initTestCase()
+{
+    qRegisterMetaType<KWin::Client*>();
+    qRegisterMetaType<KWin::Toplevel*>();
+    QSignalSpy workspaceCreatedSpy(kwinApp(), &Application::workspaceCreated);
+    QVERIFY(workspaceCreatedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName.toLocal8Bit()));
+    kwinApp()->setConfig(KSharedConfig::openConfig(QString(), KConfig::SimpleConfig));
+    qputenv("KWIN_COMPOSE", QByteArrayLiteral("Q"));
+
+    kwinApp()->start();
+    QVERIFY(workspaceCreatedSpy.wait());
+    QVERIFY(Compositor::self());
+    waylandServer()->initWorkspace();
+
+    m_damageMonitor = new DamageMonitor;
+    QVERIFY(Test::injectEffect(m_damageMonitor, QStringLiteral("damagemonitor")));
+}
+
+void X11DamageTest::init()
+{
+    m_connection.reset(xcb_connect(nullptr, nullptr));
+    QVERIFY(!xcb_connection_has_error(m_connection.data()));
+}
+
+void X11DamageTest::cleanup()
+{
+    const bool hadClients = !workspace()->clientList().isEmpty();
+    m_connection.reset();
+    if (hadClients) {
+        QTRY_VERIFY(workspace()->clientList().isEmpty());
+    }
+}
+
+Client *X11DamageTest::createClient(const QSize &size)
+{
+    QSignalSpy clientAddedSpy(workspace(), &Workspace::clientAdded);
+    if (!clientAddedSpy.isValid()) {
+        return nullptr;
+    }
+    const xcb_window_t w = xcb_generate_id(m_connection.data());
+    xcb_create_window(m_connection.data(), XCB_COPY_FROM_PARENT, w, rootWindow(),
+                      0, 0, size.width(), size.height(),
+                      0, XCB_WINDOW_CLASS_INPUT_OUTPUT, XCB_COPY_FROM_PARENT, 0, nullptr);
+    xcb_map_window(m_connection.data(), w);
+    xcb_flush(m_connection.data());
+    if (!clientAddedSpy.wait()) {
+        return nullptr;
+    }
+    return clientAddedSpy.first().first().value<Client *>();
+}
+
+void X11DamageTest::sendDamage(Client *client, const QRect &area)
+{
+    // the damage events as the X server reports them with the delta rectangles report level
+    xcb_damage_notify_event_t event;
+    memset(&event, 0, sizeof(event));
+    event.response_type = Xcb::Extensions::self()->damageNotifyEvent();
+    event.level = XCB_DAMAGE_REPORT_LEVEL_DELTA_RECTANGLES;
+    event.drawable = client->frameId();
+    event.area.x = area.x();
+    event.area.y = area.y();
+    event.area.width = area.width();
+    event.area.height = area.height();
+    workspace()->workspaceEvent(reinterpret_cast<xcb_generic_event_t *>(&event));
+}
+
+void X11DamageTest::testBatching()
+{
+    Client *client = createClient();
+    QVERIFY(client);
+    QTRY_COMPARE(Compositor::self()->pendingRepaints(), QRegion());
+    QSignalSpy damagedSpy(client, &Toplevel::damaged);
+    QVERIFY(damagedSpy.isValid());
+
+    // the notifies are only collected, nothing is applied before the next frame
+    const QRegion before = client->damage();
+    sendDamage(client, QRect(0, 0, 10, 10));
+    sendDamage(client, QRect(50, 50, 20, 10));
+    sendDamage(client, QRect(5, 5, 10, 10));
+    QCOMPARE(damagedSpy.count(), 3);
+    QCOMPARE(damagedSpy.at(1).at(1).toRect(), QRect(50, 50, 20, 10));
+    QCOMPARE(client->damage(), before);
+
+    // the frame applies all of them at once
+    const QRegion expected = QRegion(0, 0, 10, 10) | QRegion(50, 50, 20, 10) | QRegion(5, 5, 10, 10);
+    QVERIFY(client->applyPendingDamage());
+    QCOMPARE(client->damage(), before | expected);
+    QVERIFY(!client->applyPendingDamage());
+    QCOMPARE(client->damage(), before | expected);
+}
+
+void X11DamageTest::testMergeSmallUpdates()
+{
+    Client *client = createClient();
+    QVERIFY(client);
+    QTRY_COMPARE(Compositor::self()->pendingRepaints(), QRegion());
+
+    // a client drawing many separate small areas, e.g. a terminal updating single cells
+    const QRegion before = client->damage();
+    QRect bounds;
+    for (int i = 0; i < 20; ++i) {
+        const QRect cell((i % 5) * 30, (i / 5) * 30, 8, 12);
+        sendDamage(client, cell);
+        bounds |= cell;
+    }
+    QVERIFY(client->applyPendingDamage());
+    // they are tracked as their bounding rect instead of a complex region
+    QCOMPARE(client->damage(), before | bounds);
+}
+
+void X11DamageTest::testOccludedDamageSpam()
+{
+    // a window which keeps drawing while it is covered by a bigger one
+    Client *client = createClient();
+    QVERIFY(client);
+    Client *cover = createClient(QSize(600, 600));
+    QVERIFY(cover);
+    client->move(QPoint(300, 300));
+    cover->move(QPoint(100, 100));
+    workspace()->raiseClient(cover);
+    QTRY_VERIFY(client->isOccluded());
+    QTRY_COMPARE(Compositor::self()->pendingRepaints(), QRegion());
+
+    const QRegion before = client->damage();
+    QRect bounds;
+    for (int i = 0; i < 1000; ++i) {
+        const QRect cell((i % 10) * 10, (i / 10 % 10) * 10, 5, 5);
+        sendDamage(client, cell);
+        bounds |= cell;
+    }
+    QVERIFY(!before.intersects(bounds));
+
+    // frames which do not expose the window leave its damage pending
+    Compositor::self()->addRepaint(QRect(1200, 1000, 10, 10));
+    QTRY_COMPARE(Compositor::self()->pendingRepaints(), QRegion());
+    QVERIFY(client->isOccluded());
+    QCOMPARE(client->damage(), before);
+    QVERIFY(!client->applyPendingDamage());
+    QCOMPARE(client->damage(), before);
+
+    // the frame which exposes the window paints it with the damage applied
+    QSignalSpy prePaintedSpy(m_damageMonitor, &DamageMonitor::windowPrePainted);
+    QVERIFY(prePaintedSpy.isValid());
+    m_damageMonitor->setWindow(client);
+    cover->move(QPoint(700, 100));
+    QVERIFY(prePaintedSpy.wait());
+    m_damageMonitor->setWindow(nullptr);
+    QVERIFY(!client->isOccluded());
+    QCOMPARE(QRegion(bounds) - prePaintedSpy.first().first().value<QRegion>(), QRegion());
+}
+
+WAYLANDTEST_MAIN(X11DamageTest)
+#include "x11_damage_test.moc"
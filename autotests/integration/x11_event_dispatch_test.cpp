@@ -0,0 +1,249 @@
+/********************************************************************
+KWin - the KDE window manager
+This file is part of the KDE project.
+
+Copyright (C) 2019 KWin-lowlatency developers
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "kwin_wayland_test.h"
+#include "client.h"
+#include "platform.h"
+#include "wayland_server.h"
+#include "workspace.h"
+#include "x11eventfilter.h"
+
+#include <xcb/xcb.h>
+
+using namespace KWin;
+static const QString s_socketName = QStringLiteral("wayland_test_x11_event_dispatch-0");
+
+class CountingFilter : public X11EventFilter
+{
+public:
+    explicit CountingFilter(int eventType)
+        : X11EventFilter(eventType)
+    {
+    }
+    CountingFilter(int extension, int genericEventType)
+        : X11EventFilter(XCB_GE_GENERIC, extension, genericEventType)
+    {
+    }
+
+    bool event(xcb_generic_event_t *event) override {
+        Q_UNUSED(event)
+        ++count;
+        return true;
+    }
+
+    int count = 0;
+};
+
+struct XcbConnectionDeleter
+{
+    static inline void cleanup(xcb_connection_t *pointer)
+    {
+        xcb_disconnect(pointer);
+    }
+};
+
+class X11EventDispatchTest : public QObject
+{
+Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testEventFilter();
+    void testGenericEventFilter();
+    void benchmarkReplay_data();
+    void benchmarkReplay();
+
+private:
+    QVector<Client *> createClients(int count);
+
+    QScopedPointer<xcb_connection_t, XcbConnectionDeleter> m_connection;
+};
+
+void X11EventDispatchTest::initTestCase()
+{
+    qRegisterMetaType<KWin::Client*>();
+    QSignalSpy workspaceCreatedSpy(kwinApp(), &Application::workspaceCreated);
+    QVERIFY(workspaceCreatedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName.toLocal8Bit()));
+    kwinApp()->setConfig(KSharedConfig::openConfig(QString(), KConfig::SimpleConfig));
+
+    kwinApp()->start();
+    QVERIFY(workspaceCreatedSpy.wait());
+    waylandServer()->initWorkspace();
+}
+
+void X11EventDispatchTest::init()
+{
+    m_connection.reset(xcb_connect(nullptr, nullptr));
+    QVERIFY(!xcb_connection_has_error(m_connection.data()));
+}
+
+void X11EventDispatchTest::cleanup()
+{
+    const bool hadClients = !workspace()->clientList().isEmpty();
+    m_connection.reset();
+    if (hadClients) {
+        QTRY_VERIFY(workspace()->clientList().isEmpty());
+    }
+}
+
+QVector<Client *> X11EventDispatchTest::createClients(int count)
+{
+    QSignalSpy clientAddedSpy(workspace(), &Workspace::clientAdded);
+    QVector<Client *> clients;
+    if (!clientAddedSpy.isValid()) {
+        return clients;
+    }
+    for (int i = 0; i < count; ++i) {
+        const xcb_window_t w = xcb_generate_id(m_connection.data());
+        xcb_create_window(m_connection.data(), XCB_COPY_FROM_PARENT, w, rootWindow(),
+                          (i % 10) * 100, (i / 10) * 100, 100, 100,
+                          0, XCB_WINDOW_CLASS_INPUT_OUTPUT, XCB_COPY_FROM_PARENT, 0, nullptr);
+        xcb_map_window(m_connection.data(), w);
+    }
+    xcb_flush(m_connection.data());
+    while (clientAddedSpy.count() < count) {
+        if (!clientAddedSpy.wait()) {
+            return clients;
+        }
+    }
+    for (const QList<QVariant> &arguments : clientAddedSpy) {
+        clients << arguments.first().value<Client *>();
+    }
+    return clients;
+}
+
+void X11EventDispatchTest::testEventFilter()
+{
+    // gravity notify events are not handled by anything else
+    xcb_gravity_notify_event_t event;
+    memset(&event, 0, sizeof(event));
+    event.response_type = XCB_GRAVITY_NOTIFY;
+    event.window = rootWindow();
+    auto *e = reinterpret_cast<xcb_generic_event_t *>(&event);
+    QVERIFY(!workspace()->workspaceEvent(e));
+
+    QScopedPointer<CountingFilter> filter(new CountingFilter(XCB_GRAVITY_NOTIFY));
+    QScopedPointer<CountingFilter> otherFilter(new CountingFilter(XCB_CIRCULATE_NOTIFY));
+    QVERIFY(workspace()->workspaceEvent(e));
+    QCOMPARE(filter->count, 1);
+    QCOMPARE(otherFilter->count, 0);
+
+    // the sent flag does not change the event type
+    event.response_type = XCB_GRAVITY_NOTIFY | 0x80;
+    QVERIFY(workspace()->workspaceEvent(e));
+    QCOMPARE(filter->count, 2);
+
+    filter.reset();
+    QVERIFY(!workspace()->workspaceEvent(e));
+    QCOMPARE(otherFilter->count, 0);
+}
+
+void X11EventDispatchTest::testGenericEventFilter()
+{
+    xcb_ge_generic_event_t event;
+    memset(&event, 0, sizeof(event));
+    event.response_type = XCB_GE_GENERIC;
+    event.extension = 200;
+    event.event_type = 7;
+    auto *e = reinterpret_cast<xcb_generic_event_t *>(&event);
+    QVERIFY(!workspace()->workspaceEvent(e));
+
+    QScopedPointer<CountingFilter> filter(new CountingFilter(200, 7));
+    QScopedPointer<CountingFilter> otherType(new CountingFilter(200, 8));
+    QScopedPointer<CountingFilter> otherExtension(new CountingFilter(201, 7));
+    QVERIFY(workspace()->workspaceEvent(e));
+    QCOMPARE(filter->count, 1);
+    QCOMPARE(otherType->count, 0);
+    QCOMPARE(otherExtension->count, 0);
+
+    filter.reset();
+    QVERIFY(!workspace()->workspaceEvent(e));
+}
+
+void X11EventDispatchTest::benchmarkReplay_data()
+{
+    QTest::addColumn<int>("clientCount");
+
+    QTest::newRow("10") << 10;
+    QTest::newRow("50") << 50;
+}
+
+void X11EventDispatchTest::benchmarkReplay()
+{
+    // A stream like the ones recorded while moving the pointer over a busy desktop: mostly
+    // motion on the frames, property changes on the clients and events for windows
+    // KWin does not manage.
+    QFETCH(int, clientCount);
+    const QVector<Client *> clients = createClients(clientCount);
+    QCOMPARE(clients.count(), clientCount);
+
+    xcb_intern_atom_cookie_t cookie = xcb_intern_atom(m_connection.data(), false, 20, "_KWIN_BENCHMARK_ATOM");
+    QScopedPointer<xcb_intern_atom_reply_t, QScopedPointerPodDeleter> atom(xcb_intern_atom_reply(m_connection.data(), cookie, nullptr));
+    QVERIFY(!atom.isNull());
+
+    QVector<xcb_generic_event_t> stream;
+    for (int i = 0; i < 1000; ++i) {
+        const Client *client = clients.at((i * 7) % clients.count());
+        xcb_generic_event_t event;
+        memset(&event, 0, sizeof(event));
+        switch (i % 10) {
+        case 7:
+        case 8: {
+            auto *property = reinterpret_cast<xcb_property_notify_event_t *>(&event);
+            property->response_type = XCB_PROPERTY_NOTIFY;
+            property->window = client->window();
+            property->atom = atom->atom;
+            property->state = XCB_PROPERTY_NEW_VALUE;
+            break;
+        }
+        case 9: {
+            auto *visibility = reinterpret_cast<xcb_visibility_notify_event_t *>(&event);
+            visibility->response_type = XCB_VISIBILITY_NOTIFY;
+            visibility->window = xcb_generate_id(m_connection.data());
+            break;
+        }
+        default: {
+            auto *motion = reinterpret_cast<xcb_motion_notify_event_t *>(&event);
+            motion->response_type = XCB_MOTION_NOTIFY;
+            motion->event = client->frameId();
+            motion->root = rootWindow();
+            motion->event_x = i % 100;
+            motion->event_y = (i / 10) % 100;
+            motion->root_x = client->x() + motion->event_x;
+            motion->root_y = client->y() + motion->event_y;
+            motion->same_screen = 1;
+            break;
+        }
+        }
+        stream << event;
+    }
+
+    QBENCHMARK {
+        for (xcb_generic_event_t &event : stream) {
+            workspace()->workspaceEvent(&event);
+        }
+    }
+}
+
+WAYLANDTEST_MAIN(X11EventDispatchTest)
+#include "x11_event_dispatch_test.moc"
@@ -0,0 +1,188 @@
+/********************************************************************
+KWin - the KDE window manager
+This file is part of the KDE project.
+
+Copyright (C) 2019 KWin-lowlatency developers
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "kwin_wayland_test.h"
+#include "client.h"
+#include "platform.h"
+#include "wayland_server.h"
+#include "workspace.h"
+
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QTimer>
+
+#include <xcb/xcb.h>
+#include <xcb/shape.h>
+
+using namespace KWin;
+static const QString s_socketName = QStringLiteral("wayland_test_x11_manage-0");
+
+struct XcbConnectionDeleter
+{
+    static inline void cleanup(xcb_connection_t *pointer)
+    {
+        xcb_disconnect(pointer);
+    }
+};
+
+class X11ManageTest : public QObject
+{
+Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testShaped_data();
+    void testShaped();
+    void benchmarkTimeToFirstPaint_data();
+    void benchmarkTimeToFirstPaint();
+
+private:
+    xcb_window_t createWindow(int index);
+
+    QScopedPointer<xcb_connection_t, XcbConnectionDeleter> m_connection;
+};
+
+void X11ManageTest::initTestCase()
+{
+    qRegisterMetaType<KWin::Client*>();
+    QSignalSpy workspaceCreatedSpy(kwinApp(), &Application::workspaceCreated);
+    QVERIFY(workspaceCreatedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName.toLocal8Bit()));
+    kwinApp()->setConfig(KSharedConfig::openConfig(QString(), KConfig::SimpleConfig));
+
+    kwinApp()->start();
+    QVERIFY(workspaceCreatedSpy.wait());
+    waylandServer()->initWorkspace();
+}
+
+void X11ManageTest::init()
+{
+    m_connection.reset(xcb_connect(nullptr, nullptr));
+    QVERIFY(!xcb_connection_has_error(m_connection.data()));
+}
+
+void X11ManageTest::cleanup()
+{
+    const bool hadClients = !workspace()->clientList().isEmpty();
+    m_connection.reset();
+    if (hadClients) {
+        QTRY_VERIFY(workspace()->clientList().isEmpty());
+    }
+}
+
+xcb_window_t X11ManageTest::createWindow(int index)
+{
+    const xcb_window_t w = xcb_generate_id(m_connection.data());
+    xcb_create_window(m_connection.data(), XCB_COPY_FROM_PARENT, w, rootWindow(),
+                      (index % 10) * 100, (index / 10 % 10) * 100, 100, 100,
+                      0, XCB_WINDOW_CLASS_INPUT_OUTPUT, XCB_COPY_FROM_PARENT, 0, nullptr);
+    return w;
+}
+
+void X11ManageTest::testShaped_data()
+{
+    QTest::addColumn<bool>("shaped");
+
+    QTest::newRow("rectangular") << false;
+    QTest::newRow("shaped") << true;
+}
+
+void X11ManageTest::testShaped()
+{
+    // the shape is requested together with the other properties of a new window
+    QFETCH(bool, shaped);
+    QSignalSpy clientAddedSpy(workspace(), &Workspace::clientAdded);
+    QVERIFY(clientAddedSpy.isValid());
+
+    const xcb_window_t w = createWindow(0);
+    if (shaped) {
+        const xcb_rectangle_t rects[] = {
+            { 0, 0, 50, 100 },
+            { 50, 50, 50, 50 }
+        };
+        xcb_shape_rectangles(m_connection.data(), XCB_SHAPE_SO_SET, XCB_SHAPE_SK_BOUNDING,
+                             XCB_CLIP_ORDERING_UNSORTED, w, 0, 0, 2, rects);
+    }
+    xcb_map_window(m_connection.data(), w);
+    xcb_flush(m_connection.data());
+
+    QVERIFY(clientAddedSpy.wait());
+    Client *client = clientAddedSpy.first().first().value<Client *>();
+    QVERIFY(client);
+    QCOMPARE(client->window(), w);
+    QCOMPARE(client->shape(), shaped);
+}
+
+void X11ManageTest::benchmarkTimeToFirstPaint_data()
+{
+    QTest::addColumn<int>("count");
+
+    QTest::newRow("1") << 1;
+    QTest::newRow("10") << 10;
+    QTest::newRow("100") << 100;
+}
+
+void X11ManageTest::benchmarkTimeToFirstPaint()
+{
+    // maps all windows at once and measures until the last of them is ready for painting,
+    // the unmapping of the windows must not be part of the result
+    QFETCH(int, count);
+    QVector<xcb_window_t> windows;
+    for (int i = 0; i < count; ++i) {
+        windows << createWindow(i);
+    }
+    xcb_flush(m_connection.data());
+
+    int shown = 0;
+    QEventLoop loop;
+    QTimer::singleShot(30000, &loop, &QEventLoop::quit);
+    connect(workspace(), &Workspace::clientAdded, &loop,
+        [&shown, &loop, count] (Client *client) {
+            auto windowShown = [&shown, &loop, count] {
+                if (++shown == count) {
+                    loop.quit();
+                }
+            };
+            if (client->readyForPainting()) {
+                windowShown();
+            } else {
+                connect(client, &Toplevel::windowShown, &loop, windowShown);
+            }
+        }
+    );
+
+    QElapsedTimer timer;
+    timer.start();
+    for (xcb_window_t w : windows) {
+        xcb_map_window(m_connection.data(), w);
+    }
+    xcb_flush(m_connection.data());
+    if (shown < count) {
+        loop.exec();
+    }
+    const qint64 elapsed = timer.elapsed();
+    QCOMPARE(shown, count);
+    QTest::setBenchmarkResult(elapsed, QTest::WalltimeMilliseconds);
+}
+
+WAYLANDTEST_MAIN(X11ManageTest)
+#include "x11_manage_test.moc"
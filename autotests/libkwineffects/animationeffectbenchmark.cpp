@@ -0,0 +1,119 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2019 KWin-lowlatency developers
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+
+#include "../mock_effectshandler.h"
+#include "../mock_effectwindow.h"
+
+#include <kwinanimationeffect.h>
+
+#include <QtTest>
+
+using namespace KWin;
+using namespace std::chrono_literals;
+
+class BenchmarkAnimationEffect : public AnimationEffect
+{
+    Q_OBJECT
+public:
+    using AnimationEffect::animate;
+};
+
+class AnimationEffectBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void benchmarkFrame_data();
+    void benchmarkFrame();
+
+private:
+    MockEffectsHandler *m_effects = nullptr;
+};
+
+void AnimationEffectBenchmark::initTestCase()
+{
+    m_effects = new MockEffectsHandler(KWin::XRenderCompositing);
+}
+
+void AnimationEffectBenchmark::cleanupTestCase()
+{
+    delete m_effects;
+    m_effects = nullptr;
+}
+
+void AnimationEffectBenchmark::benchmarkFrame_data()
+{
+    QTest::addColumn<int>("windowCount");
+    QTest::addColumn<int>("screenCount");
+
+    QTest::newRow("10 windows") << 10 << 1;
+    QTest::newRow("100 windows") << 100 << 1;
+    QTest::newRow("100 windows, 3 screens") << 100 << 3;
+}
+
+void AnimationEffectBenchmark::benchmarkFrame()
+{
+    // a desktop switch: every window fades, scales, slides and squashes at the same time
+    QFETCH(int, windowCount);
+    QFETCH(int, screenCount);
+
+    QVector<MockEffectWindow*> windows;
+    for (int i = 0; i < windowCount; ++i) {
+        windows << new MockEffectWindow();
+    }
+
+    BenchmarkAnimationEffect *effect = new BenchmarkAnimationEffect;
+    for (MockEffectWindow *w : qAsConst(windows)) {
+        // long enough to stay running for the whole benchmark
+        effect->animate(w, AnimationEffect::Opacity, 0, 3600000, FPx2(1.0), QEasingCurve::OutCubic, 0, FPx2(0.0));
+        effect->animate(w, AnimationEffect::Scale, 0, 3600000, FPx2(1.0), QEasingCurve::OutBack, 0, FPx2(0.8));
+        effect->animate(w, AnimationEffect::Translation, 0, 3600000, FPx2(0.0, 0.0), QEasingCurve::InOutQuad, 0, FPx2(200.0, 0.0));
+        effect->animate(w, AnimationEffect::Brightness, 0, 3600000, FPx2(1.0), QEasingCurve::Linear, 0, FPx2(0.5));
+    }
+    QVERIFY(effect->isActive());
+
+    std::chrono::nanoseconds presentationTime = 1s;
+    QBENCHMARK {
+        presentationTime += 16666667ns;
+        m_effects->setPresentationTime(presentationTime);
+
+        ScreenPrePaintData screenData;
+        effect->prePaintScreen(screenData, 16);
+        for (int screen = 0; screen < screenCount; ++screen) {
+            for (MockEffectWindow *w : qAsConst(windows)) {
+                WindowPrePaintData prePaintData;
+                prePaintData.mask = 0;
+                effect->prePaintWindow(w, prePaintData, 16);
+                WindowPaintData paintData(w);
+                effect->paintWindow(w, 0, QRegion(0, 0, 100, 100), paintData);
+            }
+        }
+        effect->postPaintScreen();
+    }
+    QVERIFY(effect->isActive());
+
+    delete effect;
+    qDeleteAll(windows);
+}
+
+QTEST_MAIN(AnimationEffectBenchmark)
+#include "animationeffectbenchmark.moc"
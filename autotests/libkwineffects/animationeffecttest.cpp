@@ -0,0 +1,285 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2019 KWin-lowlatency developers
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+
+#include "../mock_effectshandler.h"
+#include "../mock_effectwindow.h"
+
+#include <kwinanimationeffect.h>
+
+#include <QtTest>
+
+using namespace KWin;
+using namespace std::chrono_literals;
+
+class TestAnimationEffect : public AnimationEffect
+{
+    Q_OBJECT
+public:
+    using AnimationEffect::animate;
+    using AnimationEffect::set;
+    using AnimationEffect::cancel;
+};
+
+/**
+ * The outcome of painting a window through the effect.
+ **/
+struct PaintResult
+{
+    bool translucent;
+    bool transformed;
+    qreal opacity;
+    qreal brightness;
+    qreal saturation;
+    qreal xTranslation;
+    qreal yTranslation;
+    qreal xScale;
+    qreal yScale;
+};
+
+class AnimationEffectTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void init();
+    void cleanup();
+
+    void testRunning();
+    void testDelayed();
+    void testFinished();
+    void testCancelled();
+
+private:
+    void startFrame(std::chrono::nanoseconds presentationTime);
+    void endFrame();
+    PaintResult paint(MockEffectWindow *w);
+
+    MockEffectsHandler *m_effects = nullptr;
+    TestAnimationEffect *m_effect = nullptr;
+};
+
+void AnimationEffectTest::initTestCase()
+{
+    m_effects = new MockEffectsHandler(KWin::XRenderCompositing);
+}
+
+void AnimationEffectTest::cleanupTestCase()
+{
+    delete m_effects;
+    m_effects = nullptr;
+}
+
+void AnimationEffectTest::init()
+{
+    m_effect = new TestAnimationEffect;
+}
+
+void AnimationEffectTest::cleanup()
+{
+    delete m_effect;
+    m_effect = nullptr;
+}
+
+void AnimationEffectTest::startFrame(std::chrono::nanoseconds presentationTime)
+{
+    m_effects->setPresentationTime(presentationTime);
+    ScreenPrePaintData data;
+    m_effect->prePaintScreen(data, 16);
+}
+
+void AnimationEffectTest::endFrame()
+{
+    m_effect->postPaintScreen();
+}
+
+PaintResult AnimationEffectTest::paint(MockEffectWindow *w)
+{
+    WindowPrePaintData prePaintData;
+    prePaintData.mask = 0;
+    m_effect->prePaintWindow(w, prePaintData, 16);
+    WindowPaintData data(w);
+    m_effect->paintWindow(w, prePaintData.mask, QRegion(0, 0, 100, 100), data);
+    return PaintResult{bool(prePaintData.mask & Effect::PAINT_WINDOW_TRANSLUCENT),
+                       bool(prePaintData.mask & Effect::PAINT_WINDOW_TRANSFORMED),
+                       data.opacity(), data.brightness(), data.saturation(),
+                       data.xTranslation(), data.yTranslation(), data.xScale(), data.yScale()};
+}
+
+void AnimationEffectTest::testRunning()
+{
+    // the values are interpolated linearly, each attribute on its own
+    MockEffectWindow w;
+    MockEffectWindow other;
+    m_effect->animate(&w, AnimationEffect::Opacity, 0, 1000, FPx2(0.5), QEasingCurve::Linear, 0, FPx2(1.0));
+    m_effect->animate(&w, AnimationEffect::Brightness, 0, 1000, FPx2(0.5), QEasingCurve::Linear, 0, FPx2(1.0));
+    m_effect->animate(&w, AnimationEffect::Saturation, 0, 1000, FPx2(0.0), QEasingCurve::Linear, 0, FPx2(1.0));
+    m_effect->animate(&w, AnimationEffect::Translation, 0, 1000, FPx2(100.0, -40.0), QEasingCurve::Linear, 0, FPx2(0.0, 0.0));
+    m_effect->animate(&w, AnimationEffect::Scale, 0, 1000, FPx2(0.5), QEasingCurve::Linear, 0, FPx2(1.0));
+    m_effect->animate(&other, AnimationEffect::Opacity, 0, 500, FPx2(0.0), QEasingCurve::Linear, 0, FPx2(1.0));
+    QVERIFY(m_effect->isActive());
+
+    // the first frame starts the time lines
+    startFrame(1s);
+    PaintResult result = paint(&w);
+    QVERIFY(result.translucent);
+    QVERIFY(result.transformed);
+    QCOMPARE(result.opacity, 1.0);
+    QCOMPARE(result.brightness, 1.0);
+    QCOMPARE(result.saturation, 1.0);
+    QCOMPARE(result.xTranslation, 0.0);
+    QCOMPARE(result.yTranslation, 0.0);
+    QCOMPARE(result.xScale, 1.0);
+    QCOMPARE(result.yScale, 1.0);
+    endFrame();
+
+    startFrame(1250ms);
+    result = paint(&w);
+    QVERIFY(result.translucent);
+    QVERIFY(result.transformed);
+    QCOMPARE(result.opacity, 0.875);
+    QCOMPARE(result.brightness, 0.875);
+    QCOMPARE(result.saturation, 0.75);
+    QCOMPARE(result.xTranslation, 25.0);
+    QCOMPARE(result.yTranslation, -10.0);
+    QCOMPARE(result.xScale, 0.875);
+    QCOMPARE(result.yScale, 0.875);
+    // windows do not see the animations of each other
+    result = paint(&other);
+    QVERIFY(result.translucent);
+    QVERIFY(!result.transformed);
+    QCOMPARE(result.opacity, 0.5);
+    QCOMPARE(result.brightness, 1.0);
+    QCOMPARE(result.xTranslation, 0.0);
+    endFrame();
+}
+
+void AnimationEffectTest::testDelayed()
+{
+    // a delayed animation with a start value waits at it, one without is not applied yet
+    MockEffectWindow waiting;
+    MockEffectWindow pending;
+    m_effect->animate(&waiting, AnimationEffect::Opacity, 0, 1000, FPx2(0.0), QEasingCurve::Linear, 3600000, FPx2(0.5));
+    m_effect->animate(&waiting, AnimationEffect::Saturation, 0, 1000, FPx2(1.0), QEasingCurve::Linear, 3600000, FPx2(0.25));
+    m_effect->animate(&waiting, AnimationEffect::Translation, 0, 1000, FPx2(0.0, 0.0), QEasingCurve::Linear, 3600000, FPx2(20.0, 30.0));
+    m_effect->animate(&pending, AnimationEffect::Opacity, 0, 1000, FPx2(0.0), QEasingCurve::Linear, 3600000);
+
+    for (auto time : {1000ms, 1500ms, 2000ms}) {
+        startFrame(time);
+        PaintResult result = paint(&waiting);
+        QVERIFY(result.translucent);
+        QVERIFY(result.transformed);
+        QCOMPARE(result.opacity, 0.5);
+        QCOMPARE(result.brightness, 1.0);
+        QCOMPARE(result.saturation, 0.25);
+        QCOMPARE(result.xTranslation, 20.0);
+        QCOMPARE(result.yTranslation, 30.0);
+
+        result = paint(&pending);
+        QVERIFY(!result.translucent);
+        QVERIFY(!result.transformed);
+        QCOMPARE(result.opacity, 1.0);
+        endFrame();
+    }
+    QVERIFY(m_effect->isActive());
+}
+
+void AnimationEffectTest::testFinished()
+{
+    // a finished animation is gone, a persistent one is kept at its target
+    MockEffectWindow w;
+    m_effect->animate(&w, AnimationEffect::Opacity, 0, 100, FPx2(0.5), QEasingCurve::Linear, 0, FPx2(1.0));
+    m_effect->set(&w, AnimationEffect::Brightness, 0, 100, FPx2(0.5), QEasingCurve::Linear, 0, FPx2(1.0));
+    m_effect->set(&w, AnimationEffect::Translation, 0, 100, FPx2(8.0, 4.0), QEasingCurve::Linear, 0, FPx2(0.0, 0.0));
+
+    startFrame(1s);
+    endFrame();
+    startFrame(1050ms);
+    PaintResult result = paint(&w);
+    QCOMPARE(result.opacity, 0.75);
+    QCOMPARE(result.brightness, 0.75);
+    QCOMPARE(result.xTranslation, 4.0);
+    QCOMPARE(result.yTranslation, 2.0);
+    endFrame();
+
+    for (auto time : {1200ms, 1300ms}) {
+        startFrame(time);
+        result = paint(&w);
+        QVERIFY(!result.translucent);
+        QVERIFY(result.transformed);
+        QCOMPARE(result.opacity, 1.0);
+        QCOMPARE(result.brightness, 0.5);
+        QCOMPARE(result.saturation, 1.0);
+        QCOMPARE(result.xTranslation, 8.0);
+        QCOMPARE(result.yTranslation, 4.0);
+        endFrame();
+    }
+    QVERIFY(m_effect->isActive());
+}
+
+void AnimationEffectTest::testCancelled()
+{
+    // cancelling takes effect right away, even within a frame
+    MockEffectWindow w;
+    MockEffectWindow other;
+    const quint64 opacity = m_effect->animate(&w, AnimationEffect::Opacity, 0, 1000, FPx2(0.5), QEasingCurve::Linear, 0, FPx2(1.0));
+    const quint64 translation = m_effect->animate(&w, AnimationEffect::Translation, 0, 1000, FPx2(100.0, -40.0), QEasingCurve::Linear, 0, FPx2(0.0, 0.0));
+    const quint64 otherOpacity = m_effect->animate(&other, AnimationEffect::Opacity, 0, 1000, FPx2(0.0), QEasingCurve::Linear, 0, FPx2(1.0));
+
+    startFrame(1s);
+    endFrame();
+    startFrame(1250ms);
+    PaintResult result = paint(&w);
+    QCOMPARE(result.opacity, 0.875);
+    QCOMPARE(result.xTranslation, 25.0);
+
+    QVERIFY(m_effect->cancel(opacity));
+    result = paint(&w);
+    QVERIFY(!result.translucent);
+    QVERIFY(result.transformed);
+    QCOMPARE(result.opacity, 1.0);
+    QCOMPARE(result.xTranslation, 25.0);
+    QCOMPARE(result.yTranslation, -10.0);
+    result = paint(&other);
+    QCOMPARE(result.opacity, 0.75);
+    endFrame();
+
+    QVERIFY(m_effect->cancel(translation));
+    QVERIFY(!m_effect->cancel(opacity));
+    startFrame(1500ms);
+    result = paint(&w);
+    QVERIFY(!result.translucent);
+    QVERIFY(!result.transformed);
+    QCOMPARE(result.opacity, 1.0);
+    QCOMPARE(result.xTranslation, 0.0);
+    QCOMPARE(result.yTranslation, 0.0);
+    result = paint(&other);
+    QCOMPARE(result.opacity, 0.5);
+    endFrame();
+
+    QVERIFY(m_effect->cancel(otherOpacity));
+    QVERIFY(!m_effect->isActive());
+    result = paint(&other);
+    QVERIFY(!result.translucent);
+    QCOMPARE(result.opacity, 1.0);
+}
+
+QTEST_MAIN(AnimationEffectTest)
+#include "animationeffecttest.moc"
@@ -0,0 +1,228 @@
+/********************************************************************
+KWin - the KDE window manager
+This file is part of the KDE project.
+
+Copyright (C) 2019 KWin-lowlatency developers
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "mock_gl.h"
+#include "../../libkwineffects/kwinglshadercache_p.h"
+#include <QTest>
+#include <kwinglplatform.h>
+#include <kwinglutils.h>
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QStandardPaths>
+
+using namespace KWin;
+
+void KWin::cleanupGL()
+{
+    GLPlatform::cleanup();
+}
+
+bool KWin::hasGLVersion(int major, int minor, int release)
+{
+    return GLPlatform::instance()->glVersion() >= kVersionNumber(major, minor, release);
+}
+
+bool KWin::hasGLExtension(const QByteArray &extension)
+{
+    return s_gl && s_gl->getString.extensions.contains(extension);
+}
+
+static QString cacheBase()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QStringLiteral("/kwin/shaders");
+}
+
+class GLShaderCacheTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testUnsupported();
+    void testMiss();
+    void testHit();
+    void testRejected();
+    void testOtherDriverKept();
+    void testStaleDirectories();
+
+private:
+    void detect(const QByteArray &renderer);
+    bool createDirectory(const QString &name, const QDateTime &lastUsed);
+};
+
+void GLShaderCacheTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+void GLShaderCacheTest::init()
+{
+    QDir(cacheBase()).removeRecursively();
+    s_gl = new MockGL;
+    s_gl->program.formats = 1;
+    detect(QByteArrayLiteral("Mesa DRI Intel(R) HD Graphics 620 (Kaby Lake GT2)"));
+}
+
+void GLShaderCacheTest::cleanup()
+{
+    cleanupGL();
+    delete s_gl;
+    s_gl = nullptr;
+    QDir(cacheBase()).removeRecursively();
+}
+
+void GLShaderCacheTest::detect(const QByteArray &renderer)
+{
+    GLPlatform::cleanup();
+    s_gl->getString.vendor = QByteArrayLiteral("Intel Open Source Technology Center");
+    s_gl->getString.renderer = renderer;
+    s_gl->getString.version = QByteArrayLiteral("4.5 (Core Profile) Mesa 18.3.0");
+    s_gl->getString.shadingLanguageVersion = QByteArrayLiteral("4.50");
+    s_gl->getString.extensions = QVector<QByteArray>{QByteArrayLiteral("GL_ARB_get_program_binary")};
+    GLPlatform::instance()->detect(EglPlatformInterface);
+}
+
+bool GLShaderCacheTest::createDirectory(const QString &name, const QDateTime &lastUsed)
+{
+    const QString path = cacheBase() + QLatin1Char('/') + name;
+    if (!QDir().mkpath(path)) {
+        return false;
+    }
+    QFile entry(path + QStringLiteral("/0123456789abcdef0123456789abcdef01234567"));
+    if (!entry.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    QFile stamp(path + QStringLiteral("/last-used"));
+    if (!stamp.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    return stamp.setFileTime(lastUsed, QFileDevice::FileModificationTime);
+}
+
+void GLShaderCacheTest::testUnsupported()
+{
+    // without any binary format there is nothing that could be stored
+    s_gl->program.formats = 0;
+    ShaderCache cache;
+    QVERIFY(!cache.isValid());
+    QVERIFY(!cache.load(1, cache.key(QByteArrayLiteral("sources"))));
+}
+
+void GLShaderCacheTest::testMiss()
+{
+    ShaderCache cache;
+    QVERIFY(cache.isValid());
+    QVERIFY(QDir(cache.directory()).exists());
+    QVERIFY(!cache.load(1, cache.key(QByteArrayLiteral("sources"))));
+    QVERIFY(s_gl->program.loaded.isEmpty());
+}
+
+void GLShaderCacheTest::testHit()
+{
+    s_gl->program.format = 42;
+    s_gl->program.binary = QByteArrayLiteral("linked program");
+    QByteArray key;
+    {
+        ShaderCache cache;
+        QVERIFY(cache.isValid());
+        key = cache.key(QByteArrayLiteral("sources"));
+        cache.prepare(1);
+        cache.store(1, key);
+        QVERIFY(QFile::exists(cache.directory() + QLatin1Char('/') + QString::fromLatin1(key)));
+    }
+
+    // the next start loads the program from the disk
+    ShaderCache cache;
+    QVERIFY(cache.load(2, key));
+    QCOMPARE(s_gl->program.loaded, QByteArrayLiteral("linked program"));
+    QVERIFY(!cache.load(2, cache.key(QByteArrayLiteral("other sources"))));
+}
+
+void GLShaderCacheTest::testRejected()
+{
+    s_gl->program.format = 42;
+    s_gl->program.binary = QByteArrayLiteral("linked program");
+    ShaderCache cache;
+    const QByteArray key = cache.key(QByteArrayLiteral("sources"));
+    cache.store(1, key);
+    const QString fileName = cache.directory() + QLatin1Char('/') + QString::fromLatin1(key);
+    QVERIFY(QFile::exists(fileName));
+
+    // the driver does not accept the format anymore, the entry gets discarded
+    s_gl->program.format = 43;
+    QVERIFY(!cache.load(2, key));
+    QCOMPARE(s_gl->program.loaded, QByteArrayLiteral("linked program"));
+    QVERIFY(!QFile::exists(fileName));
+}
+
+void GLShaderCacheTest::testOtherDriverKept()
+{
+    // e.g. a laptop with two GPUs, switching between them must not throw away the cache
+    s_gl->program.format = 42;
+    s_gl->program.binary = QByteArrayLiteral("linked program");
+    QString firstDirectory;
+    QByteArray key;
+    {
+        ShaderCache cache;
+        firstDirectory = cache.directory();
+        key = cache.key(QByteArrayLiteral("sources"));
+        cache.store(1, key);
+    }
+
+    detect(QByteArrayLiteral("AMD Radeon RX 560 Series (POLARIS11, DRM 3.27.0, 4.19.0, LLVM 7.0.0)"));
+    {
+        ShaderCache cache;
+        QVERIFY(cache.isValid());
+        QVERIFY(cache.directory() != firstDirectory);
+        QVERIFY(!cache.load(1, key));
+    }
+    QVERIFY(QFile::exists(firstDirectory + QLatin1Char('/') + QString::fromLatin1(key)));
+
+    detect(QByteArrayLiteral("Mesa DRI Intel(R) HD Graphics 620 (Kaby Lake GT2)"));
+    ShaderCache cache;
+    QCOMPARE(cache.directory(), firstDirectory);
+    QVERIFY(cache.load(1, key));
+}
+
+void GLShaderCacheTest::testStaleDirectories()
+{
+    const QDateTime now = QDateTime::currentDateTime();
+    QVERIFY(createDirectory(QStringLiteral("expired"), now.addDays(-60)));
+    QVERIFY(createDirectory(QStringLiteral("yesterday"), now.addDays(-1)));
+    QVERIFY(createDirectory(QStringLiteral("twodaysago"), now.addDays(-2)));
+    QVERIFY(createDirectory(QStringLiteral("lastweek"), now.addDays(-7)));
+
+    // the current directory and the two most recently used other ones are kept
+    ShaderCache cache;
+    QVERIFY(cache.isValid());
+    const QDir base(cacheBase());
+    QVERIFY(!base.exists(QStringLiteral("expired")));
+    QVERIFY(base.exists(QStringLiteral("yesterday")));
+    QVERIFY(base.exists(QStringLiteral("twodaysago")));
+    QVERIFY(!base.exists(QStringLiteral("lastweek")));
+    QVERIFY(QDir(cache.directory()).exists());
+    QCOMPARE(base.entryList(QDir::Dirs | QDir::NoDotAndDotDot).count(), 3);
+}
+
+QTEST_GUILESS_MAIN(GLShaderCacheTest)
+#include "kwinglshadercachetest.moc"
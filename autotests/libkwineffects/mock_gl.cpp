@@ -20,6 +20,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "mock_gl.h"
 #include <epoxy/gl.h>
 
+#include <cstring>
+
 MockGL *s_gl = nullptr;
 
 static const GLubyte *mock_glGetString(GLenum name)
@@ -63,8 +65,74 @@ static void mock_glGetIntegerv(GLenum pname, GLint *data)
             *data = s_gl->getString.extensions.count();
         }
     }
+    if (pname == GL_NUM_PROGRAM_BINARY_FORMATS) {
+        if (data && s_gl) {
+            *data = s_gl->program.formats;
+        }
+    }
+}
+
+static GLenum mock_glGetError()
+{
+    return GL_NO_ERROR;
+}
+
+static void mock_glProgramBinary(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length)
+{
+    Q_UNUSED(program)
+    if (!s_gl) {
+        return;
+    }
+    s_gl->program.loaded = QByteArray(static_cast<const char*>(binary), length);
+    s_gl->program.linked = binaryFormat == s_gl->program.format;
+}
+
+static void mock_glProgramParameteri(GLuint program, GLenum pname, GLint value)
+{
+    Q_UNUSED(program)
+    Q_UNUSED(pname)
+    Q_UNUSED(value)
+}
+
+static void mock_glGetProgramiv(GLuint program, GLenum pname, GLint *params)
+{
+    Q_UNUSED(program)
+    if (!s_gl || !params) {
+        return;
+    }
+    switch (pname) {
+    case GL_LINK_STATUS:
+        *params = s_gl->program.linked ? GL_TRUE : GL_FALSE;
+        break;
+    case GL_PROGRAM_BINARY_LENGTH:
+        *params = s_gl->program.binary.size();
+        break;
+    default:
+        break;
+    }
+}
+
+static void mock_glGetProgramBinary(GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary)
+{
+    Q_UNUSED(program)
+    if (!s_gl) {
+        return;
+    }
+    const GLsizei size = qMin(bufSize, GLsizei(s_gl->program.binary.size()));
+    memcpy(binary, s_gl->program.binary.constData(), size);
+    if (length) {
+        *length = size;
+    }
+    if (binaryFormat) {
+        *binaryFormat = s_gl->program.format;
+    }
 }
 
 PFNGLGETSTRINGPROC epoxy_glGetString = mock_glGetString;
 PFNGLGETSTRINGIPROC epoxy_glGetStringi = mock_glGetStringi;
 PFNGLGETINTEGERVPROC epoxy_glGetIntegerv = mock_glGetIntegerv;
+PFNGLGETERRORPROC epoxy_glGetError = mock_glGetError;
+PFNGLPROGRAMBINARYPROC epoxy_glProgramBinary = mock_glProgramBinary;
+PFNGLPROGRAMPARAMETERIPROC epoxy_glProgramParameteri = mock_glProgramParameteri;
+PFNGLGETPROGRAMIVPROC epoxy_glGetProgramiv = mock_glGetProgramiv;
+PFNGLGETPROGRAMBINARYPROC epoxy_glGetProgramBinary = mock_glGetProgramBinary;
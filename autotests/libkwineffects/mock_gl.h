@@ -32,6 +32,15 @@ struct MockGL {
         QByteArray extensionsString;
         QByteArray shadingLanguageVersion;
     } getString;
+    struct {
+        int formats = 0;
+        // the binary glGetProgramBinary returns
+        quint32 format = 0;
+        QByteArray binary;
+        // the binary last passed to glProgramBinary, which links if it has the format above
+        QByteArray loaded;
+        bool linked = false;
+    } program;
 };
 
 extern MockGL *s_gl;
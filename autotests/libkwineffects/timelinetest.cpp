@@ -35,6 +35,10 @@ private Q_SLOTS:
     void testUpdateForward();
     void testUpdateBackward();
     void testUpdateFinished();
+    void testAdvance();
+    void testAdvanceSamePresentationTime();
+    void testAdvanceSubMillisecond();
+    void testAdvanceAfterReset();
     void testToggleDirection();
     void testReset();
     void testSetElapsed_data();
@@ -127,6 +131,90 @@ void TimeLineTest::testUpdateFinished()
     QVERIFY(timeLine.done());
 }
 
+void TimeLineTest::testAdvance()
+{
+    KWin::TimeLine timeLine(1000ms, KWin::TimeLine::Forward);
+    timeLine.setEasingCurve(QEasingCurve::Linear);
+
+    // the first frame only starts the timeline
+    timeLine.advance(5000ms);
+    QCOMPARE(timeLine.value(), 0.0);
+    QVERIFY(!timeLine.done());
+
+    // 100/1000
+    timeLine.advance(5100ms);
+    QCOMPARE(timeLine.value(), 0.1);
+    QVERIFY(!timeLine.done());
+
+    // 900/1000
+    timeLine.advance(5900ms);
+    QCOMPARE(timeLine.value(), 0.9);
+    QVERIFY(!timeLine.done());
+
+    // 1000/1000
+    timeLine.advance(9000ms);
+    QCOMPARE(timeLine.value(), 1.0);
+    QVERIFY(timeLine.done());
+}
+
+void TimeLineTest::testAdvanceSamePresentationTime()
+{
+    // painting the same frame on several screens must not speed up the timeline
+    KWin::TimeLine timeLine(1000ms, KWin::TimeLine::Forward);
+    timeLine.setEasingCurve(QEasingCurve::Linear);
+
+    timeLine.advance(5000ms);
+    timeLine.advance(5200ms);
+    timeLine.advance(5200ms);
+    timeLine.advance(5200ms);
+    QCOMPARE(timeLine.value(), 0.2);
+
+    // nor must an older presentation time move it back
+    timeLine.advance(5100ms);
+    QCOMPARE(timeLine.value(), 0.2);
+    QCOMPARE(timeLine.elapsed(), 200ms);
+}
+
+void TimeLineTest::testAdvanceSubMillisecond()
+{
+    // 60 frames at 60 Hz are exactly one second, rounding to milliseconds would lose 40ms
+    KWin::TimeLine timeLine(1000ms, KWin::TimeLine::Forward);
+    timeLine.setEasingCurve(QEasingCurve::Linear);
+
+    const std::chrono::nanoseconds start = 5000ms;
+    timeLine.advance(start);
+    for (int i = 1; i < 60; ++i) {
+        timeLine.advance(start + std::chrono::nanoseconds(1000000000ll * i / 60));
+    }
+    QVERIFY(!timeLine.done());
+    QCOMPARE(timeLine.elapsed(), 983ms);
+
+    timeLine.advance(start + 1000ms);
+    QVERIFY(timeLine.done());
+}
+
+void TimeLineTest::testAdvanceAfterReset()
+{
+    KWin::TimeLine timeLine(1000ms, KWin::TimeLine::Forward);
+    timeLine.setEasingCurve(QEasingCurve::Linear);
+
+    timeLine.advance(5000ms);
+    timeLine.advance(5500ms);
+    QCOMPARE(timeLine.value(), 0.5);
+
+    // after a reset the timeline starts again at the next frame
+    timeLine.reset();
+    timeLine.advance(8000ms);
+    QCOMPARE(timeLine.value(), 0.0);
+    timeLine.advance(8300ms);
+    QCOMPARE(timeLine.value(), 0.3);
+
+    // setting the elapsed time keeps advancing from the last frame
+    timeLine.setElapsed(600ms);
+    timeLine.advance(8400ms);
+    QCOMPARE(timeLine.value(), 0.7);
+}
+
 void TimeLineTest::testToggleDirection()
 {
     KWin::TimeLine timeLine(1000ms, KWin::TimeLine::Forward);
@@ -48,6 +48,12 @@ public:
     double animationTimeFactor() const override {
         return 0;
     }
+    std::chrono::nanoseconds presentationTime() const override {
+        return m_presentationTime;
+    }
+    void setPresentationTime(std::chrono::nanoseconds presentationTime) {
+        m_presentationTime = presentationTime;
+    }
     xcb_atom_t announceSupportProperty(const QByteArray &, KWin::Effect *) override {
         return XCB_ATOM_NONE;
     }
@@ -273,5 +279,6 @@ public:
 
 private:
     bool m_animationsSuported = true;
+    std::chrono::nanoseconds m_presentationTime = std::chrono::nanoseconds::zero();
 };
 #endif
@@ -0,0 +1,151 @@
+/********************************************************************
+KWin - the KDE window manager
+This file is part of the KDE project.
+
+Copyright (C) 2012 Martin Gräßlin <mgraesslin@kde.org>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "mock_effectwindow.h"
+
+namespace KWin
+{
+
+MockEffectWindow::MockEffectWindow(QObject *parent)
+    : EffectWindow(parent)
+{
+}
+
+WindowQuadList MockEffectWindow::buildQuads(bool force) const
+{
+    Q_UNUSED(force)
+    return WindowQuadList();
+}
+
+QVariant MockEffectWindow::data(int role) const
+{
+    Q_UNUSED(role)
+    return QVariant();
+}
+
+QRect MockEffectWindow::decorationInnerRect() const
+{
+    return QRect();
+}
+
+void MockEffectWindow::deleteProperty(long int atom) const
+{
+    Q_UNUSED(atom)
+}
+
+void MockEffectWindow::disablePainting(int reason)
+{
+    Q_UNUSED(reason)
+}
+
+void MockEffectWindow::enablePainting(int reason)
+{
+    Q_UNUSED(reason)
+}
+
+void MockEffectWindow::addRepaint(const QRect &r)
+{
+    Q_UNUSED(r)
+}
+
+void MockEffectWindow::addRepaint(int x, int y, int w, int h)
+{
+    Q_UNUSED(x)
+    Q_UNUSED(y)
+    Q_UNUSED(w)
+    Q_UNUSED(h)
+}
+
+void MockEffectWindow::addRepaintFull()
+{
+}
+
+void MockEffectWindow::addLayerRepaint(const QRect &r)
+{
+    Q_UNUSED(r)
+}
+
+void MockEffectWindow::addLayerRepaint(int x, int y, int w, int h)
+{
+    Q_UNUSED(x)
+    Q_UNUSED(y)
+    Q_UNUSED(w)
+    Q_UNUSED(h)
+}
+
+EffectWindow *MockEffectWindow::findModal()
+{
+    return nullptr;
+}
+
+const EffectWindowGroup *MockEffectWindow::group() const
+{
+    return nullptr;
+}
+
+bool MockEffectWindow::isPaintingEnabled()
+{
+    return true;
+}
+
+EffectWindowList MockEffectWindow::mainWindows() const
+{
+    return EffectWindowList();
+}
+
+QByteArray MockEffectWindow::readProperty(long int atom, long int type, int format) const
+{
+    Q_UNUSED(atom)
+    Q_UNUSED(type)
+    Q_UNUSED(format)
+    return QByteArray();
+}
+
+void MockEffectWindow::refWindow()
+{
+}
+
+void MockEffectWindow::setData(int role, const QVariant &data)
+{
+    Q_UNUSED(role)
+    Q_UNUSED(data)
+}
+
+void MockEffectWindow::minimize()
+{
+}
+
+void MockEffectWindow::unminimize()
+{
+}
+
+void MockEffectWindow::closeWindow()
+{
+}
+
+QRegion MockEffectWindow::shape() const
+{
+    return QRegion();
+}
+
+void MockEffectWindow::unrefWindow()
+{
+}
+
+}
@@ -0,0 +1,161 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2019 KWin-lowlatency developers
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "../effects/blur/blurcache.h"
+
+#include <QTest>
+
+using namespace KWin;
+
+static const qint64 s_textureSize = 1024 * 1024;
+
+// the cache only uses the windows as keys
+static const EffectWindow *window(quintptr id)
+{
+    return reinterpret_cast<const EffectWindow*>(id * 8);
+}
+
+class TestBlurCache : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testHit();
+    void testInvalidate();
+    void testEviction();
+    void testShrinkBudget();
+    void testRemove();
+};
+
+void TestBlurCache::testHit()
+{
+    BlurCache cache;
+    cache.setBudget(4 * s_textureSize);
+    const QRegion shape(0, 0, 100, 50);
+
+    BlurCache::Entry &entry = cache.use(window(1));
+    cache.setTexture(entry, GLTexture(), s_textureSize);
+    QCOMPARE(cache.missing(entry, shape), shape);
+    QCOMPARE(cache.misses(), quint64(1));
+
+    // the blur is computed and stored for the shape
+    entry.valid |= shape;
+    QVERIFY(cache.missing(entry, shape).isEmpty());
+    QCOMPARE(cache.hits(), quint64(1));
+
+    // a larger shape only needs the new part
+    const QRegion larger(0, 0, 100, 80);
+    QCOMPARE(cache.missing(entry, larger), QRegion(0, 50, 100, 30));
+    QCOMPARE(cache.partialHits(), quint64(1));
+    QCOMPARE(cache.misses(), quint64(1));
+    QCOMPARE(cache.hits(), quint64(1));
+}
+
+void TestBlurCache::testInvalidate()
+{
+    BlurCache cache;
+    cache.setBudget(4 * s_textureSize);
+    const QRegion shape(0, 0, 100, 50);
+
+    BlurCache::Entry &first = cache.use(window(1));
+    cache.setTexture(first, GLTexture(), s_textureSize);
+    first.valid = shape;
+    BlurCache::Entry &second = cache.use(window(2));
+    cache.setTexture(second, GLTexture(), s_textureSize);
+    second.valid = shape;
+
+    // content changed behind a part of the window
+    first.valid -= QRegion(0, 0, 10, 10);
+    QCOMPARE(cache.missing(first, shape), QRegion(0, 0, 10, 10));
+    QVERIFY(cache.missing(second, shape).isEmpty());
+
+    // a transformed screen invalidates everything but keeps the textures
+    cache.invalidate();
+    QCOMPARE(cache.missing(*cache.find(window(1)), shape), shape);
+    QCOMPARE(cache.missing(*cache.find(window(2)), shape), shape);
+    QCOMPARE(cache.memory(), 2 * s_textureSize);
+    QCOMPARE(cache.count(), 2);
+}
+
+void TestBlurCache::testEviction()
+{
+    BlurCache cache;
+    cache.setBudget(2 * s_textureSize);
+
+    for (quintptr i = 1; i <= 2; ++i) {
+        BlurCache::Entry &entry = cache.use(window(i));
+        cache.setTexture(entry, GLTexture(), s_textureSize);
+        entry.valid = QRegion(0, 0, 10, 10);
+    }
+    QCOMPARE(cache.memory(), 2 * s_textureSize);
+    QCOMPARE(cache.evictions(), quint64(0));
+
+    // the first window is used again, so the second one is the least recently used
+    cache.use(window(1));
+    BlurCache::Entry &third = cache.use(window(3));
+    cache.setTexture(third, GLTexture(), s_textureSize);
+    QCOMPARE(cache.memory(), 2 * s_textureSize);
+    QCOMPARE(cache.evictions(), quint64(1));
+    QCOMPARE(cache.find(window(1))->memory, s_textureSize);
+    QVERIFY(!cache.find(window(1))->valid.isEmpty());
+    QCOMPARE(cache.find(window(2))->memory, qint64(0));
+    QVERIFY(cache.find(window(2))->valid.isEmpty());
+    QCOMPARE(cache.find(window(3))->memory, s_textureSize);
+}
+
+void TestBlurCache::testShrinkBudget()
+{
+    BlurCache cache;
+    cache.setBudget(3 * s_textureSize);
+    for (quintptr i = 1; i <= 3; ++i) {
+        cache.setTexture(cache.use(window(i)), GLTexture(), s_textureSize);
+    }
+    QCOMPARE(cache.memory(), 3 * s_textureSize);
+
+    cache.setBudget(s_textureSize);
+    QCOMPARE(cache.memory(), s_textureSize);
+    QCOMPARE(cache.evictions(), quint64(2));
+    QCOMPARE(cache.find(window(3))->memory, s_textureSize);
+
+    // a texture larger than the budget is still kept for the window using it
+    cache.setBudget(0);
+    QCOMPARE(cache.memory(), qint64(0));
+    BlurCache::Entry &entry = cache.use(window(1));
+    cache.setTexture(entry, GLTexture(), s_textureSize);
+    QCOMPARE(cache.memory(), s_textureSize);
+}
+
+void TestBlurCache::testRemove()
+{
+    BlurCache cache;
+    cache.setBudget(4 * s_textureSize);
+    cache.setTexture(cache.use(window(1)), GLTexture(), s_textureSize);
+    cache.setTexture(cache.use(window(2)), GLTexture(), s_textureSize);
+
+    cache.remove(window(1));
+    QVERIFY(!cache.find(window(1)));
+    QCOMPARE(cache.memory(), s_textureSize);
+    QCOMPARE(cache.count(), 1);
+
+    cache.clear();
+    QCOMPARE(cache.memory(), qint64(0));
+    QCOMPARE(cache.count(), 0);
+}
+
+QTEST_GUILESS_MAIN(TestBlurCache)
+#include "test_blur_cache.moc"
@@ -0,0 +1,202 @@
+/********************************************************************
+KWin - the KDE window manager
+This file is part of the KDE project.
+
+Copyright (C) 2019 KWin-lowlatency developers
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "../plugins/platforms/fbdev/fb_blit.h"
+
+#include <QPainter>
+#include <QRegion>
+#include <QTest>
+
+using namespace KWin;
+
+Q_DECLARE_METATYPE(QImage::Format)
+
+static const uchar s_untouched = 0xa5;
+
+static int bytesPerPixel(QImage::Format format)
+{
+    switch (format) {
+    case QImage::Format_RGB888:
+        return 3;
+    case QImage::Format_RGB16:
+        return 2;
+    default:
+        return 4;
+    }
+}
+
+// a render buffer with all kinds of colors, deterministic
+static QImage renderBuffer(const QSize &size)
+{
+    QImage image(size, QImage::Format_RGB32);
+    quint32 seed = 1;
+    for (int y = 0; y < size.height(); ++y) {
+        QRgb *line = reinterpret_cast<QRgb*>(image.scanLine(y));
+        for (int x = 0; x < size.width(); ++x) {
+            seed = seed * 1103515245 + 12345;
+            line[x] = 0xff000000 | (seed >> 8);
+        }
+    }
+    return image;
+}
+
+/**
+ * An in-memory framebuffer, with padding at the end of each row like real ones have.
+ **/
+struct FakeFramebuffer
+{
+    FakeFramebuffer(const QSize &size, QImage::Format format)
+        : size(size)
+        , format(format)
+        , bytesPerLine(size.width() * bytesPerPixel(format) + 64)
+        , memory(bytesPerLine * size.height(), char(s_untouched))
+    {
+    }
+    uchar *data() {
+        return reinterpret_cast<uchar*>(memory.data());
+    }
+    const uchar *pixel(int x, int y) const {
+        return reinterpret_cast<const uchar*>(memory.constData()) + y * bytesPerLine + x * bytesPerPixel(format);
+    }
+
+    QSize size;
+    QImage::Format format;
+    int bytesPerLine;
+    QByteArray memory;
+};
+
+class TestFramebufferBlit : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testBlit_data();
+    void testBlit();
+    void testUnsupported();
+    void benchmarkBlit_data();
+    void benchmarkBlit();
+};
+
+void TestFramebufferBlit::testBlit_data()
+{
+    QTest::addColumn<QImage::Format>("format");
+    QTest::addColumn<bool>("bgr");
+
+    QTest::newRow("XRGB8888") << QImage::Format_RGB32 << false;
+    QTest::newRow("XBGR8888") << QImage::Format_RGB32 << true;
+    QTest::newRow("RGBA8888") << QImage::Format_RGBA8888 << false;
+    QTest::newRow("BGRA8888") << QImage::Format_RGBA8888 << true;
+    QTest::newRow("RGB888") << QImage::Format_RGB888 << false;
+    QTest::newRow("BGR888") << QImage::Format_RGB888 << true;
+    QTest::newRow("RGB565") << QImage::Format_RGB16 << false;
+}
+
+void TestFramebufferBlit::testBlit()
+{
+    // the damaged pixels have to end up exactly as QImage converts them, nothing else may change
+    QFETCH(QImage::Format, format);
+    QFETCH(bool, bgr);
+    const QSize size(301, 97);
+    const QImage source = renderBuffer(size);
+    FakeFramebuffer framebuffer(size, format);
+
+    // widths which exercise all vector and scalar paths, one rect crosses the border
+    QRegion damage;
+    damage += QRect(0, 0, 1, 1);
+    damage += QRect(3, 10, 5, 7);
+    damage += QRect(20, 20, 33, 4);
+    damage += QRect(100, 40, 64, 30);
+    damage += QRect(280, 90, 50, 50);
+    QVERIFY(blitToFramebuffer(source, damage, framebuffer.data(), framebuffer.bytesPerLine, format, bgr));
+
+    const QImage expected = (bgr ? source.rgbSwapped() : source).convertToFormat(format);
+    const int bpp = bytesPerPixel(format);
+    const QByteArray untouched(bpp, char(s_untouched));
+    for (int y = 0; y < size.height(); ++y) {
+        for (int x = 0; x < size.width(); ++x) {
+            const QByteArray actual(reinterpret_cast<const char*>(framebuffer.pixel(x, y)), bpp);
+            if (damage.contains(QPoint(x, y))) {
+                const QByteArray reference(reinterpret_cast<const char*>(expected.constScanLine(y) + x * bpp), bpp);
+                if (actual != reference) {
+                    QFAIL(qPrintable(QStringLiteral("Wrong pixel at %1,%2").arg(x).arg(y)));
+                }
+            } else if (actual != untouched) {
+                QFAIL(qPrintable(QStringLiteral("Pixel at %1,%2 is not damaged, but changed").arg(x).arg(y)));
+            }
+        }
+    }
+    // the padding stays untouched as well
+    for (int y = 0; y < size.height(); ++y) {
+        const QByteArray padding(reinterpret_cast<const char*>(framebuffer.pixel(size.width(), y)),
+                                 framebuffer.bytesPerLine - size.width() * bpp);
+        QCOMPARE(padding, QByteArray(padding.size(), char(s_untouched)));
+    }
+}
+
+void TestFramebufferBlit::testUnsupported()
+{
+    const QImage source = renderBuffer(QSize(10, 10));
+    FakeFramebuffer framebuffer(source.size(), QImage::Format_RGB16);
+    QVERIFY(!blitToFramebuffer(source, source.rect(), framebuffer.data(), framebuffer.bytesPerLine, QImage::Format_RGB16, true));
+    QVERIFY(!blitToFramebuffer(source, source.rect(), framebuffer.data(), framebuffer.bytesPerLine, QImage::Format_Mono, false));
+    QCOMPARE(framebuffer.memory, QByteArray(framebuffer.memory.size(), char(s_untouched)));
+}
+
+void TestFramebufferBlit::benchmarkBlit_data()
+{
+    QTest::addColumn<QImage::Format>("format");
+    QTest::addColumn<bool>("bgr");
+    QTest::addColumn<bool>("painter");
+
+    // the way the framebuffer backend presented before, a QPainter and a converted copy
+    QTest::newRow("XRGB8888 QPainter") << QImage::Format_RGB32 << false << true;
+    QTest::newRow("XRGB8888") << QImage::Format_RGB32 << false << false;
+    QTest::newRow("RGBA8888 QPainter") << QImage::Format_RGBA8888 << false << true;
+    QTest::newRow("RGBA8888") << QImage::Format_RGBA8888 << false << false;
+    QTest::newRow("BGR888 QPainter") << QImage::Format_RGB888 << true << true;
+    QTest::newRow("BGR888") << QImage::Format_RGB888 << true << false;
+    QTest::newRow("RGB565 QPainter") << QImage::Format_RGB16 << false << true;
+    QTest::newRow("RGB565") << QImage::Format_RGB16 << false << false;
+}
+
+void TestFramebufferBlit::benchmarkBlit()
+{
+    // full 1080p frames
+    QFETCH(QImage::Format, format);
+    QFETCH(bool, bgr);
+    QFETCH(bool, painter);
+    const QSize size(1920, 1080);
+    const QImage source = renderBuffer(size);
+    FakeFramebuffer framebuffer(size, format);
+    QImage target(framebuffer.data(), size.width(), size.height(), framebuffer.bytesPerLine, format);
+
+    if (painter) {
+        QBENCHMARK {
+            QPainter p(&target);
+            p.drawImage(QPoint(0, 0), bgr ? source.rgbSwapped() : source);
+        }
+    } else {
+        const QRegion damage(source.rect());
+        QBENCHMARK {
+            blitToFramebuffer(source, damage, framebuffer.data(), framebuffer.bytesPerLine, format, bgr);
+        }
+    }
+}
+
+QTEST_GUILESS_MAIN(TestFramebufferBlit)
+#include "test_fb_blit.moc"
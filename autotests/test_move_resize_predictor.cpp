@@ -0,0 +1,130 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2019 KWin-lowlatency developers
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "../move_resize_predictor.h"
+
+#include <QTest>
+
+using namespace KWin;
+
+static const qint64 s_nanosPerMilli = 1000 * 1000;
+
+class TestMoveResizePredictor : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testEmpty();
+    void testSingleSample();
+    void testConstantVelocity();
+    void testStopped();
+    void testHorizonCapped();
+    void testTimeWrapsAround();
+    void testPredictionError();
+};
+
+void TestMoveResizePredictor::testEmpty()
+{
+    MoveResizePredictor predictor;
+    QVERIFY(predictor.isEmpty());
+    QCOMPARE(predictor.latest(), QPointF());
+    QCOMPARE(predictor.predict(0, 0), QPointF());
+}
+
+void TestMoveResizePredictor::testSingleSample()
+{
+    // without a second sample there is no velocity
+    MoveResizePredictor predictor;
+    predictor.addSample(QPointF(10, 20), 100, 100 * s_nanosPerMilli);
+    QVERIFY(!predictor.isEmpty());
+    QCOMPARE(predictor.latest(), QPointF(10, 20));
+    QCOMPARE(predictor.predict(8 * s_nanosPerMilli, 104 * s_nanosPerMilli), QPointF(10, 20));
+}
+
+void TestMoveResizePredictor::testConstantVelocity()
+{
+    // one px per ms to the right, half a px per ms down
+    MoveResizePredictor predictor;
+    for (quint32 time = 0; time <= 16; time += 4) {
+        predictor.addSample(QPointF(time, time / 2.0), time, time * s_nanosPerMilli);
+    }
+    QCOMPARE(predictor.latest(), QPointF(16, 8));
+    // 2 ms since the last sample and 8 ms until the frame is shown
+    QCOMPARE(predictor.predict(8 * s_nanosPerMilli, 18 * s_nanosPerMilli), QPointF(26, 13));
+
+    predictor.reset();
+    QVERIFY(predictor.isEmpty());
+}
+
+void TestMoveResizePredictor::testStopped()
+{
+    // a pointer which did not report any motion for a while is at rest
+    MoveResizePredictor predictor;
+    predictor.addSample(QPointF(0, 0), 0, 0);
+    predictor.addSample(QPointF(4, 0), 4, 4 * s_nanosPerMilli);
+    QCOMPARE(predictor.predict(8 * s_nanosPerMilli, 100 * s_nanosPerMilli), QPointF(4, 0));
+}
+
+void TestMoveResizePredictor::testHorizonCapped()
+{
+    MoveResizePredictor predictor;
+    predictor.addSample(QPointF(0, 0), 0, 0);
+    predictor.addSample(QPointF(4, 0), 4, 4 * s_nanosPerMilli);
+    QCOMPARE(predictor.predict(200 * s_nanosPerMilli, 4 * s_nanosPerMilli), QPointF(54, 0));
+}
+
+void TestMoveResizePredictor::testTimeWrapsAround()
+{
+    // the event times are 32 bit milliseconds, wrapping after about 49 days
+    MoveResizePredictor predictor;
+    predictor.addSample(QPointF(0, 0), 0xfffffffe, 0);
+    predictor.addSample(QPointF(4, 0), 2, 4 * s_nanosPerMilli);
+    QCOMPARE(predictor.predict(6 * s_nanosPerMilli, 4 * s_nanosPerMilli), QPointF(10, 0));
+}
+
+void TestMoveResizePredictor::testPredictionError()
+{
+    // the pointer moves with half a px per ms and reports its position every 4 ms, a frame is
+    // painted every 16 ms and shown 8 ms later, that's where the pointer is when it is seen
+    static const qreal velocity = 0.5;
+    static const qint64 delay = 8;
+    MoveResizePredictor predictor;
+    qreal latestError = 0;
+    qreal predictedError = 0;
+    int frames = 0;
+    for (qint64 time = 0; time <= 500; ++time) {
+        if (time % 4 == 0) {
+            predictor.addSample(QPointF(time * velocity, 0), quint32(time), time * s_nanosPerMilli);
+        }
+        if (time % 16 == 1 && time > 32) {
+            const qreal shown = (time + delay) * velocity;
+            latestError += qAbs(predictor.latest().x() - shown);
+            predictedError += qAbs(predictor.predict(delay * s_nanosPerMilli, time * s_nanosPerMilli).x() - shown);
+            ++frames;
+        }
+    }
+    QVERIFY(frames > 0);
+    latestError /= frames;
+    predictedError /= frames;
+    // following the newest position the window lags behind by the age of the sample plus the delay
+    QCOMPARE(latestError, 4.5);
+    QVERIFY(predictedError < 0.001);
+}
+
+QTEST_GUILESS_MAIN(TestMoveResizePredictor)
+#include "test_move_resize_predictor.moc"
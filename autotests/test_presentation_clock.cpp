@@ -0,0 +1,112 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2019 KWin-lowlatency developers
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "../presentationclock.h"
+
+#include <QTest>
+
+using namespace KWin;
+using namespace std::chrono_literals;
+using std::chrono::nanoseconds;
+
+class TestPresentationClock : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testPredictWithoutPresentation();
+    void testPredictOnVblankGrid();
+    void testStalePresentation();
+    void testElapsedMilliseconds();
+    void testElapsedMillisecondsCarry();
+};
+
+void TestPresentationClock::testPredictWithoutPresentation()
+{
+    // without a presentation there is no vblank grid, the frame is shown an interval later
+    PresentationClock clock;
+    clock.setInterval(10ms);
+    QCOMPARE(clock.predicted(), nanoseconds::zero());
+    QCOMPARE(clock.predict(100ms), nanoseconds(110ms));
+    QCOMPARE(clock.predicted(), nanoseconds(110ms));
+}
+
+void TestPresentationClock::testPredictOnVblankGrid()
+{
+    PresentationClock clock;
+    clock.setInterval(10ms);
+    clock.presented(1000ms);
+
+    // started right after the flip, shown at the next vblank
+    QCOMPARE(clock.predict(1002ms), nanoseconds(1010ms));
+    // another frame in the same interval cannot be shown at the same vblank
+    QCOMPARE(clock.predict(1005ms), nanoseconds(1020ms));
+
+    // a late frame skips vblanks, but stays on the grid
+    clock.presented(1020ms);
+    QCOMPARE(clock.predict(1047ms), nanoseconds(1050ms));
+    // started exactly at a vblank, shown at the next one
+    QCOMPARE(clock.predict(1060ms), nanoseconds(1070ms));
+
+    // the grid follows the reported presentations, not the previous predictions
+    clock.presented(1073ms);
+    QCOMPARE(clock.predict(1075ms), nanoseconds(1083ms));
+}
+
+void TestPresentationClock::testStalePresentation()
+{
+    // after a second without a presentation the grid is not trusted anymore
+    PresentationClock clock;
+    clock.setInterval(10ms);
+    clock.presented(1s);
+    QCOMPARE(clock.predict(3s + 4ms), nanoseconds(3s + 14ms));
+}
+
+void TestPresentationClock::testElapsedMilliseconds()
+{
+    nanoseconds remainder = nanoseconds::zero();
+    QCOMPARE(PresentationClock::elapsedMilliseconds(1s, 1s + 16ms, remainder), 16);
+    QCOMPARE(remainder, nanoseconds::zero());
+    QCOMPARE(PresentationClock::elapsedMilliseconds(1s, 1s + 500us, remainder), 0);
+    QCOMPARE(remainder, nanoseconds(500us));
+    QCOMPARE(PresentationClock::elapsedMilliseconds(1s, 1s + 700us, remainder), 1);
+    QCOMPARE(remainder, nanoseconds(200us));
+}
+
+void TestPresentationClock::testElapsedMillisecondsCarry()
+{
+    // 60 Hz frames are not a whole number of milliseconds apart
+    const nanoseconds interval(16666667);
+    nanoseconds remainder = nanoseconds::zero();
+    nanoseconds time = 1s;
+    QVector<int> diffs;
+    int total = 0;
+    for (int i = 0; i < 60; ++i) {
+        const int diff = PresentationClock::elapsedMilliseconds(time, time + interval, remainder);
+        diffs << diff;
+        total += diff;
+        time += interval;
+    }
+    QCOMPARE(diffs.mid(0, 3), QVector<int>({16, 17, 17}));
+    // a second worth of frames adds up to a second, nothing gets lost to the rounding
+    QCOMPARE(total, 1000);
+    QCOMPARE(remainder, nanoseconds(20));
+}
+
+QTEST_GUILESS_MAIN(TestPresentationClock)
+#include "test_presentation_clock.moc"
@@ -0,0 +1,224 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2019 KWin-lowlatency developers
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "../effects/presentwindows/naturallayout.h"
+
+#include <QTest>
+
+using namespace KWin;
+
+static const QRect s_area(0, 0, 1920, 1080);
+
+// Deterministic window set: windows of varying size, cascaded around a few hot spots
+// the way applications tend to be placed
+static QVector<QRect> syntheticWindows(int count)
+{
+    QVector<QRect> windows;
+    windows.reserve(count);
+    quint32 seed = 42;
+    auto next = [&seed] (int max) {
+        seed = seed * 1103515245 + 12345;
+        return int((seed >> 16) % quint32(max));
+    };
+    for (int i = 0; i < count; ++i) {
+        const QSize size(300 + next(900), 200 + next(600));
+        const QPoint hotSpot((i % 3) * 400, (i % 2) * 200);
+        windows << QRect(hotSpot + QPoint(next(300), next(200)), size);
+    }
+    return windows;
+}
+
+static NaturalLayout *createLayout(const QVector<QRect> &windows, bool fillGaps = true)
+{
+    NaturalLayout *layout = new NaturalLayout(s_area, 20, fillGaps);
+    for (int i = 0; i < windows.count(); ++i) {
+        layout->addWindow(NaturalLayout::Key(i + 1), windows.at(i));
+    }
+    return layout;
+}
+
+class NaturalLayoutTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testNoOverlap_data();
+    void testNoOverlap();
+    void testEmpty();
+    void testBudget();
+    void testCancel();
+    void testReuse();
+    void benchmarkLayout_data();
+    void benchmarkLayout();
+    void benchmarkAddWindow_data();
+    void benchmarkAddWindow();
+};
+
+void NaturalLayoutTest::testNoOverlap_data()
+{
+    QTest::addColumn<int>("count");
+    QTest::addColumn<bool>("fillGaps");
+
+    QTest::newRow("2") << 2 << false;
+    QTest::newRow("10") << 10 << false;
+    QTest::newRow("10/fill") << 10 << true;
+    QTest::newRow("50/fill") << 50 << true;
+}
+
+void NaturalLayoutTest::testNoOverlap()
+{
+    QFETCH(int, count);
+    QFETCH(bool, fillGaps);
+    QScopedPointer<NaturalLayout> layout(createLayout(syntheticWindows(count), fillGaps));
+    QVERIFY(layout->step());
+    QVERIFY(layout->isFinished());
+
+    const QHash<NaturalLayout::Key, QRect> targets = layout->targets();
+    QCOMPARE(targets.count(), count);
+    for (auto it = targets.constBegin(); it != targets.constEnd(); ++it) {
+        QVERIFY(s_area.contains(it.value()));
+        for (auto other = targets.constBegin(); other != targets.constEnd(); ++other) {
+            if (it == other) {
+                continue;
+            }
+            // scaling onto the screen may round adjacent windows by a pixel
+            QVERIFY(!it.value().adjusted(1, 1, -1, -1).intersects(other.value()));
+        }
+    }
+}
+
+void NaturalLayoutTest::testEmpty()
+{
+    NaturalLayout layout(s_area, 20, true);
+    QVERIFY(layout.step());
+    QVERIFY(layout.targets().isEmpty());
+}
+
+void NaturalLayoutTest::testBudget()
+{
+    // a budget of zero does a single iteration and provides a provisional layout
+    QScopedPointer<NaturalLayout> layout(createLayout(syntheticWindows(50)));
+    QVERIFY(!layout->step(0));
+    QVERIFY(!layout->isFinished());
+    const QHash<NaturalLayout::Key, QRect> provisional = layout->targets();
+    QCOMPARE(provisional.count(), 50);
+    for (const QRect &target : provisional) {
+        QVERIFY(s_area.contains(target));
+    }
+
+    // continuing in slices ends with the same layout as running it at once
+    int slices = 1;
+    while (!layout->step(0)) {
+        ++slices;
+    }
+    QVERIFY(slices > 1);
+    QScopedPointer<NaturalLayout> reference(createLayout(syntheticWindows(50)));
+    QVERIFY(reference->step());
+    QCOMPARE(layout->targets(), reference->targets());
+}
+
+void NaturalLayoutTest::testCancel()
+{
+    QScopedPointer<NaturalLayout> layout(createLayout(syntheticWindows(50)));
+    layout->cancel();
+    QVERIFY(!layout->step());
+    QVERIFY(!layout->isFinished());
+}
+
+void NaturalLayoutTest::testReuse()
+{
+    const QVector<QRect> windows = syntheticWindows(30);
+    QScopedPointer<NaturalLayout> previous(createLayout(windows));
+    QVERIFY(previous->step());
+
+    // removing a window keeps the others separated, all of them start from the previous solution
+    QScopedPointer<NaturalLayout> removed(new NaturalLayout(s_area, 20, false));
+    for (int i = 1; i < windows.count(); ++i) {
+        removed->addWindow(NaturalLayout::Key(i + 1), windows.at(i));
+    }
+    removed->reuse(*previous);
+    QCOMPARE(removed->reusedCount(), windows.count() - 1);
+    QVERIFY(removed->step());
+    QCOMPARE(removed->targets().count(), windows.count() - 1);
+
+    // a window with a changed geometry is not taken from the previous layout
+    QScopedPointer<NaturalLayout> changed(new NaturalLayout(s_area, 20, false));
+    for (int i = 0; i < windows.count(); ++i) {
+        changed->addWindow(NaturalLayout::Key(i + 1), i == 0 ? windows.at(i).translated(100, 100) : windows.at(i));
+    }
+    changed->reuse(*previous);
+    QCOMPARE(changed->reusedCount(), windows.count() - 1);
+    QVERIFY(changed->step());
+    QCOMPARE(changed->targets().count(), windows.count());
+
+    // a different area cannot be reused
+    QScopedPointer<NaturalLayout> otherArea(new NaturalLayout(QRect(0, 0, 1280, 1024), 20, false));
+    for (int i = 0; i < windows.count(); ++i) {
+        otherArea->addWindow(NaturalLayout::Key(i + 1), windows.at(i));
+    }
+    otherArea->reuse(*previous);
+    QCOMPARE(otherArea->reusedCount(), 0);
+    QScopedPointer<NaturalLayout> fresh(new NaturalLayout(QRect(0, 0, 1280, 1024), 20, false));
+    for (int i = 0; i < windows.count(); ++i) {
+        fresh->addWindow(NaturalLayout::Key(i + 1), windows.at(i));
+    }
+    QVERIFY(otherArea->step());
+    QVERIFY(fresh->step());
+    QCOMPARE(otherArea->targets(), fresh->targets());
+}
+
+void NaturalLayoutTest::benchmarkLayout_data()
+{
+    QTest::addColumn<int>("count");
+
+    QTest::newRow("10") << 10;
+    QTest::newRow("50") << 50;
+    QTest::newRow("100") << 100;
+    QTest::newRow("200") << 200;
+}
+
+void NaturalLayoutTest::benchmarkLayout()
+{
+    QFETCH(int, count);
+    const QVector<QRect> windows = syntheticWindows(count);
+    QBENCHMARK {
+        QScopedPointer<NaturalLayout> layout(createLayout(windows));
+        layout->step();
+    }
+}
+
+void NaturalLayoutTest::benchmarkAddWindow_data()
+{
+    benchmarkLayout_data();
+}
+
+void NaturalLayoutTest::benchmarkAddWindow()
+{
+    QFETCH(int, count);
+    const QVector<QRect> windows = syntheticWindows(count + 1);
+    QScopedPointer<NaturalLayout> previous(createLayout(windows.mid(0, count)));
+    QVERIFY(previous->step());
+    QBENCHMARK {
+        QScopedPointer<NaturalLayout> layout(createLayout(windows));
+        layout->reuse(*previous);
+        layout->step();
+    }
+}
+
+QTEST_MAIN(NaturalLayoutTest)
+#include "test_presentwindows_natural_layout.moc"
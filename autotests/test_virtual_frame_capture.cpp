@@ -0,0 +1,280 @@
+/********************************************************************
+KWin - the KDE window manager
+This file is part of the KDE project.
+
+Copyright (C) 2019 KWin-lowlatency developers
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "../plugins/platforms/virtual/frame_capture.h"
+
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTest>
+
+using namespace KWin;
+
+static QImage frameImage(int frame, QImage::Format format)
+{
+    QImage image(64, 48, format);
+    for (int y = 0; y < image.height(); ++y) {
+        for (int x = 0; x < image.width(); ++x) {
+            image.setPixel(x, y, qRgb(x * 4, y * 5, frame * 16));
+        }
+    }
+    return image;
+}
+
+/**
+ * Walks through the frames of a stream file.
+ **/
+class StreamReader
+{
+public:
+    explicit StreamReader(const QString &fileName) {
+        QFile file(fileName);
+        if (file.open(QIODevice::ReadOnly)) {
+            m_data = file.readAll();
+        }
+    }
+    bool isValid() const {
+        return m_data.startsWith(QByteArrayLiteral("KWINFRM1") + QByteArray(8, '\0'));
+    }
+    bool atEnd() const {
+        return m_offset >= m_data.size();
+    }
+    /**
+     * Where the next frame header starts.
+     **/
+    int offset() const {
+        return m_offset;
+    }
+    int size() const {
+        return m_data.size();
+    }
+    bool next(FrameCapture::StreamFrameHeader *header, QVector<QRect> *damage, QByteArray *pixels) {
+        if (m_offset + int(sizeof(*header)) > m_data.size()) {
+            return false;
+        }
+        memcpy(header, m_data.constData() + m_offset, sizeof(*header));
+        int offset = m_offset + sizeof(*header);
+        damage->clear();
+        for (quint32 i = 0; i < header->damageRectCount; ++i) {
+            qint32 r[4];
+            memcpy(r, m_data.constData() + offset, sizeof(r));
+            *damage << QRect(r[0], r[1], r[2], r[3]);
+            offset += sizeof(r);
+        }
+        *pixels = m_data.mid(offset, header->pixelsSize);
+        offset += header->pixelsSize;
+        // the padding up to the next frame is part of the stream
+        const int padding = (16 - offset % 16) % 16;
+        if (m_data.mid(offset, padding) != QByteArray(padding, '\0')) {
+            return false;
+        }
+        m_offset = offset + padding;
+        return header->magic == 0x454d5246 && pixels->size() == int(header->pixelsSize);
+    }
+
+private:
+    QByteArray m_data;
+    int m_offset = 16;
+};
+
+class TestVirtualFrameCapture : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void cleanup();
+    void testRaw_data();
+    void testRaw();
+    void testDelta();
+    void testAlignment();
+    void testPng();
+    void testDroppedFrames();
+};
+
+void TestVirtualFrameCapture::cleanup()
+{
+    qunsetenv("KWIN_WAYLAND_VIRTUAL_CAPTURE_FORMAT");
+    qunsetenv("KWIN_WAYLAND_VIRTUAL_CAPTURE_QUEUE");
+}
+
+void TestVirtualFrameCapture::testRaw_data()
+{
+    QTest::addColumn<int>("format");
+    QTest::addColumn<bool>("bottomUp");
+
+    QTest::newRow("QPainter") << int(QImage::Format_RGB32) << false;
+    QTest::newRow("OpenGL") << int(QImage::Format_RGBA8888) << true;
+}
+
+void TestVirtualFrameCapture::testRaw()
+{
+    // every frame ends up in full in the stream, rows top to bottom
+    QFETCH(int, format);
+    QFETCH(bool, bottomUp);
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    {
+        FrameCapture capture(dir.path());
+        QCOMPARE(capture.encoding(), FrameCapture::Encoding::Raw);
+        for (int i = 0; i < 3; ++i) {
+            const QImage image = frameImage(i, QImage::Format(format));
+            QVERIFY(capture.capture(1, bottomUp ? image.mirrored() : image, QRect(10, 10, 5 + i, 5), bottomUp));
+        }
+    }
+
+    StreamReader reader(dir.path() + QStringLiteral("/screen1.kwinframes"));
+    QVERIFY(reader.isValid());
+    for (int i = 0; i < 3; ++i) {
+        FrameCapture::StreamFrameHeader header;
+        QVector<QRect> damage;
+        QByteArray pixels;
+        QVERIFY(reader.next(&header, &damage, &pixels));
+        QCOMPARE(header.flags, 0u);
+        QCOMPARE(header.sequence, quint64(i));
+        QCOMPARE(header.width, 64u);
+        QCOMPARE(header.height, 48u);
+        QCOMPARE(header.format, quint32(format));
+        QCOMPARE(header.droppedFrames, 0u);
+        QCOMPARE(damage, QVector<QRect>{QRect(10, 10, 5 + i, 5)});
+        const QImage image(reinterpret_cast<const uchar*>(pixels.constData()), header.width, header.height, header.stride, QImage::Format(format));
+        QCOMPARE(image, frameImage(i, QImage::Format(format)));
+    }
+    QVERIFY(reader.atEnd());
+}
+
+void TestVirtualFrameCapture::testDelta()
+{
+    // only the damaged pixels are in the stream, clipped to the frame
+    qputenv("KWIN_WAYLAND_VIRTUAL_CAPTURE_FORMAT", QByteArrayLiteral("delta"));
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QImage image = frameImage(1, QImage::Format_RGBA8888);
+    QRegion damage;
+    damage += QRect(0, 0, 4, 4);
+    damage += QRect(60, 40, 10, 10);
+    {
+        FrameCapture capture(dir.path());
+        QCOMPARE(capture.encoding(), FrameCapture::Encoding::Delta);
+        QVERIFY(capture.capture(0, image.mirrored(), damage, true));
+    }
+
+    StreamReader reader(dir.path() + QStringLiteral("/screen0.kwinframes"));
+    QVERIFY(reader.isValid());
+    FrameCapture::StreamFrameHeader header;
+    QVector<QRect> rects;
+    QByteArray pixels;
+    QVERIFY(reader.next(&header, &rects, &pixels));
+    QCOMPARE(header.flags, 1u);
+    QCOMPARE(rects, (QVector<QRect>{QRect(0, 0, 4, 4), QRect(60, 40, 4, 8)}));
+    QCOMPARE(header.pixelsSize, quint64((16 + 32) * 4));
+    int offset = 0;
+    for (const QRect &rect : qAsConst(rects)) {
+        const QImage piece(reinterpret_cast<const uchar*>(pixels.constData() + offset), rect.width(), rect.height(), rect.width() * 4, QImage::Format_RGBA8888);
+        QCOMPARE(piece, image.copy(rect));
+        offset += rect.width() * rect.height() * 4;
+    }
+    QVERIFY(reader.atEnd());
+}
+
+void TestVirtualFrameCapture::testAlignment()
+{
+    // sizes which are no multiples of 16 bytes, the headers are still aligned
+    qputenv("KWIN_WAYLAND_VIRTUAL_CAPTURE_FORMAT", QByteArrayLiteral("delta"));
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    {
+        FrameCapture capture(dir.path());
+        for (int i = 0; i < 4; ++i) {
+            QVERIFY(capture.capture(0, frameImage(i, QImage::Format_RGB32), QRect(i, i, 3 + i, 1 + 2 * i), false));
+        }
+    }
+
+    StreamReader reader(dir.path() + QStringLiteral("/screen0.kwinframes"));
+    QVERIFY(reader.isValid());
+    QCOMPARE(reader.offset(), 16);
+    int frames = 0;
+    while (!reader.atEnd()) {
+        QCOMPARE(reader.offset() % 16, 0);
+        QCOMPARE(reader.offset() % int(alignof(FrameCapture::StreamFrameHeader)), 0);
+        FrameCapture::StreamFrameHeader header;
+        QVector<QRect> damage;
+        QByteArray pixels;
+        QVERIFY(reader.next(&header, &damage, &pixels));
+        QCOMPARE(header.sequence, quint64(frames));
+        ++frames;
+    }
+    QCOMPARE(frames, 4);
+    QCOMPARE(reader.size() % 16, 0);
+}
+
+void TestVirtualFrameCapture::testPng()
+{
+    qputenv("KWIN_WAYLAND_VIRTUAL_CAPTURE_FORMAT", QByteArrayLiteral("png"));
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QImage image = frameImage(2, QImage::Format_RGBA8888);
+    {
+        FrameCapture capture(dir.path());
+        QVERIFY(capture.capture(0, image.mirrored(), image.rect(), true));
+        QVERIFY(capture.capture(0, image.mirrored(), image.rect(), true));
+    }
+    QCOMPARE(QImage(dir.path() + QStringLiteral("/screen0-0.png")).convertToFormat(QImage::Format_RGBA8888), image);
+    QVERIFY(QFile::exists(dir.path() + QStringLiteral("/screen0-1.png")));
+}
+
+void TestVirtualFrameCapture::testDroppedFrames()
+{
+    // a frame too big for the queue is only written while nothing else is queued,
+    // every frame is either in the stream or counted as dropped in the next one
+    qputenv("KWIN_WAYLAND_VIRTUAL_CAPTURE_QUEUE", QByteArrayLiteral("1"));
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QImage image(1024, 1024, QImage::Format_RGB32);
+    image.fill(Qt::red);
+    quint64 dropped = 0;
+    {
+        FrameCapture capture(dir.path());
+        QVERIFY(capture.capture(0, image, image.rect()));
+        for (int i = 1; i < 20; ++i) {
+            capture.capture(0, image, image.rect());
+        }
+        // the last one makes it, so that it reports the drops before it
+        QTRY_VERIFY(capture.capture(0, image, image.rect()));
+        dropped = capture.droppedFrames();
+    }
+
+    StreamReader reader(dir.path() + QStringLiteral("/screen0.kwinframes"));
+    QVERIFY(reader.isValid());
+    quint64 written = 0;
+    quint64 reported = 0;
+    quint64 expectedSequence = 0;
+    while (!reader.atEnd()) {
+        FrameCapture::StreamFrameHeader header;
+        QVector<QRect> damage;
+        QByteArray pixels;
+        QVERIFY(reader.next(&header, &damage, &pixels));
+        QCOMPARE(header.sequence, expectedSequence + header.droppedFrames);
+        expectedSequence = header.sequence + 1;
+        reported += header.droppedFrames;
+        written++;
+    }
+    QCOMPARE(reported, dropped);
+    QCOMPARE(written + dropped, expectedSequence);
+}
+
+QTEST_GUILESS_MAIN(TestVirtualFrameCapture)
+#include "test_virtual_frame_capture.moc"
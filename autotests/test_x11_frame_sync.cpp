@@ -0,0 +1,129 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2019 KWin-lowlatency developers
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "../x11framesync.h"
+
+#include <QTest>
+
+using namespace KWin;
+using namespace std::chrono_literals;
+
+class TestX11FrameSync : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testVisible();
+    void testIncompleteFrame();
+    void testOccludedThrottled();
+    void testExposed();
+    void testReset();
+};
+
+void TestX11FrameSync::testVisible()
+{
+    X11FrameSync sync;
+    QVERIFY(!sync.isFramePending());
+    QVERIFY(!sync.framePainted(false, 16ms));
+
+    // the client draws a frame
+    sync.counterChanged(1);
+    QVERIFY(!sync.isFramePending());
+    sync.counterChanged(2);
+    QVERIFY(sync.isFramePending());
+    QCOMPARE(sync.completedFrame(), quint64(2));
+
+    // a visible window gets every frame acknowledged once
+    QVERIFY(sync.framePainted(false, 32ms));
+    QVERIFY(!sync.isFramePending());
+    QVERIFY(!sync.framePainted(false, 48ms));
+
+    sync.counterChanged(3);
+    sync.counterChanged(4);
+    QVERIFY(sync.framePainted(false, 64ms));
+    QCOMPARE(sync.completedFrame(), quint64(4));
+}
+
+void TestX11FrameSync::testIncompleteFrame()
+{
+    X11FrameSync sync;
+    sync.counterChanged(2);
+    // the next frame is started before the compositor painted, the completed one stays pending
+    sync.counterChanged(3);
+    QVERIFY(sync.isFramePending());
+    QCOMPARE(sync.completedFrame(), quint64(2));
+    QVERIFY(sync.framePainted(false, 16ms));
+
+    // the counter is 64 bit
+    const quint64 large = (quint64(1) << 32) + 2;
+    sync.counterChanged(large);
+    QCOMPARE(sync.completedFrame(), large);
+}
+
+void TestX11FrameSync::testOccludedThrottled()
+{
+    // a client drawing as fast as the compositor paints at 60 Hz
+    X11FrameSync sync;
+    int acknowledged = 0;
+    quint64 counter = 0;
+    std::chrono::milliseconds now = 10000ms;
+    for (int frame = 0; frame < 180; ++frame) {
+        if (!sync.isFramePending()) {
+            sync.counterChanged(++counter);
+            sync.counterChanged(++counter);
+        }
+        now += 16ms;
+        if (sync.framePainted(true, now)) {
+            ++acknowledged;
+        }
+    }
+    // three seconds, the occluded window gets one frame per second
+    QCOMPARE(acknowledged, 3);
+    QVERIFY(sync.isFramePending());
+    QVERIFY(sync.nextOccludedFrame() > now);
+    QVERIFY(sync.nextOccludedFrame() - now <= X11FrameSync::occludedInterval());
+}
+
+void TestX11FrameSync::testExposed()
+{
+    X11FrameSync sync;
+    sync.counterChanged(2);
+    QVERIFY(sync.framePainted(true, 5000ms));
+    sync.counterChanged(4);
+    QVERIFY(!sync.framePainted(true, 5016ms));
+    QVERIFY(sync.isFramePending());
+
+    // once exposed the frame is acknowledged with the next painted frame
+    QVERIFY(sync.framePainted(false, 5032ms));
+    QCOMPARE(sync.completedFrame(), quint64(4));
+    sync.counterChanged(6);
+    QVERIFY(sync.framePainted(false, 5048ms));
+}
+
+void TestX11FrameSync::testReset()
+{
+    X11FrameSync sync;
+    sync.counterChanged(2);
+    sync.reset();
+    QVERIFY(!sync.isFramePending());
+    QCOMPARE(sync.completedFrame(), quint64(0));
+    QVERIFY(!sync.framePainted(false, 16ms));
+}
+
+QTEST_GUILESS_MAIN(TestX11FrameSync)
+#include "test_x11_frame_sync.moc"
@@ -0,0 +1,247 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2019 KWin-lowlatency developers
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+// Qt
+#include <QRegion>
+#include <QtTest>
+// xcb
+#include <xcb/xcb.h>
+#include <xcb/damage.h>
+#include <xcb/xfixes.h>
+
+// Compares the two ways of tracking the damage of many windows the compositor can use:
+// fetching the damage region of each window with a round trip per frame, as KWin used to,
+// or accumulating the rectangles reported by delta damage events, as Toplevel does now.
+class TestXcbDamage : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void init();
+    void cleanup();
+
+    void testDeltaRectangles();
+    void benchmarkDamage_data();
+    void benchmarkDamage();
+
+private:
+    void createWindows(int count, uint8_t reportLevel);
+    void damageWindows();
+    QVector<QRegion> fetchDamage();
+    QVector<QRegion> readDamageEvents();
+    void sync();
+
+    xcb_connection_t *m_connection = nullptr;
+    xcb_window_t m_root = XCB_WINDOW_NONE;
+    xcb_gcontext_t m_gc = XCB_NONE;
+    uint8_t m_damageEventBase = 0;
+    QVector<xcb_window_t> m_windows;
+    QVector<xcb_damage_damage_t> m_damages;
+    QHash<xcb_damage_damage_t, int> m_damageIndex;
+    int m_frame = 0;
+};
+
+void TestXcbDamage::initTestCase()
+{
+    m_connection = xcb_connect(nullptr, nullptr);
+    QVERIFY(!xcb_connection_has_error(m_connection));
+    m_root = xcb_setup_roots_iterator(xcb_get_setup(m_connection)).data->root;
+
+    const xcb_query_extension_reply_t *damage = xcb_get_extension_data(m_connection, &xcb_damage_id);
+    if (!damage || !damage->present) {
+        QSKIP("The X server does not support the damage extension");
+    }
+    m_damageEventBase = damage->first_event;
+    // both extensions have to be initialized before they can be used
+    free(xcb_xfixes_query_version_reply(m_connection, xcb_xfixes_query_version(m_connection, 5, 0), nullptr));
+    free(xcb_damage_query_version_reply(m_connection, xcb_damage_query_version(m_connection, 1, 1), nullptr));
+
+    m_gc = xcb_generate_id(m_connection);
+    const uint32_t values[] = { 0xff0000ff };
+    xcb_create_gc(m_connection, m_gc, m_root, XCB_GC_FOREGROUND, values);
+}
+
+void TestXcbDamage::cleanupTestCase()
+{
+    if (m_connection) {
+        xcb_disconnect(m_connection);
+        m_connection = nullptr;
+    }
+}
+
+void TestXcbDamage::init()
+{
+    m_frame = 0;
+}
+
+void TestXcbDamage::cleanup()
+{
+    for (xcb_damage_damage_t damage : m_damages) {
+        xcb_damage_destroy(m_connection, damage);
+    }
+    for (xcb_window_t window : m_windows) {
+        xcb_destroy_window(m_connection, window);
+    }
+    m_damages.clear();
+    m_damageIndex.clear();
+    m_windows.clear();
+    sync();
+    while (xcb_generic_event_t *event = xcb_poll_for_event(m_connection)) {
+        free(event);
+    }
+}
+
+void TestXcbDamage::createWindows(int count, uint8_t reportLevel)
+{
+    const uint32_t values[] = { true };
+    for (int i = 0; i < count; ++i) {
+        const xcb_window_t window = xcb_generate_id(m_connection);
+        xcb_create_window(m_connection, XCB_COPY_FROM_PARENT, window, m_root,
+                          (i % 20) * 50, (i / 20) * 50, 50, 50,
+                          0, XCB_WINDOW_CLASS_INPUT_OUTPUT, XCB_COPY_FROM_PARENT,
+                          XCB_CW_OVERRIDE_REDIRECT, values);
+        xcb_map_window(m_connection, window);
+        const xcb_damage_damage_t damage = xcb_generate_id(m_connection);
+        xcb_damage_create(m_connection, damage, window, reportLevel);
+        m_damageIndex.insert(damage, m_damages.count());
+        m_windows << window;
+        m_damages << damage;
+    }
+    sync();
+    // drop the damage caused by mapping
+    readDamageEvents();
+    for (xcb_damage_damage_t damage : m_damages) {
+        xcb_damage_subtract(m_connection, damage, XCB_NONE, XCB_NONE);
+    }
+    sync();
+}
+
+void TestXcbDamage::damageWindows()
+{
+    // every window updates two small areas, which move with each frame
+    const int16_t offset = m_frame++ % 40;
+    const xcb_rectangle_t rects[] = {
+        { offset, 0, 10, 10 },
+        { 0, offset, 5, 5 }
+    };
+    for (xcb_window_t window : m_windows) {
+        xcb_poly_fill_rectangle(m_connection, window, m_gc, 2, rects);
+    }
+}
+
+QVector<QRegion> TestXcbDamage::fetchDamage()
+{
+    QVector<QRegion> regions(m_damages.count());
+    QVector<xcb_xfixes_fetch_region_cookie_t> cookies(m_damages.count());
+    for (int i = 0; i < m_damages.count(); ++i) {
+        const xcb_xfixes_region_t region = xcb_generate_id(m_connection);
+        xcb_xfixes_create_region(m_connection, region, 0, nullptr);
+        xcb_damage_subtract(m_connection, m_damages.at(i), XCB_NONE, region);
+        cookies[i] = xcb_xfixes_fetch_region_unchecked(m_connection, region);
+        xcb_xfixes_destroy_region(m_connection, region);
+    }
+    for (int i = 0; i < cookies.count(); ++i) {
+        xcb_xfixes_fetch_region_reply_t *reply = xcb_xfixes_fetch_region_reply(m_connection, cookies.at(i), nullptr);
+        if (!reply) {
+            continue;
+        }
+        const xcb_rectangle_t *rects = xcb_xfixes_fetch_region_rectangles(reply);
+        for (int j = 0; j < xcb_xfixes_fetch_region_rectangles_length(reply); ++j) {
+            regions[i] += QRect(rects[j].x, rects[j].y, rects[j].width, rects[j].height);
+        }
+        free(reply);
+    }
+    return regions;
+}
+
+QVector<QRegion> TestXcbDamage::readDamageEvents()
+{
+    QVector<QRegion> regions(m_damages.count());
+    while (xcb_generic_event_t *event = xcb_poll_for_event(m_connection)) {
+        if ((event->response_type & ~0x80) == m_damageEventBase + XCB_DAMAGE_NOTIFY) {
+            const auto *damage = reinterpret_cast<xcb_damage_notify_event_t*>(event);
+            const int index = m_damageIndex.value(damage->damage, -1);
+            if (index != -1) {
+                regions[index] += QRect(damage->area.x, damage->area.y, damage->area.width, damage->area.height);
+            }
+        }
+        free(event);
+    }
+    return regions;
+}
+
+void TestXcbDamage::sync()
+{
+    free(xcb_get_input_focus_reply(m_connection, xcb_get_input_focus(m_connection), nullptr));
+}
+
+void TestXcbDamage::testDeltaRectangles()
+{
+    createWindows(1, XCB_DAMAGE_REPORT_LEVEL_DELTA_RECTANGLES);
+
+    damageWindows();
+    sync();
+    QCOMPARE(readDamageEvents().first(), QRegion(0, 0, 10, 10) | QRegion(0, 0, 5, 5));
+
+    // damaging the same area again does not report anything as long as it is not subtracted
+    m_frame = 0;
+    damageWindows();
+    sync();
+    QVERIFY(readDamageEvents().first().isEmpty());
+
+    xcb_damage_subtract(m_connection, m_damages.first(), XCB_NONE, XCB_NONE);
+    damageWindows();
+    sync();
+    QCOMPARE(readDamageEvents().first(), QRegion(1, 0, 10, 10) | QRegion(0, 1, 5, 5));
+}
+
+void TestXcbDamage::benchmarkDamage_data()
+{
+    QTest::addColumn<bool>("events");
+
+    QTest::newRow("fetch") << false;
+    QTest::newRow("events") << true;
+}
+
+void TestXcbDamage::benchmarkDamage()
+{
+    QFETCH(bool, events);
+    createWindows(300, events ? XCB_DAMAGE_REPORT_LEVEL_DELTA_RECTANGLES : XCB_DAMAGE_REPORT_LEVEL_NON_EMPTY);
+
+    // a frame: all windows draw, then the compositor collects what has changed
+    QBENCHMARK {
+        damageWindows();
+        sync();
+        QVector<QRegion> regions;
+        if (events) {
+            regions = readDamageEvents();
+            for (xcb_damage_damage_t damage : m_damages) {
+                xcb_damage_subtract(m_connection, damage, XCB_NONE, XCB_NONE);
+            }
+        } else {
+            readDamageEvents();
+            regions = fetchDamage();
+        }
+        QVERIFY(!regions.last().isEmpty());
+    }
+}
+
+QTEST_GUILESS_MAIN(TestXcbDamage)
+#include "test_xcb_damage.moc"
@@ -126,6 +126,7 @@ Client::Client()
 {
     // TODO: Do all as initialization
     syncRequest.counter = syncRequest.alarm = XCB_NONE;
+    syncRequest.extendedCounter = syncRequest.extendedAlarm = XCB_NONE;
     syncRequest.timeout = syncRequest.failsafeTimeout = NULL;
     syncRequest.lastTimestamp = xTime();
     syncRequest.isPending = false;
@@ -194,6 +195,8 @@ Client::~Client()
     //SWrapper::Client::clientRelease(this);
     if (syncRequest.alarm != XCB_NONE)
         xcb_sync_destroy_alarm(connection(), syncRequest.alarm);
+    if (syncRequest.extendedAlarm != XCB_NONE)
+        xcb_sync_destroy_alarm(connection(), syncRequest.extendedAlarm);
     assert(!isMoveResize());
     assert(m_client == XCB_WINDOW_NONE);
     assert(m_wrapper == XCB_WINDOW_NONE);
@@ -1626,14 +1629,25 @@ void Client::getIcons()
     setIcon(icon);
 }
 
-void Client::getSyncCounter()
+Xcb::Property Client::fetchSyncCounter() const
 {
     // TODO: make sync working on XWayland
     static const bool isX11 = kwinApp()->operationMode() == Application::OperationModeX11;
     if (!Xcb::Extensions::self()->isSyncAvailable() || !isX11)
-        return;
+        return Xcb::Property();
+
+    // the second counter is set by clients implementing the extended protocol
+    return Xcb::Property(false, window(), atoms->net_wm_sync_request_counter, XCB_ATOM_CARDINAL, 0, 2);
+}
+
+void Client::getSyncCounter()
+{
+    Xcb::Property syncProp = fetchSyncCounter();
+    readSyncCounter(syncProp);
+}
 
-    Xcb::Property syncProp(false, window(), atoms->net_wm_sync_request_counter, XCB_ATOM_CARDINAL, 0, 1);
+void Client::readSyncCounter(Xcb::Property &syncProp)
+{
     const xcb_sync_counter_t counter = syncProp.value<xcb_sync_counter_t>(XCB_NONE);
     if (counter != XCB_NONE) {
         syncRequest.counter = counter;
@@ -1665,6 +1679,104 @@ void Client::getSyncCounter()
             }
         }
     }
+
+    xcb_sync_counter_t extendedCounter = XCB_NONE;
+    const xcb_sync_counter_t *counters = syncProp.value<const xcb_sync_counter_t*>();
+    if (counters && syncProp.data()->value_len >= 2) {
+        extendedCounter = counters[1];
+    }
+    if (extendedCounter == syncRequest.extendedCounter) {
+        return;
+    }
+    auto *c = connection();
+    if (syncRequest.extendedAlarm != XCB_NONE) {
+        xcb_sync_destroy_alarm(c, syncRequest.extendedAlarm);
+        syncRequest.extendedAlarm = XCB_NONE;
+    }
+    syncRequest.extendedCounter = extendedCounter;
+    m_frameSync.reset();
+    if (extendedCounter == XCB_NONE) {
+        return;
+    }
+    // the counter belongs to the client, the alarm reports every change of it
+    xcb_sync_create_alarm_value_list_t values;
+    memset(&values, 0, sizeof(values));
+    values.counter = extendedCounter;
+    values.valueType = XCB_SYNC_VALUETYPE_RELATIVE;
+    values.value.lo = 1;
+    values.testType = XCB_SYNC_TESTTYPE_POSITIVE_TRANSITION;
+    values.delta.lo = 1;
+    values.events = 1;
+    syncRequest.extendedAlarm = xcb_generate_id(c);
+    auto cookie = xcb_sync_create_alarm_aux_checked(c, syncRequest.extendedAlarm,
+                                                    XCB_SYNC_CA_COUNTER | XCB_SYNC_CA_VALUE_TYPE | XCB_SYNC_CA_VALUE |
+                                                    XCB_SYNC_CA_TEST_TYPE | XCB_SYNC_CA_DELTA | XCB_SYNC_CA_EVENTS,
+                                                    &values);
+    ScopedCPointer<xcb_generic_error_t> error(xcb_request_check(c, cookie));
+    if (!error.isNull()) {
+        syncRequest.extendedCounter = syncRequest.extendedAlarm = XCB_NONE;
+    }
+}
+
+void Client::handleFrameSync(const xcb_sync_int64_t &value)
+{
+    m_frameSync.counterChanged((quint64(quint32(value.hi)) << 32) | value.lo);
+    if (!m_frameSync.isFramePending()) {
+        return;
+    }
+    if (!compositing()) {
+        // nothing gets painted, the frame is as good as drawn
+        m_frameSync.framePainted(false, std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()));
+        sendFrameDrawn();
+        return;
+    }
+    // the frame is acknowledged after the compositor painted it, even if it did not damage anything
+    if (Compositor::self()) {
+        Compositor::self()->scheduleRepaint();
+    }
+}
+
+void Client::framePainted()
+{
+    if (!m_frameSync.isFramePending()) {
+        return;
+    }
+    const auto now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch());
+    if (m_frameSync.framePainted(isOccluded(), now)) {
+        if (m_frameSyncTimer) {
+            m_frameSyncTimer->stop();
+        }
+        sendFrameDrawn();
+        return;
+    }
+    // throttled, the client gets the acknowledgement later even if the compositor idles meanwhile
+    if (!m_frameSyncTimer) {
+        m_frameSyncTimer = new QTimer(this);
+        m_frameSyncTimer->setSingleShot(true);
+        connect(m_frameSyncTimer, &QTimer::timeout, this, &Client::framePainted);
+    }
+    if (!m_frameSyncTimer->isActive()) {
+        m_frameSyncTimer->start(qMax<qint64>(0, (m_frameSync.nextOccludedFrame() - now).count()));
+    }
+}
+
+void Client::sendFrameDrawn()
+{
+    // the frame drawn time is in microseconds of the monotonic clock
+    const quint64 counter = m_frameSync.completedFrame();
+    const quint64 drawn = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    xcb_client_message_event_t ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.response_type = XCB_CLIENT_MESSAGE;
+    ev.window = window();
+    ev.type = atoms->net_wm_frame_drawn;
+    ev.format = 32;
+    ev.data.data32[0] = counter & 0xffffffff;
+    ev.data.data32[1] = counter >> 32;
+    ev.data.data32[2] = drawn & 0xffffffff;
+    ev.data.data32[3] = drawn >> 32;
+    xcb_send_event(connection(), false, window(), 0, reinterpret_cast<const char*>(&ev));
+    xcb_flush(connection());
 }
 
 /**
@@ -27,6 +27,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "rules.h"
 #include "tabgroup.h"
 #include "abstract_client.h"
+#include "x11framesync.h"
 #include "xcbutils.h"
 // Qt
 #include <QElapsedTimer>
@@ -118,6 +119,7 @@ public:
     NET::WindowType windowType(bool direct = false, int supported_types = 0) const;
 
     bool manage(xcb_window_t w, bool isMapped);
+    bool manage(xcb_window_t w, bool isMapped, Xcb::WindowAttributes &attr, Xcb::WindowGeometry &windowGeometry);
     void releaseWindow(bool on_shutdown = false);
     void destroyClient();
 
@@ -305,6 +307,9 @@ public:
         xcb_sync_counter_t counter;
         xcb_sync_int64_t value;
         xcb_sync_alarm_t alarm;
+        // the counter of the extended protocol, changed by the client for every frame
+        xcb_sync_counter_t extendedCounter;
+        xcb_sync_alarm_t extendedAlarm;
         xcb_timestamp_t lastTimestamp;
         QTimer *timeout, *failsafeTimeout;
         bool isPending;
@@ -313,6 +318,15 @@ public:
         return syncRequest;
     }
     void handleSync();
+    /**
+     * The client changed its extended sync counter to @p value.
+     **/
+    void handleFrameSync(const xcb_sync_int64_t &value);
+    /**
+     * Called after the compositor painted a frame, acknowledges the frame the client
+     * completed with _NET_WM_FRAME_DRAWN unless the window is occluded.
+     **/
+    void framePainted();
 
     static void cleanupX11();
 
@@ -339,11 +353,11 @@ private:
     void leaveNotifyEvent(xcb_leave_notify_event_t *e);
     void focusInEvent(xcb_focus_in_event_t *e);
     void focusOutEvent(xcb_focus_out_event_t *e);
-    virtual void damageNotifyEvent();
+    virtual void damageNotifyEvent(const QRect &area);
 
     bool buttonPressEvent(xcb_window_t w, int button, int state, int x, int y, int x_root, int y_root, xcb_timestamp_t time = XCB_CURRENT_TIME);
     bool buttonReleaseEvent(xcb_window_t w, int button, int state, int x, int y, int x_root, int y_root);
-    bool motionNotifyEvent(xcb_window_t w, int state, int x, int y, int x_root, int y_root);
+    bool motionNotifyEvent(xcb_window_t w, int state, int x, int y, int x_root, int y_root, xcb_timestamp_t time);
 
     Client* findAutogroupCandidate() const;
 
@@ -423,7 +437,10 @@ private:
     NETExtendedStrut strut() const;
     int checkShadeGeometry(int w, int h);
     void getSyncCounter();
+    Xcb::Property fetchSyncCounter() const;
+    void readSyncCounter(Xcb::Property &syncProp);
     void sendSyncRequest();
+    void sendFrameDrawn();
     void leaveMoveResize() override;
     void positionGeometryTip() override;
     void grabButton(int mod);
@@ -533,6 +550,9 @@ private:
     QSize client_size;
     bool shade_geometry_change;
     SyncRequest syncRequest;
+    X11FrameSync m_frameSync;
+    // acknowledges the frame of an occluded window if nothing gets painted
+    QTimer *m_frameSyncTimer = nullptr;
     static bool check_active_modal; ///< \see Client::checkActiveModal()
     int sm_stacking_order;
     friend struct ResetupRulesProcedure;
@@ -68,6 +68,11 @@ public:
     virtual ~ClientMachine();
 
     void resolve(xcb_window_t window, xcb_window_t clientLeader);
+    /**
+     * Variant of resolve() for callers which already read WM_CLIENT_MACHINE of @p window,
+     * e.g. together with its other properties.
+     **/
+    void resolve(const QByteArray &windowMachine, xcb_window_t window, xcb_window_t clientLeader);
     const QByteArray &hostName() const;
     bool isLocal() const;
     static QByteArray localhost();
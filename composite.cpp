@@ -375,6 +375,17 @@ void Compositor::startupWithWorkspace()
     performCompositing();
 }
 
+qint64 Compositor::presentationDelay() const
+{
+    return milliToNano(1000) / qMax(1, m_xrrRefreshRate);
+}
+
+void Compositor::predictPresentationTime()
+{
+    m_presentationClock.setInterval(std::chrono::nanoseconds(presentationDelay()));
+    m_presentationClock.predict(std::chrono::steady_clock::now().time_since_epoch());
+}
+
 void Compositor::scheduleRepaint()
 {
     if (!compositeTimer.isActive())
@@ -663,10 +674,13 @@ void Compositor::aboutToSwapBuffers()
     m_bufferSwapPending = true;
 }
 
-void Compositor::bufferSwapComplete()
+void Compositor::bufferSwapComplete(std::chrono::nanoseconds presentationTime)
 {
     assert(m_bufferSwapPending);
     m_bufferSwapPending = false;
+    if (presentationTime > std::chrono::nanoseconds::zero()) {
+        m_presentationClock.presented(presentationTime);
+    }
 
     if (m_composeAtSwapCompletion) {
         m_composeAtSwapCompletion = false;
@@ -674,6 +688,16 @@ void Compositor::bufferSwapComplete()
     }
 }
 
+// tells the X11 clients implementing the extended sync protocol that their frame got painted
+static void acknowledgeFrames(const ToplevelList &windows)
+{
+    for (Toplevel *t : windows) {
+        if (Client *c = qobject_cast<Client*>(t)) {
+            c->framePainted();
+        }
+    }
+}
+
 void Compositor::performCompositing()
 {
     if (m_scene->usesOverlayWindow() && !isOverlayWindowVisible())
@@ -694,14 +718,31 @@ void Compositor::performCompositing()
         return;
     }
 
+    // Move or resize the window the user is dragging to the newest pointer position right before
+    // painting, so that the frame shows the window where the pointer is
+    if (AbstractClient *c = Workspace::self()->getMovingClient()) {
+        c->applyPendingMoveResize(presentationDelay());
+    }
+
     // Create a list of all windows in the stacking order
     ToplevelList windows = Workspace::self()->xStackingOrder();
     ToplevelList damaged;
 
-    // Reset the damage state of each window and fetch the damage region
-    // without waiting for a reply
+    // The windows which this frame exposes show their held back damage in it already, instead
+    // of being painted with their old content and fetching the damage for the next frame
+    QRegion exposed = repaints_region;
+    for (Toplevel *win : windows) {
+        exposed |= win->layerRepaints();
+    }
+    for (Toplevel *win : windows) {
+        if (win->isOccluded() && exposed.intersects(win->visibleRect())) {
+            win->setOccluded(false);
+        }
+    }
+
+    // Apply the damage reported by the damage events of each window and reset its damage state
     foreach (Toplevel *win, windows) {
-        if (win->resetAndFetchDamage())
+        if (win->applyPendingDamage())
             damaged << win;
     }
 
@@ -719,21 +760,9 @@ void Compositor::performCompositing()
         windows.append(t);
     }
 
-    // Get the replies
-    foreach (Toplevel *win, damaged) {
-        // Discard the cached lanczos texture
-        if (win->effectWindow()) {
-            const QVariant texture = win->effectWindow()->data(LanczosCacheRole);
-            if (texture.isValid()) {
-                delete static_cast<GLTexture *>(texture.value<void*>());
-                win->effectWindow()->setData(LanczosCacheRole, QVariant());
-            }
-        }
-
-        win->getDamageRegionReply();
-    }
-
     if (repaints_region.isEmpty() && !windowRepaintsPending()) {
+        // the frames the clients completed did not change anything on screen
+        acknowledgeFrames(windows);
         m_scene->idle();
         m_timeSinceLastVBlank = fpsInterval - (options->vBlankTime() + 1); // means "start now"
         m_timeSinceStart += m_timeSinceLastVBlank;
@@ -768,6 +797,7 @@ void Compositor::performCompositing()
     if (m_framesToTestForSafety > 0 && (m_scene->compositingType() & OpenGLCompositing)) {
         kwinApp()->platform()->createOpenGLSafePoint(Platform::OpenGLSafePoint::PreFrame);
     }
+    predictPresentationTime();
     m_timeSinceLastVBlank = m_scene->paint(repaints, windows);
     if (m_framesToTestForSafety > 0) {
         if (m_scene->compositingType() & OpenGLCompositing) {
@@ -780,6 +810,8 @@ void Compositor::performCompositing()
     }
     m_timeSinceStart += m_timeSinceLastVBlank;
 
+    acknowledgeFrames(Workspace::self()->xStackingOrder());
+
     if (waylandServer()) {
         for (Toplevel *win : qAsConst(damaged)) {
             if (auto surface = win->surface()) {
@@ -978,7 +1010,7 @@ bool Toplevel::setupCompositing()
 
     if (kwinApp()->operationMode() == Application::OperationModeX11 && !surface()) {
         damage_handle = xcb_generate_id(connection());
-        xcb_damage_create(connection(), damage_handle, frameId(), XCB_DAMAGE_REPORT_LEVEL_NON_EMPTY);
+        xcb_damage_create(connection(), damage_handle, frameId(), XCB_DAMAGE_REPORT_LEVEL_DELTA_RECTANGLES);
     }
 
     damage_region = QRegion(0, 0, width(), height());
@@ -1012,6 +1044,7 @@ void Toplevel::finishCompositing(ReleaseReason releaseReason)
 
     damage_handle = XCB_NONE;
     damage_region = QRegion();
+    m_pendingDamage = QRegion();
     repaints_region = QRegion();
     effect_window = NULL;
 }
@@ -1023,14 +1056,17 @@ void Toplevel::discardWindowPixmap()
         effectWindow()->sceneWindow()->pixmapDiscarded();
 }
 
-void Toplevel::damageNotifyEvent()
+void Toplevel::damageNotifyEvent(const QRect &area)
 {
     m_isDamaged = true;
 
-    // Note: The rect is supposed to specify the damage extents,
-    //       but we don't know it at this point. No one who connects
-    //       to this signal uses the rect however.
-    emit damaged(this, QRect());
+    // Many small updates are cheaper to repaint as one rect than to track as a complex region
+    m_pendingDamage += area;
+    if (m_pendingDamage.rectCount() >= 16) {
+        m_pendingDamage = m_pendingDamage.boundingRect();
+    }
+
+    emit damaged(this, area);
 }
 
 bool Toplevel::compositing() const
@@ -1041,11 +1077,10 @@ bool Toplevel::compositing() const
     return Workspace::self()->compositing();
 }
 
-void Client::damageNotifyEvent()
+void Client::damageNotifyEvent(const QRect &area)
 {
     if (syncRequest.isPending && isResize()) {
-        emit damaged(this, QRect());
-        m_isDamaged = true;
+        Toplevel::damageNotifyEvent(area);
         return;
     }
 
@@ -1056,73 +1091,45 @@ void Client::damageNotifyEvent()
         }
     }
 
-    Toplevel::damageNotifyEvent();
+    Toplevel::damageNotifyEvent(area);
 }
 
-bool Toplevel::resetAndFetchDamage()
+bool Toplevel::applyPendingDamage()
 {
     if (!m_isDamaged)
         return false;
 
-    if (damage_handle == XCB_NONE) {
-        m_isDamaged = false;
-        return true;
-    }
-
-    xcb_connection_t *conn = connection();
-
-    // Create a new region and copy the damage region to it,
-    // resetting the damaged state.
-    xcb_xfixes_region_t region = xcb_generate_id(conn);
-    xcb_xfixes_create_region(conn, region, 0, 0);
-    xcb_damage_subtract(conn, damage_handle, 0, region);
+    // the damage reported by damage events keeps accumulating in the server and no further
+    // damage events get reported for the areas which are already damaged, the damage gets
+    // subtracted once the window is exposed
+    if (m_occluded && ready_for_painting && !m_pendingDamage.isEmpty())
+        return false;
 
-    // Send a fetch-region request and destroy the region
-    m_regionCookie = xcb_xfixes_fetch_region_unchecked(conn, region);
-    xcb_xfixes_destroy_region(conn, region);
+    if (damage_handle != XCB_NONE) {
+        // The damage events reported the damaged areas already, so only the damage
+        // object has to be reset in order to get events for new damage. Whatever got
+        // damaged after the events which have been processed so far, gets reported
+        // by events which are still in the queue.
+        xcb_damage_subtract(connection(), damage_handle, XCB_NONE, XCB_NONE);
+    }
 
+    damage_region += m_pendingDamage;
+    repaints_region += m_pendingDamage;
+    m_pendingDamage = QRegion();
     m_isDamaged = false;
-    m_damageReplyPending = true;
 
-    return m_damageReplyPending;
+    return true;
 }
 
-void Toplevel::getDamageRegionReply()
+void Toplevel::setOccluded(bool occluded)
 {
-    if (!m_damageReplyPending)
+    if (m_occluded == occluded)
         return;
-
-    m_damageReplyPending = false;
-
-    // Get the fetch-region reply
-    xcb_xfixes_fetch_region_reply_t *reply =
-            xcb_xfixes_fetch_region_reply(connection(), m_regionCookie, 0);
-
-    if (!reply)
-        return;
-
-    // Convert the reply to a QRegion
-    int count = xcb_xfixes_fetch_region_rectangles_length(reply);
-    QRegion region;
-
-    if (count > 1 && count < 16) {
-        xcb_rectangle_t *rects = xcb_xfixes_fetch_region_rectangles(reply);
-
-        QVector<QRect> qrects;
-        qrects.reserve(count);
-
-        for (int i = 0; i < count; i++)
-            qrects << QRect(rects[i].x, rects[i].y, rects[i].width, rects[i].height);
-
-        region.setRects(qrects.constData(), count);
-    } else
-        region += QRect(reply->extents.x, reply->extents.y,
-                        reply->extents.width, reply->extents.height);
-
-    damage_region += region;
-    repaints_region += region;
-
-    free(reply);
+    m_occluded = occluded;
+    if (!m_occluded && m_isDamaged) {
+        // the pending damage gets fetched with the next frame
+        emit needsRepaint();
+    }
 }
 
 void Toplevel::addDamageFull()
@@ -23,6 +23,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define KWIN_COMPOSITE_H
 // KWin
 #include <kwinglobals.h>
+#include "presentationclock.h"
 // KDE
 #include <KSelectionOwner>
 // Qt
@@ -32,6 +33,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QBasicTimer>
 #include <QRegion>
 
+#include <chrono>
+
 namespace KWin {
 
 class Client;
@@ -60,6 +63,13 @@ public:
     void addRepaint(const QRect& r);
     void addRepaint(const QRegion& r);
     void addRepaint(int x, int y, int w, int h);
+    /**
+     * The area which is going to be repainted with the next frame, in addition to
+     * the repaints of the individual windows.
+     **/
+    const QRegion &pendingRepaints() const {
+        return repaints_region;
+    }
     /**
      * Whether the Compositor is active. That is a Scene is present and the Compositor is
      * not shutting down itself.
@@ -68,6 +78,20 @@ public:
     int xrrRefreshRate() const {
         return m_xrrRefreshRate;
     }
+    /**
+     * The time in nanoseconds from the start of a paint pass until the frame is shown.
+     * Frames are painted right after a vblank, so this is a full refresh interval.
+     **/
+    qint64 presentationDelay() const;
+    /**
+     * When the frame which is being painted is expected to be shown, in nanoseconds of
+     * std::chrono::steady_clock. It is predicted at the start of each paint pass from when
+     * the last frame was shown and the refresh rate, so it lies on the vblank grid and does
+     * not jitter with the time the paint pass happens to start.
+     **/
+    std::chrono::nanoseconds presentationTime() const {
+        return m_presentationClock.predicted();
+    }
     void setCompositeResetTimer(int msecs);
 
     bool hasScene() const {
@@ -170,8 +194,11 @@ public Q_SLOTS:
 
     /**
      * Notifies the compositor that a pending buffer swap has completed.
+     * @p presentationTime is when the frame was shown, in nanoseconds of
+     * std::chrono::steady_clock, as reported by the backend, e.g. the timestamp of
+     * the page flip event. It is zero if the backend does not know or nothing got shown.
      */
-    void bufferSwapComplete();
+    void bufferSwapComplete(std::chrono::nanoseconds presentationTime = std::chrono::nanoseconds::zero());
 
 Q_SIGNALS:
     void compositingToggled(bool active);
@@ -202,6 +229,7 @@ private Q_SLOTS:
 private:
     void claimCompositorSelection();
     void setCompositeTimer();
+    void predictPresentationTime();
     bool windowRepaintsPending() const;
     /**
      * Continues the startup after Scene And Workspace are created
@@ -229,6 +257,7 @@ private:
     bool m_starting; // start() sets this variable while starting
     qint64 m_timeSinceLastVBlank;
     qint64 m_timeSinceStart = 0;
+    PresentationClock m_presentationClock;
     Scene *m_scene;
     bool m_bufferSwapPending;
     bool m_composeAtSwapCompletion;
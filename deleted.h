@@ -163,6 +163,13 @@ public:
         return m_transientFor.contains(const_cast<Toplevel *>(toplevel));
     }
 
+    /**
+     * Returns the list of toplevels this client was a transient for.
+     **/
+    ToplevelList mainWindows() const {
+        return m_transientFor;
+    }
+
     /**
      * Returns the list of transients.
      *
@@ -421,9 +421,32 @@ void EffectsHandlerImpl::postPaintScreen()
     // no special final code
 }
 
+const EffectsHandlerImpl::EffectsList &EffectsHandlerImpl::windowChain(EffectWindow *w)
+{
+    EffectWindowImpl *window = static_cast<EffectWindowImpl*>(w);
+    if (window->m_effectChainSerial != m_paintSerial) {
+        window->m_effectChainSerial = m_paintSerial;
+        window->m_effectChain.clear();
+        for (Effect *effect : qAsConst(m_activeEffects)) {
+            if (effect->isActiveForWindow(w)) {
+                window->m_effectChain << effect;
+            }
+        }
+    }
+    return window->m_effectChain;
+}
+
+// the per window methods walk through the chain of the window, which is entered with the first call
 void EffectsHandlerImpl::prePaintWindow(EffectWindow* w, WindowPrePaintData& data, int time)
 {
-    if (m_currentPaintWindowIterator != m_activeEffects.constEnd()) {
+    if (!m_paintWindowChain) {
+        m_paintWindowChain = &windowChain(w);
+        m_currentPaintWindowIterator = m_paintWindowChain->constBegin();
+        prePaintWindow(w, data, time);
+        m_paintWindowChain = nullptr;
+        return;
+    }
+    if (m_currentPaintWindowIterator != m_paintWindowChain->constEnd()) {
         (*m_currentPaintWindowIterator++)->prePaintWindow(w, data, time);
         --m_currentPaintWindowIterator;
     }
@@ -432,7 +455,14 @@ void EffectsHandlerImpl::prePaintWindow(EffectWindow* w, WindowPrePaintData& dat
 
 void EffectsHandlerImpl::paintWindow(EffectWindow* w, int mask, QRegion region, WindowPaintData& data)
 {
-    if (m_currentPaintWindowIterator != m_activeEffects.constEnd()) {
+    if (!m_paintWindowChain) {
+        m_paintWindowChain = &windowChain(w);
+        m_currentPaintWindowIterator = m_paintWindowChain->constBegin();
+        paintWindow(w, mask, region, data);
+        m_paintWindowChain = nullptr;
+        return;
+    }
+    if (m_currentPaintWindowIterator != m_paintWindowChain->constEnd()) {
         (*m_currentPaintWindowIterator++)->paintWindow(w, mask, region, data);
         --m_currentPaintWindowIterator;
     } else
@@ -452,7 +482,14 @@ void EffectsHandlerImpl::paintEffectFrame(EffectFrame* frame, QRegion region, do
 
 void EffectsHandlerImpl::postPaintWindow(EffectWindow* w)
 {
-    if (m_currentPaintWindowIterator != m_activeEffects.constEnd()) {
+    if (!m_paintWindowChain) {
+        m_paintWindowChain = &windowChain(w);
+        m_currentPaintWindowIterator = m_paintWindowChain->constBegin();
+        postPaintWindow(w);
+        m_paintWindowChain = nullptr;
+        return;
+    }
+    if (m_currentPaintWindowIterator != m_paintWindowChain->constEnd()) {
         (*m_currentPaintWindowIterator++)->postPaintWindow(w);
         --m_currentPaintWindowIterator;
     }
@@ -469,7 +506,14 @@ Effect *EffectsHandlerImpl::provides(Effect::Feature ef)
 
 void EffectsHandlerImpl::drawWindow(EffectWindow* w, int mask, QRegion region, WindowPaintData& data)
 {
-    if (m_currentDrawWindowIterator != m_activeEffects.constEnd()) {
+    if (!m_drawWindowChain) {
+        m_drawWindowChain = &windowChain(w);
+        m_currentDrawWindowIterator = m_drawWindowChain->constBegin();
+        drawWindow(w, mask, region, data);
+        m_drawWindowChain = nullptr;
+        return;
+    }
+    if (m_currentDrawWindowIterator != m_drawWindowChain->constEnd()) {
         (*m_currentDrawWindowIterator++)->drawWindow(w, mask, region, data);
         --m_currentDrawWindowIterator;
     } else
@@ -516,8 +560,10 @@ void EffectsHandlerImpl::startPaint()
             m_activeEffects << it->second;
         }
     }
-    m_currentDrawWindowIterator = m_activeEffects.constBegin();
-    m_currentPaintWindowIterator = m_activeEffects.constBegin();
+    // the window chains are built again when they are needed in this frame
+    ++m_paintSerial;
+    m_paintWindowChain = nullptr;
+    m_drawWindowChain = nullptr;
     m_currentPaintScreenIterator = m_activeEffects.constBegin();
     m_currentPaintEffectFrameIterator = m_activeEffects.constBegin();
 }
@@ -1057,6 +1103,11 @@ double EffectsHandlerImpl::animationTimeFactor() const
     return options->animationTimeFactor();
 }
 
+std::chrono::nanoseconds EffectsHandlerImpl::presentationTime() const
+{
+    return m_compositor->presentationTime();
+}
+
 WindowQuadType EffectsHandlerImpl::newWindowQuadType()
 {
     return WindowQuadType(next_window_quad_type++);
@@ -1487,6 +1538,7 @@ void EffectsHandlerImpl::effectsChanged()
 {
     loaded_effects.clear();
     m_activeEffects.clear(); // it's possible to have a reconfigure and a quad rebuild between two paint cycles - bug #308201
+    ++m_paintSerial; // the window chains may reference unloaded effects
 
     loaded_effects.reserve(effect_order.count());
     std::copy(effect_order.constBegin(), effect_order.constEnd(),
@@ -1697,11 +1749,6 @@ EffectWindowImpl::EffectWindowImpl(Toplevel *toplevel)
 
 EffectWindowImpl::~EffectWindowImpl()
 {
-    QVariant cachedTextureVariant = data(LanczosCacheRole);
-    if (cachedTextureVariant.isValid()) {
-        GLTexture *cachedTexture = static_cast< GLTexture*>(cachedTextureVariant.value<void*>());
-        delete cachedTexture;
-    }
 }
 
 bool EffectWindowImpl::isPaintingEnabled()
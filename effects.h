@@ -164,6 +164,7 @@ public:
     QSize virtualScreenSize() const override;
     QRect virtualScreenGeometry() const override;
     double animationTimeFactor() const override;
+    std::chrono::nanoseconds presentationTime() const override;
     WindowQuadType newWindowQuadType() override;
 
     void defineCursor(Qt::CursorShape shape) override;
@@ -344,7 +345,16 @@ private:
 
     typedef QVector< Effect*> EffectsList;
     typedef EffectsList::const_iterator EffectsIterator;
+    /**
+     * The active effects interested in @p w in the current frame.
+     **/
+    const EffectsList &windowChain(EffectWindow *w);
     EffectsList m_activeEffects;
+    // identifies the frame the window chains were built for
+    quint64 m_paintSerial = 1;
+    // the window chains in use while walking through prePaintWindow/paintWindow/postPaintWindow and drawWindow
+    const EffectsList *m_paintWindowChain = nullptr;
+    const EffectsList *m_drawWindowChain = nullptr;
     EffectsIterator m_currentDrawWindowIterator;
     EffectsIterator m_currentPaintWindowIterator;
     EffectsIterator m_currentPaintEffectFrameIterator;
@@ -509,6 +519,11 @@ private:
     bool managed = false;
     bool waylandClient;
     bool x11Client;
+
+    // maintained by EffectsHandlerImpl::windowChain
+    friend class EffectsHandlerImpl;
+    QVector<Effect*> m_effectChain;
+    quint64 m_effectChainSerial = 0;
 };
 
 class EffectWindowGroupImpl
@@ -111,6 +111,9 @@ void BlurEffect::deleteFBOs()
 
     m_renderTargets.clear();
     m_renderTextures.clear();
+
+    // the cached results have the size of the render textures
+    m_blurCache.clear();
 }
 
 void BlurEffect::updateTexture()
@@ -232,6 +235,7 @@ void BlurEffect::reconfigure(ReconfigureFlags flags)
     m_offset = blurStrengthValues[blurStrength].offset;
     m_expandSize = blurOffsets[m_downSampleIterations - 1].expandSize;
     m_noiseStrength = BlurConfig::noiseStrength();
+    m_blurCache.setBudget(qint64(BlurConfig::cacheSize()) * 1024 * 1024);
 
     m_scalingFactor = qMax(1.0, QGuiApplication::primaryScreen()->logicalDotsPerInch() / 96.0);
 
@@ -300,6 +304,8 @@ void BlurEffect::slotWindowAdded(EffectWindow *w)
 
 void BlurEffect::slotWindowDeleted(EffectWindow *w)
 {
+    m_blurCache.remove(w);
+
     auto it = windowBlurChangedConnections.find(w);
     if (it == windowBlurChangedConnections.end()) {
         return;
@@ -441,6 +447,14 @@ void BlurEffect::prePaintScreen(ScreenPrePaintData &data, int time)
     m_currentBlur = QRegion();
 
     effects->prePaintScreen(data, time);
+
+    // The cached blur results are only tracked for untransformed painting, a transformed
+    // window moves content around without damaging it.
+    m_useBlurCache = !(data.mask & (PAINT_SCREEN_TRANSFORMED | PAINT_SCREEN_WITH_TRANSFORMED_WINDOWS));
+    if (!m_useBlurCache) {
+        m_blurCache.invalidate();
+    }
+    m_changedArea = data.paint;
 }
 
 void BlurEffect::prePaintWindow(EffectWindow* w, WindowPrePaintData& data, int time)
@@ -449,7 +463,12 @@ void BlurEffect::prePaintWindow(EffectWindow* w, WindowPrePaintData& data, int t
 
     effects->prePaintWindow(w, data, time);
 
+    BlurCache::Entry *cache = m_blurCache.find(w);
     if (!w->isPaintingEnabled()) {
+        // changes behind the window are not tracked while it is not painted
+        if (cache) {
+            cache->valid = QRegion();
+        }
         return;
     }
     if (!m_shader || !m_shader->isValid()) {
@@ -494,6 +513,15 @@ void BlurEffect::prePaintWindow(EffectWindow* w, WindowPrePaintData& data, int t
 
     m_currentBlur |= expandedBlur;
 
+    // the cached blur stays valid everywhere except around content which changed underneath,
+    // this is what changes for the windows above as well
+    const QRegion changedBlur = expand(m_changedArea & expandedBlur) & blurArea;
+    if (cache) {
+        cache->valid -= changedBlur;
+    }
+    m_changedArea -= data.clip;
+    m_changedArea |= oldPaint | changedBlur;
+
     // we don't consider damaged areas which are occluded and are not
     // explicitly damaged by this window
     m_damagedArea -= data.clip;
@@ -559,7 +587,22 @@ void BlurEffect::drawWindow(EffectWindow *w, int mask, QRegion region, WindowPai
         }
 
         if (!shape.isEmpty()) {
-            doBlur(shape, screen, data.opacity(), data.screenProjectionMatrix(), w->isDock(), w->geometry());
+            // per output rendering maps every output onto the same textures, the cache
+            // is only used when the whole screen is painted at once
+            BlurCache::Entry *cache = nullptr;
+            if (m_useBlurCache && !translated && !scaled && screen == effects->virtualScreenGeometry()) {
+                cache = &m_blurCache.use(w);
+                const QRect bounds = (blurRegion(w).translated(w->pos()) & screen).boundingRect();
+                if (cache->bounds != bounds) {
+                    // a dock's blur is clamped to its bounds, other windows only have
+                    // to blur the newly covered area
+                    if (w->isDock()) {
+                        cache->valid = QRegion();
+                    }
+                    cache->bounds = bounds;
+                }
+            }
+            doBlur(shape, screen, data.opacity(), data.screenProjectionMatrix(), w->isDock(), w->geometry(), cache);
         }
     }
 
@@ -607,14 +650,28 @@ void BlurEffect::generateNoiseTexture()
     m_noiseTexture.setWrapMode(GL_REPEAT);
 }
 
-void BlurEffect::doBlur(const QRegion& shape, const QRect& screen, const float opacity, const QMatrix4x4 &screenProjection, bool isDock, QRect windowRect)
+void BlurEffect::doBlur(const QRegion& shape, const QRect& screen, const float opacity, const QMatrix4x4 &screenProjection, bool isDock, QRect windowRect, BlurCache::Entry *cache)
 {
     // Blur would not render correctly on a secondary monitor because of wrong coordinates
     // BUG: 393723
     const int xTranslate = -screen.x();
     const int yTranslate = effects->virtualScreenSize().height() - screen.height() - screen.y();
 
-    const QRegion expandedBlurRegion = expand(shape) & expand(screen);
+    // Only the part which is not cached yet has to go through the down and upsample iterations
+    QRegion blurShape = shape;
+    GLTexture *source = &m_renderTextures[1];
+    if (cache) {
+        if (cache->texture.isNull()) {
+            GLTexture texture(GL_RGBA8, m_renderTextures[1].size());
+            texture.setFilter(GL_LINEAR);
+            texture.setWrapMode(GL_CLAMP_TO_EDGE);
+            m_blurCache.setTexture(*cache, texture, qint64(texture.width()) * texture.height() * 4);
+        }
+        blurShape = m_blurCache.missing(*cache, shape);
+        source = &cache->texture;
+    }
+
+    const QRegion expandedBlurRegion = blurShape.isEmpty() ? QRegion() : (expand(blurShape) & expand(screen));
 
     // Upload geometry for the down and upsample iterations
     GLVertexBuffer *vbo = GLVertexBuffer::streamingBuffer();
@@ -622,32 +679,41 @@ void BlurEffect::doBlur(const QRegion& shape, const QRect& screen, const float o
     uploadGeometry(vbo, expandedBlurRegion.translated(xTranslate, yTranslate), shape);
     vbo->bindArrays();
 
-    const QRect sourceRect = expandedBlurRegion.boundingRect() & screen;
-    const QRect destRect = sourceRect.translated(xTranslate, yTranslate);
+    const int blurRectCount = expandedBlurRegion.rectCount() * 6;
+
+    if (!blurShape.isEmpty()) {
+        const QRect sourceRect = expandedBlurRegion.boundingRect() & screen;
+        const QRect destRect = sourceRect.translated(xTranslate, yTranslate);
+
+        GLRenderTarget::pushRenderTargets(m_renderTargetStack);
+
+        /*
+         * If the window is a dock or panel we avoid the "extended blur" effect.
+         * Extended blur is when windows that are not under the blurred area affect
+         * the final blur result.
+         * We want to avoid this on panels, because it looks really weird and ugly
+         * when maximized windows or windows near the panel affect the dock blur.
+         */
+        if (isDock) {
+            m_renderTargets.last()->blitFromFramebuffer(sourceRect, destRect);
+            const QRect blurRect = cache ? cache->bounds : shape.boundingRect();
+            copyScreenSampleTexture(vbo, blurRectCount, blurRect.translated(xTranslate, yTranslate), screenProjection);
+        } else {
+            m_renderTargets.first()->blitFromFramebuffer(sourceRect, destRect);
 
-    GLRenderTarget::pushRenderTargets(m_renderTargetStack);
-    int blurRectCount = expandedBlurRegion.rectCount() * 6;
+            // Remove the m_renderTargets[0] from the top of the stack that we will not use
+            GLRenderTarget::popRenderTarget();
+        }
 
-    /*
-     * If the window is a dock or panel we avoid the "extended blur" effect.
-     * Extended blur is when windows that are not under the blurred area affect
-     * the final blur result.
-     * We want to avoid this on panels, because it looks really weird and ugly
-     * when maximized windows or windows near the panel affect the dock blur.
-     */
-    if (isDock) {
-        m_renderTargets.last()->blitFromFramebuffer(sourceRect, destRect);
-        copyScreenSampleTexture(vbo, blurRectCount, shape.translated(xTranslate, yTranslate), screenProjection);
-    } else {
-        m_renderTargets.first()->blitFromFramebuffer(sourceRect, destRect);
+        const QRegion blurRegion = expandedBlurRegion.translated(xTranslate, yTranslate);
+        downSampleTexture(vbo, blurRectCount, blurRegion);
+        upSampleTexture(vbo, blurRectCount, blurRegion);
 
-        // Remove the m_renderTargets[0] from the top of the stack that we will not use
-        GLRenderTarget::popRenderTarget();
+        if (cache) {
+            updateBlurCache(cache, blurShape, expandedBlurRegion, QPoint(xTranslate, yTranslate));
+        }
     }
 
-    downSampleTexture(vbo, blurRectCount);
-    upSampleTexture(vbo, blurRectCount);
-
     // Modulate the blurred texture with the window opacity if the window isn't opaque
     if (opacity < 1.0) {
         glEnable(GL_BLEND);
@@ -662,7 +728,7 @@ void BlurEffect::doBlur(const QRegion& shape, const QRect& screen, const float o
         glBlendFunc(GL_CONSTANT_ALPHA, GL_ONE_MINUS_CONSTANT_ALPHA);
     }
 
-    upscaleRenderToScreen(vbo, blurRectCount * (m_downSampleIterations + 1), shape.rectCount() * 6, screenProjection, windowRect.topLeft());
+    upscaleRenderToScreen(vbo, blurRectCount * (m_downSampleIterations + 1), shape.rectCount() * 6, screenProjection, windowRect.topLeft(), source);
 
     if (opacity < 1.0) {
         glDisable(GL_BLEND);
@@ -671,10 +737,40 @@ void BlurEffect::doBlur(const QRegion& shape, const QRect& screen, const float o
     vbo->unbindArrays();
 }
 
-void BlurEffect::upscaleRenderToScreen(GLVertexBuffer *vbo, int vboStart, int blurRectCount, QMatrix4x4 screenProjection, QPoint windowPosition)
+void BlurEffect::updateBlurCache(BlurCache::Entry *cache, const QRegion &blurShape, const QRegion &expandedBlurRegion, const QPoint &translation)
+{
+    // The final upsample pass reads around every pixel, so the cache needs the
+    // freshly computed surrounding as well. It is still within the expanded region.
+    const int margin = 4 * (m_offset + 1);
+    QRegion copyRegion;
+    for (const QRect &rect : blurShape) {
+        copyRegion |= rect.adjusted(-margin, -margin, margin, margin);
+    }
+    copyRegion &= expandedBlurRegion;
+
+    const int height = m_renderTextures[1].height();
+
+    GLRenderTarget::pushRenderTarget(m_renderTargets[1]);
+    cache->texture.bind();
+    for (const QRect &r : copyRegion.translated(translation)) {
+        // same coordinates as the geometry of the first downsample iteration
+        const int x = r.x() / 2;
+        const int y = r.y() / 2;
+        const int width = (r.x() + r.width()) / 2 - x;
+        const int rectHeight = (r.y() + r.height()) / 2 - y;
+        const int glY = height - y - rectHeight;
+        glCopyTexSubImage2D(GL_TEXTURE_2D, 0, x, glY, x, glY, width, rectHeight);
+    }
+    cache->texture.unbind();
+    GLRenderTarget::popRenderTarget();
+
+    cache->valid |= blurShape;
+}
+
+void BlurEffect::upscaleRenderToScreen(GLVertexBuffer *vbo, int vboStart, int blurRectCount, QMatrix4x4 screenProjection, QPoint windowPosition, GLTexture *source)
 {
     glActiveTexture(GL_TEXTURE0);
-    m_renderTextures[1].bind();
+    source->bind();
 
     if (m_noiseStrength > 0) {
         m_shader->bind(BlurShader::NoiseSampleType);
@@ -699,8 +795,29 @@ void BlurEffect::upscaleRenderToScreen(GLVertexBuffer *vbo, int vboStart, int bl
     m_shader->unbind();
 }
 
-void BlurEffect::downSampleTexture(GLVertexBuffer *vbo, int blurRectCount)
+static QVector<QRect> scaledRects(const QRegion &region, int divisionRatio)
+{
+    // the same rounding as uploadRegion
+    QVector<QRect> rects;
+    rects.reserve(region.rectCount());
+    for (const QRect &r : region) {
+        rects << QRect(QPoint(r.x() / divisionRatio, r.y() / divisionRatio),
+                       QPoint((r.x() + r.width()) / divisionRatio - 1, (r.y() + r.height()) / divisionRatio - 1));
+    }
+    return rects;
+}
+
+void BlurEffect::downSampleTexture(GLVertexBuffer *vbo, int blurRectCount, const QRegion &blurRegion)
 {
+    if (m_shader->isComputeValid()) {
+        for (int i = 1; i <= m_downSampleIterations; i++) {
+            m_shader->compute(BlurShader::DownSampleType, m_renderTextures[i - 1], m_renderTextures[i], scaledRects(blurRegion, 1 << i), m_offset);
+            // keep the render target stack in sync with the fragment shader path
+            GLRenderTarget::popRenderTarget();
+        }
+        return;
+    }
+
     QMatrix4x4 modelViewProjectionMatrix;
 
     m_shader->bind(BlurShader::DownSampleType);
@@ -723,8 +840,16 @@ void BlurEffect::downSampleTexture(GLVertexBuffer *vbo, int blurRectCount)
     m_shader->unbind();
 }
 
-void BlurEffect::upSampleTexture(GLVertexBuffer *vbo, int blurRectCount)
+void BlurEffect::upSampleTexture(GLVertexBuffer *vbo, int blurRectCount, const QRegion &blurRegion)
 {
+    if (m_shader->isComputeValid()) {
+        for (int i = m_downSampleIterations - 1; i >= 1; i--) {
+            m_shader->compute(BlurShader::UpSampleType, m_renderTextures[i + 1], m_renderTextures[i], scaledRects(blurRegion, 1 << i), m_offset);
+            GLRenderTarget::popRenderTarget();
+        }
+        return;
+    }
+
     QMatrix4x4 modelViewProjectionMatrix;
 
     m_shader->bind(BlurShader::UpSampleType);
@@ -747,7 +872,7 @@ void BlurEffect::upSampleTexture(GLVertexBuffer *vbo, int blurRectCount)
     m_shader->unbind();
 }
 
-void BlurEffect::copyScreenSampleTexture(GLVertexBuffer *vbo, int blurRectCount, QRegion blurShape, QMatrix4x4 screenProjection)
+void BlurEffect::copyScreenSampleTexture(GLVertexBuffer *vbo, int blurRectCount, const QRect &blurRect, QMatrix4x4 screenProjection)
 {
     m_shader->bind(BlurShader::CopySampleType);
 
@@ -758,7 +883,7 @@ void BlurEffect::copyScreenSampleTexture(GLVertexBuffer *vbo, int blurRectCount,
      * This '1' sized adjustment is necessary do avoid windows affecting the blur that are
      * right next to this window.
      */
-    m_shader->setBlurRect(blurShape.boundingRect().adjusted(1, 1, -1, -1), effects->virtualScreenSize());
+    m_shader->setBlurRect(blurRect.adjusted(1, 1, -1, -1), effects->virtualScreenSize());
     m_renderTextures.last().bind();
 
     vbo->draw(GL_TRIANGLES, 0, blurRectCount);
@@ -25,6 +25,8 @@
 #include <kwinglplatform.h>
 #include <kwinglutils.h>
 
+#include "blurcache.h"
+
 #include <QVector>
 #include <QVector2D>
 #include <QStack>
@@ -83,15 +85,16 @@ private:
     QRegion blurRegion(const EffectWindow *w) const;
     bool shouldBlur(const EffectWindow *w, int mask, const WindowPaintData &data) const;
     void updateBlurRegion(EffectWindow *w) const;
-    void doBlur(const QRegion &shape, const QRect &screen, const float opacity, const QMatrix4x4 &screenProjection, bool isDock, QRect windowRect);
+    void updateBlurCache(BlurCache::Entry *cache, const QRegion &blurShape, const QRegion &expandedBlurRegion, const QPoint &translation);
+    void doBlur(const QRegion &shape, const QRect &screen, const float opacity, const QMatrix4x4 &screenProjection, bool isDock, QRect windowRect, BlurCache::Entry *cache = nullptr);
     void uploadRegion(QVector2D *&map, const QRegion &region, const int downSampleIterations);
     void uploadGeometry(GLVertexBuffer *vbo, const QRegion &blurRegion, const QRegion &windowRegion);
     void generateNoiseTexture();
 
-    void upscaleRenderToScreen(GLVertexBuffer *vbo, int vboStart, int blurRectCount, QMatrix4x4 screenProjection, QPoint windowPosition);
-    void downSampleTexture(GLVertexBuffer *vbo, int blurRectCount);
-    void upSampleTexture(GLVertexBuffer *vbo, int blurRectCount);
-    void copyScreenSampleTexture(GLVertexBuffer *vbo, int blurRectCount, QRegion blurShape, QMatrix4x4 screenProjection);
+    void upscaleRenderToScreen(GLVertexBuffer *vbo, int vboStart, int blurRectCount, QMatrix4x4 screenProjection, QPoint windowPosition, GLTexture *source);
+    void downSampleTexture(GLVertexBuffer *vbo, int blurRectCount, const QRegion &blurRegion);
+    void upSampleTexture(GLVertexBuffer *vbo, int blurRectCount, const QRegion &blurRegion);
+    void copyScreenSampleTexture(GLVertexBuffer *vbo, int blurRectCount, const QRect &blurRect, QMatrix4x4 screenProjection);
 
 private:
     BlurShader *m_shader;
@@ -106,6 +109,9 @@ private:
     QRegion m_damagedArea; // keeps track of the area which has been damaged (from bottom to top)
     QRegion m_paintedArea; // actually painted area which is greater than m_damagedArea
     QRegion m_currentBlur; // keeps track of the currently blured area of the windows(from bottom to top)
+    QRegion m_changedArea; // content changed this frame (from bottom to top), including the screen damage
+    bool m_useBlurCache = false;
+    BlurCache m_blurCache;
 
     int m_downSampleIterations; // number of times the texture will be downsized to half size
     int m_offset;
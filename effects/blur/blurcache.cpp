@@ -0,0 +1,157 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2019 KWin-lowlatency developers
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "blurcache.h"
+
+namespace KWin
+{
+
+qint64 BlurCache::budget() const
+{
+    return m_budget;
+}
+
+void BlurCache::setBudget(qint64 budget)
+{
+    m_budget = budget;
+    evict(nullptr);
+}
+
+qint64 BlurCache::memory() const
+{
+    return m_memory;
+}
+
+int BlurCache::count() const
+{
+    return m_entries.count();
+}
+
+BlurCache::Entry *BlurCache::find(const EffectWindow *w)
+{
+    auto it = m_entries.find(w);
+    if (it == m_entries.end()) {
+        return nullptr;
+    }
+    return &*it;
+}
+
+BlurCache::Entry &BlurCache::use(const EffectWindow *w)
+{
+    Entry &entry = m_entries[w];
+    entry.lastUsed = ++m_useCounter;
+    return entry;
+}
+
+void BlurCache::setTexture(Entry &entry, const GLTexture &texture, qint64 memory)
+{
+    release(entry);
+    entry.texture = texture;
+    entry.memory = memory;
+    m_memory += memory;
+    evict(&entry);
+}
+
+QRegion BlurCache::missing(const Entry &entry, const QRegion &shape)
+{
+    const QRegion missing = shape - entry.valid;
+    if (missing.isEmpty()) {
+        ++m_hits;
+    } else if (missing == shape) {
+        ++m_misses;
+    } else {
+        ++m_partialHits;
+    }
+    return missing;
+}
+
+void BlurCache::invalidate()
+{
+    for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+        it->valid = QRegion();
+    }
+}
+
+void BlurCache::remove(const EffectWindow *w)
+{
+    auto it = m_entries.find(w);
+    if (it == m_entries.end()) {
+        return;
+    }
+    release(*it);
+    m_entries.erase(it);
+}
+
+void BlurCache::clear()
+{
+    m_entries.clear();
+    m_memory = 0;
+}
+
+quint64 BlurCache::hits() const
+{
+    return m_hits;
+}
+
+quint64 BlurCache::partialHits() const
+{
+    return m_partialHits;
+}
+
+quint64 BlurCache::misses() const
+{
+    return m_misses;
+}
+
+quint64 BlurCache::evictions() const
+{
+    return m_evictions;
+}
+
+void BlurCache::release(Entry &entry)
+{
+    m_memory -= entry.memory;
+    entry.memory = 0;
+    entry.texture = GLTexture();
+    entry.valid = QRegion();
+}
+
+void BlurCache::evict(const Entry *keep)
+{
+    while (m_memory > m_budget) {
+        // the entries stay, they are small and references to them are handed out during a
+        // frame, only the textures are released
+        Entry *lru = nullptr;
+        for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+            if (&*it == keep || it->memory == 0) {
+                continue;
+            }
+            if (!lru || it->lastUsed < lru->lastUsed) {
+                lru = &*it;
+            }
+        }
+        if (!lru) {
+            break;
+        }
+        release(*lru);
+        ++m_evictions;
+    }
+}
+
+}
@@ -0,0 +1,106 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2019 KWin-lowlatency developers
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#ifndef KWIN_BLUR_CACHE_H
+#define KWIN_BLUR_CACHE_H
+
+#include <kwinglutils.h>
+
+#include <QHash>
+#include <QRect>
+#include <QRegion>
+
+namespace KWin
+{
+
+class EffectWindow;
+
+/**
+ * @brief The half sized blur results of the windows, kept across frames.
+ *
+ * The blur only has to be recomputed where the content behind a window changed. The
+ * textures are kept under a memory budget, the least recently used ones are released
+ * first when it is exceeded.
+ **/
+class BlurCache
+{
+public:
+    struct Entry {
+        GLTexture texture;
+        QRegion valid; // area in screen coordinates for which the texture holds an up to date result
+        QRect bounds; // bounding rect of the blurred area the texture was computed for
+        qint64 memory = 0; // size of the texture in bytes
+        quint64 lastUsed = 0;
+    };
+
+    qint64 budget() const;
+    /**
+     * Sets the memory in bytes the textures may use and releases textures until it is met.
+     **/
+    void setBudget(qint64 budget);
+    qint64 memory() const;
+    int count() const;
+
+    /**
+     * @returns the entry of @p w or @c null if there is none. It is not marked as used.
+     **/
+    Entry *find(const EffectWindow *w);
+    /**
+     * @returns the entry of @p w, created if needed, and marks it as the most recently used.
+     **/
+    Entry &use(const EffectWindow *w);
+    /**
+     * Stores @p texture taking @p memory bytes in @p entry. The textures of the least
+     * recently used other entries are released if the budget is exceeded.
+     **/
+    void setTexture(Entry &entry, const GLTexture &texture, qint64 memory);
+    /**
+     * @returns the part of @p shape which is not cached in @p entry and has to be blurred.
+     **/
+    QRegion missing(const Entry &entry, const QRegion &shape);
+
+    /**
+     * Marks all cached results as outdated, the textures are kept.
+     **/
+    void invalidate();
+    void remove(const EffectWindow *w);
+    void clear();
+
+    quint64 hits() const;
+    quint64 partialHits() const;
+    quint64 misses() const;
+    quint64 evictions() const;
+
+private:
+    void release(Entry &entry);
+    void evict(const Entry *keep);
+
+    QHash<const EffectWindow*, Entry> m_entries;
+    qint64 m_budget = 0;
+    qint64 m_memory = 0;
+    quint64 m_useCounter = 0;
+    quint64 m_hits = 0;
+    quint64 m_partialHits = 0;
+    quint64 m_misses = 0;
+    quint64 m_evictions = 0;
+};
+
+}
+
+#endif
@@ -246,6 +246,80 @@ BlurShader::BlurShader(QObject *parent)
 
         ShaderManager::instance()->popShader();
     }
+
+    if (m_valid && GLPlatform::instance()->supports(ComputeShaders) && qgetenv("KWIN_BLUR_COMPUTE") != QByteArrayLiteral("0")) {
+        initComputeShaders();
+    }
+}
+
+void BlurShader::initComputeShaders()
+{
+    // Same iterations as the fragment shaders, but every invocation writes one texel of the
+    // target image. The rect uniform restricts the dispatch to one rect of the blur region.
+    QByteArray computeHeader;
+    if (GLPlatform::instance()->isGLES()) {
+        computeHeader += "#version 310 es\n\n";
+        computeHeader += "precision highp float;\n";
+    } else {
+        computeHeader += "#version 430\n\n";
+    }
+    computeHeader += "layout(local_size_x = 16, local_size_y = 16) in;\n";
+    computeHeader += "layout(rgba8, binding = 0) writeonly uniform highp image2D targetImage;\n";
+    computeHeader += "uniform highp sampler2D texUnit;\n";
+    computeHeader += "uniform float offset;\n";
+    computeHeader += "uniform vec2 halfpixel;\n";
+    computeHeader += "uniform ivec4 rect;\n\n";
+    computeHeader += "void main(void)\n";
+    computeHeader += "{\n";
+    computeHeader += "    ivec2 pos = ivec2(gl_GlobalInvocationID.xy);\n";
+    computeHeader += "    if (pos.x >= rect.z || pos.y >= rect.w) {\n";
+    computeHeader += "        return;\n";
+    computeHeader += "    }\n";
+    computeHeader += "    ivec2 texel = rect.xy + pos;\n";
+    computeHeader += "    vec2 uv = (vec2(texel) + 0.5) / vec2(imageSize(targetImage));\n";
+    computeHeader += "    \n";
+
+    QByteArray computeDownSource = computeHeader;
+    computeDownSource += "    vec4 sum = texture(texUnit, uv) * 4.0;\n";
+    computeDownSource += "    sum += texture(texUnit, uv - halfpixel.xy * offset);\n";
+    computeDownSource += "    sum += texture(texUnit, uv + halfpixel.xy * offset);\n";
+    computeDownSource += "    sum += texture(texUnit, uv + vec2(halfpixel.x, -halfpixel.y) * offset);\n";
+    computeDownSource += "    sum += texture(texUnit, uv - vec2(halfpixel.x, -halfpixel.y) * offset);\n";
+    computeDownSource += "    \n";
+    computeDownSource += "    imageStore(targetImage, texel, sum / 8.0);\n";
+    computeDownSource += "}\n";
+
+    QByteArray computeUpSource = computeHeader;
+    computeUpSource += "    vec4 sum = texture(texUnit, uv + vec2(-halfpixel.x * 2.0, 0.0) * offset);\n";
+    computeUpSource += "    sum += texture(texUnit, uv + vec2(-halfpixel.x, halfpixel.y) * offset) * 2.0;\n";
+    computeUpSource += "    sum += texture(texUnit, uv + vec2(0.0, halfpixel.y * 2.0) * offset);\n";
+    computeUpSource += "    sum += texture(texUnit, uv + vec2(halfpixel.x, halfpixel.y) * offset) * 2.0;\n";
+    computeUpSource += "    sum += texture(texUnit, uv + vec2(halfpixel.x * 2.0, 0.0) * offset);\n";
+    computeUpSource += "    sum += texture(texUnit, uv + vec2(halfpixel.x, -halfpixel.y) * offset) * 2.0;\n";
+    computeUpSource += "    sum += texture(texUnit, uv + vec2(0.0, -halfpixel.y * 2.0) * offset);\n";
+    computeUpSource += "    sum += texture(texUnit, uv + vec2(-halfpixel.x, -halfpixel.y) * offset) * 2.0;\n";
+    computeUpSource += "    \n";
+    computeUpSource += "    imageStore(targetImage, texel, sum / 12.0);\n";
+    computeUpSource += "}\n";
+
+    m_computeDownsample.reset(ShaderManager::instance()->loadComputeShaderFromCode(computeDownSource));
+    m_computeUpsample.reset(ShaderManager::instance()->loadComputeShaderFromCode(computeUpSource));
+
+    m_computeValid = m_computeDownsample->isValid() && m_computeUpsample->isValid();
+    if (!m_computeValid) {
+        // the fragment shaders are used instead
+        m_computeDownsample.reset();
+        m_computeUpsample.reset();
+        return;
+    }
+
+    m_offsetLocationComputeDownsample = m_computeDownsample->uniformLocation("offset");
+    m_halfpixelLocationComputeDownsample = m_computeDownsample->uniformLocation("halfpixel");
+    m_rectLocationComputeDownsample = m_computeDownsample->uniformLocation("rect");
+
+    m_offsetLocationComputeUpsample = m_computeUpsample->uniformLocation("offset");
+    m_halfpixelLocationComputeUpsample = m_computeUpsample->uniformLocation("halfpixel");
+    m_rectLocationComputeUpsample = m_computeUpsample->uniformLocation("rect");
 }
 
 BlurShader::~BlurShader()
@@ -442,4 +516,60 @@ void BlurShader::unbind()
     ShaderManager::instance()->popShader();
 }
 
+void BlurShader::compute(SampleType sampleType, GLTexture &source, GLTexture &target, const QVector<QRect> &rects, float offset)
+{
+    if (!isComputeValid()) {
+        return;
+    }
+
+    GLShader *shader = nullptr;
+    int offsetLocation = -1;
+    int halfpixelLocation = -1;
+    int rectLocation = -1;
+
+    switch (sampleType) {
+    case DownSampleType:
+        shader = m_computeDownsample.data();
+        offsetLocation = m_offsetLocationComputeDownsample;
+        halfpixelLocation = m_halfpixelLocationComputeDownsample;
+        rectLocation = m_rectLocationComputeDownsample;
+        break;
+
+    case UpSampleType:
+        shader = m_computeUpsample.data();
+        offsetLocation = m_offsetLocationComputeUpsample;
+        halfpixelLocation = m_halfpixelLocationComputeUpsample;
+        rectLocation = m_rectLocationComputeUpsample;
+        break;
+
+    default:
+        Q_UNREACHABLE();
+        break;
+    }
+
+    ShaderManager::instance()->pushShader(shader);
+    shader->setUniform(offsetLocation, offset);
+    shader->setUniform(halfpixelLocation, QVector2D(0.5 / target.width(), 0.5 / target.height()));
+
+    glActiveTexture(GL_TEXTURE0);
+    source.bind();
+    glBindImageTexture(0, target.texture(), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+
+    for (const QRect &rect : rects) {
+        if (rect.isEmpty()) {
+            continue;
+        }
+        // the image has its origin in the bottom left corner
+        glUniform4i(rectLocation, rect.x(), target.height() - rect.y() - rect.height(), rect.width(), rect.height());
+        glDispatchCompute((rect.width() + 15) / 16, (rect.height() + 15) / 16, 1);
+    }
+
+    // The result is read by the next iteration, by the final upscale and by the blur cache
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+
+    glBindImageTexture(0, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+    source.unbind();
+    ShaderManager::instance()->popShader();
+}
+
 } // namespace KWin
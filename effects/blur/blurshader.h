@@ -26,6 +26,7 @@
 #include <QMatrix4x4>
 #include <QObject>
 #include <QScopedPointer>
+#include <QVector>
 #include <QVector2D>
 #include <QVector4D>
 
@@ -59,11 +60,26 @@ public:
     void setTexturePosition(const QPoint &texPos);
     void setBlurRect(const QRect &blurRect, const QSize &screenSize);
 
+    /**
+     * Whether the down and upsample iterations can run as compute shaders.
+     **/
+    bool isComputeValid() const;
+    /**
+     * Runs a down or upsample iteration as compute shader, sampling @p source and writing
+     * into @p target. The @p rects are in texels of @p target with the origin in the top
+     * left corner, like the geometry used for the fragment shaders.
+     **/
+    void compute(SampleType sampleType, GLTexture &source, GLTexture &target, const QVector<QRect> &rects, float offset);
+
 private:
+    void initComputeShaders();
+
     QScopedPointer<GLShader> m_shaderDownsample;
     QScopedPointer<GLShader> m_shaderUpsample;
     QScopedPointer<GLShader> m_shaderCopysample;
     QScopedPointer<GLShader> m_shaderNoisesample;
+    QScopedPointer<GLShader> m_computeDownsample;
+    QScopedPointer<GLShader> m_computeUpsample;
 
     int m_mvpMatrixLocationDownsample;
     int m_offsetLocationDownsample;
@@ -86,6 +102,14 @@ private:
     int m_texStartPosLocationNoisesample;
     int m_halfpixelLocationNoisesample;
 
+    int m_offsetLocationComputeDownsample;
+    int m_halfpixelLocationComputeDownsample;
+    int m_rectLocationComputeDownsample;
+
+    int m_offsetLocationComputeUpsample;
+    int m_halfpixelLocationComputeUpsample;
+    int m_rectLocationComputeUpsample;
+
     //Caching uniform values to aviod unnecessary setUniform calls
     int m_activeSampleType = -1;
 
@@ -102,6 +126,7 @@ private:
     QMatrix4x4 m_matrixNoisesample;
 
     bool m_valid = false;
+    bool m_computeValid = false;
 
     Q_DISABLE_COPY(BlurShader);
 };
@@ -111,6 +136,11 @@ inline bool BlurShader::isValid() const
     return m_valid;
 }
 
+inline bool BlurShader::isComputeValid() const
+{
+    return m_computeValid;
+}
+
 } // namespace KWin
 
 #endif
@@ -121,7 +121,7 @@ void CoverSwitchEffect::prePaintScreen(ScreenPrePaintData& data, int time)
     if (mActivated || stop || stopRequested) {
         data.mask |= Effect::PAINT_SCREEN_WITH_TRANSFORMED_WINDOWS;
         if (animation || start || stop) {
-            timeLine.update(std::chrono::milliseconds(time));
+            timeLine.advance(effects->presentationTime());
         }
         if (selected_window == NULL)
             abort();
@@ -376,10 +376,10 @@ void CubeEffect::prePaintScreen(ScreenPrePaintData& data, int time)
 
         if (animationState != AnimationState::None || verticalAnimationState != VerticalAnimationState::None) {
             if (animationState != AnimationState::None) {
-                timeLine.update(std::chrono::milliseconds(time));
+                timeLine.advance(effects->presentationTime());
             }
             if (verticalAnimationState != VerticalAnimationState::None) {
-                verticalTimeLine.update(std::chrono::milliseconds(time));
+                verticalTimeLine.advance(effects->presentationTime());
             }
             rotateCube();
         }
@@ -95,15 +95,15 @@ void DimInactiveEffect::reconfigure(ReconfigureFlags flags)
 
 void DimInactiveEffect::prePaintScreen(ScreenPrePaintData &data, int time)
 {
-    const std::chrono::milliseconds delta(time);
+    const std::chrono::nanoseconds presentationTime = effects->presentationTime();
 
     if (m_fullScreenTransition.active) {
-        m_fullScreenTransition.timeLine.update(delta);
+        m_fullScreenTransition.timeLine.advance(presentationTime);
     }
 
     auto transitionIt = m_transitions.begin();
     while (transitionIt != m_transitions.end()) {
-        (*transitionIt).update(delta);
+        (*transitionIt).advance(presentationTime);
         ++transitionIt;
     }
 
@@ -81,11 +81,11 @@ void GlideEffect::reconfigure(ReconfigureFlags flags)
 
 void GlideEffect::prePaintScreen(ScreenPrePaintData &data, int time)
 {
-    const std::chrono::milliseconds delta(time);
+    const std::chrono::nanoseconds presentationTime = effects->presentationTime();
 
     auto animationIt = m_animations.begin();
     while (animationIt != m_animations.end()) {
-        (*animationIt).update(delta);
+        (*animationIt).advance(presentationTime);
         ++animationIt;
     }
 
@@ -199,6 +199,11 @@ bool GlideEffect::isActive() const
     return !m_animations.isEmpty();
 }
 
+bool GlideEffect::isActiveForWindow(const EffectWindow *w) const
+{
+    return m_animations.contains(const_cast<EffectWindow*>(w));
+}
+
 bool GlideEffect::supported()
 {
     return effects->isOpenGLCompositing()
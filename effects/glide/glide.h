@@ -55,6 +55,7 @@ public:
     void postPaintScreen() override;
 
     bool isActive() const override;
+    bool isActiveForWindow(const EffectWindow *w) const override;
     int requestedEffectChainPosition() const override;
 
     static bool supported();
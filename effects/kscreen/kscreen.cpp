@@ -81,7 +81,7 @@ void KscreenEffect::reconfigure(ReconfigureFlags flags)
 void KscreenEffect::prePaintScreen(ScreenPrePaintData &data, int time)
 {
     if (m_state == StateFadingIn || m_state == StateFadingOut) {
-        m_timeLine.update(std::chrono::milliseconds(time));
+        m_timeLine.advance(effects->presentationTime());
         if (m_timeLine.done()) {
             switchState();
         }
@@ -55,11 +55,11 @@ void MagicLampEffect::reconfigure(ReconfigureFlags)
 
 void MagicLampEffect::prePaintScreen(ScreenPrePaintData& data, int time)
 {
-    const std::chrono::milliseconds delta(time);
+    const std::chrono::nanoseconds presentationTime = effects->presentationTime();
 
     auto animationIt = m_animations.begin();
     while (animationIt != m_animations.end()) {
-        (*animationIt).update(delta);
+        (*animationIt).advance(presentationTime);
         ++animationIt;
     }
 
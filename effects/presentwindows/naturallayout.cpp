@@ -0,0 +1,484 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2008 Lucas Murray <lmurray@undefinedfire.com>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+
+#include "naturallayout.h"
+
+#include <QElapsedTimer>
+
+#include <algorithm>
+
+namespace KWin
+{
+
+static inline int floorDiv(int value, int divisor)
+{
+    return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+}
+
+static inline QRect withMargin(const QRect &rect)
+{
+    // Windows closer than 5 pixels to each other count as overlapping
+    return rect.adjusted(-5, -5, 5, 5);
+}
+
+void NaturalLayout::SpatialIndex::reset(int cellSize, int count)
+{
+    m_cells.clear();
+    m_cellSize = qMax(1, cellSize);
+    m_visited.fill(0, count);
+    m_stamp = 0;
+}
+
+template <typename F>
+void NaturalLayout::SpatialIndex::forEachCell(const QRect &rect, F f) const
+{
+    const int x1 = floorDiv(rect.left(), m_cellSize);
+    const int x2 = floorDiv(rect.right(), m_cellSize);
+    const int y1 = floorDiv(rect.top(), m_cellSize);
+    const int y2 = floorDiv(rect.bottom(), m_cellSize);
+    for (int x = x1; x <= x2; ++x) {
+        for (int y = y1; y <= y2; ++y) {
+            f((quint64(quint32(x)) << 32) | quint32(y));
+        }
+    }
+}
+
+void NaturalLayout::SpatialIndex::insert(int index, const QRect &rect)
+{
+    forEachCell(withMargin(rect), [this, index] (quint64 cell) {
+        m_cells[cell].append(index);
+    });
+}
+
+void NaturalLayout::SpatialIndex::remove(int index, const QRect &rect)
+{
+    forEachCell(withMargin(rect), [this, index] (quint64 cell) {
+        auto it = m_cells.find(cell);
+        if (it == m_cells.end()) {
+            return;
+        }
+        it->removeOne(index);
+        if (it->isEmpty()) {
+            m_cells.erase(it);
+        }
+    });
+}
+
+void NaturalLayout::SpatialIndex::move(int index, const QRect &from, const QRect &to)
+{
+    if (from == to) {
+        return;
+    }
+    remove(index, from);
+    insert(index, to);
+}
+
+void NaturalLayout::SpatialIndex::query(const QRect &rect, QVector<int> &candidates)
+{
+    candidates.clear();
+    if (++m_stamp == 0) {
+        // stamp wrapped around, forget all old visits
+        m_visited.fill(0);
+        m_stamp = 1;
+    }
+    forEachCell(withMargin(rect), [this, &candidates] (quint64 cell) {
+        const auto it = m_cells.constFind(cell);
+        if (it == m_cells.constEnd()) {
+            return;
+        }
+        for (int index : *it) {
+            if (m_visited[index] == m_stamp) {
+                continue;
+            }
+            m_visited[index] = m_stamp;
+            candidates.append(index);
+        }
+    });
+    // keep the order of the window list, the layout must not depend on the hashing
+    std::sort(candidates.begin(), candidates.end());
+}
+
+NaturalLayout::NaturalLayout(const QRect &area, int accuracy, bool fillGaps)
+    : m_area(area)
+    , m_accuracy(accuracy)
+    , m_fillGaps(fillGaps)
+{
+}
+
+void NaturalLayout::addWindow(Key key, const QRect &geometry)
+{
+    // Reuse the unused "slot" as a preferred direction attribute. This is used when the window
+    // is on the edge of the screen to try to use as much screen real estate as possible.
+    m_windows.append(Window{key, geometry, geometry, m_windows.count() % 4});
+}
+
+void NaturalLayout::reuse(const NaturalLayout &previous)
+{
+    if (m_prepared || previous.m_area != m_area || previous.m_accuracy != m_accuracy) {
+        return;
+    }
+    for (const Window &window : qAsConst(m_windows)) {
+        const auto it = previous.m_separated.constFind(window.key);
+        if (it != previous.m_separated.constEnd() && it->first == window.geometry) {
+            m_seeds.insert(window.key, it->second);
+        }
+    }
+}
+
+void NaturalLayout::cancel()
+{
+    m_cancelled.store(1);
+}
+
+void NaturalLayout::prepare()
+{
+    m_prepared = true;
+    m_bounds = m_area;
+    int cellSize = 0;
+    for (Window &window : m_windows) {
+        window.target = m_seeds.value(window.key, window.geometry);
+        m_bounds = m_bounds.united(window.target);
+        cellSize += qMax(window.geometry.width(), window.geometry.height());
+    }
+    if (m_windows.isEmpty()) {
+        m_phase = Phase::Finished;
+        return;
+    }
+    // A cell of roughly one window keeps the number of cells per window and the
+    // number of windows per cell small
+    m_index.reset(cellSize / m_windows.count(), m_windows.count());
+    for (int i = 0; i < m_windows.count(); ++i) {
+        m_index.insert(i, m_windows.at(i).target);
+    }
+}
+
+bool NaturalLayout::step(qint64 budget)
+{
+    QElapsedTimer timer;
+    timer.start();
+    if (!m_prepared) {
+        prepare();
+    }
+    while (m_phase != Phase::Finished) {
+        if (m_cancelled.load()) {
+            return false;
+        }
+        switch (m_phase) {
+        case Phase::Separate:
+            separateWindow(m_current++);
+            if (m_current == m_windows.count()) {
+                // a full pass without any overlap ends the brute-forcing
+                if (!m_changed) {
+                    for (const Window &window : qAsConst(m_windows)) {
+                        m_separated.insert(window.key, qMakePair(window.geometry, window.target));
+                    }
+                    m_phase = Phase::Scale;
+                }
+                m_current = 0;
+                m_changed = false;
+            }
+            break;
+        case Phase::Scale:
+            scaleToArea();
+            m_phase = m_fillGaps ? Phase::FillGaps : Phase::Finished;
+            break;
+        case Phase::FillGaps:
+            enlargeWindow(m_current++);
+            if (m_current == m_windows.count()) {
+                if (!m_changed) {
+                    limitScale();
+                    m_phase = Phase::Finished;
+                }
+                m_current = 0;
+                m_changed = false;
+            }
+            break;
+        case Phase::Finished:
+            break;
+        }
+        if (budget >= 0 && timer.nsecsElapsed() >= budget) {
+            break;
+        }
+    }
+    return isFinished();
+}
+
+void NaturalLayout::separateWindow(int index)
+{
+    // Push the window apart from all overlapping windows _slightly_ as we try to
+    // brute-force the most optimal positions over many iterations.
+    Window &w = m_windows[index];
+    m_index.query(w.target, m_candidates);
+    for (int candidate : qAsConst(m_candidates)) {
+        if (candidate == index) {
+            continue;
+        }
+        Window &e = m_windows[candidate];
+        if (!withMargin(w.target).intersects(withMargin(e.target))) {
+            continue;
+        }
+        m_changed = true;
+        const QRect oldW = w.target;
+        const QRect oldE = e.target;
+
+        // Determine pushing direction
+        QPoint diff(e.target.center() - w.target.center());
+        // Prevent dividing by zero and non-movement
+        if (diff.x() == 0 && diff.y() == 0)
+            diff.setX(1);
+        // Approximate a vector of between 10px and 20px in magnitude in the same direction
+        diff *= m_accuracy / double(diff.manhattanLength());
+        // Move both windows apart
+        w.target.translate(-diff);
+        e.target.translate(diff);
+
+        // Try to keep the bounding rect the same aspect as the screen so that more
+        // screen real estate is utilised. We do this by splitting the screen into nine
+        // equal sections, if the window center is in any of the corner sections pull the
+        // window towards the outer corner. If it is in any of the other edge sections
+        // alternate between each corner on that edge. We don't want to determine it
+        // randomly as it will not produce consistant locations when using the filter.
+        // Only move one window so we don't cause large amounts of unnecessary zooming
+        // in some situations. We need to do this even when expanding later just in case
+        // all windows are the same size.
+        // (We are using an old bounding rect for this, hopefully it doesn't matter)
+        int xSection = (w.target.x() - m_bounds.x()) / (m_bounds.width() / 3);
+        int ySection = (w.target.y() - m_bounds.y()) / (m_bounds.height() / 3);
+        diff = QPoint(0, 0);
+        if (xSection != 1 || ySection != 1) { // Remove this if you want the center to pull as well
+            if (xSection == 1)
+                xSection = (w.direction / 2 ? 2 : 0);
+            if (ySection == 1)
+                ySection = (w.direction % 2 ? 2 : 0);
+        }
+        if (xSection == 0 && ySection == 0)
+            diff = QPoint(m_bounds.topLeft() - w.target.center());
+        if (xSection == 2 && ySection == 0)
+            diff = QPoint(m_bounds.topRight() - w.target.center());
+        if (xSection == 2 && ySection == 2)
+            diff = QPoint(m_bounds.bottomRight() - w.target.center());
+        if (xSection == 0 && ySection == 2)
+            diff = QPoint(m_bounds.bottomLeft() - w.target.center());
+        if (diff.x() != 0 || diff.y() != 0) {
+            diff *= m_accuracy / double(diff.manhattanLength());
+            w.target.translate(diff);
+        }
+
+        m_index.move(index, oldW, w.target);
+        m_index.move(candidate, oldE, e.target);
+
+        // Update bounding rect
+        m_bounds = m_bounds.united(w.target);
+        m_bounds = m_bounds.united(e.target);
+    }
+}
+
+double NaturalLayout::boundsScale() const
+{
+    // Work out scaling by getting the most top-left and most bottom-right window coords.
+    // The 20's and 10's are so that the windows don't touch the edge of the screen.
+    if (m_bounds == m_area)
+        return 1.0; // Don't add borders to the screen
+    else if (m_area.width() / double(m_bounds.width()) < m_area.height() / double(m_bounds.height()))
+        return (m_area.width() - 20) / double(m_bounds.width());
+    else
+        return (m_area.height() - 20) / double(m_bounds.height());
+}
+
+QRect NaturalLayout::scaledBounds(double scale) const
+{
+    // Make bounding rect fill the screen size for later steps
+    return QRect(
+               m_bounds.x() - (m_area.width() - 20 - m_bounds.width() * scale) / 2 - 10 / scale,
+               m_bounds.y() - (m_area.height() - 20 - m_bounds.height() * scale) / 2 - 10 / scale,
+               m_area.width() / scale,
+               m_area.height() / scale
+           );
+}
+
+void NaturalLayout::scaleToArea()
+{
+    const double scale = boundsScale();
+    const QRect bounds = scaledBounds(scale);
+
+    // Move all windows back onto the screen and set their scale
+    for (Window &window : m_windows) {
+        window.target.setRect((window.target.x() - bounds.x()) * scale + m_area.x(),
+                              (window.target.y() - bounds.y()) * scale + m_area.y(),
+                              window.target.width() * scale,
+                              window.target.height() * scale
+                              );
+    }
+
+    if (!m_fillGaps) {
+        return;
+    }
+    // Don't expand onto or over the border
+    m_outerBorder = m_area.adjusted(-200, -200, 200, 200);
+    m_innerBorder = m_area.adjusted(10 / scale, 10 / scale, -10 / scale, -10 / scale);
+
+    int cellSize = 0;
+    for (const Window &window : qAsConst(m_windows)) {
+        cellSize += qMax(window.target.width(), window.target.height());
+    }
+    m_index.reset(cellSize / m_windows.count(), m_windows.count());
+    for (int i = 0; i < m_windows.count(); ++i) {
+        m_index.insert(i, m_windows.at(i).target);
+    }
+}
+
+void NaturalLayout::enlargeWindow(int index)
+{
+    // Try to fill the gaps by enlarging windows if they have the space
+    QRect *target = &m_windows[index].target;
+    const Window &window = m_windows.at(index);
+    const QRect original = *target;
+    QRect oldRect;
+    // This may cause some slight distortion if the windows are enlarged a large amount
+    int widthDiff = m_accuracy;
+    int heightDiff = heightForWidth(window, target->width() + widthDiff) - target->height();
+    int xDiff = widthDiff / 2;  // Also move a bit in the direction of the enlarge, allows the
+    int yDiff = heightDiff / 2; // center windows to be enlarged if there is gaps on the side.
+
+    // heightDiff (and yDiff) will be re-computed after each successfull enlargement attempt
+    // so that the error introduced in the window's aspect ratio is minimized
+
+    // Attempt enlarging to the top-right
+    oldRect = *target;
+    target->setRect(target->x() + xDiff,
+                    target->y() - yDiff - heightDiff,
+                    target->width() + widthDiff,
+                    target->height() + heightDiff
+                    );
+    if (isOverlappingAny(index))
+        *target = oldRect;
+    else {
+        m_changed = true;
+        heightDiff = heightForWidth(window, target->width() + widthDiff) - target->height();
+        yDiff = heightDiff / 2;
+    }
+
+    // Attempt enlarging to the bottom-right
+    oldRect = *target;
+    target->setRect(
+                     target->x() + xDiff,
+                     target->y() + yDiff,
+                     target->width() + widthDiff,
+                     target->height() + heightDiff
+                 );
+    if (isOverlappingAny(index))
+        *target = oldRect;
+    else {
+        m_changed = true;
+        heightDiff = heightForWidth(window, target->width() + widthDiff) - target->height();
+        yDiff = heightDiff / 2;
+    }
+
+    // Attempt enlarging to the bottom-left
+    oldRect = *target;
+    target->setRect(
+                     target->x() - xDiff - widthDiff,
+                     target->y() + yDiff,
+                     target->width() + widthDiff,
+                     target->height() + heightDiff
+                 );
+    if (isOverlappingAny(index))
+        *target = oldRect;
+    else {
+        m_changed = true;
+        heightDiff = heightForWidth(window, target->width() + widthDiff) - target->height();
+        yDiff = heightDiff / 2;
+    }
+
+    // Attempt enlarging to the top-left
+    oldRect = *target;
+    target->setRect(
+                     target->x() - xDiff - widthDiff,
+                     target->y() - yDiff - heightDiff,
+                     target->width() + widthDiff,
+                     target->height() + heightDiff
+                 );
+    if (isOverlappingAny(index))
+        *target = oldRect;
+    else
+        m_changed = true;
+
+    m_index.move(index, original, *target);
+}
+
+void NaturalLayout::limitScale()
+{
+    // The expanding code above can actually enlarge windows over 1.0/2.0 scale, we don't like this
+    // We can't add this to the loop above as it would cause a never-ending loop so we have to make
+    // do with the less-than-optimal space usage with using this method.
+    for (Window &window : m_windows) {
+        QRect *target = &window.target;
+        const QRect &geometry = window.geometry;
+        double scale = target->width() / double(geometry.width());
+        if (scale > 2.0 || (scale > 1.0 && (geometry.width() > 300 || geometry.height() > 300))) {
+            scale = (geometry.width() > 300 || geometry.height() > 300) ? 1.0 : 2.0;
+            target->setRect(
+                             target->center().x() - int(geometry.width() * scale) / 2,
+                             target->center().y() - int(geometry.height() * scale) / 2,
+                             geometry.width() * scale,
+                             geometry.height() * scale);
+        }
+    }
+}
+
+bool NaturalLayout::isOverlappingAny(int index)
+{
+    const QRect &target = m_windows.at(index).target;
+    // The border is the outer rect minus the inner rect
+    if (m_outerBorder.intersects(target) && !m_innerBorder.contains(target))
+        return true;
+    m_index.query(target, m_candidates);
+    for (int candidate : qAsConst(m_candidates)) {
+        if (candidate == index)
+            continue;
+        if (withMargin(target).intersects(withMargin(m_windows.at(candidate).target)))
+            return true;
+    }
+    return false;
+}
+
+QHash<NaturalLayout::Key, QRect> NaturalLayout::targets() const
+{
+    QHash<Key, QRect> targets;
+    targets.reserve(m_windows.count());
+    if (m_phase != Phase::Separate || !m_prepared) {
+        for (const Window &window : m_windows) {
+            targets.insert(window.key, window.target);
+        }
+        return targets;
+    }
+    // Still separating, map the current iteration onto the screen area
+    const double scale = boundsScale();
+    const QRect bounds = scaledBounds(scale);
+    for (const Window &window : m_windows) {
+        targets.insert(window.key, QRect((window.target.x() - bounds.x()) * scale + m_area.x(),
+                                         (window.target.y() - bounds.y()) * scale + m_area.y(),
+                                         window.target.width() * scale,
+                                         window.target.height() * scale));
+    }
+    return targets;
+}
+
+}
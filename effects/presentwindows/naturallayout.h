@@ -0,0 +1,162 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2008 Lucas Murray <lmurray@undefinedfire.com>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+
+#ifndef KWIN_PRESENTWINDOWS_NATURALLAYOUT_H
+#define KWIN_PRESENTWINDOWS_NATURALLAYOUT_H
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QRect>
+#include <QVector>
+
+namespace KWin
+{
+
+/**
+ * The "natural" layout of the present windows effect.
+ *
+ * Windows start at their real geometry and are pushed apart until no two of them
+ * overlap, afterwards the result is scaled onto the screen area and optionally the
+ * gaps are filled by enlarging windows.
+ *
+ * The layout only operates on plain geometries identified by an opaque key, it never
+ * touches an EffectWindow. This allows to advance it on a worker thread. The work is
+ * split into slices with step(), targets() always provides the best layout found so far.
+ **/
+class NaturalLayout
+{
+public:
+    typedef quintptr Key;
+
+    NaturalLayout(const QRect &area, int accuracy, bool fillGaps);
+
+    /**
+     * Adds the window identified by @p key with its current @p geometry.
+     * Windows have to be added in a stable order, the position in the list determines
+     * the preferred direction a window is pulled to.
+     **/
+    void addWindow(Key key, const QRect &geometry);
+    int windowCount() const {
+        return m_windows.count();
+    }
+    /**
+     * Starts from the solution of @p previous for all windows which were laid out there
+     * with the same geometry. Adding or removing a single window then only needs a few
+     * iterations. Must be called before the first step().
+     **/
+    void reuse(const NaturalLayout &previous);
+    /**
+     * The number of windows which start from the solution of a previous layout.
+     **/
+    int reusedCount() const {
+        return m_seeds.count();
+    }
+
+    /**
+     * Advances the layout for at most @p budget nanoseconds. A negative budget runs the
+     * layout to completion.
+     * @returns @c true once the layout is finished
+     **/
+    bool step(qint64 budget = -1);
+    bool isFinished() const {
+        return m_phase == Phase::Finished;
+    }
+    /**
+     * Aborts the layout, a step() running on another thread returns as soon as possible.
+     **/
+    void cancel();
+
+    /**
+     * The target geometries in screen coordinates. If the layout is not yet finished
+     * this is the provisional layout of the current iteration.
+     **/
+    QHash<Key, QRect> targets() const;
+
+private:
+    /**
+     * Uniform grid over the targets, used to find the candidates for an overlap check
+     * without testing against every other window.
+     **/
+    class SpatialIndex
+    {
+    public:
+        void reset(int cellSize, int count);
+        void insert(int index, const QRect &rect);
+        void remove(int index, const QRect &rect);
+        void move(int index, const QRect &from, const QRect &to);
+        /**
+         * Fills @p candidates with the sorted indices of all rects in cells touched by @p rect.
+         **/
+        void query(const QRect &rect, QVector<int> &candidates);
+    private:
+        template <typename F>
+        void forEachCell(const QRect &rect, F f) const;
+        QHash<quint64, QVector<int>> m_cells;
+        QVector<quint32> m_visited;
+        quint32 m_stamp = 0;
+        int m_cellSize = 1;
+    };
+    enum class Phase {
+        Separate,
+        Scale,
+        FillGaps,
+        Finished
+    };
+    struct Window {
+        Key key;
+        QRect geometry;
+        QRect target;
+        int direction;
+    };
+    void prepare();
+    void separateWindow(int index);
+    void scaleToArea();
+    void enlargeWindow(int index);
+    void limitScale();
+    bool isOverlappingAny(int index);
+    double boundsScale() const;
+    QRect scaledBounds(double scale) const;
+    int heightForWidth(const Window &window, int width) const {
+        return int((width / double(window.geometry.width())) * window.geometry.height());
+    }
+
+    QRect m_area;
+    int m_accuracy;
+    bool m_fillGaps;
+    QVector<Window> m_windows;
+    // Windows start here instead of their geometry, see reuse()
+    QHash<Key, QRect> m_seeds;
+    // Solution of the separation phase with the geometry it was computed for
+    QHash<Key, QPair<QRect, QRect>> m_separated;
+    SpatialIndex m_index;
+    QVector<int> m_candidates;
+    QRect m_bounds;
+    QRect m_outerBorder;
+    QRect m_innerBorder;
+    Phase m_phase = Phase::Separate;
+    bool m_prepared = false;
+    int m_current = 0;
+    bool m_changed = false;
+    QAtomicInt m_cancelled;
+};
+
+}
+
+#endif
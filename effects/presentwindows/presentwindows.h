@@ -22,10 +22,14 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef KWIN_PRESENTWINDOWS_H
 #define KWIN_PRESENTWINDOWS_H
 
+#include "naturallayout.h"
 #include "presentwindows_proxy.h"
 
 #include <kwineffects.h>
 
+#include <QFutureWatcher>
+#include <QSharedPointer>
+
 class QMouseEvent;
 class QElapsedTimer;
 class QQuickView;
@@ -234,6 +238,7 @@ private Q_SLOTS:
 protected:
     // Window rearranging
     void rearrangeWindows();
+    void updateCaptionFrames();
     void reCreateGrids();
     void calculateWindowTransformations(EffectWindowList windowlist, int screen,
                                         WindowMotionManager& motionManager, bool external = false);
@@ -254,7 +259,10 @@ protected:
     inline int heightForWidth(EffectWindow *w, int width) {
         return int((width / double(w->width())) * w->height());
     }
-    bool isOverlappingAny(EffectWindow *w, const QHash<EffectWindow*, QRect> &targets, const QRegion &border);
+    void applyNaturalLayout(const NaturalLayout &layout, const EffectWindowList &windowlist,
+                            WindowMotionManager& motionManager);
+    void cancelNaturalLayout(int screen);
+    void cancelNaturalLayouts();
 
     // Filter box
     void updateFilterFrame();
@@ -309,6 +317,10 @@ private:
     // Grid layout info
     QList<GridSize> m_gridSizes;
 
+    // Natural layout info, the last layout of each screen and the ones still running
+    QHash<int, QSharedPointer<NaturalLayout>> m_naturalLayouts;
+    QHash<int, QFutureWatcher<bool>*> m_naturalLayoutWatchers;
+
     // Filter box
     EffectFrame* m_filterFrame;
     QString m_windowFilter;
@@ -39,6 +39,9 @@ public:
         return ef == Effect::Resize;
     }
     inline bool isActive() const { return m_active || AnimationEffect::isActive(); }
+    bool isActiveForWindow(const EffectWindow *w) const override {
+        return (m_active && w == m_resizeWindow) || AnimationEffect::isActiveForWindow(w);
+    }
     virtual void prePaintScreen(ScreenPrePaintData& data, int time);
     virtual void prePaintWindow(EffectWindow* w, WindowPrePaintData& data, int time);
     virtual void paintWindow(EffectWindow* w, int mask, QRegion region, WindowPaintData& data);
@@ -57,11 +57,11 @@ void SheetEffect::reconfigure(ReconfigureFlags flags)
 
 void SheetEffect::prePaintScreen(ScreenPrePaintData &data, int time)
 {
-    const std::chrono::milliseconds delta(time);
+    const std::chrono::nanoseconds presentationTime = effects->presentationTime();
 
     auto animationIt = m_animations.begin();
     while (animationIt != m_animations.end()) {
-        (*animationIt).timeLine.update(delta);
+        (*animationIt).timeLine.advance(presentationTime);
         ++animationIt;
     }
 
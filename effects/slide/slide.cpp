@@ -75,7 +75,7 @@ void SlideEffect::reconfigure(ReconfigureFlags)
 
 void SlideEffect::prePaintScreen(ScreenPrePaintData &data, int time)
 {
-    m_timeLine.update(std::chrono::milliseconds(time));
+    m_timeLine.advance(effects->presentationTime());
 
     data.mask |= PAINT_SCREEN_TRANSFORMED
               |  PAINT_SCREEN_BACKGROUND_FIRST;
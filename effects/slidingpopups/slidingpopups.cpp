@@ -105,7 +105,7 @@ void SlidingPopupsEffect::prePaintWindow(EffectWindow *w, WindowPrePaintData &da
         return;
     }
 
-    (*animationIt).timeLine.update(std::chrono::milliseconds(time));
+    (*animationIt).timeLine.advance(effects->presentationTime());
     data.setTransformed();
     w->enablePainting(EffectWindow::PAINT_DISABLED | EffectWindow::PAINT_DISABLED_BY_DELETE);
 
@@ -472,4 +472,9 @@ bool SlidingPopupsEffect::isActive() const
     return !m_animations.isEmpty();
 }
 
+bool SlidingPopupsEffect::isActiveForWindow(const EffectWindow *w) const
+{
+    return m_animations.contains(const_cast<EffectWindow*>(w));
+}
+
 } // namespace
@@ -43,6 +43,7 @@ public:
     void postPaintWindow(EffectWindow *w) override;
     void reconfigure(ReconfigureFlags flags) override;
     bool isActive() const override;
+    bool isActiveForWindow(const EffectWindow *w) const override;
 
     int requestedEffectChainPosition() const override {
         return 40;
@@ -99,7 +99,7 @@ void SnapHelperEffect::reconfigure(ReconfigureFlags flags)
 void SnapHelperEffect::prePaintScreen(ScreenPrePaintData &data, int time)
 {
     if (m_animation.active) {
-        m_animation.timeLine.update(std::chrono::milliseconds(time));
+        m_animation.timeLine.advance(effects->presentationTime());
     }
 
     effects->prePaintScreen(data, time);
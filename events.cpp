@@ -174,20 +174,99 @@ QVector<QByteArray> s_xcbEerrors({
     QByteArrayLiteral("Unknown")});
 
 
+// the highest bit of the response type only marks events sent by other clients
+static const int s_eventTypeCount = 0x80;
+
+static quint32 genericEventKey(int extension, int eventType)
+{
+    return (quint32(extension) << 16) | quint16(eventType);
+}
+
 void Workspace::registerEventFilter(X11EventFilter *filter)
 {
-    if (filter->isGenericEvent())
-        m_genericEventFilters.append(filter);
-    else
-        m_eventFilters.append(filter);
+    if (filter->isGenericEvent()) {
+        const auto eventTypes = filter->genericEventTypes();
+        for (int eventType : eventTypes) {
+            m_genericEventFilters[genericEventKey(filter->extension(), eventType)].append(filter);
+        }
+    } else {
+        m_eventFilters.resize(s_eventTypeCount);
+        const auto eventTypes = filter->eventTypes();
+        for (int eventType : eventTypes) {
+            if (eventType > 0 && eventType < s_eventTypeCount && eventType != XCB_GE_GENERIC) {
+                m_eventFilters[eventType].append(filter);
+            }
+        }
+    }
 }
 
 void Workspace::unregisterEventFilter(X11EventFilter *filter)
 {
-    if (filter->isGenericEvent())
-        m_genericEventFilters.removeOne(filter);
-    else
-        m_eventFilters.removeOne(filter);
+    if (filter->isGenericEvent()) {
+        const auto eventTypes = filter->genericEventTypes();
+        for (int eventType : eventTypes) {
+            auto it = m_genericEventFilters.find(genericEventKey(filter->extension(), eventType));
+            if (it != m_genericEventFilters.end()) {
+                it->removeOne(filter);
+                if (it->isEmpty()) {
+                    m_genericEventFilters.erase(it);
+                }
+            }
+        }
+    } else {
+        const auto eventTypes = filter->eventTypes();
+        for (int eventType : eventTypes) {
+            if (eventType > 0 && eventType < m_eventFilters.size()) {
+                m_eventFilters[eventType].removeOne(filter);
+            }
+        }
+    }
+}
+
+Toplevel *Workspace::findEventTarget(xcb_window_t w)
+{
+    auto it = m_eventTargets.find(w);
+    if (it != m_eventTargets.end()) {
+        // the input window changes with the decoration and ids get reused
+        Toplevel *target = it.value();
+        if (target->isClient()) {
+            const Client *c = static_cast<Client*>(target);
+            if (c->window() == w || c->wrapperId() == w || c->frameId() == w || c->inputId() == w) {
+                return target;
+            }
+        } else if (target->window() == w) {
+            return target;
+        }
+        m_eventTargets.erase(it);
+    }
+
+    Toplevel *target = nullptr;
+    if (Client* c = findClient(Predicate::WindowMatch, w)) {
+        target = c;
+    } else if (Client* c = findClient(Predicate::WrapperIdMatch, w)) {
+        target = c;
+    } else if (Client* c = findClient(Predicate::FrameIdMatch, w)) {
+        target = c;
+    } else if (Client *c = findClient(Predicate::InputIdMatch, w)) {
+        target = c;
+    } else {
+        target = findUnmanaged(w);
+    }
+    if (target) {
+        m_eventTargets.insert(w, target);
+    }
+    return target;
+}
+
+void Workspace::removeEventTarget(Toplevel *target)
+{
+    for (auto it = m_eventTargets.begin(); it != m_eventTargets.end();) {
+        if (it.value() == target) {
+            it = m_eventTargets.erase(it);
+        } else {
+            ++it;
+        }
+    }
 }
 
 
@@ -227,17 +306,20 @@ bool Workspace::workspaceEvent(xcb_generic_event_t *e)
         return false;
     }
 
+    // copies, filters may get destroyed while processing the event
     if (eventType == XCB_GE_GENERIC) {
         xcb_ge_generic_event_t *ge = reinterpret_cast<xcb_ge_generic_event_t *>(e);
 
-        foreach (X11EventFilter *filter, m_genericEventFilters) {
-            if (filter->extension() == ge->extension && filter->genericEventTypes().contains(ge->event_type) && filter->event(e)) {
+        const QList<X11EventFilter *> filters = m_genericEventFilters.value(genericEventKey(ge->extension, ge->event_type));
+        for (X11EventFilter *filter : filters) {
+            if (filter->event(e)) {
                 return true;
             }
         }
-    } else {
-        foreach (X11EventFilter *filter, m_eventFilters) {
-            if (filter->eventTypes().contains(eventType) && filter->event(e)) {
+    } else if (eventType < m_eventFilters.size()) {
+        const QList<X11EventFilter *> filters = m_eventFilters.at(eventType);
+        for (X11EventFilter *filter : filters) {
+            if (filter->event(e)) {
                 return true;
             }
         }
@@ -257,21 +339,13 @@ bool Workspace::workspaceEvent(xcb_generic_event_t *e)
 
     const xcb_window_t eventWindow = findEventWindow(e);
     if (eventWindow != XCB_WINDOW_NONE) {
-        if (Client* c = findClient(Predicate::WindowMatch, eventWindow)) {
-            if (c->windowEvent(e))
-                return true;
-        } else if (Client* c = findClient(Predicate::WrapperIdMatch, eventWindow)) {
-            if (c->windowEvent(e))
-                return true;
-        } else if (Client* c = findClient(Predicate::FrameIdMatch, eventWindow)) {
-            if (c->windowEvent(e))
-                return true;
-        } else if (Client *c = findClient(Predicate::InputIdMatch, eventWindow)) {
-            if (c->windowEvent(e))
-                return true;
-        } else if (Unmanaged* c = findUnmanaged(eventWindow)) {
-            if (c->windowEvent(e))
+        if (Toplevel *target = findEventTarget(eventWindow)) {
+            if (target->isClient()) {
+                if (static_cast<Client*>(target)->windowEvent(e))
+                    return true;
+            } else if (static_cast<Unmanaged*>(target)->windowEvent(e)) {
                 return true;
+            }
         }
     }
 
@@ -519,7 +593,7 @@ bool Client::windowEvent(xcb_generic_event_t *e)
     case XCB_MOTION_NOTIFY: {
         const auto *event = reinterpret_cast<xcb_motion_notify_event_t*>(e);
         motionNotifyEvent(event->event, event->state,
-                          event->event_x, event->event_y, event->root_x, event->root_y);
+                          event->event_x, event->event_y, event->root_x, event->root_y, event->time);
         workspace()->updateFocusMousePosition(QPoint(event->root_x, event->root_y));
         break;
     }
@@ -532,14 +606,14 @@ bool Client::windowEvent(xcb_generic_event_t *e)
         // Fake a MotionEvent in such cases to make handle of mouse
         // events simpler (Qt does that too).
         motionNotifyEvent(event->event, event->state,
-                          event->event_x, event->event_y, event->root_x, event->root_y);
+                          event->event_x, event->event_y, event->root_x, event->root_y, event->time);
         workspace()->updateFocusMousePosition(QPoint(event->root_x, event->root_y));
         break;
     }
     case XCB_LEAVE_NOTIFY: {
         auto *event = reinterpret_cast<xcb_leave_notify_event_t*>(e);
         motionNotifyEvent(event->event, event->state,
-                          event->event_x, event->event_y, event->root_x, event->root_y);
+                          event->event_x, event->event_y, event->root_x, event->root_y, event->time);
         leaveNotifyEvent(event);
         // not here, it'd break following enter notify handling
         // workspace()->updateFocusMousePosition( QPoint( e->xcrossing.x_root, e->xcrossing.y_root ));
@@ -569,8 +643,11 @@ bool Client::windowEvent(xcb_generic_event_t *e)
             detectShape(window());  // workaround for #19644
             updateShape();
         }
-        if (eventType == Xcb::Extensions::self()->damageNotifyEvent() && reinterpret_cast<xcb_damage_notify_event_t*>(e)->drawable == frameId())
-            damageNotifyEvent();
+        if (eventType == Xcb::Extensions::self()->damageNotifyEvent()) {
+            const auto *event = reinterpret_cast<xcb_damage_notify_event_t*>(e);
+            if (event->drawable == frameId())
+                damageNotifyEvent(QRect(event->area.x, event->area.y, event->area.width, event->area.height));
+        }
         break;
     }
     return true; // eat all events
@@ -1064,7 +1141,7 @@ bool Client::buttonReleaseEvent(xcb_window_t w, int button, int state, int x, in
 }
 
 // return value matters only when filtering events before decoration gets them
-bool Client::motionNotifyEvent(xcb_window_t w, int state, int x, int y, int x_root, int y_root)
+bool Client::motionNotifyEvent(xcb_window_t w, int state, int x, int y, int x_root, int y_root, xcb_timestamp_t time)
 {
     if (w == frameId() && isDecorated() && !isMinimized()) {
         // TODO Mouse move event dependent on state
@@ -1095,7 +1172,11 @@ bool Client::motionNotifyEvent(xcb_window_t w, int state, int x, int y, int x_ro
         y = this->y();
     }
 
-    handleMoveResize(QPoint(x, y), QPoint(x_root, y_root));
+    if (isMoveResize()) {
+        queueMoveResize(QPoint(x_root, y_root), time);
+    } else {
+        handleMoveResize(QPoint(x, y), QPoint(x_root, y_root));
+    }
     return true;
 }
 
@@ -1284,8 +1365,10 @@ bool Unmanaged::windowEvent(xcb_generic_event_t *e)
             addWorkspaceRepaint(geometry());  // in case shape change removes part of this window
             emit geometryShapeChanged(this, geometry());
         }
-        if (eventType == Xcb::Extensions::self()->damageNotifyEvent())
-            damageNotifyEvent();
+        if (eventType == Xcb::Extensions::self()->damageNotifyEvent()) {
+            const auto *event = reinterpret_cast<xcb_damage_notify_event_t*>(e);
+            damageNotifyEvent(QRect(event->area.x, event->area.y, event->area.width, event->area.height));
+        }
         break;
     }
     }
@@ -2745,6 +2745,13 @@ bool Client::doStartMoveResize()
 
 void AbstractClient::finishMoveResize(bool cancel)
 {
+    // the window ends up where the pointer was last reported, not where it was predicted to be
+    if (!cancel && m_moveResize.updatePending) {
+        updateMoveResize(m_moveResize.predictor.latest());
+    }
+    m_moveResize.updatePending = false;
+    m_moveResize.predictor.reset();
+
     GeometryUpdatesBlocker blocker(this);
     const bool wasResize = isResize(); // store across leaveMoveResize
     leaveMoveResize();
@@ -447,7 +447,7 @@ public:
         }
         switch (event->type()) {
         case QEvent::MouseMove:
-            c->updateMoveResize(event->screenPos().toPoint());
+            c->queueMoveResize(event->screenPos(), event->timestamp());
             break;
         case QEvent::MouseButtonRelease:
             if (event->buttons() == Qt::NoButton) {
@@ -491,7 +491,6 @@ public:
     }
 
     bool touchMotion(quint32 id, const QPointF &pos, quint32 time) override {
-        Q_UNUSED(time)
         AbstractClient *c = workspace()->getMovingClient();
         if (!c) {
             return false;
@@ -501,7 +500,7 @@ public:
             m_set = true;
         }
         if (m_id == id) {
-            c->updateMoveResize(pos.toPoint());
+            c->queueMoveResize(pos, time);
         }
         return true;
     }
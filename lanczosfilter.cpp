@@ -20,11 +20,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 *********************************************************************/
 
 #include "lanczosfilter.h"
-#include "client.h"
-#include "deleted.h"
 #include "effects.h"
 #include "screens.h"
-#include "unmanaged.h"
 #include "options.h"
 #include "workspace.h"
 
@@ -49,11 +46,68 @@ LanczosFilter::LanczosFilter(QObject* parent)
     , m_shader(0)
     , m_uOffsets(0)
     , m_uKernel(0)
+    , m_activeWindow(nullptr)
+    , m_useCounter(0)
+    , m_cacheMemory(0)
+    , m_cacheHits(0)
+    , m_cachePartialHits(0)
+    , m_cacheMisses(0)
+    , m_cacheEvictions(0)
 {
+    connect(effects, &EffectsHandler::windowDamaged, this,
+        [this] (EffectWindow *w, const QRect &r) {
+            auto it = m_cache.find(w);
+            if (it != m_cache.end()) {
+                it->dirty += r;
+            }
+        }
+    );
+    connect(effects, &EffectsHandler::windowGeometryShapeChanged, this,
+        [this] (EffectWindow *w) {
+            invalidateCacheTexture(w);
+        }
+    );
+    connect(effects, &EffectsHandler::windowPaddingChanged, this,
+        [this] (EffectWindow *w) {
+            invalidateCacheTexture(w);
+        }
+    );
+    connect(effects, &EffectsHandler::windowActivated, this,
+        [this] (EffectWindow *w) {
+            // the decorations of both windows change
+            invalidateCacheTexture(m_activeWindow);
+            invalidateCacheTexture(w);
+            m_activeWindow = w;
+        }
+    );
+    connect(effects, &EffectsHandler::windowDeleted, this,
+        [this] (EffectWindow *w) {
+            if (m_activeWindow == w) {
+                m_activeWindow = nullptr;
+            }
+            auto it = m_cache.find(w);
+            if (it != m_cache.end()) {
+                discardCacheTexture(it);
+                m_cache.erase(it);
+            }
+        }
+    );
+    connect(options, &Options::glLanczosCacheSizeChanged, this,
+        [this] {
+            // trim right away, the cached textures might not get painted again for a while
+            if (m_cacheMemory > qint64(options->glLanczosCacheSize()) * 1024 * 1024) {
+                effects->makeOpenGLContextCurrent();
+                evictCacheTextures(nullptr);
+            }
+        }
+    );
 }
 
 LanczosFilter::~LanczosFilter()
 {
+    for (auto it = m_cache.begin(); it != m_cache.end(); ++it) {
+        delete it->texture;
+    }
     delete m_offscreenTarget;
     delete m_offscreenTex;
 }
@@ -204,176 +258,44 @@ void LanczosFilter::performPaint(EffectWindowImpl* w, int mask, QRegion region,
             int sw = width;
             int sh = height;
 
-            GLTexture *cachedTexture = static_cast< GLTexture*>(w->data(LanczosCacheRole).value<void*>());
-            if (cachedTexture) {
-                if (cachedTexture->width() == tw && cachedTexture->height() == th) {
-                    cachedTexture->bind();
-                    if (hardwareClipping) {
-                        glEnable(GL_SCISSOR_TEST);
-                    }
-
-                    glEnable(GL_BLEND);
-                    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
-
-                    const qreal rgb = data.brightness() * data.opacity();
-                    const qreal a = data.opacity();
-
-                    ShaderBinder binder(ShaderTrait::MapTexture | ShaderTrait::Modulate | ShaderTrait::AdjustSaturation);
-                    GLShader *shader = binder.shader();
-                    QMatrix4x4 mvp = data.screenProjectionMatrix();
-                    mvp.translate(textureRect.x(), textureRect.y());
-                    shader->setUniform(GLShader::ModelViewProjectionMatrix, mvp);
-                    shader->setUniform(GLShader::ModulationConstant, QVector4D(rgb, rgb, rgb, a));
-                    shader->setUniform(GLShader::Saturation, data.saturation());
-
-                    cachedTexture->render(region, textureRect, hardwareClipping);
-
-                    glDisable(GL_BLEND);
-                    if (hardwareClipping) {
-                        glDisable(GL_SCISSOR_TEST);
-                    }
-                    cachedTexture->unbind();
-                    m_timer.start(5000, this);
-                    return;
+            CacheEntry &entry = m_cache[w];
+            entry.lastUsed = ++m_useCounter;
+            QRect dirtyRect;
+            if (!entry.texture || entry.texture->width() != tw || entry.texture->height() != th) {
+                // offscreen texture not matching - recreate
+                if (entry.texture) {
+                    m_cacheMemory -= qint64(entry.texture->width()) * entry.texture->height() * 4;
+                    delete entry.texture;
+                }
+                entry.texture = new GLTexture(GL_RGBA8, tw, th);
+                entry.texture->setFilter(GL_LINEAR);
+                entry.texture->setWrapMode(GL_CLAMP_TO_EDGE);
+                entry.sourceSize = QSize();
+                m_cacheMemory += qint64(tw) * th * 4;
+                evictCacheTextures(w);
+            }
+            if (entry.sourceSize != QSize(sw, sh)) {
+                // nothing usable in the texture, filter the complete window
+                ++m_cacheMisses;
+                entry.sourceSize = QSize(sw, sh);
+                dirtyRect = QRect(0, 0, tw, th);
+            } else if (!entry.dirty.isEmpty()) {
+                // only filter what is affected by the damage
+                dirtyRect = affectedRect(entry.dirty.boundingRect().translated(-winGeo.topLeft()), entry.sourceSize, QSize(tw, th));
+                if (dirtyRect.isEmpty()) {
+                    ++m_cacheHits;
                 } else {
-                    // offscreen texture not matching - delete
-                    delete cachedTexture;
-                    cachedTexture = 0;
-                    w->setData(LanczosCacheRole, QVariant());
+                    ++m_cachePartialHits;
                 }
+            } else {
+                ++m_cacheHits;
             }
+            entry.dirty = QRegion();
 
-            WindowPaintData thumbData = data;
-            thumbData.setXScale(1.0);
-            thumbData.setYScale(1.0);
-            thumbData.setXTranslation(-w->x() - left);
-            thumbData.setYTranslation(-w->y() - top);
-            thumbData.setBrightness(1.0);
-            thumbData.setOpacity(1.0);
-            thumbData.setSaturation(1.0);
-
-            // Bind the offscreen FBO and draw the window on it unscaled
-            updateOffscreenSurfaces();
-            GLRenderTarget::pushRenderTarget(m_offscreenTarget);
-
-            QMatrix4x4 modelViewProjectionMatrix;
-            modelViewProjectionMatrix.ortho(0, m_offscreenTex->width(), m_offscreenTex->height(), 0 , 0, 65535);
-            thumbData.setProjectionMatrix(modelViewProjectionMatrix);
-
-            glClearColor(0.0, 0.0, 0.0, 0.0);
-            glClear(GL_COLOR_BUFFER_BIT);
-            w->sceneWindow()->performPaint(mask, infiniteRegion(), thumbData);
-
-            // Create a scratch texture and copy the rendered window into it
-            GLTexture tex(GL_RGBA8, sw, sh);
-            tex.setFilter(GL_LINEAR);
-            tex.setWrapMode(GL_CLAMP_TO_EDGE);
-            tex.bind();
-
-            glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, m_offscreenTex->height() - sh, sw, sh);
-
-            // Set up the shader for horizontal scaling
-            float dx = sw / float(tw);
-            int kernelSize;
-            createKernel(dx, &kernelSize);
-            createOffsets(kernelSize, sw, Qt::Horizontal);
-
-            ShaderManager::instance()->pushShader(m_shader.data());
-            m_shader->setUniform(GLShader::ModelViewProjectionMatrix, modelViewProjectionMatrix);
-            setUniforms();
-
-            // Draw the window back into the FBO, this time scaled horizontally
-            glClear(GL_COLOR_BUFFER_BIT);
-            QVector<float> verts;
-            QVector<float> texCoords;
-            verts.reserve(12);
-            texCoords.reserve(12);
-
-            texCoords << 1.0 << 0.0; verts << tw  << 0.0; // Top right
-            texCoords << 0.0 << 0.0; verts << 0.0 << 0.0; // Top left
-            texCoords << 0.0 << 1.0; verts << 0.0 << sh;  // Bottom left
-            texCoords << 0.0 << 1.0; verts << 0.0 << sh;  // Bottom left
-            texCoords << 1.0 << 1.0; verts << tw  << sh;  // Bottom right
-            texCoords << 1.0 << 0.0; verts << tw  << 0.0; // Top right
-            GLVertexBuffer *vbo = GLVertexBuffer::streamingBuffer();
-            vbo->reset();
-            vbo->setData(6, 2, verts.constData(), texCoords.constData());
-            vbo->render(GL_TRIANGLES);
-
-            // At this point we don't need the scratch texture anymore
-            tex.unbind();
-            tex.discard();
-
-            // create scratch texture for second rendering pass
-            GLTexture tex2(GL_RGBA8, tw, sh);
-            tex2.setFilter(GL_LINEAR);
-            tex2.setWrapMode(GL_CLAMP_TO_EDGE);
-            tex2.bind();
-
-            glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, m_offscreenTex->height() - sh, tw, sh);
-
-            // Set up the shader for vertical scaling
-            float dy = sh / float(th);
-            createKernel(dy, &kernelSize);
-            createOffsets(kernelSize, m_offscreenTex->height(), Qt::Vertical);
-            setUniforms();
-
-            // Now draw the horizontally scaled window in the FBO at the right
-            // coordinates on the screen, while scaling it vertically and blending it.
-            glClear(GL_COLOR_BUFFER_BIT);
-
-            verts.clear();
-
-            verts << tw  << 0.0; // Top right
-            verts << 0.0 << 0.0; // Top left
-            verts << 0.0 << th;  // Bottom left
-            verts << 0.0 << th;  // Bottom left
-            verts << tw  << th;  // Bottom right
-            verts << tw  << 0.0; // Top right
-            vbo->setData(6, 2, verts.constData(), texCoords.constData());
-            vbo->render(GL_TRIANGLES);
-
-            tex2.unbind();
-            tex2.discard();
-            ShaderManager::instance()->popShader();
-
-            // create cache texture
-            GLTexture *cache = new GLTexture(GL_RGBA8, tw, th);
-
-            cache->setFilter(GL_LINEAR);
-            cache->setWrapMode(GL_CLAMP_TO_EDGE);
-            cache->bind();
-            glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, m_offscreenTex->height() - th, tw, th);
-            GLRenderTarget::popRenderTarget();
-
-            if (hardwareClipping) {
-                glEnable(GL_SCISSOR_TEST);
+            if (!dirtyRect.isEmpty()) {
+                filterWindow(w, mask, data, QRect(winGeo.topLeft(), QSize(sw, sh)), entry.texture, dirtyRect);
             }
-
-            glEnable(GL_BLEND);
-            glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
-
-            const qreal rgb = data.brightness() * data.opacity();
-            const qreal a = data.opacity();
-
-            ShaderBinder binder(ShaderTrait::MapTexture | ShaderTrait::Modulate | ShaderTrait::AdjustSaturation);
-            GLShader *shader = binder.shader();
-            QMatrix4x4 mvp = data.screenProjectionMatrix();
-            mvp.translate(textureRect.x(), textureRect.y());
-            shader->setUniform(GLShader::ModelViewProjectionMatrix, mvp);
-            shader->setUniform(GLShader::ModulationConstant, QVector4D(rgb, rgb, rgb, a));
-            shader->setUniform(GLShader::Saturation, data.saturation());
-
-            cache->render(region, textureRect, hardwareClipping);
-
-            glDisable(GL_BLEND);
-
-            if (hardwareClipping) {
-                glDisable(GL_SCISSOR_TEST);
-            }
-
-            cache->unbind();
-            w->setData(LanczosCacheRole, QVariant::fromValue(static_cast<void*>(cache)));
+            paintCacheTexture(entry.texture, region, textureRect, hardwareClipping, data);
 
             // Delete the offscreen surface after 5 seconds
             m_timer.start(5000, this);
@@ -383,6 +305,181 @@ void LanczosFilter::performPaint(EffectWindowImpl* w, int mask, QRegion region,
     w->sceneWindow()->performPaint(mask, region, data);
 } // End of function
 
+void LanczosFilter::filterWindow(EffectWindowImpl *w, int mask, const WindowPaintData &data, const QRect &source,
+                                 GLTexture *cache, const QRect &rect)
+{
+    const int sw = source.width();
+    const int sh = source.height();
+    const int tw = cache->width();
+    const int th = cache->height();
+
+    WindowPaintData thumbData = data;
+    thumbData.setXScale(1.0);
+    thumbData.setYScale(1.0);
+    thumbData.setXTranslation(-w->x() - source.left());
+    thumbData.setYTranslation(-w->y() - source.top());
+    thumbData.setBrightness(1.0);
+    thumbData.setOpacity(1.0);
+    thumbData.setSaturation(1.0);
+
+    // Bind the offscreen FBO and draw the window on it unscaled
+    updateOffscreenSurfaces();
+    GLRenderTarget::pushRenderTarget(m_offscreenTarget);
+
+    QMatrix4x4 modelViewProjectionMatrix;
+    modelViewProjectionMatrix.ortho(0, m_offscreenTex->width(), m_offscreenTex->height(), 0 , 0, 65535);
+    thumbData.setProjectionMatrix(modelViewProjectionMatrix);
+
+    glClearColor(0.0, 0.0, 0.0, 0.0);
+    glClear(GL_COLOR_BUFFER_BIT);
+    w->sceneWindow()->performPaint(mask, infiniteRegion(), thumbData);
+
+    // Create a scratch texture and copy the rendered window into it
+    GLTexture tex(GL_RGBA8, sw, sh);
+    tex.setFilter(GL_LINEAR);
+    tex.setWrapMode(GL_CLAMP_TO_EDGE);
+    tex.bind();
+
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, m_offscreenTex->height() - sh, sw, sh);
+
+    // The vertical pass needs the rows of the horizontal pass within the reach of its kernel,
+    // the kernel passes only touch these rows and the columns of the updated rect.
+    float dx = sw / float(tw);
+    float dy = sh / float(th);
+    int kernelSize;
+    createKernel(dy, &kernelSize);
+    const QRect horizontalRect = QRect(QPoint(rect.left(), qFloor(rect.top() * dy) - kernelSize - 1),
+                                       QPoint(rect.right(), qCeil((rect.bottom() + 1) * dy) + kernelSize + 1))
+                                 & QRect(0, 0, tw, sh);
+    glEnable(GL_SCISSOR_TEST);
+    setScissor(horizontalRect);
+
+    // Set up the shader for horizontal scaling
+    createKernel(dx, &kernelSize);
+    createOffsets(kernelSize, sw, Qt::Horizontal);
+
+    ShaderManager::instance()->pushShader(m_shader.data());
+    m_shader->setUniform(GLShader::ModelViewProjectionMatrix, modelViewProjectionMatrix);
+    setUniforms();
+
+    // Draw the window back into the FBO, this time scaled horizontally
+    glClear(GL_COLOR_BUFFER_BIT);
+    QVector<float> verts;
+    QVector<float> texCoords;
+    verts.reserve(12);
+    texCoords.reserve(12);
+
+    texCoords << 1.0 << 0.0; verts << tw  << 0.0; // Top right
+    texCoords << 0.0 << 0.0; verts << 0.0 << 0.0; // Top left
+    texCoords << 0.0 << 1.0; verts << 0.0 << sh;  // Bottom left
+    texCoords << 0.0 << 1.0; verts << 0.0 << sh;  // Bottom left
+    texCoords << 1.0 << 1.0; verts << tw  << sh;  // Bottom right
+    texCoords << 1.0 << 0.0; verts << tw  << 0.0; // Top right
+    GLVertexBuffer *vbo = GLVertexBuffer::streamingBuffer();
+    vbo->reset();
+    vbo->setData(6, 2, verts.constData(), texCoords.constData());
+    vbo->render(GL_TRIANGLES);
+
+    // At this point we don't need the scratch texture anymore
+    tex.unbind();
+    tex.discard();
+
+    // create scratch texture for second rendering pass
+    GLTexture tex2(GL_RGBA8, tw, sh);
+    tex2.setFilter(GL_LINEAR);
+    tex2.setWrapMode(GL_CLAMP_TO_EDGE);
+    tex2.bind();
+
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, m_offscreenTex->height() - sh, tw, sh);
+
+    // Set up the shader for vertical scaling
+    createKernel(dy, &kernelSize);
+    createOffsets(kernelSize, m_offscreenTex->height(), Qt::Vertical);
+    setUniforms();
+    setScissor(rect);
+
+    // Now draw the horizontally scaled window in the FBO at the right
+    // coordinates on the screen, while scaling it vertically and blending it.
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    verts.clear();
+
+    verts << tw  << 0.0; // Top right
+    verts << 0.0 << 0.0; // Top left
+    verts << 0.0 << th;  // Bottom left
+    verts << 0.0 << th;  // Bottom left
+    verts << tw  << th;  // Bottom right
+    verts << tw  << 0.0; // Top right
+    vbo->setData(6, 2, verts.constData(), texCoords.constData());
+    vbo->render(GL_TRIANGLES);
+
+    tex2.unbind();
+    tex2.discard();
+    ShaderManager::instance()->popShader();
+    glDisable(GL_SCISSOR_TEST);
+
+    // update the affected part of the cache texture
+    cache->bind();
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, rect.x(), th - rect.y() - rect.height(),
+                        rect.x(), m_offscreenTex->height() - rect.y() - rect.height(), rect.width(), rect.height());
+    cache->unbind();
+    GLRenderTarget::popRenderTarget();
+}
+
+void LanczosFilter::paintCacheTexture(GLTexture *cache, const QRegion &region, const QRect &textureRect,
+                                      bool hardwareClipping, const WindowPaintData &data)
+{
+    cache->bind();
+    if (hardwareClipping) {
+        glEnable(GL_SCISSOR_TEST);
+    }
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+    const qreal rgb = data.brightness() * data.opacity();
+    const qreal a = data.opacity();
+
+    ShaderBinder binder(ShaderTrait::MapTexture | ShaderTrait::Modulate | ShaderTrait::AdjustSaturation);
+    GLShader *shader = binder.shader();
+    QMatrix4x4 mvp = data.screenProjectionMatrix();
+    mvp.translate(textureRect.x(), textureRect.y());
+    shader->setUniform(GLShader::ModelViewProjectionMatrix, mvp);
+    shader->setUniform(GLShader::ModulationConstant, QVector4D(rgb, rgb, rgb, a));
+    shader->setUniform(GLShader::Saturation, data.saturation());
+
+    cache->render(region, textureRect, hardwareClipping);
+
+    glDisable(GL_BLEND);
+    if (hardwareClipping) {
+        glDisable(GL_SCISSOR_TEST);
+    }
+    cache->unbind();
+}
+
+QRect LanczosFilter::affectedRect(const QRect &damage, const QSize &sourceSize, const QSize &targetSize) const
+{
+    // A source pixel contributes to all target pixels within the reach of the kernel,
+    // plus one pixel for the linear texture sampling.
+    const float dx = sourceSize.width() / float(targetSize.width());
+    const float dy = sourceSize.height() / float(targetSize.height());
+    const int reachX = qBound(3, qCeil(dx * 2.0) * 2 + 1 - 2, 29) / 2 + 2;
+    const int reachY = qBound(3, qCeil(dy * 2.0) * 2 + 1 - 2, 29) / 2 + 2;
+    const QRect source = damage & QRect(QPoint(0, 0), sourceSize);
+    if (source.isEmpty()) {
+        return QRect();
+    }
+    return QRect(QPoint(qFloor((source.left() - reachX) / dx), qFloor((source.top() - reachY) / dy)),
+                 QPoint(qCeil((source.right() + reachX) / dx), qCeil((source.bottom() + reachY) / dy)))
+           & QRect(QPoint(0, 0), targetSize);
+}
+
+void LanczosFilter::setScissor(const QRect &rect) const
+{
+    // rect is in the top-down coordinates of the offscreen target
+    glScissor(rect.x(), m_offscreenTex->height() - rect.y() - rect.height(), rect.width(), rect.height());
+}
+
 void LanczosFilter::timerEvent(QTimerEvent *event)
 {
     if (event->timerId() == m_timer.timerId()) {
@@ -392,28 +489,68 @@ void LanczosFilter::timerEvent(QTimerEvent *event)
         delete m_offscreenTex;
         m_offscreenTarget = 0;
         m_offscreenTex = 0;
-        foreach (Client *c, Workspace::self()->clientList()) {
-            discardCacheTexture(c->effectWindow());
-        }
-        foreach (Client *c, Workspace::self()->desktopList()) {
-            discardCacheTexture(c->effectWindow());
+        // Keep the cache textures, but changes we are not notified about (e.g. the
+        // decoration) might have happened until the filter is used again
+        for (auto it = m_cache.begin(); it != m_cache.end(); ++it) {
+            it->sourceSize = QSize();
         }
-        foreach (Unmanaged *u, Workspace::self()->unmanagedList()) {
-            discardCacheTexture(u->effectWindow());
+    }
+}
+
+void LanczosFilter::invalidateCacheTexture(EffectWindow *w)
+{
+    auto it = m_cache.find(w);
+    if (it != m_cache.end()) {
+        it->sourceSize = QSize();
+    }
+}
+
+void LanczosFilter::discardCacheTexture(Cache::iterator it)
+{
+    if (it->texture) {
+        m_cacheMemory -= qint64(it->texture->width()) * it->texture->height() * 4;
+        delete it->texture;
+        it->texture = nullptr;
+    }
+}
+
+void LanczosFilter::evictCacheTextures(EffectWindow *keep)
+{
+    const qint64 budget = qint64(options->glLanczosCacheSize()) * 1024 * 1024;
+    while (m_cacheMemory > budget) {
+        // evict the least recently used texture
+        auto lru = m_cache.end();
+        for (auto it = m_cache.begin(); it != m_cache.end(); ++it) {
+            if (it.key() == keep || !it->texture) {
+                continue;
+            }
+            if (lru == m_cache.end() || it->lastUsed < lru->lastUsed) {
+                lru = it;
+            }
         }
-        foreach (Deleted *d, Workspace::self()->deletedList()) {
-            discardCacheTexture(d->effectWindow());
+        if (lru == m_cache.end()) {
+            break;
         }
+        discardCacheTexture(lru);
+        m_cache.erase(lru);
+        ++m_cacheEvictions;
     }
 }
 
-void LanczosFilter::discardCacheTexture(EffectWindow *w)
+QString LanczosFilter::supportInformation() const
 {
-    QVariant cachedTextureVariant = w->data(LanczosCacheRole);
-    if (cachedTextureVariant.isValid()) {
-        delete static_cast< GLTexture*>(cachedTextureVariant.value<void*>());
-        w->setData(LanczosCacheRole, QVariant());
-    }
+    QString support;
+    support.append(QStringLiteral("Lanczos filter: "));
+    support.append(m_shader ? QStringLiteral("yes\n") : QStringLiteral("no\n"));
+    support.append(QStringLiteral("Lanczos cache textures: %1\n").arg(m_cache.count()));
+    support.append(QStringLiteral("Lanczos cache memory: %1 of %2 KiB\n")
+                   .arg(m_cacheMemory / 1024)
+                   .arg(qint64(options->glLanczosCacheSize()) * 1024));
+    support.append(QStringLiteral("Lanczos cache hits: %1\n").arg(m_cacheHits));
+    support.append(QStringLiteral("Lanczos cache partial hits: %1\n").arg(m_cachePartialHits));
+    support.append(QStringLiteral("Lanczos cache misses: %1\n").arg(m_cacheMisses));
+    support.append(QStringLiteral("Lanczos cache evictions: %1\n").arg(m_cacheEvictions));
+    return support;
 }
 
 void LanczosFilter::setUniforms()
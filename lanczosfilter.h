@@ -24,6 +24,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QObject>
 #include <QBasicTimer>
+#include <QHash>
+#include <QRegion>
 #include <QVector>
 #include <QVector2D>
 #include <QVector4D>
@@ -50,14 +52,36 @@ public:
     explicit LanczosFilter(QObject* parent = 0);
     ~LanczosFilter();
     void performPaint(EffectWindowImpl* w, int mask, QRegion region, WindowPaintData& data);
+    QString supportInformation() const;
 
 protected:
     virtual void timerEvent(QTimerEvent*);
 private:
+    /**
+     * The filtered texture of a window. It is kept across frames and only the parts
+     * affected by damage are filtered again.
+     **/
+    struct CacheEntry {
+        GLTexture *texture = nullptr;
+        // size of the unscaled window the texture was filtered from
+        QSize sourceSize;
+        // damage since the last filtering in window coordinates
+        QRegion dirty;
+        quint64 lastUsed = 0;
+    };
+    typedef QHash<EffectWindow*, CacheEntry> Cache;
     void init();
     void updateOffscreenSurfaces();
     void setUniforms();
-    void discardCacheTexture(EffectWindow *w);
+    void discardCacheTexture(Cache::iterator it);
+    void invalidateCacheTexture(EffectWindow *w);
+    void evictCacheTextures(EffectWindow *keep);
+    void filterWindow(EffectWindowImpl *w, int mask, const WindowPaintData &data, const QRect &source,
+                      GLTexture *cache, const QRect &rect);
+    void paintCacheTexture(GLTexture *cache, const QRegion &region, const QRect &textureRect,
+                           bool hardwareClipping, const WindowPaintData &data);
+    QRect affectedRect(const QRect &damage, const QSize &sourceSize, const QSize &targetSize) const;
+    void setScissor(const QRect &rect) const;
 
     void createKernel(float delta, int *kernelSize);
     void createOffsets(int count, float width, Qt::Orientation direction);
@@ -70,6 +94,15 @@ private:
     int m_uKernel;
     QVector2D m_offsets[16];
     QVector4D m_kernel[16];
+
+    Cache m_cache;
+    EffectWindow *m_activeWindow;
+    quint64 m_useCounter;
+    qint64 m_cacheMemory;
+    quint64 m_cacheHits;
+    quint64 m_cachePartialHits;
+    quint64 m_cacheMisses;
+    quint64 m_cacheEvictions;
 };
 
 } // namespace
@@ -97,9 +97,101 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QDebug>
 
+#include <algorithm>
+
 namespace KWin
 {
 
+/**
+ * Marks a longest increasing subsequence of @p positions. Windows which are part
+ * of it kept their relative order, all others have been moved by the restack.
+ **/
+static QVector<bool> unmovedWindows(const QVector<int> &positions)
+{
+    QVector<int> tails; // index of the smallest tail of a subsequence of each length
+    QVector<int> predecessors(positions.size(), -1);
+    for (int i = 0; i < positions.size(); ++i) {
+        auto it = std::lower_bound(tails.begin(), tails.end(), positions.at(i),
+            [&positions] (int index, int position) {
+                return positions.at(index) < position;
+            });
+        if (it != tails.begin()) {
+            predecessors[i] = *(it - 1);
+        }
+        if (it == tails.end()) {
+            tails.append(i);
+        } else {
+            *it = i;
+        }
+    }
+    QVector<bool> unmoved(positions.size(), false);
+    for (int i = tails.isEmpty() ? -1 : tails.last(); i != -1; i = predecessors.at(i)) {
+        unmoved[i] = true;
+    }
+    return unmoved;
+}
+
+static bool isPaintedForRestack(const Toplevel *t)
+{
+    return t->readyForPainting() && t->isOnCurrentDesktop();
+}
+
+/**
+ * The area in which the visible result differs between @p oldOrder and @p newOrder. That is
+ * where two windows which changed their relative position overlap. Windows only present in
+ * one of the orders are repainted completely.
+ **/
+static QRegion restackedRegion(const ToplevelList &oldOrder, const ToplevelList &newOrder)
+{
+    QHash<Toplevel*, int> oldPositions;
+    oldPositions.reserve(oldOrder.size());
+    for (int i = 0; i < oldOrder.size(); ++i) {
+        oldPositions.insert(oldOrder.at(i), i);
+    }
+
+    QRegion region;
+    ToplevelList kept;
+    QVector<int> positions;
+    kept.reserve(newOrder.size());
+    positions.reserve(newOrder.size());
+    for (Toplevel *t : newOrder) {
+        const auto it = oldPositions.constFind(t);
+        if (it == oldPositions.constEnd()) {
+            if (isPaintedForRestack(t)) {
+                region += t->visibleRect();
+            }
+            continue;
+        }
+        kept << t;
+        positions << it.value();
+        oldPositions.erase(it);
+    }
+    for (auto it = oldPositions.constBegin(); it != oldPositions.constEnd(); ++it) {
+        if (isPaintedForRestack(it.key())) {
+            region += it.key()->visibleRect();
+        }
+    }
+
+    // every pair which swapped contains at least one moved window, a raise or lower moves
+    // just one window and costs a single pass over the others
+    const QVector<bool> unmoved = unmovedWindows(positions);
+    for (int i = 0; i < kept.size(); ++i) {
+        if (unmoved.at(i) || !isPaintedForRestack(kept.at(i))) {
+            continue;
+        }
+        const QRect rect = kept.at(i)->visibleRect();
+        for (int j = 0; j < kept.size(); ++j) {
+            if (i == j || (j < i) == (positions.at(j) < positions.at(i))) {
+                continue;
+            }
+            if (isPaintedForRestack(kept.at(j))) {
+                region += rect & kept.at(j)->visibleRect();
+            }
+        }
+    }
+    return region;
+}
+
 //*******************************
 // Workspace
 //*******************************
@@ -118,14 +210,23 @@ void Workspace::updateStackingOrder(bool propagate_new_clients)
         return;
     }
     ToplevelList new_stacking_order = constrainedStackingOrder();
-    bool changed = (force_restacking || new_stacking_order != stacking_order);
+    const bool forced = force_restacking;
+    bool changed = (forced || new_stacking_order != stacking_order);
     force_restacking = false;
+    const ToplevelList old_stacking_order = stacking_order;
     stacking_order = new_stacking_order;
     if (changed || propagate_new_clients) {
         propagateClients(propagate_new_clients);
         emit stackingOrderChanged();
-        if (m_compositor) {
+        if (m_compositor && forced) {
+            // e.g. a hidden preview is shown, the order alone does not tell what changed
             m_compositor->addRepaintFull();
+        } else if (m_compositor) {
+            // only where windows which changed their order overlap
+            const QRegion repaint = restackedRegion(old_stacking_order, stacking_order);
+            if (!repaint.isEmpty()) {
+                m_compositor->addRepaint(repaint);
+            }
         }
 
         if (active_client)
@@ -490,6 +591,27 @@ void Workspace::restoreSessionStackingOrder(Client* c)
     unconstrained_stacking_order.append(c);
 }
 
+/**
+ * All windows @p client is a direct or indirect transient for, following the transient
+ * graph upwards instead of testing every window in the stacking order.
+ **/
+static QVector<AbstractClient*> transientAncestors(AbstractClient *client)
+{
+    QVector<AbstractClient*> ancestors;
+    QVector<AbstractClient*> pending{client};
+    while (!pending.isEmpty()) {
+        const QList<AbstractClient*> mainClients = pending.takeLast()->mainClients();
+        for (AbstractClient *mainClient : mainClients) {
+            // group transients may form loops
+            if (mainClient != client && !ancestors.contains(mainClient)) {
+                ancestors.append(mainClient);
+                pending.append(mainClient);
+            }
+        }
+    }
+    return ancestors;
+}
+
 /*!
   Returns a stacking order based upon \a list that fulfills certain contained.
  */
@@ -498,14 +620,14 @@ ToplevelList Workspace::constrainedStackingOrder()
     ToplevelList layer[ NumLayers ];
 
     // build the order from layers
-    QVector< QMap<Group*, Layer> > minimum_layer(screens()->count());
+    QVector< QHash<Group*, Layer> > minimum_layer(screens()->count());
     for (ToplevelList::ConstIterator it = unconstrained_stacking_order.constBegin(),
                                   end = unconstrained_stacking_order.constEnd(); it != end; ++it) {
         Layer l = (*it)->layer();
 
         const int screen = (*it)->screen();
         Client *c = qobject_cast<Client*>(*it);
-        QMap< Group*, Layer >::iterator mLayer = minimum_layer[screen].find(c ? c->group() : NULL);
+        QHash< Group*, Layer >::iterator mLayer = minimum_layer[screen].find(c ? c->group() : NULL);
         if (mLayer != minimum_layer[screen].end()) {
             // If a window is raised above some other window in the same window group
             // which is in the ActiveLayer (i.e. it's fulscreened), make sure it stays
@@ -514,17 +636,39 @@ ToplevelList Workspace::constrainedStackingOrder()
                 l = ActiveLayer;
             *mLayer = l;
         } else if (c) {
-            minimum_layer[screen].insertMulti(c->group(), l);
+            minimum_layer[screen].insert(c->group(), l);
         }
         layer[ l ].append(*it);
     }
     ToplevelList stacking;
+    stacking.reserve(unconstrained_stacking_order.size());
     for (Layer lay = FirstLayer;
             lay < NumLayers;
             ++lay)
         stacking += layer[ lay ];
+
+    // deleted transients by the windows they were transient for
+    QHash<const Toplevel*, QVector<Deleted*> > deletedTransients;
+    if (!deletedList().isEmpty()) {
+        for (Toplevel *toplevel : qAsConst(stacking)) {
+            auto *deleted = qobject_cast<Deleted *>(toplevel);
+            if (!deleted) {
+                continue;
+            }
+            for (const Toplevel *mainWindow : deleted->mainWindows()) {
+                deletedTransients[mainWindow].append(deleted);
+            }
+        }
+    }
+
+    // positions in the stacking order, kept up to date while transients are moved
+    QHash<const Toplevel*, int> positions;
+    positions.reserve(stacking.size());
+    for (int i = 0; i < stacking.size(); ++i) {
+        positions.insert(stacking.at(i), i);
+    }
+
     // now keep transients above their mainwindows
-    // TODO this could(?) use some optimization
     for (int i = stacking.size() - 1; i >= 0;) {
         // Index of the main window for the current transient window.
         int i2 = -1;
@@ -534,24 +678,23 @@ ToplevelList Workspace::constrainedStackingOrder()
         // the current transient will be moved.
         bool hasTransients = false;
 
-        // Find topmost client this one is transient for.
+        // Find topmost client this one is transient for. Only the windows reachable in
+        // the transient graph are candidates, if none of them is above the transient,
+        // it is already on top of its main windows.
         if (auto *client = qobject_cast<AbstractClient *>(stacking[i])) {
             if (!client->isTransient()) {
                 --i;
                 continue;
             }
-            for (i2 = stacking.size() - 1; i2 >= 0; --i2) {
-                auto *c2 = qobject_cast<AbstractClient *>(stacking[i2]);
-                if (!c2) {
+            const QVector<AbstractClient*> mainClients = transientAncestors(client);
+            for (AbstractClient *mainClient : mainClients) {
+                if (!mainClient->hasTransient(client, true)
+                        || !keepTransientAbove(mainClient, client)) {
                     continue;
                 }
-                if (c2 == client) {
-                    i2 = -1; // Don't reorder, already on top of its main window.
-                    break;
-                }
-                if (c2->hasTransient(client, true)
-                        && keepTransientAbove(c2, client)) {
-                    break;
+                const int index = positions.value(mainClient, -1);
+                if (index > i && index > i2) {
+                    i2 = index;
                 }
             }
 
@@ -559,18 +702,13 @@ ToplevelList Workspace::constrainedStackingOrder()
 
             // If the current transient doesn't have any "alive" transients, check
             // whether it has deleted transients that have to be raised.
-            const bool searchForDeletedTransients = !hasTransients
-                && !deletedList().isEmpty();
-            if (searchForDeletedTransients) {
-                for (int j = i + 1; j < stacking.count(); ++j) {
-                    auto *deleted = qobject_cast<Deleted *>(stacking[j]);
-                    if (!deleted) {
-                        continue;
-                    }
-                    if (deleted->wasTransientFor(client)) {
-                        hasTransients = true;
-                        break;
-                    }
+            if (!hasTransients) {
+                const auto deleted = deletedTransients.constFind(client);
+                if (deleted != deletedTransients.constEnd()) {
+                    hasTransients = std::any_of(deleted->constBegin(), deleted->constEnd(),
+                        [&positions, i] (Deleted *transient) {
+                            return positions.value(transient, -1) > i;
+                        });
                 }
             }
         } else if (auto *deleted = qobject_cast<Deleted *>(stacking[i])) {
@@ -578,15 +716,13 @@ ToplevelList Workspace::constrainedStackingOrder()
                 --i;
                 continue;
             }
-            for (i2 = stacking.size() - 1; i2 >= 0; --i2) {
-                Toplevel *c2 = stacking[i2];
-                if (c2 == deleted) {
-                    i2 = -1; // Don't reorder, already on top of its main window.
-                    break;
+            for (Toplevel *mainWindow : deleted->mainWindows()) {
+                if (!keepDeletedTransientAbove(mainWindow, deleted)) {
+                    continue;
                 }
-                if (deleted->wasTransientFor(c2)
-                        && keepDeletedTransientAbove(c2, deleted)) {
-                    break;
+                const int index = positions.value(mainWindow, -1);
+                if (index > i && index > i2) {
+                    i2 = index;
                 }
             }
             hasTransients = !deleted->transients().isEmpty();
@@ -598,6 +734,7 @@ ToplevelList Workspace::constrainedStackingOrder()
         }
 
         Toplevel *current = stacking[i];
+        const int from = i;
 
         stacking.removeAt(i);
         --i; // move onto the next item (for next for () iteration)
@@ -607,6 +744,10 @@ ToplevelList Workspace::constrainedStackingOrder()
         }
         ++i2; // insert after (on top of) the mainwindow, it's ok if it2 is now stacking.end()
         stacking.insert(i2, current);
+        // only the windows between the old and the new position moved
+        for (int j = from; j <= i2; ++j) {
+            positions[stacking.at(j)] = j;
+        }
     }
     return stacking;
 }
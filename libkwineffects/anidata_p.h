@@ -101,6 +101,28 @@ public:
     AnimationEffect::TerminationFlags terminationFlags;
 };
 
+/**
+ * The state of an animation at the frame being painted.
+ *
+ * AnimationEffect evaluates all animations once per frame and packs the
+ * results, so painting a window neither walks the animations again nor
+ * evaluates their easing curves.
+ **/
+class AniFrame {
+public:
+    inline bool isOneDimensional() const {
+        return from[0] == from[1] && to[0] == to[1];
+    }
+
+    AnimationEffect::Attribute attribute;
+    uint meta;
+    FPx2 from, to;
+    // the interpolated value of the attribute
+    float value[2];
+    // the eased progress, 0 if the animation waits at the source
+    float progress;
+};
+
 } // namespace
 
 QDebug operator<<(QDebug dbg, const KWin::AniData &a);
@@ -37,18 +37,43 @@ namespace KWin {
 
 QElapsedTimer AnimationEffect::s_clock;
 
+/**
+ * The animations of one window at the frame being painted. The attributes
+ * which only scale a paint data value are folded into a single factor, the
+ * others are stored contiguously in AnimationEffectPrivate::m_frameAnimations.
+ **/
+struct AniWindowFrame {
+    const EffectWindow *window;
+    float opacity = 1.0;
+    float brightness = 1.0;
+    float saturation = 1.0;
+    bool translucent = false;
+    bool transformed = false;
+    bool paintDeleted = false;
+    int first = 0;
+    int count = 0;
+};
+
 class AnimationEffectPrivate {
 public:
     AnimationEffectPrivate()
     {
         m_animated = m_damageDirty = m_animationsTouched = m_isInitialized = false;
+        m_frameDirty = true;
         m_justEndedAnimation = 0;
     }
+    void evaluateFrame();
+    const AniWindowFrame *windowFrame(const EffectWindow *w);
+
     AnimationEffect::AniMap m_animations;
     static quint64 m_animCounter;
     quint64 m_justEndedAnimation; // protect against cancel
     QWeakPointer<FullScreenEffectLock> m_fullScreenEffectLock;
     bool m_animated, m_damageDirty, m_needSceneRepaint, m_animationsTouched, m_isInitialized;
+    // the animations evaluated for the frame being painted, sorted by window like m_animations
+    QVector<AniWindowFrame> m_frameWindows;
+    QVector<AniFrame> m_frameAnimations;
+    bool m_frameDirty; // the animations changed since they were evaluated
 };
 }
 
@@ -56,6 +81,88 @@ using namespace KWin;
 
 quint64 AnimationEffectPrivate::m_animCounter = 0;
 
+void AnimationEffectPrivate::evaluateFrame()
+{
+    const qint64 now = AnimationEffect::clock();
+    m_frameWindows.clear();
+    m_frameAnimations.clear();
+    for (AnimationEffect::AniMap::const_iterator entry = m_animations.constBegin(), mapEnd = m_animations.constEnd(); entry != mapEnd; ++entry) {
+        AniWindowFrame window;
+        window.window = entry.key();
+        window.first = m_frameAnimations.count();
+        bool isUsed = false;
+        for (QList<AniData>::const_iterator anim = entry->first.constBegin(), animEnd = entry->first.constEnd(); anim != animEnd; ++anim) {
+            const bool started = anim->startTime <= now;
+            if (!started && !anim->waitAtSource)
+                continue;
+            isUsed = true;
+            window.paintDeleted |= anim->keepAlive;
+
+            // the easing curve is evaluated here and nowhere else during the frame
+            const float progress = started ? anim->timeLine.value() : 0.0;
+            float value[2];
+            if (!started) {
+                value[0] = anim->from[0];
+                value[1] = anim->from[1];
+            } else if (!anim->timeLine.done()) {
+                value[0] = anim->from[0] + progress * (anim->to[0] - anim->from[0]);
+                value[1] = anim->from[1] + progress * (anim->to[1] - anim->from[1]);
+            } else { // we're done and "waiting" at the target value
+                value[0] = anim->to[0];
+                value[1] = anim->to[1];
+            }
+
+            switch (anim->attribute) {
+            case AnimationEffect::Opacity:
+                window.translucent = true;
+                window.opacity *= value[0];
+                continue;
+            case AnimationEffect::Brightness:
+                window.brightness *= value[0];
+                continue;
+            case AnimationEffect::Saturation:
+                window.saturation *= value[0];
+                continue;
+            case AnimationEffect::CrossFadePrevious:
+                window.translucent = true;
+                break;
+            default:
+                window.transformed = true;
+                break;
+            }
+
+            AniFrame frame;
+            frame.attribute = anim->attribute;
+            frame.meta = anim->meta;
+            frame.from = anim->from;
+            frame.to = anim->to;
+            frame.value[0] = value[0];
+            frame.value[1] = value[1];
+            frame.progress = progress;
+            m_frameAnimations.append(frame);
+        }
+        if (!isUsed)
+            continue;
+        window.count = m_frameAnimations.count() - window.first;
+        m_frameWindows.append(window);
+    }
+    m_frameDirty = false;
+}
+
+const AniWindowFrame *AnimationEffectPrivate::windowFrame(const EffectWindow *w)
+{
+    if (m_frameDirty)
+        evaluateFrame();
+    auto it = std::lower_bound(m_frameWindows.constBegin(), m_frameWindows.constEnd(), w,
+        [] (const AniWindowFrame &frame, const EffectWindow *window) {
+            return std::less<const EffectWindow*>()(frame.window, window);
+        }
+    );
+    if (it == m_frameWindows.constEnd() || it->window != w)
+        return nullptr;
+    return &*it;
+}
+
 AnimationEffect::AnimationEffect() : d_ptr(new AnimationEffectPrivate())
 {
     Q_D(AnimationEffect);
@@ -92,6 +199,12 @@ bool AnimationEffect::isActive() const
     return !d->m_animations.isEmpty();
 }
 
+bool AnimationEffect::isActiveForWindow(const EffectWindow *w) const
+{
+    Q_D(const AnimationEffect);
+    return d->m_animations.contains(const_cast<EffectWindow*>(w));
+}
+
 
 #define RELATIVE_XY(_FIELD_) const bool relative[2] = { static_cast<bool>(metaData(Relative##_FIELD_##X, meta)), \
                                                         static_cast<bool>(metaData(Relative##_FIELD_##Y, meta)) }
@@ -282,6 +395,7 @@ quint64 AnimationEffect::p_animate( EffectWindow *w, Attribute a, uint meta, int
     it->second = QRect();
 
     d->m_animationsTouched = true;
+    d->m_frameDirty = true;
 
     if (delay > 0) {
         QTimer::singleShot(delay, this, SLOT(triggerRepaint()));
@@ -312,6 +426,7 @@ bool AnimationEffect::retarget(quint64 animationId, FPx2 newTarget, int newRemai
                 anim->timeLine.setDirection(TimeLine::Forward);
                 anim->timeLine.setDuration(std::chrono::milliseconds(newRemainingTime));
                 anim->timeLine.reset();
+                d->m_frameDirty = true;
 
                 return true;
             }
@@ -349,6 +464,7 @@ bool AnimationEffect::redirect(quint64 animationId, Direction direction, Termina
         }
 
         animIt->terminationFlags = terminationFlags & ~TerminateAtTarget;
+        d->m_frameDirty = true;
 
         return true;
     }
@@ -375,6 +491,7 @@ bool AnimationEffect::complete(quint64 animationId)
         }
 
         animIt->timeLine.setElapsed(animIt->timeLine.duration());
+        d->m_frameDirty = true;
 
         return true;
     }
@@ -397,6 +514,7 @@ bool AnimationEffect::cancel(quint64 animationId)
                 if (d->m_animations.isEmpty())
                     disconnectGeometryChanges();
                 d->m_animationsTouched = true; // could be called from animationEnded
+                d->m_frameDirty = true;
                 return true;
             }
         }
@@ -415,20 +533,22 @@ void AnimationEffect::prePaintScreen( ScreenPrePaintData& data, int time )
     d->m_animationsTouched = false;
     AniMap::iterator entry = d->m_animations.begin(), mapEnd = d->m_animations.end();
     d->m_animated = false;
+    const qint64 now = clock();
+    const std::chrono::nanoseconds presentationTime = effects->presentationTime();
 //     short int transformed = 0;
     while (entry != mapEnd) {
         bool invalidateLayerRect = false;
         QList<AniData>::iterator anim = entry->first.begin(), animEnd = entry->first.end();
         int animCounter = 0;
         while (anim != animEnd) {
-            if (anim->startTime > clock()) {
+            if (anim->startTime > now) {
                 if (!anim->waitAtSource) {
                     ++anim;
                     ++animCounter;
                     continue;
                 }
             } else {
-                anim->timeLine.update(std::chrono::milliseconds(time));
+                anim->timeLine.advance(presentationTime);
             }
 
             if (anim->isActive()) {
@@ -478,6 +598,8 @@ void AnimationEffect::prePaintScreen( ScreenPrePaintData& data, int time )
         disconnectGeometryChanges();
     }
 
+    d->evaluateFrame();
+
     effects->prePaintScreen(data, time);
 }
 
@@ -499,10 +621,10 @@ static int yCoord(const QRect &r, int flag) {
         return r.y() + r.height()/2;
 }
 
-QRect AnimationEffect::clipRect(const QRect &geo, const AniData &anim) const
+QRect AnimationEffect::clipRect(const QRect &geo, const AniFrame &anim) const
 {
     QRect clip = geo;
-    FPx2 ratio = anim.from + progress(anim) * (anim.to - anim.from);
+    FPx2 ratio = anim.from + anim.progress * (anim.to - anim.from);
     if (anim.from[0] < 1.0 || anim.to[0] < 1.0) {
         clip.setWidth(clip.width() * ratio[0]);
     }
@@ -520,7 +642,7 @@ QRect AnimationEffect::clipRect(const QRect &geo, const AniData &anim) const
     return clip;
 }
 
-void AnimationEffect::clipWindow(const EffectWindow *w, const AniData &anim, WindowQuadList &quads) const
+void AnimationEffect::clipWindow(const EffectWindow *w, const AniFrame &anim, WindowQuadList &quads) const
 {
     return;
     const QRect geo = w->expandedGeometry();
@@ -578,35 +700,26 @@ void AnimationEffect::prePaintWindow( EffectWindow* w, WindowPrePaintData& data,
 {
     Q_D(AnimationEffect);
     if ( d->m_animated ) {
-        AniMap::const_iterator entry = d->m_animations.constFind( w );
-        if ( entry != d->m_animations.constEnd() ) {
-            bool isUsed = false;
-            bool paintDeleted = false;
-            for (QList<AniData>::const_iterator anim = entry->first.constBegin(); anim != entry->first.constEnd(); ++anim) {
-                if (anim->startTime > clock() && !anim->waitAtSource)
-                    continue;
-
-                isUsed = true;
-                if (anim->attribute == Opacity || anim->attribute == CrossFadePrevious)
-                    data.setTranslucent();
-                else if (!(anim->attribute == Brightness || anim->attribute == Saturation)) {
-                    data.setTransformed();
-                    if (anim->attribute == Clip)
-                        clipWindow(w, *anim, data.quads);
+        if (const AniWindowFrame *frame = d->windowFrame(w)) {
+            if (frame->translucent)
+                data.setTranslucent();
+            if (frame->transformed) {
+                data.setTransformed();
+                for (int i = frame->first; i < frame->first + frame->count; ++i) {
+                    const AniFrame &anim = d->m_frameAnimations.at(i);
+                    if (anim.attribute == Clip)
+                        clipWindow(w, anim, data.quads);
                 }
-
-                paintDeleted |= anim->keepAlive;
-            }
-            if ( isUsed ) {
-                if ( w->isMinimized() )
-                    w->enablePainting( EffectWindow::PAINT_DISABLED_BY_MINIMIZE );
-                else if ( w->isDeleted() && paintDeleted )
-                    w->enablePainting( EffectWindow::PAINT_DISABLED_BY_DELETE );
-                else if ( !w->isOnCurrentDesktop() )
-                    w->enablePainting( EffectWindow::PAINT_DISABLED_BY_DESKTOP );
-//                 if( !w->isPaintingEnabled() && !effects->activeFullScreenEffect() )
-//                     effects->addLayerRepaint(w->expandedGeometry());
             }
+
+            if ( w->isMinimized() )
+                w->enablePainting( EffectWindow::PAINT_DISABLED_BY_MINIMIZE );
+            else if ( w->isDeleted() && frame->paintDeleted )
+                w->enablePainting( EffectWindow::PAINT_DISABLED_BY_DELETE );
+            else if ( !w->isOnCurrentDesktop() )
+                w->enablePainting( EffectWindow::PAINT_DISABLED_BY_DESKTOP );
+//             if( !w->isPaintingEnabled() && !effects->activeFullScreenEffect() )
+//                 effects->addLayerRepaint(w->expandedGeometry());
         }
     }
     effects->prePaintWindow( w, data, time );
@@ -625,32 +738,27 @@ void AnimationEffect::paintWindow( EffectWindow* w, int mask, QRegion region, Wi
 {
     Q_D(AnimationEffect);
     if ( d->m_animated ) {
-        AniMap::const_iterator entry = d->m_animations.constFind( w );
-        if ( entry != d->m_animations.constEnd() ) {
-            for ( QList<AniData>::const_iterator anim = entry->first.constBegin(); anim != entry->first.constEnd(); ++anim ) {
-
-                if (anim->startTime > clock() && !anim->waitAtSource)
-                    continue;
-
+        if (const AniWindowFrame *frame = d->windowFrame(w)) {
+            data.multiplyOpacity(frame->opacity);
+            data.multiplyBrightness(frame->brightness);
+            data.multiplySaturation(frame->saturation);
+
+            const AniFrame *anim = d->m_frameAnimations.constData() + frame->first;
+            const AniFrame *animEnd = anim + frame->count;
+            for (; anim != animEnd; ++anim) {
                 switch (anim->attribute) {
-                case Opacity:
-                    data.multiplyOpacity(interpolated(*anim)); break;
-                case Brightness:
-                    data.multiplyBrightness(interpolated(*anim)); break;
-                case Saturation:
-                    data.multiplySaturation(interpolated(*anim)); break;
                 case Scale: {
                     const QSize sz = w->geometry().size();
                     float f1(1.0), f2(0.0);
                     if (anim->from[0] >= 0.0 && anim->to[0] >= 0.0) { // scale x
-                        f1 = interpolated(*anim, 0);
+                        f1 = anim->value[0];
                         f2 = geometryCompensation( anim->meta & AnimationEffect::Horizontal, f1 );
                         data.translate(f2 * sz.width());
                         data.setXScale(data.xScale() * f1);
                     }
                     if (anim->from[1] >= 0.0 && anim->to[1] >= 0.0) { // scale y
                         if (!anim->isOneDimensional()) {
-                            f1 = interpolated(*anim, 1);
+                            f1 = anim->value[1];
                             f2 = geometryCompensation( anim->meta & AnimationEffect::Vertical, f1 );
                         }
                         else if ( ((anim->meta & AnimationEffect::Vertical)>>1) != (anim->meta & AnimationEffect::Horizontal) )
@@ -664,10 +772,10 @@ void AnimationEffect::paintWindow( EffectWindow* w, int mask, QRegion region, Wi
                     region = clipRect(w->expandedGeometry(), *anim);
                     break;
                 case Translation:
-                    data += QPointF(interpolated(*anim, 0), interpolated(*anim, 1));
+                    data += QPointF(anim->value[0], anim->value[1]);
                     break;
                 case Size: {
-                    FPx2 dest = anim->from + progress(*anim) * (anim->to - anim->from);
+                    FPx2 dest = anim->from + anim->progress * (anim->to - anim->from);
                     const QSize sz = w->geometry().size();
                     float f;
                     if (anim->from[0] >= 0.0 && anim->to[0] >= 0.0) { // resize x
@@ -684,15 +792,15 @@ void AnimationEffect::paintWindow( EffectWindow* w, int mask, QRegion region, Wi
                 }
                 case Position: {
                     const QRect geo = w->geometry();
-                    const float prgrs = progress(*anim);
+                    const float prgrs = anim->progress;
                     if ( anim->from[0] >= 0.0 && anim->to[0] >= 0.0 ) {
-                        float dest = interpolated(*anim, 0);
+                        float dest = anim->value[0];
                         const int x[2] = {  xCoord(geo, metaData(SourceAnchor, anim->meta)),
                                             xCoord(geo, metaData(TargetAnchor, anim->meta)) };
                         data.translate(dest - (x[0] + prgrs*(x[1] - x[0])));
                     }
                     if ( anim->from[1] >= 0.0 && anim->to[1] >= 0.0 ) {
-                        float dest = interpolated(*anim, 1);
+                        float dest = anim->value[1];
                         const int y[2] = {  yCoord(geo, metaData(SourceAnchor, anim->meta)),
                                             yCoord(geo, metaData(TargetAnchor, anim->meta)) };
                         data.translate(0.0, dest - (y[0] + prgrs*(y[1] - y[0])));
@@ -701,7 +809,7 @@ void AnimationEffect::paintWindow( EffectWindow* w, int mask, QRegion region, Wi
                 }
                 case Rotation: {
                     data.setRotationAxis((Qt::Axis)metaData(Axis, anim->meta));
-                    const float prgrs = progress(*anim);
+                    const float prgrs = anim->progress;
                     data.setRotationAngle(anim->from[0] + prgrs*(anim->to[0] - anim->from[0]));
 
                     const QRect geo = w->rect();
@@ -717,10 +825,10 @@ void AnimationEffect::paintWindow( EffectWindow* w, int mask, QRegion region, Wi
                     break;
                 }
                 case Generic:
-                    genericAnimation(w, data, progress(*anim), anim->meta);
+                    genericAnimation(w, data, anim->progress, anim->meta);
                     break;
                 case CrossFadePrevious:
-                    data.setCrossFadeProgress(progress(*anim));
+                    data.setCrossFadeProgress(anim->progress);
                     break;
                 default:
                     break;
@@ -740,12 +848,13 @@ void AnimationEffect::postPaintScreen()
         if (d->m_needSceneRepaint) {
             effects->addRepaintFull();
         } else {
+            const qint64 now = clock();
             AniMap::const_iterator it = d->m_animations.constBegin(), end = d->m_animations.constEnd();
             for (; it != end; ++it) {
                 bool addRepaint = false;
                 QList<AniData>::const_iterator anim = it->first.constBegin();
                 for (; anim != it->first.constEnd(); ++anim) {
-                    if (anim->startTime > clock())
+                    if (anim->startTime > now)
                         continue;
                     if (!anim->timeLine.done()) {
                         addRepaint = true;
@@ -770,11 +879,6 @@ float AnimationEffect::interpolated( const AniData &a, int i ) const
     return a.to[i]; // we're done and "waiting" at the target value
 }
 
-float AnimationEffect::progress( const AniData &a ) const
-{
-    return a.startTime < clock() ? a.timeLine.value() : 0.0;
-}
-
 
 // TODO - get this out of the header - the functionpointer usage of QEasingCurve somehow sucks ;-)
 // qreal AnimationEffect::qecGaussian(qreal progress) // exp(-5*(2*x-1)^2)
@@ -874,6 +978,7 @@ void AnimationEffect::updateLayerRepaints()
 {
     Q_D(AnimationEffect);
     d->m_needSceneRepaint = false;
+    const qint64 now = clock();
     for (AniMap::const_iterator entry = d->m_animations.constBegin(), mapEnd = d->m_animations.constEnd(); entry != mapEnd; ++entry) {
         if (!entry->second.isNull())
             continue;
@@ -883,7 +988,7 @@ void AnimationEffect::updateLayerRepaints()
         QList<QRect> rects;
         QRect *layerRect = const_cast<QRect*>(&(entry->second));
         for (QList<AniData>::const_iterator anim = entry->first.constBegin(), animEnd = entry->first.constEnd(); anim != animEnd; ++anim) {
-            if (anim->startTime > clock())
+            if (anim->startTime > now)
                 continue;
             switch (anim->attribute) {
                 case Opacity:
@@ -1024,6 +1129,7 @@ void AnimationEffect::_windowDeleted( EffectWindow* w )
 {
     Q_D(AnimationEffect);
     d->m_animations.remove( w );
+    d->m_frameDirty = true;
 }
 
 
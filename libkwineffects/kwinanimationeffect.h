@@ -90,6 +90,7 @@ private:
 };
 
 class AniData;
+class AniFrame;
 class AnimationEffectPrivate;
 
 /**
@@ -182,6 +183,7 @@ public:
     ~AnimationEffect();
 
     bool isActive() const;
+    bool isActiveForWindow(const EffectWindow *w) const override;
 
     /**
      * Gets stored metadata.
@@ -382,10 +384,9 @@ protected:
 
 private:
     quint64 p_animate(EffectWindow *w, Attribute a, uint meta, int ms, FPx2 to, QEasingCurve curve, int delay, FPx2 from, bool keepAtTarget, bool fullScreenEffect, bool keepAlive);
-    QRect clipRect(const QRect &windowRect, const AniData&) const;
-    void clipWindow(const EffectWindow *, const AniData &, WindowQuadList &) const;
+    QRect clipRect(const QRect &windowRect, const AniFrame&) const;
+    void clipWindow(const EffectWindow *, const AniFrame &, WindowQuadList &) const;
     float interpolated( const AniData&, int i = 0 ) const;
-    float progress( const AniData& ) const;
     void disconnectGeometryChanges();
     void updateLayerRepaints();
     void validate(Attribute a, uint &meta, FPx2 *from, FPx2 *to, const EffectWindow *w) const;
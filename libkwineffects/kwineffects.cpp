@@ -619,6 +619,12 @@ bool Effect::isActive() const
     return true;
 }
 
+bool Effect::isActiveForWindow(const EffectWindow *w) const
+{
+    Q_UNUSED(w)
+    return true;
+}
+
 QString Effect::debug(const QString &) const
 {
     return QString();
@@ -1784,7 +1790,10 @@ public:
     Direction direction;
     QEasingCurve easingCurve;
 
-    std::chrono::milliseconds elapsed = std::chrono::milliseconds::zero();
+    // nanoseconds, so that advancing by presentation times keeps sub-millisecond precision
+    std::chrono::nanoseconds elapsed = std::chrono::nanoseconds::zero();
+    // the presentation time of the last advance, zero if the timeline has not been advanced yet
+    std::chrono::nanoseconds lastPresentationTime = std::chrono::nanoseconds::zero();
     bool done = false;
     RedirectMode sourceRedirectMode = RedirectMode::Relaxed;
     RedirectMode targetRedirectMode = RedirectMode::Strict;
@@ -1807,7 +1816,7 @@ TimeLine::~TimeLine() = default;
 
 qreal TimeLine::progress() const
 {
-    return static_cast<qreal>(d->elapsed.count()) / d->duration.count();
+    return static_cast<qreal>(d->elapsed.count()) / std::chrono::nanoseconds(d->duration).count();
 }
 
 qreal TimeLine::value() const
@@ -1820,6 +1829,28 @@ qreal TimeLine::value() const
 void TimeLine::update(std::chrono::milliseconds delta)
 {
     Q_ASSERT(delta >= std::chrono::milliseconds::zero());
+    advanceBy(delta);
+}
+
+void TimeLine::advance(std::chrono::nanoseconds presentationTime)
+{
+    if (d->done) {
+        return;
+    }
+    if (d->lastPresentationTime == std::chrono::nanoseconds::zero()) {
+        d->lastPresentationTime = presentationTime;
+        return;
+    }
+    if (presentationTime <= d->lastPresentationTime) {
+        return;
+    }
+    const std::chrono::nanoseconds delta = presentationTime - d->lastPresentationTime;
+    d->lastPresentationTime = presentationTime;
+    advanceBy(delta);
+}
+
+void TimeLine::advanceBy(std::chrono::nanoseconds delta)
+{
     if (d->done) {
         return;
     }
@@ -1827,12 +1858,13 @@ void TimeLine::update(std::chrono::milliseconds delta)
     if (d->elapsed >= d->duration) {
         d->done = true;
         d->elapsed = d->duration;
+        d->lastPresentationTime = std::chrono::nanoseconds::zero();
     }
 }
 
 std::chrono::milliseconds TimeLine::elapsed() const
 {
-    return d->elapsed;
+    return std::chrono::duration_cast<std::chrono::milliseconds>(d->elapsed);
 }
 
 void TimeLine::setElapsed(std::chrono::milliseconds elapsed)
@@ -1841,8 +1873,12 @@ void TimeLine::setElapsed(std::chrono::milliseconds elapsed)
     if (elapsed == d->elapsed) {
         return;
     }
+    const std::chrono::nanoseconds lastPresentationTime = d->lastPresentationTime;
     reset();
-    update(elapsed);
+    advanceBy(elapsed);
+    if (!d->done) {
+        d->lastPresentationTime = lastPresentationTime;
+    }
 }
 
 std::chrono::milliseconds TimeLine::duration() const
@@ -1876,7 +1912,7 @@ void TimeLine::setDirection(TimeLine::Direction direction)
 
     d->direction = direction;
 
-    if (d->elapsed > std::chrono::milliseconds::zero()
+    if (d->elapsed > std::chrono::nanoseconds::zero()
             || d->sourceRedirectMode == RedirectMode::Strict) {
         d->elapsed = d->duration - d->elapsed;
     }
@@ -1912,7 +1948,7 @@ void TimeLine::setEasingCurve(QEasingCurve::Type type)
 
 bool TimeLine::running() const
 {
-    return d->elapsed != std::chrono::milliseconds::zero()
+    return d->elapsed != std::chrono::nanoseconds::zero()
         && d->elapsed != d->duration;
 }
 
@@ -1923,7 +1959,8 @@ bool TimeLine::done() const
 
 void TimeLine::reset()
 {
-    d->elapsed = std::chrono::milliseconds::zero();
+    d->elapsed = std::chrono::nanoseconds::zero();
+    d->lastPresentationTime = std::chrono::nanoseconds::zero();
     d->done = false;
 }
 
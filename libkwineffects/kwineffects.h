@@ -51,6 +51,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <limits.h>
 #include <netwm.h>
 
+#include <chrono>
 #include <functional>
 
 class KConfigGroup;
@@ -188,7 +189,7 @@ X-KDE-Library=kwin4_effect_cooleffect
 
 #define KWIN_EFFECT_API_MAKE_VERSION( major, minor ) (( major ) << 8 | ( minor ))
 #define KWIN_EFFECT_API_VERSION_MAJOR 0
-#define KWIN_EFFECT_API_VERSION_MINOR 227
+#define KWIN_EFFECT_API_VERSION_MINOR 229
 #define KWIN_EFFECT_API_VERSION KWIN_EFFECT_API_MAKE_VERSION( \
         KWIN_EFFECT_API_VERSION_MAJOR, KWIN_EFFECT_API_VERSION_MINOR )
 
@@ -544,6 +545,21 @@ public:
      **/
     virtual bool isActive() const;
 
+    /**
+     * Overwrite this method to indicate whether your effect will be doing something with the
+     * window @p w in the next frame to be rendered. If the method returns @c false, the effect
+     * is excluded from the chained per window methods (prePaintWindow, paintWindow,
+     * postPaintWindow and drawWindow) of @p w in the next rendered frame, so an effect which
+     * only animates a few windows does not cost anything for all the other windows.
+     *
+     * The method is only called if isActive returns @c true, at most once per window and frame
+     * before the first chained method is invoked for the window.
+     *
+     * The default implementation of this method returns @c true.
+     * @since 5.15
+     **/
+    virtual bool isActiveForWindow(const EffectWindow *w) const;
+
     /**
      * Reimplement this method to provide online debugging.
      * This could be as trivial as printing specific detail information about the effect state
@@ -1074,6 +1090,14 @@ public:
      * if used manually.
      */
     virtual double animationTimeFactor() const = 0;
+    /**
+     * The time at which the frame being painted is expected to be shown on screen,
+     * measured on the steady clock. All animations advanced to it during one
+     * painting pass end up in the same state, no matter how late they are painted.
+     * @see TimeLine::advance
+     * @since 5.15
+     **/
+    virtual std::chrono::nanoseconds presentationTime() const = 0;
     virtual WindowQuadType newWindowQuadType() = 0;
 
     Q_SCRIPTABLE virtual KWin::EffectWindow* findWindow(WId id) const = 0;
@@ -3452,6 +3476,21 @@ public:
      **/
     void update(std::chrono::milliseconds delta);
 
+    /**
+     * Advances the timeline to the frame presented at @p presentationTime.
+     *
+     * The first call after the timeline was created or reset only records
+     * the presentation time, every following call progresses the timeline
+     * by the time passed since the previous one. Advancing to the same
+     * presentation time more than once, e.g. when the frame is painted
+     * per screen, does not progress the timeline any further.
+     *
+     * @param presentationTime The time at which the frame is going to be shown
+     * @see EffectsHandler::presentationTime
+     * @since 5.15
+     **/
+    void advance(std::chrono::nanoseconds presentationTime);
+
     /**
      * Returns the number of elapsed milliseconds.
      *
@@ -3649,6 +3688,14 @@ public:
 
 private:
     qreal progress() const;
+    /**
+     * Moves the timeline forward by @p delta, regardless of its direction. The elapsed
+     * time is clamped to the duration, the timeline is done once it reaches it.
+     *
+     * @see update
+     * @see advance
+     **/
+    void advanceBy(std::chrono::nanoseconds delta);
 
 private:
     class Data;
@@ -630,6 +630,7 @@ GLPlatform::GLPlatform()
       m_limitedGLSL(false),
       m_textureNPOT(false),
       m_limitedNPOT(false),
+      m_computeShaders(false),
       m_virtualMachine(false),
       m_preferBufferSubData(false),
       m_platformInterface(NoOpenGLPlatformInterface),
@@ -1022,6 +1023,15 @@ void GLPlatform::detect(OpenGLPlatformInterface platformInterface)
         m_supportsGLSL = true;
         m_limitedGLSL = false;
     }
+
+    if (isGLES()) {
+        m_computeShaders = m_glVersion >= kVersionNumber(3, 1);
+    } else {
+        m_computeShaders = m_supportsGLSL && !m_limitedGLSL &&
+                           (m_glVersion >= kVersionNumber(4, 3) ||
+                            (m_extensions.contains("GL_ARB_compute_shader") &&
+                             m_extensions.contains("GL_ARB_shader_image_load_store")));
+    }
 }
 
 static void print(const QByteArray &label, const QByteArray &setting)
@@ -1062,6 +1072,7 @@ void GLPlatform::printResults() const
     print(QByteArrayLiteral("Requires strict binding:"), !m_looseBinding ? QByteArrayLiteral("yes") : QByteArrayLiteral("no"));
     print(QByteArrayLiteral("GLSL shaders:"), m_supportsGLSL ? (m_limitedGLSL ? QByteArrayLiteral("limited") : QByteArrayLiteral("yes")) : QByteArrayLiteral("no"));
     print(QByteArrayLiteral("Texture NPOT support:"), m_textureNPOT ? (m_limitedNPOT ? QByteArrayLiteral("limited") : QByteArrayLiteral("yes")) : QByteArrayLiteral("no"));
+    print(QByteArrayLiteral("Compute shaders:"), m_computeShaders ? QByteArrayLiteral("yes") : QByteArrayLiteral("no"));
     print(QByteArrayLiteral("Virtual Machine:"), m_virtualMachine ? QByteArrayLiteral("yes") : QByteArrayLiteral("no"));
 }
 
@@ -1083,6 +1094,9 @@ bool GLPlatform::supports(GLFeature feature) const
     case LimitedNPOT:
         return m_limitedNPOT;
 
+    case ComputeShaders:
+        return m_computeShaders;
+
     default:
         return false;
     }
@@ -82,7 +82,14 @@ enum GLFeature {
      * - GL_CLAMP_TO_EDGE
      * - GL_CLAMP_TO_BORDER
      */
-    LimitedNPOT
+    LimitedNPOT,
+
+    /**
+     * Set when compute shaders and image load/store can be used, which
+     * requires OpenGL 4.3 (or GL_ARB_compute_shader) or OpenGL ES 3.1.
+     * @since 5.15
+     */
+    ComputeShaders
 };
 
 enum Driver {
@@ -418,6 +425,7 @@ private:
     bool m_limitedGLSL: 1;
     bool m_textureNPOT: 1;
     bool m_limitedNPOT: 1;
+    bool m_computeShaders: 1;
     bool m_virtualMachine: 1;
     bool m_preferBufferSubData: 1;
     OpenGLPlatformInterface m_platformInterface;
@@ -0,0 +1,220 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2019 KWin-lowlatency developers
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "kwinglshadercache_p.h"
+#include "kwinglplatform.h"
+#include "kwinglutils.h"
+#include "logging_p.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QVector>
+
+#include <algorithm>
+
+namespace KWin
+{
+
+static const quint32 s_magic = 0x4b575343; // "KWSC"
+static const quint32 s_version = 1;
+// directories of other drivers are kept for switching back, e.g. after a downgrade
+static const int s_maxDirectories = 3;
+static const int s_maxUnusedDays = 30;
+
+static QString stampFileName(const QString &directory)
+{
+    return directory + QStringLiteral("/last-used");
+}
+
+static QDateTime lastUsed(const QString &directory)
+{
+    const QFileInfo stamp(stampFileName(directory));
+    return stamp.exists() ? stamp.lastModified() : QFileInfo(directory).lastModified();
+}
+
+ShaderCache::ShaderCache()
+{
+    if (qstrcmp(qgetenv("KWIN_GL_SHADER_CACHE"), "0") == 0) {
+        return;
+    }
+
+    GLPlatform *platform = GLPlatform::instance();
+    if (platform->isGLES()) {
+        if (!hasGLVersion(3, 0) && !hasGLExtension(QByteArrayLiteral("GL_OES_get_program_binary"))) {
+            return;
+        }
+    } else if (!hasGLVersion(4, 1) && !hasGLExtension(QByteArrayLiteral("GL_ARB_get_program_binary"))) {
+        return;
+    }
+
+    // some drivers advertise the extension without supporting any format
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    if (formats <= 0) {
+        return;
+    }
+
+    const QString base = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation);
+    if (base.isEmpty()) {
+        return;
+    }
+
+    QCryptographicHash driver(QCryptographicHash::Sha1);
+    driver.addData(platform->glVendorString());
+    driver.addData(platform->glRendererString());
+    driver.addData(platform->glVersionString());
+    driver.addData(platform->glShadingLanguageVersionString());
+    const QString driverDirectory = QString::fromLatin1(driver.result().toHex());
+
+    const QString cacheBase = base + QStringLiteral("/kwin/shaders");
+    m_directory = cacheBase + QLatin1Char('/') + driverDirectory;
+    if (!QDir().mkpath(m_directory)) {
+        qCWarning(LIBKWINGLUTILS) << "Cannot create the shader cache directory" << m_directory;
+        return;
+    }
+    QFile stamp(stampFileName(m_directory));
+    if (stamp.open(QIODevice::WriteOnly)) {
+        stamp.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+    }
+    removeStaleDirectories(cacheBase, driverDirectory);
+    m_valid = true;
+}
+
+void ShaderCache::removeStaleDirectories(const QString &base, const QString &current)
+{
+    QDir dir(base);
+    const QStringList entries = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    const QDateTime expiry = QDateTime::currentDateTime().addDays(-s_maxUnusedDays);
+    QVector<QPair<QDateTime, QString>> others;
+    for (const QString &entry : entries) {
+        if (entry == current) {
+            continue;
+        }
+        const QString path = dir.filePath(entry);
+        const QDateTime used = lastUsed(path);
+        if (used < expiry) {
+            QDir(path).removeRecursively();
+        } else {
+            others << qMakePair(used, path);
+        }
+    }
+
+    // the most recently used ones are kept
+    std::sort(others.begin(), others.end(),
+        [] (const QPair<QDateTime, QString> &a, const QPair<QDateTime, QString> &b) {
+            return a.first > b.first;
+        }
+    );
+    for (int i = s_maxDirectories - 1; i < others.count(); ++i) {
+        QDir(others.at(i).second).removeRecursively();
+    }
+}
+
+QByteArray ShaderCache::key(const QByteArray &sources) const
+{
+    return QCryptographicHash::hash(sources, QCryptographicHash::Sha1).toHex();
+}
+
+QString ShaderCache::fileName(const QByteArray &key) const
+{
+    return m_directory + QLatin1Char('/') + QString::fromLatin1(key);
+}
+
+bool ShaderCache::load(GLuint program, const QByteArray &key)
+{
+    if (!m_valid) {
+        return false;
+    }
+    QFile file(fileName(key));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    quint32 magic = 0;
+    quint32 version = 0;
+    quint32 format = 0;
+    QByteArray binary;
+    stream >> magic >> version >> format >> binary;
+    file.close();
+
+    bool linked = false;
+    if (stream.status() == QDataStream::Ok && magic == s_magic && version == s_version && !binary.isEmpty()) {
+        // clear errors so that a rejected format does not look like a later failure
+        for (int i = 0; i < 8 && glGetError() != GL_NO_ERROR; ++i) {}
+
+        glProgramBinary(program, format, binary.constData(), binary.size());
+        GLint status = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &status);
+        linked = glGetError() == GL_NO_ERROR && status == GL_TRUE;
+    }
+
+    if (!linked) {
+        qCDebug(LIBKWINGLUTILS) << "Discarding cached shader program" << key;
+        QFile::remove(file.fileName());
+    }
+    return linked;
+}
+
+void ShaderCache::prepare(GLuint program)
+{
+    // GL_OES_get_program_binary always allows to retrieve the binary
+    if (m_valid && (!GLPlatform::instance()->isGLES() || hasGLVersion(3, 0))) {
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+}
+
+void ShaderCache::store(GLuint program, const QByteArray &key)
+{
+    if (!m_valid) {
+        return;
+    }
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+    QByteArray binary(length, Qt::Uninitialized);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+    if (length <= 0) {
+        return;
+    }
+    binary.truncate(length);
+
+    // written atomically, a crash must not leave a truncated entry behind
+    QSaveFile file(fileName(key));
+    if (!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+    QDataStream stream(&file);
+    stream << s_magic << s_version << quint32(format) << binary;
+    if (!file.commit()) {
+        qCDebug(LIBKWINGLUTILS) << "Failed to write shader cache entry" << file.fileName();
+    }
+}
+
+}
@@ -0,0 +1,88 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2019 KWin-lowlatency developers
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+
+#ifndef KWIN_GLSHADERCACHE_P_H
+#define KWIN_GLSHADERCACHE_P_H
+
+#include <epoxy/gl.h>
+
+#include <QByteArray>
+#include <QString>
+
+namespace KWin
+{
+
+/**
+ * On-disk cache of linked shader programs.
+ *
+ * Programs are stored with glGetProgramBinary and identified by a hash over their
+ * sources. All entries live in a directory per driver, identified by the vendor,
+ * renderer and version strings, so that a driver update does not try to load
+ * binaries of the old driver. Directories of other drivers are removed once they
+ * have not been used for a month, and only the two most recently used are kept.
+ *
+ * Loading a binary can always fail, e.g. if the driver rejects it, in which case
+ * the entry is removed and the program has to be compiled from source.
+ *
+ * @internal
+ **/
+class ShaderCache
+{
+public:
+    ShaderCache();
+
+    bool isValid() const {
+        return m_valid;
+    }
+    /**
+     * The directory of the current driver.
+     **/
+    QString directory() const {
+        return m_directory;
+    }
+
+    /**
+     * @returns the key for a program built from @p sources, the @p sources have to
+     * include everything that influences the link result
+     **/
+    QByteArray key(const QByteArray &sources) const;
+
+    /**
+     * Loads the binary for @p key into @p program.
+     * @returns @c true if the program is linked and ready to use
+     **/
+    bool load(GLuint program, const QByteArray &key);
+    /**
+     * Must be called before linking a program which is going to be stored.
+     **/
+    void prepare(GLuint program);
+    void store(GLuint program, const QByteArray &key);
+
+private:
+    QString fileName(const QByteArray &key) const;
+    void removeStaleDirectories(const QString &base, const QString &current);
+
+    QString m_directory;
+    bool m_valid = false;
+};
+
+}
+
+#endif
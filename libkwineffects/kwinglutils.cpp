@@ -23,6 +23,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 // need to call GLTexturePrivate::initStatic()
 #include "kwingltexture_p.h"
+#include "kwinglshadercache_p.h"
 
 #include "kwineffects.h"
 #include "kwinglplatform.h"
@@ -262,7 +263,7 @@ bool GLShader::compile(GLuint program, GLenum shaderType, const QByteArray &sour
     glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
 
     if (status == 0) {
-        const char *typeName = (shaderType == GL_VERTEX_SHADER ? "vertex" : "fragment");
+        const char *typeName = (shaderType == GL_VERTEX_SHADER ? "vertex" : (shaderType == GL_FRAGMENT_SHADER ? "fragment" : "compute"));
         qCCritical(LIBKWINGLUTILS) << "Failed to compile" << typeName << "shader:" << endl << log;
     } else if (length > 0)
         qCDebug(LIBKWINGLUTILS) << "Shader compile log:" << log;
@@ -566,6 +567,8 @@ ShaderManager::ShaderManager()
     } else {
         m_resourcePath = QStringLiteral(":/effect-shaders-1.10/");
     }
+
+    m_shaderCache.reset(new ShaderCache);
 }
 
 ShaderManager::~ShaderManager()
@@ -923,13 +926,17 @@ GLShader *ShaderManager::generateCustomShader(ShaderTraits traits, const QByteAr
 #endif
 
     GLShader *shader = new GLShader(GLShader::ExplicitLinking);
+    const QByteArray key = shaderCacheKey("custom", vertex, fragment);
+    if (loadCachedShader(shader, key)) {
+        return shader;
+    }
     shader->load(vertex, fragment);
 
     shader->bindAttributeLocation("position", VA_Position);
     shader->bindAttributeLocation("texcoord", VA_TexCoord);
     shader->bindFragDataLocation("fragColor", 0);
 
-    shader->link();
+    linkShader(shader, key);
     return shader;
 }
 
@@ -1037,13 +1044,86 @@ void ShaderManager::bindAttributeLocations(GLShader *shader) const
 GLShader *ShaderManager::loadShaderFromCode(const QByteArray &vertexSource, const QByteArray &fragmentSource)
 {
     GLShader *shader = new GLShader(GLShader::ExplicitLinking);
+    const QByteArray key = shaderCacheKey("code", vertexSource, fragmentSource);
+    if (loadCachedShader(shader, key)) {
+        return shader;
+    }
     shader->load(vertexSource, fragmentSource);
     bindAttributeLocations(shader);
     bindFragDataLocations(shader);
-    shader->link();
+    linkShader(shader, key);
     return shader;
 }
 
+GLShader *ShaderManager::loadComputeShaderFromCode(const QByteArray &computeSource)
+{
+    GLShader *shader = new GLShader(GLShader::ExplicitLinking);
+    if (!GLPlatform::instance()->supports(ComputeShaders)) {
+        qCWarning(LIBKWINGLUTILS) << "Compute shaders are not supported";
+        return shader;
+    }
+    const QByteArray key = shaderCacheKey("compute", computeSource, QByteArray());
+    if (loadCachedShader(shader, key)) {
+        return shader;
+    }
+    if (shader->compile(shader->mProgram, GL_COMPUTE_SHADER, computeSource)) {
+        linkShader(shader, key);
+    }
+    return shader;
+}
+
+QByteArray ShaderManager::shaderCacheKey(const char *kind, const QByteArray &vertexSource, const QByteArray &fragmentSource) const
+{
+    if (!m_shaderCache->isValid()) {
+        return QByteArray();
+    }
+    // the kind determines the attribute and fragment data bindings, the debug
+    // flag changes the prepared source
+    QByteArray sources(kind);
+    sources.append('\0');
+    sources.append(m_debug ? '1' : '0');
+    sources.append(vertexSource);
+    sources.append('\0');
+    sources.append(fragmentSource);
+    return m_shaderCache->key(sources);
+}
+
+bool ShaderManager::loadCachedShader(GLShader *shader, const QByteArray &key)
+{
+    if (key.isEmpty() || !m_shaderCache->load(shader->mProgram, key)) {
+        return false;
+    }
+    shader->mValid = true;
+    return true;
+}
+
+void ShaderManager::linkShader(GLShader *shader, const QByteArray &key)
+{
+    if (!key.isEmpty()) {
+        m_shaderCache->prepare(shader->mProgram);
+    }
+    if (shader->link() && !key.isEmpty()) {
+        m_shaderCache->store(shader->mProgram, key);
+    }
+}
+
+void ShaderManager::precompileShaders()
+{
+    if (!m_shaderCache->isValid()) {
+        return;
+    }
+    const ShaderTraits common[] = {
+        ShaderTrait::MapTexture,
+        ShaderTrait::MapTexture | ShaderTrait::Modulate,
+        ShaderTrait::MapTexture | ShaderTrait::Modulate | ShaderTrait::AdjustSaturation,
+        ShaderTrait::UniformColor,
+        ShaderTrait::UniformColor | ShaderTrait::Modulate
+    };
+    for (const ShaderTraits traits : common) {
+        shader(traits);
+    }
+}
+
 /***  GLRenderTarget  ***/
 bool GLRenderTarget::sSupported = false;
 bool GLRenderTarget::s_blitSupported = false;
@@ -28,6 +28,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "kwingltexture.h"
 
 // Qt
+#include <QScopedPointer>
 #include <QSize>
 #include <QStack>
 
@@ -47,6 +48,7 @@ namespace KWin
 
 class GLVertexBuffer;
 class GLVertexBufferPrivate;
+class ShaderCache;
 
 // Initializes OpenGL stuff. This includes resolving function pointers as
 //  well as checking for GL version and extensions
@@ -260,6 +262,16 @@ public:
      **/
     GLShader *loadShaderFromCode(const QByteArray &vertexSource, const QByteArray &fragmentSource);
 
+    /**
+     * Creates a GLShader consisting of a single compute shader with the specified source.
+     * The returned shader is not valid if the platform does not support compute shaders.
+     * @param computeSource The source code of the compute shader
+     * @return The created shader
+     * @see GLPlatform::supports
+     * @since 5.15
+     **/
+    GLShader *loadComputeShaderFromCode(const QByteArray &computeSource);
+
     /**
      * Creates a custom shader with the given @p traits and custom @p vertexSource and or @p fragmentSource.
      * If the @p vertexSource is empty a vertex shader with the given @p traits is generated.
@@ -307,6 +319,14 @@ public:
      */
     bool selfTest();
 
+    /**
+     * Creates the shaders for the trait combinations used by the scene up front, so
+     * that the first frames do not stall on creating them. This only happens if the
+     * program binary cache is available, in which case it merely loads the binaries.
+     * @since 5.15
+     **/
+    void precompileShaders();
+
     /**
      * @return a pointer to the ShaderManager instance
      **/
@@ -323,6 +343,9 @@ private:
 
     void bindFragDataLocations(GLShader *shader);
     void bindAttributeLocations(GLShader *shader) const;
+    QByteArray shaderCacheKey(const char *kind, const QByteArray &vertexSource, const QByteArray &fragmentSource) const;
+    bool loadCachedShader(GLShader *shader, const QByteArray &key);
+    void linkShader(GLShader *shader, const QByteArray &key);
 
     QByteArray generateVertexSource(ShaderTraits traits) const;
     QByteArray generateFragmentSource(ShaderTraits traits) const;
@@ -332,6 +355,7 @@ private:
     QHash<ShaderTraits, GLShader *> m_shaderHash;
     bool m_debug;
     QString m_resourcePath;
+    QScopedPointer<ShaderCache> m_shaderCache;
     static ShaderManager *s_shaderManager;
 };
 
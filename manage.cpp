@@ -48,10 +48,19 @@ namespace KWin
  */
 bool Client::manage(xcb_window_t w, bool isMapped)
 {
-    StackingUpdatesBlocker stacking_blocker(workspace());
-
     Xcb::WindowAttributes attr(w);
     Xcb::WindowGeometry windowGeometry(w);
+    return manage(w, isMapped, attr, windowGeometry);
+}
+
+/**
+ * Variant of manage() for callers which already requested the attributes and the
+ * geometry of @p w, e.g. together with the ones of other windows.
+ */
+bool Client::manage(xcb_window_t w, bool isMapped, Xcb::WindowAttributes &attr, Xcb::WindowGeometry &windowGeometry)
+{
+    StackingUpdatesBlocker stacking_blocker(workspace());
+
     if (attr.isNull() || windowGeometry.isNull()) {
         return false;
     }
@@ -94,7 +103,8 @@ bool Client::manage(xcb_window_t w, bool isMapped)
         NET::WM2InitialMappingState |
         NET::WM2IconPixmap |
         NET::WM2OpaqueRegion |
-        NET::WM2DesktopFileName;
+        NET::WM2DesktopFileName |
+        NET::WM2ClientMachine;
 
     auto wmClientLeaderCookie = fetchWmClientLeader();
     auto skipCloseAnimationCookie = fetchSkipCloseAnimation();
@@ -106,6 +116,12 @@ bool Client::manage(xcb_window_t w, bool isMapped)
     auto activitiesCookie = fetchActivities();
     auto applicationMenuServiceNameCookie = fetchApplicationMenuServiceName();
     auto applicationMenuObjectPathCookie = fetchApplicationMenuObjectPath();
+    auto syncCounterCookie = fetchSyncCounter();
+
+    // select the input before querying the shape, otherwise a change in between would get lost
+    if (Xcb::Extensions::self()->isShapeAvailable())
+        xcb_shape_select_input(connection(), window(), true);
+    auto shapeCookie = fetchShape(window());
 
     m_geometryHints.init(window());
     m_motif.init(window());
@@ -123,8 +139,8 @@ bool Client::manage(xcb_window_t w, bool isMapped)
 
     getResourceClass();
     readWmClientLeader(wmClientLeaderCookie);
-    getWmClientMachine();
-    getSyncCounter();
+    readWmClientMachine(QByteArray(info->clientMachine()));
+    readSyncCounter(syncCounterCookie);
     // First only read the caption text, so that setupWindowRules() can use it for matching,
     // and only then really set the caption using setCaption(), which checks for duplicates etc.
     // and also relies on rules already existing
@@ -134,9 +150,7 @@ bool Client::manage(xcb_window_t w, bool isMapped)
 
     connect(this, &Client::windowClassChanged, this, &Client::evaluateWindowRules);
 
-    if (Xcb::Extensions::self()->isShapeAvailable())
-        xcb_shape_select_input(connection(), window(), true);
-    detectShape(window());
+    readShape(shapeCookie);
     readGtkFrameExtents(gtkFrameExtentsCookie);
     detectNoBorder();
     fetchIconicName();
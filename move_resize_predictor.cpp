@@ -0,0 +1,105 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2019 KWin-lowlatency developers
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "move_resize_predictor.h"
+
+namespace KWin
+{
+
+// samples older than this (in ms) do not describe the current motion anymore
+static const quint32 s_velocityWindow = 50;
+// the pointer is not extrapolated further than this (in ms)
+static const qreal s_maxHorizon = 50;
+static const qint64 s_nanosPerMilli = 1000 * 1000;
+
+MoveResizePredictor::MoveResizePredictor()
+{
+    m_clock.start();
+}
+
+void MoveResizePredictor::addSample(const QPointF &pos, quint32 time)
+{
+    addSample(pos, time, m_clock.nsecsElapsed());
+}
+
+void MoveResizePredictor::addSample(const QPointF &pos, quint32 time, qint64 received)
+{
+    Sample &s = m_samples[m_next];
+    s.pos = pos;
+    s.time = time;
+    s.received = received;
+    m_next = (m_next + 1) % s_maxSamples;
+    m_count = qMin(m_count + 1, s_maxSamples);
+}
+
+void MoveResizePredictor::reset()
+{
+    m_next = 0;
+    m_count = 0;
+}
+
+const MoveResizePredictor::Sample &MoveResizePredictor::sample(int age) const
+{
+    return m_samples[(m_next - 1 - age + s_maxSamples) % s_maxSamples];
+}
+
+QPointF MoveResizePredictor::latest() const
+{
+    if (m_count == 0) {
+        return QPointF();
+    }
+    return sample(0).pos;
+}
+
+QPointF MoveResizePredictor::predict(qint64 delay) const
+{
+    return predict(delay, m_clock.nsecsElapsed());
+}
+
+QPointF MoveResizePredictor::predict(qint64 delay, qint64 now) const
+{
+    if (m_count == 0) {
+        return QPointF();
+    }
+    const Sample &last = sample(0);
+    const qint64 sinceLast = now - last.received;
+    if (m_count < 2 || sinceLast > s_velocityWindow * s_nanosPerMilli) {
+        // the pointer stopped, the window has to stay where the pointer is
+        return last.pos;
+    }
+
+    // the event times may wrap around, their difference does not
+    int oldest = 0;
+    for (int age = 1; age < m_count; ++age) {
+        if (last.time - sample(age).time > s_velocityWindow) {
+            break;
+        }
+        oldest = age;
+    }
+    const quint32 duration = last.time - sample(oldest).time;
+    if (duration == 0) {
+        return last.pos;
+    }
+
+    const QPointF velocity = (last.pos - sample(oldest).pos) / duration;
+    const qreal horizon = qMin(qreal(sinceLast + delay) / s_nanosPerMilli, s_maxHorizon);
+    return last.pos + velocity * horizon;
+}
+
+}
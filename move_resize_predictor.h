@@ -0,0 +1,86 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2019 KWin-lowlatency developers
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#ifndef KWIN_MOVE_RESIZE_PREDICTOR_H
+#define KWIN_MOVE_RESIZE_PREDICTOR_H
+
+#include <QElapsedTimer>
+#include <QPointF>
+
+namespace KWin
+{
+
+/**
+ * Keeps the recent pointer positions of an interactive move/resize.
+ *
+ * The positions are timestamped with the time of the input event, which is only
+ * used to derive the velocity of the pointer, and with the time they were received,
+ * which relates them to the time a frame is painted.
+ *
+ * @internal
+ **/
+class MoveResizePredictor
+{
+public:
+    MoveResizePredictor();
+
+    void addSample(const QPointF &pos, quint32 time);
+    /**
+     * Variant of addSample() for a sample received at @p received nanoseconds. The
+     * clock is arbitrary, but has to be the one passed to predict().
+     **/
+    void addSample(const QPointF &pos, quint32 time, qint64 received);
+    void reset();
+
+    bool isEmpty() const {
+        return m_count == 0;
+    }
+    /**
+     * @returns the last reported pointer position
+     **/
+    QPointF latest() const;
+    /**
+     * Extrapolates the pointer position to @p delay nanoseconds from now, based on the
+     * velocity of the recent samples. If the pointer did not move recently, the last
+     * reported position is returned.
+     **/
+    QPointF predict(qint64 delay) const;
+    /**
+     * Variant of predict() at @p now nanoseconds, on the clock of addSample().
+     **/
+    QPointF predict(qint64 delay, qint64 now) const;
+
+private:
+    struct Sample {
+        QPointF pos;
+        quint32 time = 0;
+        qint64 received = 0;
+    };
+    const Sample &sample(int age) const;
+
+    static const int s_maxSamples = 8;
+    Sample m_samples[s_maxSamples];
+    int m_next = 0;
+    int m_count = 0;
+    QElapsedTimer m_clock;
+};
+
+}
+
+#endif
@@ -22,7 +22,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 // own
 #include "netinfo.h"
 // kwin
+#include "atoms.h"
 #include "client.h"
+#include "main.h"
 #include "rootinfo_filter.h"
 #include "virtualdesktops.h"
 #include "workspace.h"
@@ -125,6 +127,14 @@ RootInfo *RootInfo::create()
         NET::ActionClose;
 
     s_self = new RootInfo(supportWindow, "KWin", properties, types, states, properties2, actions, screen_number);
+
+    // NETRootInfo does not know about the extended sync protocol, see Client::handleFrameSync
+    if (Xcb::Extensions::self()->isSyncAvailable() && kwinApp()->operationMode() == Application::OperationModeX11) {
+        const Xcb::Atom netSupported(QByteArrayLiteral("_NET_SUPPORTED"));
+        const xcb_atom_t frameDrawn = atoms->net_wm_frame_drawn;
+        xcb_change_property(connection(), XCB_PROP_MODE_APPEND, rootWindow(), netSupported,
+                            XCB_ATOM_ATOM, 32, 1, &frameDrawn);
+    }
     return s_self;
 }
 
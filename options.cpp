@@ -115,6 +115,7 @@ Options::Options(QObject *parent)
     , m_compositingInitialized(Options::defaultCompositingInitialized())
     , m_hiddenPreviews(Options::defaultHiddenPreviews())
     , m_glSmoothScale(Options::defaultGlSmoothScale())
+    , m_glLanczosCacheSize(Options::defaultGlLanczosCacheSize())
     , m_xrenderSmoothScale(Options::defaultXrenderSmoothScale())
     , m_maxFpsInterval(Options::defaultMaxFpsInterval())
     , m_refreshRate(Options::defaultRefreshRate())
@@ -148,6 +149,7 @@ Options::Options(QObject *parent)
     , borderless_maximized_windows(false)
     , show_geometry_tip(false)
     , condensed_title(false)
+    , m_moveResizePrediction(false)
     , animationSpeed(Options::defaultAnimationSpeed())
 {
     m_settings->setDefaults();
@@ -516,6 +518,15 @@ void Options::setCondensedTitle(bool condensedTitle)
     emit condensedTitleChanged();
 }
 
+void Options::setMoveResizePrediction(bool moveResizePrediction)
+{
+    if (m_moveResizePrediction == moveResizePrediction) {
+        return;
+    }
+    m_moveResizePrediction = moveResizePrediction;
+    emit moveResizePredictionChanged();
+}
+
 void Options::setElectricBorderMaximize(bool electricBorderMaximize)
 {
     if (electric_border_maximize == electricBorderMaximize) {
@@ -642,6 +653,15 @@ void Options::setGlSmoothScale(int glSmoothScale)
     emit glSmoothScaleChanged();
 }
 
+void Options::setGlLanczosCacheSize(int glLanczosCacheSize)
+{
+    if (m_glLanczosCacheSize == glLanczosCacheSize) {
+        return;
+    }
+    m_glLanczosCacheSize = glLanczosCacheSize;
+    emit glLanczosCacheSizeChanged();
+}
+
 void Options::setXrenderSmoothScale(bool xrenderSmoothScale)
 {
     if (m_xrenderSmoothScale == xrenderSmoothScale) {
@@ -854,6 +874,7 @@ void Options::syncFromKcfgc()
 {
     setShowGeometryTip(m_settings->geometryTip());
     setCondensedTitle(m_settings->condensedTitle());
+    setMoveResizePrediction(m_settings->moveResizePrediction());
     setFocusPolicy(m_settings->focusPolicy());
     setNextFocusPrefersMouse(m_settings->nextFocusPrefersMouse());
     setSeparateScreenFocus(m_settings->separateScreenFocus());
@@ -964,6 +985,7 @@ void Options::reloadCompositingSettings(bool force)
     KConfigGroup config(m_settings->config(), "Compositing");
 
     setGlSmoothScale(qBound(-1, config.readEntry("GLTextureFilter", Options::defaultGlSmoothScale()), 2));
+    setGlLanczosCacheSize(qMax(0, config.readEntry("GLLanczosCacheSize", Options::defaultGlLanczosCacheSize())));
     setGlStrictBindingFollowsDriver(!config.hasKey("GLStrictBinding"));
     if (!isGlStrictBindingFollowsDriver()) {
         setGlStrictBinding(config.readEntry("GLStrictBinding", Options::defaultGlStrictBinding()));
@@ -142,6 +142,11 @@ class KWIN_EXPORT Options : public QObject
     */
     Q_PROPERTY(bool condensedTitle READ condensedTitle WRITE setCondensedTitle NOTIFY condensedTitleChanged)
     /**
+    * whether an interactively moved or resized window is placed where the pointer is expected
+    * to be when the frame is shown, instead of where it was last reported.
+    */
+    Q_PROPERTY(bool moveResizePrediction READ isMoveResizePrediction WRITE setMoveResizePrediction NOTIFY moveResizePredictionChanged)
+    /**
     * Whether a window gets maximized when it reaches top screen edge while being moved.
     */
     Q_PROPERTY(bool electricBorderMaximize READ electricBorderMaximize WRITE setElectricBorderMaximize NOTIFY electricBorderMaximizeChanged)
@@ -175,6 +180,10 @@ class KWIN_EXPORT Options : public QObject
      * -1 = auto
      **/
     Q_PROPERTY(int glSmoothScale READ glSmoothScale WRITE setGlSmoothScale NOTIFY glSmoothScaleChanged)
+    /**
+     * Video memory in MiB the lanczos filter may use to keep filtered window textures.
+     **/
+    Q_PROPERTY(int glLanczosCacheSize READ glLanczosCacheSize WRITE setGlLanczosCacheSize NOTIFY glLanczosCacheSizeChanged)
     Q_PROPERTY(bool xrenderSmoothScale READ isXrenderSmoothScale WRITE setXrenderSmoothScale NOTIFY xrenderSmoothScaleChanged)
     Q_PROPERTY(qint64 maxFpsInterval READ maxFpsInterval WRITE setMaxFpsInterval NOTIFY maxFpsIntervalChanged)
     Q_PROPERTY(uint refreshRate READ refreshRate WRITE setRefreshRate NOTIFY refreshRateChanged)
@@ -483,6 +492,13 @@ public:
      */
     bool condensedTitle() const;
 
+    /**
+    * @returns true if the pointer position is extrapolated to the presentation of the frame during a window move/resize.
+    */
+    bool isMoveResizePrediction() const {
+        return m_moveResizePrediction;
+    }
+
     /**
     * @returns true if a window gets maximized when it reaches top screen edge
     * while being moved.
@@ -557,6 +573,10 @@ public:
     int glSmoothScale() const {
         return m_glSmoothScale;
     }
+    // Video memory in MiB for the textures cached by the lanczos filter
+    int glLanczosCacheSize() const {
+        return m_glLanczosCacheSize;
+    }
     // XRender
     bool isXrenderSmoothScale() const {
         return m_xrenderSmoothScale;
@@ -635,6 +655,7 @@ public:
     void setKeyCmdAllModKey(uint keyCmdAllModKey);
     void setShowGeometryTip(bool showGeometryTip);
     void setCondensedTitle(bool condensedTitle);
+    void setMoveResizePrediction(bool moveResizePrediction);
     void setElectricBorderMaximize(bool electricBorderMaximize);
     void setElectricBorderTiling(bool electricBorderTiling);
     void setElectricBorderCornerRatio(float electricBorderCornerRatio);
@@ -649,6 +670,7 @@ public:
     void setCompositingInitialized(bool compositingInitialized);
     void setHiddenPreviews(int hiddenPreviews);
     void setGlSmoothScale(int glSmoothScale);
+    void setGlLanczosCacheSize(int glLanczosCacheSize);
     void setXrenderSmoothScale(bool xrenderSmoothScale);
     void setMaxFpsInterval(qint64 maxFpsInterval);
     void setRefreshRate(uint refreshRate);
@@ -739,6 +761,9 @@ public:
     static int defaultGlSmoothScale() {
         return 2;
     }
+    static int defaultGlLanczosCacheSize() {
+        return 64;
+    }
     static bool defaultXrenderSmoothScale() {
         return false;
     }
@@ -826,6 +851,7 @@ Q_SIGNALS:
     void keyCmdAllModKeyChanged();
     void showGeometryTipChanged();
     void condensedTitleChanged();
+    void moveResizePredictionChanged();
     void electricBorderMaximizeChanged();
     void electricBorderTilingChanged();
     void electricBorderCornerRatioChanged();
@@ -840,6 +866,7 @@ Q_SIGNALS:
     void compositingInitializedChanged();
     void hiddenPreviewsChanged();
     void glSmoothScaleChanged();
+    void glLanczosCacheSizeChanged();
     void xrenderSmoothScaleChanged();
     void maxFpsIntervalChanged();
     void refreshRateChanged();
@@ -885,6 +912,7 @@ private:
     bool m_compositingInitialized;
     HiddenPreviews m_hiddenPreviews;
     int m_glSmoothScale;
+    int m_glLanczosCacheSize;
     bool m_xrenderSmoothScale;
     qint64 m_maxFpsInterval;
     // Settings that should be auto-detected
@@ -926,6 +954,7 @@ private:
     bool borderless_maximized_windows;
     bool show_geometry_tip;
     bool condensed_title;
+    bool m_moveResizePrediction;
     int animationSpeed; // 0 - instant, 5 - very slow
 
     QHash<Qt::KeyboardModifier, QStringList> m_modifierOnlyShortcuts;
@@ -20,6 +20,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "backend.h"
 #include <logging.h>
 
+#include <QRegion>
 #include <QtGlobal>
 
 namespace KWin
@@ -65,4 +66,10 @@ QImage *QPainterBackend::bufferForScreen(int screenId)
     return buffer();
 }
 
+QRegion QPainterBackend::prepareRenderingForScreen(int screenId)
+{
+    Q_UNUSED(screenId)
+    return QRegion();
+}
+
 }
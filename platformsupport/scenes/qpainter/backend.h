@@ -86,6 +86,15 @@ public:
      * Default implementation returns @c false.
      **/
     virtual bool perScreenRendering() const;
+    /**
+     * Called before the screen @p screenId is painted, if the rendering is split per screen
+     * and no full repaint is needed.
+     *
+     * A backend which reuses older back buffers returns the region, in global coordinates,
+     * which changed since the current back buffer of the screen was painted. It gets repainted
+     * in addition to the damage of the frame. Default implementation returns an empty region.
+     **/
+    virtual QRegion prepareRenderingForScreen(int screenId);
 
 protected:
     QPainterBackend();
@@ -222,8 +222,6 @@ void DrmBackend::pageFlipHandler(int fd, unsigned int frame, unsigned int sec, u
 {
     Q_UNUSED(fd)
     Q_UNUSED(frame)
-    Q_UNUSED(sec)
-    Q_UNUSED(usec)
     auto output = reinterpret_cast<DrmOutput*>(data);
     output->pageFlipped();
     output->m_backend->m_pageFlipsPending--;
@@ -237,7 +235,8 @@ void DrmBackend::pageFlipHandler(int fd, unsigned int frame, unsigned int sec, u
         }
 
         if (Compositor::self()) {
-            Compositor::self()->bufferSwapComplete();
+            // the timestamps of the page flip events are in CLOCK_MONOTONIC
+            Compositor::self()->bufferSwapComplete(std::chrono::seconds(sec) + std::chrono::microseconds(usec));
         }
     }
 }
@@ -159,7 +159,8 @@ void FramebufferBackend::map()
         // not valid
         return;
     }
-    void *mem = mmap(nullptr, m_bufferLength, PROT_WRITE, MAP_SHARED, m_fd, 0);
+    // the scene may render right into the framebuffer, which reads it for blending
+    void *mem = mmap(nullptr, m_bufferLength, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
     if (mem == MAP_FAILED) {
         qCWarning(KWIN_FB) << "Failed to mmap frame buffer";
         return;
@@ -0,0 +1,267 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2019 KWin-lowlatency developers
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "fb_blit.h"
+
+#include <QRegion>
+
+#include <cstring>
+
+// the vector paths assume the byte order of the pixels in a quint32 to be B, G, R, X
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+#  if defined(__AVX2__)
+#    define HAVE_AVX2
+#  endif
+#  if defined(__SSE2__)
+#    define HAVE_SSE2
+#  endif
+#  if defined(__SSSE3__)
+#    define HAVE_SSSE3
+#  endif
+#  if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#    define HAVE_NEON
+#  endif
+#endif
+
+#ifdef HAVE_SSE2
+#  include <emmintrin.h>
+#endif
+#ifdef HAVE_SSSE3
+#  include <tmmintrin.h>
+#endif
+#ifdef HAVE_AVX2
+#  include <immintrin.h>
+#endif
+#ifdef HAVE_NEON
+#  include <arm_neon.h>
+#endif
+
+namespace KWin
+{
+
+typedef void (*ConvertRow)(const quint32 *src, uchar *dst, int width);
+
+static void copyRow(const quint32 *src, uchar *dst, int width)
+{
+    std::memcpy(dst, src, width * 4);
+}
+
+// XRGB to the bytes R, G, B, 0xff
+static void swapRedBlueRow(const quint32 *src, uchar *dst, int width)
+{
+    int i = 0;
+#ifdef HAVE_AVX2
+    {
+        const __m256i green = _mm256_set1_epi32(0x0000ff00);
+        const __m256i alpha = _mm256_set1_epi32(0xff000000);
+        const __m256i low = _mm256_set1_epi32(0x000000ff);
+        const __m256i third = _mm256_set1_epi32(0x00ff0000);
+        for (; i + 8 <= width; i += 8) {
+            const __m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+            __m256i out = _mm256_or_si256(_mm256_and_si256(p, green), alpha);
+            out = _mm256_or_si256(out, _mm256_and_si256(_mm256_srli_epi32(p, 16), low));
+            out = _mm256_or_si256(out, _mm256_and_si256(_mm256_slli_epi32(p, 16), third));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4), out);
+        }
+    }
+#endif
+#ifdef HAVE_SSE2
+    {
+        const __m128i green = _mm_set1_epi32(0x0000ff00);
+        const __m128i alpha = _mm_set1_epi32(0xff000000);
+        const __m128i low = _mm_set1_epi32(0x000000ff);
+        const __m128i third = _mm_set1_epi32(0x00ff0000);
+        for (; i + 4 <= width; i += 4) {
+            const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            __m128i out = _mm_or_si128(_mm_and_si128(p, green), alpha);
+            out = _mm_or_si128(out, _mm_and_si128(_mm_srli_epi32(p, 16), low));
+            out = _mm_or_si128(out, _mm_and_si128(_mm_slli_epi32(p, 16), third));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), out);
+        }
+    }
+#endif
+#ifdef HAVE_NEON
+    for (; i + 16 <= width; i += 16) {
+        const uint8x16x4_t p = vld4q_u8(reinterpret_cast<const uint8_t*>(src + i));
+        uint8x16x4_t out;
+        out.val[0] = p.val[2];
+        out.val[1] = p.val[1];
+        out.val[2] = p.val[0];
+        out.val[3] = vdupq_n_u8(0xff);
+        vst4q_u8(dst + i * 4, out);
+    }
+#endif
+    for (; i < width; ++i) {
+        const quint32 p = src[i];
+        uchar *d = dst + i * 4;
+        d[0] = (p >> 16) & 0xff;
+        d[1] = (p >> 8) & 0xff;
+        d[2] = p & 0xff;
+        d[3] = 0xff;
+    }
+}
+
+// XRGB to the bytes B, G, R
+static void bgrRow(const quint32 *src, uchar *dst, int width)
+{
+    int i = 0;
+#ifdef HAVE_SSSE3
+    {
+        const __m128i shuffle = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+        // each store writes four bytes too many, they belong to the next two pixels
+        for (; i + 6 <= width; i += 4) {
+            const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 3), _mm_shuffle_epi8(p, shuffle));
+        }
+    }
+#endif
+#ifdef HAVE_NEON
+    for (; i + 16 <= width; i += 16) {
+        const uint8x16x4_t p = vld4q_u8(reinterpret_cast<const uint8_t*>(src + i));
+        uint8x16x3_t out;
+        out.val[0] = p.val[0];
+        out.val[1] = p.val[1];
+        out.val[2] = p.val[2];
+        vst3q_u8(dst + i * 3, out);
+    }
+#endif
+    for (; i < width; ++i) {
+        const quint32 p = src[i];
+        uchar *d = dst + i * 3;
+        d[0] = p & 0xff;
+        d[1] = (p >> 8) & 0xff;
+        d[2] = (p >> 16) & 0xff;
+    }
+}
+
+// XRGB to the bytes R, G, B
+static void rgbRow(const quint32 *src, uchar *dst, int width)
+{
+    int i = 0;
+#ifdef HAVE_SSSE3
+    {
+        const __m128i shuffle = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+        for (; i + 6 <= width; i += 4) {
+            const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 3), _mm_shuffle_epi8(p, shuffle));
+        }
+    }
+#endif
+#ifdef HAVE_NEON
+    for (; i + 16 <= width; i += 16) {
+        const uint8x16x4_t p = vld4q_u8(reinterpret_cast<const uint8_t*>(src + i));
+        uint8x16x3_t out;
+        out.val[0] = p.val[2];
+        out.val[1] = p.val[1];
+        out.val[2] = p.val[0];
+        vst3q_u8(dst + i * 3, out);
+    }
+#endif
+    for (; i < width; ++i) {
+        const quint32 p = src[i];
+        uchar *d = dst + i * 3;
+        d[0] = (p >> 16) & 0xff;
+        d[1] = (p >> 8) & 0xff;
+        d[2] = p & 0xff;
+    }
+}
+
+#ifdef HAVE_SSE2
+static inline __m128i toRgb16(__m128i p)
+{
+    const __m128i r = _mm_and_si128(_mm_srli_epi32(p, 8), _mm_set1_epi32(0xf800));
+    const __m128i g = _mm_and_si128(_mm_srli_epi32(p, 5), _mm_set1_epi32(0x07e0));
+    const __m128i b = _mm_and_si128(_mm_srli_epi32(p, 3), _mm_set1_epi32(0x001f));
+    // move into the signed range, so that packing does not saturate
+    return _mm_sub_epi32(_mm_or_si128(_mm_or_si128(r, g), b), _mm_set1_epi32(0x8000));
+}
+#endif
+
+// XRGB to RGB565, truncating like QImage does
+static void rgb16Row(const quint32 *src, uchar *dst, int width)
+{
+    quint16 *d = reinterpret_cast<quint16*>(dst);
+    int i = 0;
+#ifdef HAVE_SSE2
+    for (; i + 8 <= width; i += 8) {
+        const __m128i low = toRgb16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+        const __m128i high = toRgb16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 4)));
+        const __m128i packed = _mm_xor_si128(_mm_packs_epi32(low, high), _mm_set1_epi16(short(0x8000)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(d + i), packed);
+    }
+#endif
+#ifdef HAVE_NEON
+    for (; i + 8 <= width; i += 8) {
+        const uint8x8x4_t p = vld4_u8(reinterpret_cast<const uint8_t*>(src + i));
+        uint16x8_t out = vshll_n_u8(p.val[2], 8);
+        out = vsriq_n_u16(out, vshll_n_u8(p.val[1], 8), 5);
+        out = vsriq_n_u16(out, vshll_n_u8(p.val[0], 8), 11);
+        vst1q_u16(d + i, out);
+    }
+#endif
+    for (; i < width; ++i) {
+        const quint32 p = src[i];
+        d[i] = ((p >> 8) & 0xf800) | ((p >> 5) & 0x07e0) | ((p >> 3) & 0x001f);
+    }
+}
+
+bool blitToFramebuffer(const QImage &source, const QRegion &region,
+                       uchar *target, int bytesPerLine, QImage::Format format, bool bgr)
+{
+    Q_ASSERT(source.format() == QImage::Format_RGB32);
+    ConvertRow convertRow = nullptr;
+    int bytesPerPixel = 4;
+    switch (format) {
+    case QImage::Format_RGB32:
+        convertRow = bgr ? swapRedBlueRow : copyRow;
+        break;
+    case QImage::Format_RGBA8888:
+        convertRow = bgr ? copyRow : swapRedBlueRow;
+        break;
+    case QImage::Format_RGB888:
+        convertRow = bgr ? bgrRow : rgbRow;
+        bytesPerPixel = 3;
+        break;
+    case QImage::Format_RGB16:
+        if (bgr) {
+            return false;
+        }
+        convertRow = rgb16Row;
+        bytesPerPixel = 2;
+        break;
+    default:
+        return false;
+    }
+
+    const QRect bounds = source.rect();
+    for (const QRect &r : region) {
+        const QRect rect = r.intersected(bounds);
+        if (rect.isEmpty()) {
+            continue;
+        }
+        for (int y = rect.top(); y <= rect.bottom(); ++y) {
+            const quint32 *src = reinterpret_cast<const quint32*>(source.constScanLine(y)) + rect.x();
+            uchar *dst = target + y * bytesPerLine + rect.x() * bytesPerPixel;
+            convertRow(src, dst, rect.width());
+        }
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,45 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2019 KWin-lowlatency developers
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#ifndef KWIN_FB_BLIT_H
+#define KWIN_FB_BLIT_H
+
+#include <QImage>
+
+class QRegion;
+
+namespace KWin
+{
+
+/**
+ * Converts the pixels of the rectangles in @p region from @p source, which has to be in
+ * QImage::Format_RGB32, into the framebuffer memory at @p target. The framebuffer stores
+ * @p format, in BGR order if @p bgr is set, with @p bytesPerLine bytes per row.
+ *
+ * The conversion works row by row in place, nothing is allocated. Pixels outside of
+ * @p region are not touched.
+ *
+ * @returns @c false if the framebuffer format is not supported
+ **/
+bool blitToFramebuffer(const QImage &source, const QRegion &region,
+                       uchar *target, int bytesPerLine, QImage::Format format, bool bgr);
+
+}
+
+#endif
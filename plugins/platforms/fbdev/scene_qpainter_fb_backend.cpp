@@ -19,11 +19,13 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 *********************************************************************/
 #include "scene_qpainter_fb_backend.h"
 #include "fb_backend.h"
+#include "fb_blit.h"
 #include "composite.h"
+#include "logging.h"
 #include "logind.h"
 #include "cursor.h"
 #include "virtual_terminal.h"
-// Qt
+
 #include <QPainter>
 
 namespace KWin
@@ -31,11 +33,8 @@ namespace KWin
 FramebufferQPainterBackend::FramebufferQPainterBackend(FramebufferBackend *backend)
     : QObject()
     , QPainterBackend()
-    , m_renderBuffer(backend->size(), QImage::Format_RGB32)
     , m_backend(backend)
 {
-    m_renderBuffer.fill(Qt::black);
-
     m_backend->map();
 
     m_backBuffer = QImage((uchar*)backend->mappedMemory(),
@@ -44,6 +43,19 @@ FramebufferQPainterBackend::FramebufferQPainterBackend(FramebufferBackend *backe
                           backend->bytesPerLine(), backend->imageFormat());
 
     m_backBuffer.fill(Qt::black);
+
+    // Opt-in only: blending reads the uncached video memory and on a single buffered
+    // framebuffer every frame is visible while it is painted
+    if (backend->mappedMemory() && backend->imageFormat() == QImage::Format_RGB32 && !backend->isBGR() &&
+            qgetenv("KWIN_FB_RENDER_DIRECT") == QByteArrayLiteral("1")) {
+        // the framebuffer has the format of the scene, so there is nothing to convert
+        m_renderBuffer = QImage((uchar*)backend->mappedMemory(),
+                                backend->size().width(), backend->size().height(),
+                                backend->bytesPerLine(), QImage::Format_RGB32);
+    } else {
+        m_renderBuffer = QImage(backend->size(), QImage::Format_RGB32);
+        m_renderBuffer.fill(Qt::black);
+    }
     connect(VirtualTerminal::self(), &VirtualTerminal::activeChanged, this,
         [this] (bool active) {
             if (active) {
@@ -75,11 +87,24 @@ void FramebufferQPainterBackend::prepareRenderingFrame()
 void FramebufferQPainterBackend::present(int mask, const QRegion &damage)
 {
     Q_UNUSED(mask)
-    Q_UNUSED(damage)
     if (!LogindIntegration::self()->isActiveSession()) {
         return;
     }
+    if (m_renderBuffer.constBits() == m_backBuffer.constBits()) {
+        // the scene rendered into the framebuffer
+        return;
+    }
+    if (m_blitSupported && blitToFramebuffer(m_renderBuffer, damage, m_backBuffer.bits(), m_backBuffer.bytesPerLine(),
+                                             m_backend->imageFormat(), m_backend->isBGR())) {
+        return;
+    }
+    if (m_blitSupported) {
+        qCWarning(KWIN_FB) << "No fast conversion into the framebuffer format" << m_backend->imageFormat()
+                           << "falling back to QPainter";
+        m_blitSupported = false;
+    }
     QPainter p(&m_backBuffer);
+    p.setClipRegion(damage);
     p.drawImage(QPoint(0, 0), m_backend->isBGR() ? m_renderBuffer.rgbSwapped() : m_renderBuffer);
 }
 
@@ -45,6 +45,7 @@ private:
     QImage m_renderBuffer;
     QImage m_backBuffer;
     FramebufferBackend *m_backend;
+    bool m_blitSupported = true;
 };
 
 }
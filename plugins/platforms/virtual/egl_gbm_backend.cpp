@@ -20,6 +20,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "egl_gbm_backend.h"
 // kwin
 #include "composite.h"
+#include "frame_capture.h"
 #include "virtual_backend.h"
 #include "options.h"
 #include "screens.h"
@@ -47,11 +48,7 @@ EglGbmBackend::EglGbmBackend(VirtualBackend *b)
 
 EglGbmBackend::~EglGbmBackend()
 {
-    while (GLRenderTarget::isRenderTargetBound()) {
-        GLRenderTarget::popRenderTarget();
-    }
-    delete m_fbo;
-    delete m_backBuffer;
+    destroyBuffers();
     cleanup();
 }
 
@@ -90,14 +87,15 @@ void EglGbmBackend::init()
 
     initKWinGL();
 
-    m_backBuffer = new GLTexture(GL_RGB8, screens()->size().width(), screens()->size().height());
-    m_fbo = new GLRenderTarget(*m_backBuffer);
-    if (!m_fbo->valid()) {
-        setFailed("Could not create framebuffer object");
-        return;
+    createBuffers();
+    for (GLRenderTarget *fbo : qAsConst(m_fbos)) {
+        if (!fbo->valid()) {
+            setFailed("Could not create framebuffer object");
+            return;
+        }
     }
-    GLRenderTarget::pushRenderTarget(m_fbo);
-    if (!m_fbo->isRenderTargetBound()) {
+    GLRenderTarget::pushRenderTarget(m_fbos[m_bufferIndex]);
+    if (!GLRenderTarget::isRenderTargetBound()) {
         setFailed("Failed to bind framebuffer object");
         return;
     }
@@ -106,10 +104,34 @@ void EglGbmBackend::init()
         return;
     }
 
-    setSupportsBufferAge(false);
     initWayland();
 }
 
+void EglGbmBackend::createBuffers()
+{
+    m_bufferAge = m_backend->emulatedBufferAge();
+    setSupportsBufferAge(m_bufferAge > 0);
+    for (int i = 0; i < qMax(m_bufferAge, 1); ++i) {
+        GLTexture *texture = new GLTexture(GL_RGB8, screens()->size().width(), screens()->size().height());
+        m_backBuffers << texture;
+        m_fbos << new GLRenderTarget(*texture);
+        m_bufferAges << 0;
+    }
+    m_bufferIndex = 0;
+}
+
+void EglGbmBackend::destroyBuffers()
+{
+    while (GLRenderTarget::isRenderTargetBound()) {
+        GLRenderTarget::popRenderTarget();
+    }
+    qDeleteAll(m_fbos);
+    qDeleteAll(m_backBuffers);
+    m_fbos.clear();
+    m_backBuffers.clear();
+    m_bufferAges.clear();
+}
+
 bool EglGbmBackend::initRenderingContext()
 {
     initBufferConfigs();
@@ -156,6 +178,7 @@ bool EglGbmBackend::initBufferConfigs()
 
 void EglGbmBackend::present()
 {
+    m_backend->present();
 }
 
 void EglGbmBackend::screenGeometryChanged(const QSize &size)
@@ -172,55 +195,43 @@ SceneOpenGLTexturePrivate *EglGbmBackend::createBackendTexture(SceneOpenGLTextur
 QRegion EglGbmBackend::prepareRenderingFrame()
 {
     startRenderTimer();
-    if (!GLRenderTarget::isRenderTargetBound()) {
-        GLRenderTarget::pushRenderTarget(m_fbo);
+    if (m_bufferAge != m_backend->emulatedBufferAge()) {
+        destroyBuffers();
+        createBuffers();
+        GLRenderTarget::pushRenderTarget(m_fbos[m_bufferIndex]);
+    } else if (!GLRenderTarget::isRenderTargetBound()) {
+        // the next emulated swap buffer becomes the back buffer
+        m_bufferIndex = (m_bufferIndex + 1) % m_fbos.count();
+        GLRenderTarget::pushRenderTarget(m_fbos[m_bufferIndex]);
     }
-    return QRegion(0, 0, screens()->size().width(), screens()->size().height());
-}
-
-static void convertFromGLImage(QImage &img, int w, int h)
-{
-    // from QtOpenGL/qgl.cpp
-    // Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
-    // see http://qt.gitorious.org/qt/qt/blobs/master/src/opengl/qgl.cpp
-    if (QSysInfo::ByteOrder == QSysInfo::BigEndian) {
-        // OpenGL gives RGBA; Qt wants ARGB
-        uint *p = (uint*)img.bits();
-        uint *end = p + w * h;
-        while (p < end) {
-            uint a = *p << 24;
-            *p = (*p >> 8) | a;
-            p++;
-        }
-    } else {
-        // OpenGL gives ABGR (i.e. RGBA backwards); Qt wants ARGB
-        for (int y = 0; y < h; y++) {
-            uint *q = (uint*)img.scanLine(y);
-            for (int x = 0; x < w; ++x) {
-                const uint pixel = *q;
-                *q = ((pixel << 16) & 0xff0000) | ((pixel >> 16) & 0xff)
-                     | (pixel & 0xff00ff00);
-
-                q++;
-            }
-        }
-
+    if (!supportsBufferAge()) {
+        return QRegion(0, 0, screens()->size().width(), screens()->size().height());
     }
-    img = img.mirrored();
+    return accumulatedDamageHistory(m_bufferAges[m_bufferIndex]);
 }
 
 void EglGbmBackend::endRenderingFrame(const QRegion &renderedRegion, const QRegion &damagedRegion)
 {
     Q_UNUSED(renderedRegion)
-    Q_UNUSED(damagedRegion)
     glFlush();
-    if (m_backend->saveFrames()) {
-        QImage img = QImage(QSize(m_backBuffer->width(), m_backBuffer->height()), QImage::Format_ARGB32);
-        glReadnPixels(0, 0, m_backBuffer->width(), m_backBuffer->height(), GL_RGBA, GL_UNSIGNED_BYTE, img.byteCount(), (GLvoid*)img.bits());
-        convertFromGLImage(img, m_backBuffer->width(), m_backBuffer->height());
-        img.save(QStringLiteral("%1/%2.png").arg(m_backend->saveFrames()).arg(QString::number(m_frameCounter++)));
+    if (FrameCapture *capture = m_backend->frameCapture()) {
+        // GL_RGBA has the byte order of QImage::Format_RGBA8888, the capture thread flips the rows
+        const GLTexture *backBuffer = m_backBuffers[m_bufferIndex];
+        QImage img(backBuffer->size(), QImage::Format_RGBA8888);
+        glReadnPixels(0, 0, backBuffer->width(), backBuffer->height(), GL_RGBA, GL_UNSIGNED_BYTE, img.sizeInBytes(), (GLvoid*)img.bits());
+        capture->capture(0, img, damagedRegion, true);
     }
     GLRenderTarget::popRenderTarget();
+    if (supportsBufferAge()) {
+        for (int &age : m_bufferAges) {
+            if (age > 0) {
+                age++;
+            }
+        }
+        m_bufferAges[m_bufferIndex] = 1;
+        addToDamageHistory(damagedRegion);
+    }
+    present();
 }
 
 bool EglGbmBackend::usesOverlayWindow() const
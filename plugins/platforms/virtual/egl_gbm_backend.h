@@ -21,6 +21,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define KWIN_EGL_GBM_BACKEND_H
 #include "abstract_egl_backend.h"
 
+#include <QVector>
+
 namespace KWin
 {
 class VirtualBackend;
@@ -49,10 +51,16 @@ private:
     bool initializeEgl();
     bool initBufferConfigs();
     bool initRenderingContext();
+    void createBuffers();
+    void destroyBuffers();
     VirtualBackend *m_backend;
-    GLTexture *m_backBuffer = nullptr;
-    GLRenderTarget *m_fbo = nullptr;
-    int m_frameCounter = 0;
+    // the emulated swap buffers, the current back buffer is at m_bufferIndex
+    QVector<GLTexture*> m_backBuffers;
+    QVector<GLRenderTarget*> m_fbos;
+    // per buffer: 0 if undefined, 1 if it holds the last presented frame, 2 the one before
+    QVector<int> m_bufferAges;
+    int m_bufferIndex = 0;
+    int m_bufferAge = 0;
     friend class EglGbmTexture;
 };
 
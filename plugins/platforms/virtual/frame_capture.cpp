@@ -0,0 +1,257 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2019 KWin-lowlatency developers
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "frame_capture.h"
+#include <logging.h>
+// Qt
+#include <QFile>
+#include <QHash>
+#include <QThread>
+// std
+#include <chrono>
+
+namespace KWin
+{
+
+struct CapturedFrame
+{
+    int screen = 0;
+    quint64 sequence = 0;
+    qint64 timestamp = 0;
+    quint32 droppedFrames = 0;
+    bool bottomUp = false;
+    qint64 bytes = 0;
+    // the whole frame, unless only the damage is encoded
+    QImage image;
+    QSize size;
+    QImage::Format format = QImage::Format_Invalid;
+    QVector<QRect> damage;
+    // the pixels of each damage rectangle for delta encoding
+    QVector<QImage> damagedPixels;
+};
+
+/**
+ * Encodes the frames on the capture thread.
+ **/
+class FrameCaptureWriter : public QObject
+{
+public:
+    FrameCaptureWriter(const QString &directory, FrameCapture::Encoding encoding, QAtomicInteger<qint64> *queuedBytes)
+        : m_directory(directory)
+        , m_encoding(encoding)
+        , m_queuedBytes(queuedBytes)
+    {
+    }
+    ~FrameCaptureWriter() override {
+        qDeleteAll(m_streams);
+    }
+
+    void write(const CapturedFrame &frame);
+
+private:
+    QFile *stream(int screen);
+    void writeStream(const CapturedFrame &frame);
+
+    QString m_directory;
+    FrameCapture::Encoding m_encoding;
+    QAtomicInteger<qint64> *m_queuedBytes;
+    QHash<int, QFile*> m_streams;
+};
+
+static const int s_streamAlignment = 16;
+
+QFile *FrameCaptureWriter::stream(int screen)
+{
+    auto it = m_streams.constFind(screen);
+    if (it != m_streams.constEnd()) {
+        return it.value();
+    }
+    QFile *file = new QFile(QStringLiteral("%1/screen%2.kwinframes").arg(m_directory, QString::number(screen)));
+    if (!file->open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qCWarning(KWIN_VIRTUAL) << "Failed to open frame stream" << file->fileName();
+    } else {
+        // padded, so that the first frame header is aligned as well
+        static const char fileHeader[s_streamAlignment] = "KWINFRM1";
+        file->write(fileHeader, sizeof(fileHeader));
+    }
+    m_streams.insert(screen, file);
+    return file;
+}
+
+void FrameCaptureWriter::write(const CapturedFrame &frame)
+{
+    if (m_encoding == FrameCapture::Encoding::Png) {
+        const QImage image = frame.bottomUp ? frame.image.mirrored() : frame.image;
+        image.save(QStringLiteral("%1/screen%2-%3.png").arg(m_directory, QString::number(frame.screen), QString::number(frame.sequence)));
+    } else {
+        writeStream(frame);
+    }
+    m_queuedBytes->fetchAndAddOrdered(-frame.bytes);
+}
+
+void FrameCaptureWriter::writeStream(const CapturedFrame &frame)
+{
+    QFile *file = stream(frame.screen);
+    if (!file->isOpen()) {
+        return;
+    }
+    const bool delta = m_encoding == FrameCapture::Encoding::Delta;
+    const int bytesPerPixel = QImage::toPixelFormat(frame.format).bitsPerPixel() / 8;
+
+    FrameCapture::StreamFrameHeader header;
+    header.magic = 0x454d5246; // 'FRME' in little endian
+    header.flags = delta ? 1 : 0;
+    header.sequence = frame.sequence;
+    header.timestamp = frame.timestamp;
+    header.width = frame.size.width();
+    header.height = frame.size.height();
+    header.stride = delta ? 0 : frame.image.bytesPerLine();
+    header.format = frame.format;
+    header.damageRectCount = frame.damage.count();
+    header.droppedFrames = frame.droppedFrames;
+    header.pixelsSize = 0;
+    if (delta) {
+        for (const QRect &rect : frame.damage) {
+            header.pixelsSize += quint64(rect.width()) * rect.height() * bytesPerPixel;
+        }
+    } else {
+        header.pixelsSize = quint64(header.stride) * header.height;
+    }
+    file->write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    for (const QRect &rect : frame.damage) {
+        const qint32 r[4] = { rect.x(), rect.y(), rect.width(), rect.height() };
+        file->write(reinterpret_cast<const char*>(r), sizeof(r));
+    }
+
+    // write the rows top to bottom, whatever order OpenGL gave them in
+    auto writeRows = [file, &frame] (const QImage &image, int rowBytes) {
+        for (int y = 0; y < image.height(); ++y) {
+            const int row = frame.bottomUp ? image.height() - 1 - y : y;
+            file->write(reinterpret_cast<const char*>(image.constScanLine(row)), rowBytes);
+        }
+    };
+    if (delta) {
+        for (const QImage &pixels : frame.damagedPixels) {
+            writeRows(pixels, pixels.width() * bytesPerPixel);
+        }
+    } else {
+        writeRows(frame.image, frame.image.bytesPerLine());
+    }
+
+    const qint64 padding = (s_streamAlignment - file->pos() % s_streamAlignment) % s_streamAlignment;
+    if (padding) {
+        static const char zeros[s_streamAlignment] = {};
+        file->write(zeros, padding);
+    }
+}
+
+static FrameCapture::Encoding encodingFromEnvironment()
+{
+    const QByteArray encoding = qgetenv("KWIN_WAYLAND_VIRTUAL_CAPTURE_FORMAT").toLower();
+    if (encoding == QByteArrayLiteral("delta")) {
+        return FrameCapture::Encoding::Delta;
+    }
+    if (encoding == QByteArrayLiteral("png")) {
+        return FrameCapture::Encoding::Png;
+    }
+    return FrameCapture::Encoding::Raw;
+}
+
+FrameCapture::FrameCapture(const QString &directory)
+    : m_encoding(encodingFromEnvironment())
+    , m_queuedBytes(0)
+    , m_thread(new QThread)
+{
+    bool ok = false;
+    const int queueSize = qEnvironmentVariableIntValue("KWIN_WAYLAND_VIRTUAL_CAPTURE_QUEUE", &ok);
+    m_maximumQueuedBytes = qint64(ok && queueSize > 0 ? queueSize : 256) * 1024 * 1024;
+
+    m_writer = new FrameCaptureWriter(directory, m_encoding, &m_queuedBytes);
+    m_thread->setObjectName(QStringLiteral("KWin frame capture"));
+    m_writer->moveToThread(m_thread);
+    m_thread->start(QThread::LowPriority);
+}
+
+FrameCapture::~FrameCapture()
+{
+    // the writer finishes the frames queued before it gets to this
+    QThread *thread = m_thread;
+    QMetaObject::invokeMethod(m_writer, [thread] { thread->quit(); }, Qt::QueuedConnection);
+    m_thread->wait();
+    delete m_writer;
+    delete m_thread;
+    if (m_droppedFrames) {
+        qCWarning(KWIN_VIRTUAL) << "Frame capture dropped" << m_droppedFrames << "frames";
+    }
+}
+
+bool FrameCapture::capture(int screen, const QImage &image, const QRegion &damage, bool bottomUp)
+{
+    if (m_sequences.size() <= screen) {
+        m_sequences.resize(screen + 1);
+        m_droppedSinceLastFrame.resize(screen + 1);
+    }
+    CapturedFrame frame;
+    frame.screen = screen;
+    frame.sequence = m_sequences[screen]++;
+    frame.timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    frame.bottomUp = bottomUp;
+    frame.size = image.size();
+    frame.format = image.format();
+    const QRegion clipped = damage & image.rect();
+    frame.damage = QVector<QRect>(clipped.begin(), clipped.end());
+
+    const int bytesPerPixel = image.depth() / 8;
+    if (m_encoding == Encoding::Delta) {
+        for (const QRect &rect : qAsConst(frame.damage)) {
+            frame.bytes += qint64(rect.width()) * rect.height() * bytesPerPixel;
+        }
+    } else {
+        frame.bytes = image.sizeInBytes();
+    }
+    const qint64 queuedBytes = m_queuedBytes.load();
+    if (queuedBytes > 0 && queuedBytes + frame.bytes > m_maximumQueuedBytes) {
+        // the writer does not keep up, rather lose the frame than stall the compositor
+        m_droppedFrames++;
+        m_droppedSinceLastFrame[screen]++;
+        return false;
+    }
+    frame.droppedFrames = m_droppedSinceLastFrame[screen];
+    m_droppedSinceLastFrame[screen] = 0;
+
+    if (m_encoding == Encoding::Delta) {
+        // copy now, the image is painted on again with the next frame
+        frame.damagedPixels.reserve(frame.damage.count());
+        for (const QRect &rect : qAsConst(frame.damage)) {
+            const QRect source = bottomUp ? QRect(rect.x(), image.height() - rect.y() - rect.height(), rect.width(), rect.height()) : rect;
+            frame.damagedPixels << image.copy(source);
+        }
+    } else {
+        // shared, the compositor detaches from it when it paints the next frame
+        frame.image = image;
+    }
+
+    m_queuedBytes.fetchAndAddOrdered(frame.bytes);
+    FrameCaptureWriter *writer = m_writer;
+    QMetaObject::invokeMethod(m_writer, [writer, frame] { writer->write(frame); }, Qt::QueuedConnection);
+    return true;
+}
+
+}
@@ -0,0 +1,119 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2019 KWin-lowlatency developers
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#ifndef KWIN_VIRTUAL_FRAME_CAPTURE_H
+#define KWIN_VIRTUAL_FRAME_CAPTURE_H
+
+#include <QAtomicInteger>
+#include <QImage>
+#include <QObject>
+#include <QRegion>
+#include <QVector>
+
+class QThread;
+
+namespace KWin
+{
+class FrameCaptureWriter;
+
+/**
+ * @brief Records the frames of the virtual platform without slowing down the compositor.
+ *
+ * Frames are handed to a writer thread, the compositor only keeps a reference to the
+ * frame, or copies the damaged parts of it. If the frames queued for writing exceed the
+ * memory limit, new frames are dropped and counted instead. A frame is never dropped
+ * while the queue is empty.
+ *
+ * The encodings are:
+ * @li Raw: every frame in full, appended to one stream file per screen
+ * @li Delta: like Raw, but only the pixels of the damaged rectangles
+ * @li Png: one PNG file per screen and frame
+ *
+ * A stream file starts with the eight bytes "KWINFRM1" and eight zero bytes. Each frame
+ * follows as a StreamFrameHeader in native byte order, the damage rectangles as four
+ * qint32 each (x, y, width, height) and the pixels. In Raw streams these are height rows
+ * of stride bytes, in Delta streams the rows of each damage rectangle in turn. The frames
+ * are padded with zeros, so that every header starts at a multiple of 16 bytes and a
+ * stream can be mmap()ed and walked in place.
+ **/
+class FrameCapture
+{
+public:
+    enum class Encoding {
+        Raw,
+        Delta,
+        Png
+    };
+
+    /**
+     * The header of a frame in a stream file.
+     **/
+    struct StreamFrameHeader {
+        quint32 magic; // 'FRME'
+        quint32 flags; // 1 if the pixels are only the damaged ones
+        quint64 sequence;
+        qint64 timestamp; // nanoseconds of CLOCK_MONOTONIC at capture
+        quint32 width;
+        quint32 height;
+        quint32 stride;
+        quint32 format; // QImage::Format
+        quint32 damageRectCount;
+        quint32 droppedFrames; // dropped since the previous frame of the stream
+        quint64 pixelsSize;
+    };
+
+    /**
+     * Uses the encoding from the environment variable KWIN_WAYLAND_VIRTUAL_CAPTURE_FORMAT
+     * (raw, delta or png) and queues up to KWIN_WAYLAND_VIRTUAL_CAPTURE_QUEUE MiB.
+     **/
+    explicit FrameCapture(const QString &directory);
+    /**
+     * Writes all queued frames.
+     **/
+    ~FrameCapture();
+
+    /**
+     * Queues @p image of @p screen for writing. @p damage is in the coordinates of the
+     * image. If @p bottomUp is set, the rows of @p image are in OpenGL order.
+     *
+     * @returns @c false if the frame was dropped
+     **/
+    bool capture(int screen, const QImage &image, const QRegion &damage, bool bottomUp = false);
+
+    Encoding encoding() const {
+        return m_encoding;
+    }
+    quint64 droppedFrames() const {
+        return m_droppedFrames;
+    }
+
+private:
+    Encoding m_encoding = Encoding::Raw;
+    qint64 m_maximumQueuedBytes;
+    QAtomicInteger<qint64> m_queuedBytes;
+    quint64 m_droppedFrames = 0;
+    QVector<quint64> m_sequences;
+    QVector<quint32> m_droppedSinceLastFrame;
+    QThread *m_thread;
+    FrameCaptureWriter *m_writer;
+};
+
+}
+
+#endif
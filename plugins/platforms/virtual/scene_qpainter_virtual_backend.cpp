@@ -19,10 +19,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 *********************************************************************/
 #include "scene_qpainter_virtual_backend.h"
 #include "virtual_backend.h"
+#include "frame_capture.h"
 #include "cursor.h"
 #include "screens.h"
 
 #include <QPainter>
+#include <QTransform>
 
 namespace KWin
 {
@@ -38,42 +40,84 @@ VirtualQPainterBackend::~VirtualQPainterBackend() = default;
 
 QImage *VirtualQPainterBackend::buffer()
 {
-    return &m_backBuffers[0];
+    return bufferForScreen(0);
 }
 
 QImage *VirtualQPainterBackend::bufferForScreen(int screen)
 {
-    return &m_backBuffers[screen];
+    Output &o = m_outputs[screen];
+    return &o.buffers[o.index];
 }
 
 bool VirtualQPainterBackend::needsFullRepaint() const
 {
-    return true;
+    return m_bufferAge == 0;
 }
 
 void VirtualQPainterBackend::prepareRenderingFrame()
 {
+    if (m_bufferAge != m_backend->emulatedBufferAge()) {
+        createOutputs();
+        return;
+    }
+    for (auto it = m_outputs.begin(); it != m_outputs.end(); ++it) {
+        it->index = (it->index + 1) % it->buffers.count();
+    }
+}
+
+QRegion VirtualQPainterBackend::prepareRenderingForScreen(int screenId)
+{
+    const Output &o = m_outputs.at(screenId);
+    const int age = o.ages.at(o.index);
+    if (age == 0 || age - 1 > o.damageHistory.count()) {
+        return screens()->geometry(screenId);
+    }
+    QRegion repaint;
+    for (int i = 0; i < age - 1; ++i) {
+        repaint |= o.damageHistory.at(i);
+    }
+    return repaint;
 }
 
 void VirtualQPainterBackend::createOutputs()
 {
-    m_backBuffers.clear();
+    m_bufferAge = m_backend->emulatedBufferAge();
+    m_outputs.clear();
     for (int i = 0; i < screens()->count(); ++i) {
-        QImage buffer(screens()->size(i) * screens()->scale(i), QImage::Format_RGB32);
-        buffer.fill(Qt::black);
-        m_backBuffers << buffer;
+        Output o;
+        for (int j = 0; j < qMax(m_bufferAge, 1); ++j) {
+            QImage buffer(screens()->size(i) * screens()->scale(i), QImage::Format_RGB32);
+            buffer.fill(Qt::black);
+            o.buffers << buffer;
+            o.ages << 0;
+        }
+        m_outputs << o;
     }
 }
 
 void VirtualQPainterBackend::present(int mask, const QRegion &damage)
 {
     Q_UNUSED(mask)
-    Q_UNUSED(damage)
-    if (m_backend->saveFrames()) {
-        for (int i=0; i < m_backBuffers.size() ; i++) {
-            m_backBuffers[i].save(QStringLiteral("%1/screen%2-%3.png").arg(m_backend->screenshotDirPath(), QString::number(i), QString::number(m_frameCounter++)));
+    for (int i = 0; i < m_outputs.size(); i++) {
+        Output &o = m_outputs[i];
+        const QRect geometry = screens()->geometry(i);
+        const QRegion screenDamage = damage & geometry;
+        if (m_bufferAge > 0) {
+            for (int &age : o.ages) {
+                if (age > 0) {
+                    age++;
+                }
+            }
+            o.ages[o.index] = 1;
+            o.damageHistory.prepend(screenDamage);
+            o.damageHistory.resize(qMin(o.damageHistory.count(), m_bufferAge - 1));
+        }
+        if (FrameCapture *capture = m_backend->frameCapture()) {
+            const qreal scale = screens()->scale(i);
+            capture->capture(i, o.buffers[o.index], QTransform::fromScale(scale, scale).map(screenDamage.translated(-geometry.topLeft())));
         }
     }
+    m_backend->present();
 }
 
 bool VirtualQPainterBackend::usesOverlayWindow() const
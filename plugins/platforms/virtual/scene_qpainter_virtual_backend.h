@@ -23,6 +23,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <platformsupport/scenes/qpainter/backend.h>
 
 #include <QObject>
+#include <QImage>
+#include <QRegion>
 #include <QVector>
 
 namespace KWin
@@ -44,13 +46,23 @@ public:
     void prepareRenderingFrame() override;
     void present(int mask, const QRegion &damage) override;
     bool perScreenRendering() const override;
+    QRegion prepareRenderingForScreen(int screenId) override;
 
 private:
     void createOutputs();
 
-    QVector<QImage> m_backBuffers;
+    struct Output {
+        // the emulated swap buffers, the current back buffer is at index
+        QVector<QImage> buffers;
+        // per buffer: 0 if undefined, 1 if it holds the last presented frame, 2 the one before
+        QVector<int> ages;
+        int index = 0;
+        // the damage of the last presented frames, most recent first
+        QVector<QRegion> damageHistory;
+    };
+    QVector<Output> m_outputs;
+    int m_bufferAge = 0;
     VirtualBackend *m_backend;
-    int m_frameCounter = 0;
 };
 
 }
@@ -19,6 +19,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 *********************************************************************/
 #include "virtual_backend.h"
 #include "virtual_output.h"
+#include "composite.h"
+#include "frame_capture.h"
 #include "scene_qpainter_virtual_backend.h"
 #include "screens_virtual.h"
 #include "wayland_server.h"
@@ -45,8 +47,21 @@ VirtualBackend::VirtualBackend(QObject *parent)
         }
         if (!m_screenshotDir.isNull()) {
             qDebug() << "Screenshots saved to: " << m_screenshotDir->path();
+            m_frameCapture.reset(new FrameCapture(m_screenshotDir->path()));
         }
     }
+    if (qEnvironmentVariableIsSet("KWIN_VIRTUAL_REFRESH_RATE")) {
+        // in Hz, like on the command line of other tools
+        const int rate = qRound(qgetenv("KWIN_VIRTUAL_REFRESH_RATE").toDouble() * 1000);
+        if (rate > 0) {
+            m_refreshRate = rate;
+        }
+    }
+    m_simulatePageFlips = qEnvironmentVariableIsSet("KWIN_VIRTUAL_PAGEFLIP") &&
+                          qgetenv("KWIN_VIRTUAL_PAGEFLIP") != QByteArrayLiteral("0");
+    m_vblankJitter = qEnvironmentVariableIntValue("KWIN_VIRTUAL_VBLANK_JITTER");
+    m_missedFlipInterval = qEnvironmentVariableIntValue("KWIN_VIRTUAL_MISSED_FLIPS");
+    setEmulatedBufferAge(qEnvironmentVariableIntValue("KWIN_VIRTUAL_BUFFER_AGE"));
     setSupportsPointerWarping(true);
     setSupportsGammaControl(true);
 }
@@ -55,6 +70,14 @@ VirtualBackend::~VirtualBackend()
 {
 }
 
+void VirtualBackend::setupOutput(VirtualOutput *output, int refreshRate)
+{
+    output->setRefreshRate(refreshRate);
+    output->setVBlankJitter(m_vblankJitter);
+    output->setMissedFlipInterval(m_missedFlipInterval);
+    connect(output, &VirtualOutput::pageFlipped, this, &VirtualBackend::pageFlipped);
+}
+
 void VirtualBackend::init()
 {
     /*
@@ -66,6 +89,7 @@ void VirtualBackend::init()
     if (!m_outputs.size()) {
         VirtualOutput *dummyOutput = new VirtualOutput(this);
         dummyOutput->setGeometry(QRect(QPoint(0, 0), initialWindowSize()));
+        setupOutput(dummyOutput, m_refreshRate);
         m_outputs << dummyOutput ;
         m_enabledOutputs << dummyOutput ;
     }
@@ -113,12 +137,15 @@ Outputs VirtualBackend::enabledOutputs() const
     return m_enabledOutputs;
 }
 
-void VirtualBackend::setVirtualOutputs(int count, QVector<QRect> geometries, QVector<int> scales)
+void VirtualBackend::setVirtualOutputs(int count, QVector<QRect> geometries, QVector<int> scales, QVector<int> refreshRates)
 {
     Q_ASSERT(geometries.size() == 0 || geometries.size() == count);
     Q_ASSERT(scales.size() == 0 || scales.size() == count);
+    Q_ASSERT(refreshRates.size() == 0 || refreshRates.size() == count);
 
     bool countChanged = m_outputs.size() != count;
+    // the page flips of the old outputs will never complete
+    cancelPageFlips();
     qDeleteAll(m_outputs.begin(), m_outputs.end());
     m_outputs.resize(count);
     m_enabledOutputs.resize(count);
@@ -135,10 +162,69 @@ void VirtualBackend::setVirtualOutputs(int count, QVector<QRect> geometries, QVe
             vo->setGeometry(QRect(QPoint(sumWidth, 0), initialWindowSize()));
             sumWidth += initialWindowSize().width();
         }
+        setupOutput(vo, refreshRates.isEmpty() ? m_refreshRate : refreshRates.at(i));
         m_outputs[i] = m_enabledOutputs[i] = vo;
     }
 
     emit virtualOutputsSet(countChanged);
 }
 
+void VirtualBackend::setPageFlipSimulation(bool enabled, int vblankJitter, int missedFlipInterval)
+{
+    m_simulatePageFlips = enabled;
+    m_vblankJitter = vblankJitter;
+    m_missedFlipInterval = missedFlipInterval;
+    for (VirtualOutput *output : qAsConst(m_outputs)) {
+        output->setVBlankJitter(vblankJitter);
+        output->setMissedFlipInterval(missedFlipInterval);
+    }
+}
+
+void VirtualBackend::setEmulatedBufferAge(int age)
+{
+    m_emulatedBufferAge = qBound(0, age, 3);
+}
+
+void VirtualBackend::present()
+{
+    if (!m_simulatePageFlips || !Compositor::self()) {
+        return;
+    }
+    for (VirtualOutput *output : qAsConst(m_enabledOutputs)) {
+        if (output->present()) {
+            m_pageFlipsPending++;
+            if (m_pageFlipsPending == 1) {
+                m_pageFlipPresentationTime = 0;
+                m_pageFlipCompositor = Compositor::self();
+                m_pageFlipCompositor->aboutToSwapBuffers();
+            }
+        }
+    }
+}
+
+void VirtualBackend::pageFlipped(quint64 sequence, qint64 presentationTime)
+{
+    Q_UNUSED(sequence)
+    if (m_pageFlipsPending == 0) {
+        return;
+    }
+    m_pageFlipsPending--;
+    m_pageFlipPresentationTime = qMax(m_pageFlipPresentationTime, presentationTime);
+    // like the DRM backend, the next frame starts once all outputs flipped
+    if (m_pageFlipsPending == 0 && m_pageFlipCompositor) {
+        m_pageFlipCompositor->bufferSwapComplete(std::chrono::nanoseconds(m_pageFlipPresentationTime));
+    }
+}
+
+void VirtualBackend::cancelPageFlips()
+{
+    if (m_pageFlipsPending == 0) {
+        return;
+    }
+    m_pageFlipsPending = 0;
+    if (m_pageFlipCompositor) {
+        m_pageFlipCompositor->bufferSwapComplete();
+    }
+}
+
 }
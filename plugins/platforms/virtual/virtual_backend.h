@@ -24,12 +24,15 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <kwin_export.h>
 
 #include <QObject>
+#include <QPointer>
 #include <QRect>
 
 class QTemporaryDir;
 
 namespace KWin
 {
+class Compositor;
+class FrameCapture;
 class VirtualOutput;
 
 class KWIN_EXPORT VirtualBackend : public Platform
@@ -47,12 +50,46 @@ public:
         return !m_screenshotDir.isNull();
     }
     QString screenshotDirPath() const;
+    /**
+     * Records the frames to the screenshot directory, @c null unless saveFrames().
+     **/
+    FrameCapture *frameCapture() const {
+        return m_frameCapture.data();
+    }
 
     Screens *createScreens(QObject *parent = nullptr) override;
     QPainterBackend* createQPainterBackend() override;
     OpenGLBackend *createOpenGLBackend() override;
 
-    Q_INVOKABLE void setVirtualOutputs(int count, QVector<QRect> geometries = QVector<QRect>(), QVector<int> scales = QVector<int>());
+    Q_INVOKABLE void setVirtualOutputs(int count, QVector<QRect> geometries = QVector<QRect>(), QVector<int> scales = QVector<int>(), QVector<int> refreshRates = QVector<int>());
+
+    /**
+     * Emulates a display: frames are only shown at the vblanks of the outputs and the
+     * Compositor waits for the page flips like it does on hardware. Page flips can be
+     * delayed by up to @p vblankJitter microseconds, and every @p missedFlipInterval-th
+     * flip can miss its vblank.
+     *
+     * Off by default, or enabled with the environment variable KWIN_VIRTUAL_PAGEFLIP.
+     **/
+    Q_INVOKABLE void setPageFlipSimulation(bool enabled, int vblankJitter = 0, int missedFlipInterval = 0);
+    bool simulatesPageFlips() const {
+        return m_simulatePageFlips;
+    }
+    /**
+     * Emulates @p age swap buffers in the rendering backends, so that a frame is painted
+     * into the buffer which was shown @p age frames ago and only the damage since then is
+     * repainted. An @p age of 0 disables the emulation, then every frame is fully repainted.
+     *
+     * At most 3, and 0 by default, or set with the environment variable KWIN_VIRTUAL_BUFFER_AGE.
+     **/
+    Q_INVOKABLE void setEmulatedBufferAge(int age);
+    int emulatedBufferAge() const {
+        return m_emulatedBufferAge;
+    }
+    /**
+     * Called by the scene backends once a frame is rendered.
+     **/
+    void present();
 
     Outputs outputs() const override;
     Outputs enabledOutputs() const override;
@@ -65,10 +102,26 @@ Q_SIGNALS:
     void virtualOutputsSet(bool countChanged);
 
 private:
+    void setupOutput(VirtualOutput *output, int refreshRate);
+    void pageFlipped(quint64 sequence, qint64 presentationTime);
+    void cancelPageFlips();
+
     QVector<VirtualOutput*> m_outputs;
     QVector<VirtualOutput*> m_enabledOutputs;
 
     QScopedPointer<QTemporaryDir> m_screenshotDir;
+    QScopedPointer<FrameCapture> m_frameCapture;
+
+    bool m_simulatePageFlips = false;
+    int m_refreshRate = 60000;
+    int m_vblankJitter = 0;
+    int m_missedFlipInterval = 0;
+    int m_pageFlipsPending = 0;
+    // the latest presentation time of the outputs which flipped
+    qint64 m_pageFlipPresentationTime = 0;
+    int m_emulatedBufferAge = 0;
+    // the Compositor which waits for the pending page flips
+    QPointer<Compositor> m_pageFlipCompositor;
 };
 
 }
@@ -19,15 +19,27 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 *********************************************************************/
 #include "virtual_output.h"
 
+#include <chrono>
+
 namespace KWin
 {
 
+static qint64 monotonicTime()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 VirtualOutput::VirtualOutput(QObject *parent)
     : AbstractOutput()
+    , m_vblankOrigin(monotonicTime())
 {
     Q_UNUSED(parent);
 
     setScale(1.);
+
+    m_pageFlipTimer.setSingleShot(true);
+    m_pageFlipTimer.setTimerType(Qt::PreciseTimer);
+    connect(&m_pageFlipTimer, &QTimer::timeout, this, &VirtualOutput::pageFlip);
 }
 
 VirtualOutput::~VirtualOutput()
@@ -46,4 +58,73 @@ void VirtualOutput::setGeometry(const QRect &geo)
     setGlobalPos(geo.topLeft());
 }
 
+int VirtualOutput::refreshRate() const
+{
+    return m_refreshRate;
+}
+
+void VirtualOutput::setRefreshRate(int refreshRate)
+{
+    if (refreshRate <= 0 || refreshRate == m_refreshRate) {
+        return;
+    }
+    // continue the sequence from the last vblank at the old rate
+    const qint64 elapsed = (monotonicTime() - m_vblankOrigin) / vblankInterval();
+    m_vblankOrigin += elapsed * vblankInterval();
+    m_originSequence += elapsed;
+    m_refreshRate = refreshRate;
+}
+
+void VirtualOutput::setVBlankJitter(int jitter)
+{
+    m_vblankJitter = qMax(0, jitter);
+}
+
+void VirtualOutput::setMissedFlipInterval(int interval)
+{
+    m_missedFlipInterval = qMax(0, interval);
+}
+
+qint64 VirtualOutput::vblankInterval() const
+{
+    return Q_INT64_C(1000000000000) / m_refreshRate;
+}
+
+quint64 VirtualOutput::sequenceAt(qint64 vblank) const
+{
+    return m_originSequence + (vblank - m_vblankOrigin) / vblankInterval();
+}
+
+bool VirtualOutput::present()
+{
+    if (m_pageFlipPending) {
+        return false;
+    }
+    const qint64 now = monotonicTime();
+    const qint64 interval = vblankInterval();
+    // the frame makes it to the next vblank, even if that is right now
+    qint64 vblank = m_vblankOrigin + ((now - m_vblankOrigin) / interval + 1) * interval;
+    ++m_flipCount;
+    if (m_missedFlipInterval > 0 && m_flipCount % m_missedFlipInterval == 0) {
+        vblank += interval;
+    }
+    qint64 delivery = vblank;
+    if (m_vblankJitter > 0) {
+        delivery += std::uniform_int_distribution<qint64>(0, m_vblankJitter * Q_INT64_C(1000))(m_random);
+    }
+    m_pendingPresentationTime = vblank;
+    m_pageFlipPending = true;
+    // the timer has millisecond precision, never deliver before the vblank
+    m_pageFlipTimer.start(int((delivery - now + 999999) / 1000000));
+    return true;
+}
+
+void VirtualOutput::pageFlip()
+{
+    m_pageFlipPending = false;
+    m_lastPresentationTime = m_pendingPresentationTime;
+    m_vblankSequence = sequenceAt(m_pendingPresentationTime);
+    emit pageFlipped(m_vblankSequence, m_lastPresentationTime);
+}
+
 }
@@ -24,6 +24,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QObject>
 #include <QRect>
+#include <QTimer>
+
+#include <random>
 
 namespace KWin
 {
@@ -41,6 +44,47 @@ public:
 
     void setGeometry(const QRect &geo);
 
+    /**
+     * The refresh rate in mHz, e.g. 60000 for 60 Hz, which is the default.
+     **/
+    int refreshRate() const override;
+    void setRefreshRate(int refreshRate);
+    /**
+     * Delays the delivery of each page flip by a random amount of up to @p jitter
+     * microseconds. The presentation time stays at the vblank, like on real hardware.
+     * The random sequence is seeded with a constant, so runs are reproducible.
+     **/
+    void setVBlankJitter(int jitter);
+    /**
+     * Makes every @p interval-th page flip miss its vblank and complete one refresh
+     * later. @c 0 disables missed flips.
+     **/
+    void setMissedFlipInterval(int interval);
+
+    /**
+     * Queues the frame which was just rendered for the next simulated vblank.
+     * pageFlipped() is emitted once it is on screen.
+     *
+     * @returns @c false if a page flip is still pending
+     **/
+    bool present();
+    bool isPageFlipPending() const {
+        return m_pageFlipPending;
+    }
+    /**
+     * The number of vblanks since the output was created when the last frame was presented.
+     **/
+    quint64 vblankSequence() const {
+        return m_vblankSequence;
+    }
+    /**
+     * The time of the vblank at which the last frame was presented, in nanoseconds of
+     * CLOCK_MONOTONIC.
+     **/
+    qint64 lastPresentationTime() const {
+        return m_lastPresentationTime;
+    }
+
     int getGammaRampSize() const override {
         return m_gammaSize;
     }
@@ -49,12 +93,33 @@ public:
         return m_gammaResult;
     }
 
+Q_SIGNALS:
+    void pageFlipped(quint64 sequence, qint64 presentationTime);
+
 private:
     Q_DISABLE_COPY(VirtualOutput);
     friend class VirtualBackend;
 
+    qint64 vblankInterval() const;
+    quint64 sequenceAt(qint64 vblank) const;
+    void pageFlip();
+
     QSize m_pixelSize;
 
+    int m_refreshRate = 60000;
+    int m_vblankJitter = 0;
+    int m_missedFlipInterval = 0;
+    // a vblank, all others follow at multiples of the refresh interval
+    qint64 m_vblankOrigin;
+    quint64 m_originSequence = 0;
+    bool m_pageFlipPending = false;
+    qint64 m_pendingPresentationTime = 0;
+    quint64 m_flipCount = 0;
+    quint64 m_vblankSequence = 0;
+    qint64 m_lastPresentationTime = 0;
+    QTimer m_pageFlipTimer;
+    std::minstd_rand m_random;
+
     int m_gammaSize = 200;
     bool m_gammaResult = true;
 };
@@ -122,7 +122,12 @@ bool EglWaylandBackend::initRenderingContext()
 
     const QSize &size = m_wayland->shellSurfaceSize();
     auto s = m_wayland->surface();
-    connect(s, &KWayland::Client::Surface::frameRendered, Compositor::self(), &Compositor::bufferSwapComplete);
+    connect(s, &KWayland::Client::Surface::frameRendered, Compositor::self(),
+        [] {
+            // the frame callback has no timestamp, it arrives when the host showed the frame
+            Compositor::self()->bufferSwapComplete(std::chrono::steady_clock::now().time_since_epoch());
+        }
+    );
     m_overlay = wl_egl_window_create(*s, size.width(), size.height());
     if (!m_overlay) {
         qCCritical(KWIN_WAYLAND_BACKEND) << "Creating Wayland Egl window failed";
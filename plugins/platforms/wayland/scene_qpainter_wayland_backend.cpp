@@ -38,8 +38,12 @@ WaylandQPainterBackend::WaylandQPainterBackend(Wayland::WaylandBackend *b)
     connect(b->shmPool(), SIGNAL(poolResized()), SLOT(remapBuffer()));
     connect(b, &Wayland::WaylandBackend::shellSurfaceSizeChanged,
             this, &WaylandQPainterBackend::screenGeometryChanged);
-    connect(b->surface(), &KWayland::Client::Surface::frameRendered,
-            Compositor::self(), &Compositor::bufferSwapComplete);
+    connect(b->surface(), &KWayland::Client::Surface::frameRendered, Compositor::self(),
+        [] {
+            // the frame callback has no timestamp, it arrives when the host showed the frame
+            Compositor::self()->bufferSwapComplete(std::chrono::steady_clock::now().time_since_epoch());
+        }
+    );
 }
 
 WaylandQPainterBackend::~WaylandQPainterBackend()
@@ -92,7 +92,9 @@ bool SwapEventFilter::event(xcb_generic_event_t *event)
     // by a WireToEvent handler, and the GLX drawable when the event was
     // received over the wire
     if (ev->drawable == m_drawable || ev->drawable == m_glxDrawable) {
-        Compositor::self()->bufferSwapComplete();
+        // the UST of Mesa is CLOCK_MONOTONIC in microseconds
+        const quint64 ust = (quint64(ev->ust_hi) << 32) | ev->ust_lo;
+        Compositor::self()->bufferSwapComplete(std::chrono::microseconds(ust));
         return true;
     }
 
@@ -136,6 +138,10 @@ GlxBackend::~GlxBackend()
     }
     // TODO: cleanup in error case
     // do cleanup after initBuffer()
+    for (const QVector<GLuint> &textures : qAsConst(m_texturePool)) {
+        glDeleteTextures(textures.count(), textures.constData());
+    }
+    m_texturePool.clear();
     cleanupGL();
     doneCurrent();
 
@@ -828,6 +834,30 @@ void GlxBackend::doneCurrent()
     glXMakeCurrent(display(), None, nullptr);
 }
 
+GLuint GlxBackend::acquireTexture(GLenum target)
+{
+    // a texture name is bound to the target it got first used with
+    QVector<GLuint> &textures = m_texturePool[target];
+    if (!textures.isEmpty()) {
+        return textures.takeLast();
+    }
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    return texture;
+}
+
+void GlxBackend::releaseTexture(GLenum target, GLuint texture)
+{
+    // enough for a few windows being resized at the same time
+    static const int s_maxPooledTextures = 16;
+    QVector<GLuint> &textures = m_texturePool[target];
+    if (textures.count() < s_maxPooledTextures) {
+        textures.append(texture);
+    } else {
+        glDeleteTextures(1, &texture);
+    }
+}
+
 OverlayWindow* GlxBackend::overlayWindow()
 {
     return m_overlayWindow;
@@ -854,6 +884,11 @@ GlxTexture::~GlxTexture()
     if (m_glxpixmap != None) {
         if (!options->isGlStrictBinding()) {
             glXReleaseTexImageEXT(display(), m_glxpixmap, GLX_FRONT_LEFT_EXT);
+            // the texture does not reference the pixmap anymore and can be used for the next one
+            if (m_texture != 0) {
+                m_backend->releaseTexture(m_target, m_texture);
+                m_texture = 0;
+            }
         }
         glXDestroyPixmap(display(), m_glxpixmap);
         m_glxpixmap = None;
@@ -902,10 +937,15 @@ bool GlxTexture::loadTexture(xcb_pixmap_t pixmap, const QSize &size, xcb_visuali
     m_yInverted     = info->y_inverted ? true : false;
     m_canUseMipmaps = false;
 
-    glGenTextures(1, &m_texture);
+    m_texture = m_backend->acquireTexture(m_target);
 
     q->setDirty();
     q->setFilter(GL_NEAREST);
+    // a reused texture may still have the wrap mode of its previous window pixmap,
+    // rectangle textures do not support the default one
+    if (m_target == GL_TEXTURE_2D) {
+        m_wrapModeChanged = true;
+    }
 
     glBindTexture(m_target, m_texture);
     glXBindTexImageEXT(display(), m_glxpixmap, GLX_FRONT_LEFT_EXT, nullptr);
@@ -98,6 +98,8 @@ private:
 
     int visualDepth(xcb_visualid_t visual) const;
     FBConfigInfo *infoForVisual(xcb_visualid_t visual);
+    GLuint acquireTexture(GLenum target);
+    void releaseTexture(GLenum target, GLuint texture);
 
     /**
      * @brief The OverlayWindow used by this Backend.
@@ -109,6 +111,12 @@ private:
     GLXContext ctx;
     QHash<xcb_visualid_t, FBConfigInfo *> m_fbconfigHash;
     QHash<xcb_visualid_t, int> m_visualDepthHash;
+    /**
+     * Texture names of released window textures per texture target. Window pixmaps get
+     * recreated whenever a window is resized, reusing the texture objects saves the
+     * driver from allocating new ones for every resize step.
+     **/
+    QHash<GLenum, QVector<GLuint>> m_texturePool;
     std::unique_ptr<SwapEventFilter> m_swapEventFilter;
     int m_bufferAge;
     bool m_haveMESACopySubBuffer = false;
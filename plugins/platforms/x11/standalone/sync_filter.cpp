@@ -41,6 +41,15 @@ bool SyncFilter::event(xcb_generic_event_t *event)
     );
     if (client) {
         client->handleSync();
+        return false;
+    }
+    auto frameClient = workspace()->findClient(
+        [e] (const Client *c) {
+            return e->alarm == c->getSyncRequest().extendedAlarm;
+        }
+    );
+    if (frameClient) {
+        frameClient->handleFrameSync(e->counter_value);
     }
     return false;
 }
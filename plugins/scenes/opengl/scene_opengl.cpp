@@ -946,6 +946,7 @@ SceneOpenGL2::SceneOpenGL2(OpenGLBackend *backend, QObject *parent)
         init_ok = false;
         return;
     }
+    ShaderManager::instance()->precompileShaders();
 
     qCDebug(KWIN_OPENGL) << "OpenGL 2 compositing successfully initialized";
     init_ok = true;
@@ -1038,9 +1039,18 @@ void SceneOpenGL2::finalDrawWindow(EffectWindowImpl* w, int mask, QRegion region
     if (waylandServer() && waylandServer()->isScreenLocked() && !w->window()->isLockScreen() && !w->window()->isInputMethod()) {
         return;
     }
+    markDrawn(w);
     performPaintWindow(w, mask, region, data);
 }
 
+QString SceneOpenGL2::supportInformation() const
+{
+    if (!m_lanczosFilter) {
+        return QStringLiteral("Lanczos filter: not used yet\n");
+    }
+    return m_lanczosFilter->supportInformation();
+}
+
 void SceneOpenGL2::performPaintWindow(EffectWindowImpl* w, int mask, QRegion region, WindowPaintData& data)
 {
     if (mask & PAINT_WINDOW_LANCZOS) {
@@ -122,6 +122,8 @@ public:
     QMatrix4x4 projectionMatrix() const override { return m_projectionMatrix; }
     QMatrix4x4 screenProjectionMatrix() const override { return m_screenProjectionMatrix; }
 
+    QString supportInformation() const override;
+
 protected:
     virtual void paintSimpleScreen(int mask, QRegion region);
     virtual void paintGenericScreen(int mask, ScreenPaintData data);
@@ -0,0 +1,314 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2019 KWin-lowlatency developers
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "displaylist.h"
+
+#include <QPainter>
+#include <QPixmap>
+
+#include <algorithm>
+
+namespace KWin
+{
+
+/**
+ * QPainterPath caches data lazily in const methods, so a path shared between the
+ * replaying threads is not painted directly. Each of them paints its own copy.
+ **/
+static QPainterPath copyPath(const QPainterPath &path)
+{
+    QPainterPath copy;
+    copy.addPath(path);
+    copy.setFillRule(path.fillRule());
+    return copy;
+}
+
+/**
+ * Records every draw call together with a snapshot of the painter state. It claims all
+ * features, so QPainter hands over transformations, clipping and opacity instead of
+ * emulating them.
+ **/
+class DisplayListEngine : public QPaintEngine
+{
+public:
+    explicit DisplayListEngine(DisplayList *list)
+        : QPaintEngine(QPaintEngine::AllFeatures)
+        , m_list(list)
+    {
+    }
+
+    bool begin(QPaintDevice *device) override {
+        Q_UNUSED(device)
+        m_list->m_states << DisplayList::State();
+        return true;
+    }
+    bool end() override {
+        return true;
+    }
+    Type type() const override {
+        return QPaintEngine::User;
+    }
+
+    void updateState(const QPaintEngineState &state) override;
+
+    void drawImage(const QRectF &rect, const QImage &image, const QRectF &source, Qt::ImageConversionFlags flags) override {
+        DisplayList::Command command;
+        command.type = DisplayList::CommandType::Image;
+        command.rect = rect;
+        command.image = image;
+        command.source = source;
+        command.flags = flags;
+        m_list->record(std::move(command), rect, false);
+    }
+    void drawPixmap(const QRectF &rect, const QPixmap &pixmap, const QRectF &source) override {
+        // raster pixmaps share their data with the image, which can be painted from any thread
+        drawImage(rect, pixmap.toImage(), source, Qt::AutoColor);
+    }
+    void drawPath(const QPainterPath &path) override {
+        DisplayList::Command command;
+        command.type = DisplayList::CommandType::Path;
+        command.path = path;
+        m_list->record(std::move(command), path.controlPointRect(), true);
+    }
+    void drawPolygon(const QPointF *points, int pointCount, PolygonDrawMode mode) override {
+        DisplayList::Command command;
+        command.type = DisplayList::CommandType::Polygon;
+        command.polygon = QPolygonF(pointCount);
+        std::copy(points, points + pointCount, command.polygon.begin());
+        command.polygonMode = mode;
+        const QRectF bounds = command.polygon.boundingRect();
+        m_list->record(std::move(command), bounds, true);
+    }
+    void drawPolygon(const QPoint *points, int pointCount, PolygonDrawMode mode) override {
+        QVector<QPointF> pointsF(pointCount);
+        std::copy(points, points + pointCount, pointsF.begin());
+        drawPolygon(pointsF.constData(), pointCount, mode);
+    }
+    void drawRects(const QRectF *rects, int rectCount) override {
+        DisplayList::Command command;
+        command.type = DisplayList::CommandType::Rects;
+        command.rects.resize(rectCount);
+        std::copy(rects, rects + rectCount, command.rects.begin());
+        QRectF bounds;
+        for (int i = 0; i < rectCount; ++i) {
+            bounds |= rects[i];
+        }
+        m_list->record(std::move(command), bounds, true);
+    }
+    void drawRects(const QRect *rects, int rectCount) override {
+        QVector<QRectF> rectsF(rectCount);
+        std::copy(rects, rects + rectCount, rectsF.begin());
+        drawRects(rectsF.constData(), rectCount);
+    }
+
+private:
+    DisplayList *m_list;
+};
+
+void DisplayListEngine::updateState(const QPaintEngineState &state)
+{
+    // the new state starts as a copy of the last one, so only what changed is queried
+    DisplayList::State current = m_list->m_states.last();
+    const QPaintEngine::DirtyFlags dirty = state.state();
+    QPainter *p = painter();
+    if (dirty & QPaintEngine::DirtyTransform) {
+        current.transform = p->combinedTransform();
+    }
+    if (dirty & (QPaintEngine::DirtyClipEnabled | QPaintEngine::DirtyClipRegion | QPaintEngine::DirtyClipPath)) {
+        current.clipping = p->hasClipping();
+        current.clipRegion = QRegion();
+        current.clipPath = QPainterPath();
+        current.clipIsPath = false;
+        if (current.clipping) {
+            // QPainter reports the clip in the coordinates of the current transformation
+            const QTransform transform = p->combinedTransform();
+            if (transform.type() <= QTransform::TxTranslate) {
+                current.clipRegion = p->clipRegion().translated(qRound(transform.dx()), qRound(transform.dy()));
+            } else {
+                current.clipPath = transform.map(p->clipPath());
+                current.clipIsPath = true;
+            }
+        }
+    }
+    if (dirty & QPaintEngine::DirtyOpacity) {
+        current.opacity = state.opacity();
+    }
+    if (dirty & QPaintEngine::DirtyCompositionMode) {
+        current.compositionMode = state.compositionMode();
+    }
+    if (dirty & QPaintEngine::DirtyHints) {
+        current.renderHints = state.renderHints();
+    }
+    if (dirty & QPaintEngine::DirtyPen) {
+        current.pen = state.pen();
+    }
+    if (dirty & QPaintEngine::DirtyBrush) {
+        current.brush = state.brush();
+    }
+    if (dirty & QPaintEngine::DirtyBrushOrigin) {
+        current.brushOrigin = state.brushOrigin();
+    }
+    m_list->m_states << current;
+}
+
+DisplayList::DisplayList()
+    : m_engine(new DisplayListEngine(this))
+{
+}
+
+DisplayList::~DisplayList() = default;
+
+void DisplayList::reset(const QRect &geometry)
+{
+    m_geometry = geometry;
+    m_boundingRect = QRect();
+    m_states.clear();
+    m_commands.clear();
+}
+
+QRect DisplayList::boundingRect() const
+{
+    return m_boundingRect;
+}
+
+bool DisplayList::isEmpty() const
+{
+    return m_commands.isEmpty();
+}
+
+QPaintEngine *DisplayList::paintEngine() const
+{
+    return m_engine.data();
+}
+
+int DisplayList::metric(PaintDeviceMetric metric) const
+{
+    switch (metric) {
+    case PdmWidth:
+        return m_geometry.x() + m_geometry.width();
+    case PdmHeight:
+        return m_geometry.y() + m_geometry.height();
+    case PdmWidthMM:
+        return qRound((m_geometry.x() + m_geometry.width()) * 25.4 / 96);
+    case PdmHeightMM:
+        return qRound((m_geometry.y() + m_geometry.height()) * 25.4 / 96);
+    case PdmNumColors:
+        return 0;
+    case PdmDepth:
+        return 32;
+    case PdmDpiX:
+    case PdmDpiY:
+    case PdmPhysicalDpiX:
+    case PdmPhysicalDpiY:
+        return 96;
+    case PdmDevicePixelRatio:
+        return 1;
+    case PdmDevicePixelRatioScaled:
+        return devicePixelRatioFScale();
+    default:
+        return QPaintDevice::metric(metric);
+    }
+}
+
+void DisplayList::record(Command &&command, const QRectF &logicalBounds, bool stroked)
+{
+    const State &state = m_states.last();
+    QRectF bounds = logicalBounds;
+    if (stroked && state.pen.style() != Qt::NoPen) {
+        const qreal margin = qMax<qreal>(1.0, state.pen.widthF());
+        bounds.adjust(-margin, -margin, margin, margin);
+    }
+    // one pixel for antialiasing and rounding
+    QRect deviceBounds = state.transform.mapRect(bounds).toAlignedRect().adjusted(-1, -1, 1, 1);
+    if (state.clipping) {
+        deviceBounds &= state.clipIsPath ? state.clipPath.boundingRect().toAlignedRect() : state.clipRegion.boundingRect();
+    }
+    if (deviceBounds.isEmpty()) {
+        return;
+    }
+    command.state = m_states.count() - 1;
+    command.bounds = deviceBounds;
+    m_boundingRect |= deviceBounds;
+    m_commands << std::move(command);
+}
+
+void DisplayList::replay(QPainter *painter, const QRect &area) const
+{
+    const QTransform base = painter->transform();
+    int appliedState = -1;
+    for (const Command &command : m_commands) {
+        if (!command.bounds.intersects(area)) {
+            continue;
+        }
+        if (command.state != appliedState) {
+            const State &state = m_states.at(command.state);
+            // the clip is given in device coordinates of the recording
+            painter->setTransform(base);
+            if (state.clipping) {
+                if (state.clipIsPath) {
+                    painter->setClipPath(copyPath(state.clipPath));
+                } else {
+                    painter->setClipRegion(state.clipRegion);
+                }
+            } else {
+                painter->setClipping(false);
+            }
+            painter->setTransform(state.transform * base);
+            painter->setOpacity(state.opacity);
+            painter->setCompositionMode(state.compositionMode);
+            painter->setRenderHints(QPainter::RenderHints(~0), false);
+            painter->setRenderHints(state.renderHints);
+            painter->setPen(state.pen);
+            painter->setBrush(state.brush);
+            painter->setBrushOrigin(state.brushOrigin);
+            appliedState = command.state;
+        }
+        switch (command.type) {
+        case CommandType::Image:
+            painter->drawImage(command.rect, command.image, command.source, command.flags);
+            break;
+        case CommandType::Path:
+            painter->drawPath(copyPath(command.path));
+            break;
+        case CommandType::Polygon:
+            switch (command.polygonMode) {
+            case QPaintEngine::PolylineMode:
+                painter->drawPolyline(command.polygon);
+                break;
+            case QPaintEngine::ConvexMode:
+                painter->drawConvexPolygon(command.polygon);
+                break;
+            case QPaintEngine::WindingMode:
+                painter->drawPolygon(command.polygon, Qt::WindingFill);
+                break;
+            default:
+                painter->drawPolygon(command.polygon, Qt::OddEvenFill);
+                break;
+            }
+            break;
+        case CommandType::Rects:
+            painter->drawRects(command.rects);
+            break;
+        }
+    }
+    painter->setTransform(base);
+    painter->setClipping(false);
+}
+
+}
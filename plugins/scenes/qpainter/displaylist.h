@@ -0,0 +1,124 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2019 KWin-lowlatency developers
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#ifndef KWIN_SCENE_QPAINTER_DISPLAYLIST_H
+#define KWIN_SCENE_QPAINTER_DISPLAYLIST_H
+
+#include <QBrush>
+#include <QImage>
+#include <QPaintDevice>
+#include <QPaintEngine>
+#include <QPainterPath>
+#include <QPen>
+#include <QRegion>
+#include <QScopedPointer>
+#include <QSharedPointer>
+#include <QTransform>
+#include <QVector>
+
+namespace KWin
+{
+
+class DisplayListEngine;
+
+/**
+ * @brief A paint device recording the painting of a frame in memory.
+ *
+ * Unlike QPicture nothing is serialized: images are kept as shallow copies, so recording
+ * costs about as much as a list append per draw call. The recorded frame can be replayed
+ * concurrently by several threads, each into its own part of the target.
+ *
+ * The images drawn must not be modified until the display list is cleared.
+ **/
+class DisplayList : public QPaintDevice
+{
+public:
+    DisplayList();
+    ~DisplayList() override;
+
+    /**
+     * Discards the recorded frame and sets the area of the device, in the coordinates
+     * the frame is painted in.
+     **/
+    void reset(const QRect &geometry);
+    /**
+     * The area touched by the recorded painting, in device coordinates.
+     **/
+    QRect boundingRect() const;
+    bool isEmpty() const;
+    /**
+     * Replays the commands touching @p area, given in device coordinates, on @p painter.
+     * The painter's transformation maps the device coordinates to its target. It is safe
+     * to replay the same display list from several threads at the same time.
+     **/
+    void replay(QPainter *painter, const QRect &area) const;
+
+    QPaintEngine *paintEngine() const override;
+
+protected:
+    int metric(PaintDeviceMetric metric) const override;
+
+private:
+    friend class DisplayListEngine;
+
+    struct State {
+        QTransform transform;
+        bool clipping = false;
+        // the clip in device coordinates, a path if it is not representable as a region
+        QRegion clipRegion;
+        QPainterPath clipPath;
+        bool clipIsPath = false;
+        qreal opacity = 1.0;
+        QPainter::CompositionMode compositionMode = QPainter::CompositionMode_SourceOver;
+        QPainter::RenderHints renderHints;
+        QPen pen;
+        QBrush brush;
+        QPointF brushOrigin;
+    };
+    enum class CommandType {
+        Image,
+        Path,
+        Polygon,
+        Rects
+    };
+    struct Command {
+        CommandType type;
+        int state;
+        QRect bounds;
+        QRectF rect;
+        QImage image;
+        QRectF source;
+        Qt::ImageConversionFlags flags;
+        QPainterPath path;
+        QPolygonF polygon;
+        QPaintEngine::PolygonDrawMode polygonMode;
+        QVector<QRectF> rects;
+    };
+    void record(Command &&command, const QRectF &logicalBounds, bool stroked);
+
+    QRect m_geometry;
+    QRect m_boundingRect;
+    QVector<State> m_states;
+    QVector<Command> m_commands;
+    QScopedPointer<DisplayListEngine> m_engine;
+};
+
+}
+
+#endif
@@ -18,6 +18,7 @@ You should have received a copy of the GNU General Public License
 along with this program.  If not, see <http://www.gnu.org/licenses/>.
 *********************************************************************/
 #include "scene_qpainter.h"
+#include "displaylist.h"
 // KWin
 #include "client.h"
 #include "composite.h"
@@ -36,8 +37,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 // Qt
 #include <QDebug>
 #include <QPainter>
+#include <QThreadPool>
+#include <QtConcurrentRun>
 #include <KDecoration2/Decoration>
 
+#include <algorithm>
 #include <cmath>
 
 namespace KWin
@@ -63,6 +67,13 @@ SceneQPainter::SceneQPainter(QPainterBackend *backend, QObject *parent)
     , m_backend(backend)
     , m_painter(new QPainter())
 {
+    const int threads = qEnvironmentVariableIntValue("KWIN_QPAINTER_THREADS");
+    if (threads > 1) {
+        m_tilePool.reset(new QThreadPool);
+        // the compositor thread renders tiles as well
+        m_tilePool->setMaxThreadCount(threads - 1);
+        m_displayList.reset(new DisplayList);
+    }
 }
 
 SceneQPainter::~SceneQPainter()
@@ -94,6 +105,7 @@ qint64 SceneQPainter::paint(QRegion damage, ToplevelList toplevels)
     renderTimer.start();
 
     createStackingOrder(toplevels);
+    m_scratchImagesUsed = 0;
 
     int mask = 0;
     m_backend->prepareRenderingFrame();
@@ -102,6 +114,11 @@ qint64 SceneQPainter::paint(QRegion damage, ToplevelList toplevels)
         if (needsFullRepaint) {
             mask |= Scene::PAINT_SCREEN_BACKGROUND_FIRST;
             damage = screens()->geometry();
+        } else {
+            // the first screen resets the repaints of the windows, the others need them as well
+            for (Scene::Window *w : qAsConst(stacking_order)) {
+                damage |= w->window()->repaints();
+            }
         }
         QRegion overallUpdate;
         for (int i = 0; i < screens()->count(); ++i) {
@@ -110,22 +127,39 @@ qint64 SceneQPainter::paint(QRegion damage, ToplevelList toplevels)
             if (!buffer || buffer->isNull()) {
                 continue;
             }
-            m_painter->begin(buffer);
-            m_painter->save();
-            m_painter->setWindow(geometry);
+            if (m_tilePool) {
+                // the frame is recorded and rasterized in tiles afterwards
+                m_displayList->reset(geometry);
+                m_painter->begin(m_displayList.data());
+                m_painter->save();
+            } else {
+                m_painter->begin(buffer);
+                m_painter->save();
+                m_painter->setWindow(geometry);
+            }
 
+            const QRegion repaint = needsFullRepaint ? QRegion() : m_backend->prepareRenderingForScreen(i);
             QRegion updateRegion, validRegion;
-            paintScreen(&mask, damage.intersected(geometry), QRegion(), &updateRegion, &validRegion);
+            paintScreen(&mask, damage.intersected(geometry), repaint.intersected(geometry), &updateRegion, &validRegion);
             overallUpdate = overallUpdate.united(updateRegion);
             paintCursor();
 
             m_painter->restore();
             m_painter->end();
+            if (m_tilePool) {
+                paintTiles(buffer, geometry);
+            }
         }
         m_backend->showOverlay();
         m_backend->present(mask, overallUpdate);
     } else {
-        m_painter->begin(m_backend->buffer());
+        QImage *buffer = m_backend->buffer();
+        if (m_tilePool) {
+            m_displayList->reset(QRect(QPoint(0, 0), buffer->size()));
+            m_painter->begin(m_displayList.data());
+        } else {
+            m_painter->begin(buffer);
+        }
         m_painter->setClipping(true);
         m_painter->setClipRegion(damage);
         if (m_backend->needsFullRepaint()) {
@@ -139,17 +173,78 @@ qint64 SceneQPainter::paint(QRegion damage, ToplevelList toplevels)
         m_backend->showOverlay();
 
         m_painter->end();
+        if (m_tilePool) {
+            paintTiles(buffer, QRect(QPoint(0, 0), buffer->size()));
+        }
         m_backend->present(mask, updateRegion);
     }
 
     // do cleanup
     clearStackingOrder();
+    // the images not needed in this frame are released, the pool only holds what one frame uses
+    m_scratchImages.resize(m_scratchImagesUsed);
 
     emit frameRendered();
 
     return renderTimer.nsecsElapsed();
 }
 
+void SceneQPainter::paintTiles(QImage *buffer, const QRect &geometry)
+{
+    static const int s_tileSize = 256;
+
+    // the same mapping as QPainter::setWindow(geometry) on the buffer
+    QTransform toBuffer;
+    toBuffer.scale(qreal(buffer->width()) / geometry.width(), qreal(buffer->height()) / geometry.height());
+    toBuffer.translate(-geometry.x(), -geometry.y());
+    const QRect painted = toBuffer.mapRect(m_displayList->boundingRect()).intersected(buffer->rect());
+    if (painted.isEmpty()) {
+        m_displayList->reset(QRect());
+        return;
+    }
+
+    QVector<QRect> tiles;
+    for (int y = painted.y() / s_tileSize * s_tileSize; y <= painted.bottom(); y += s_tileSize) {
+        for (int x = painted.x() / s_tileSize * s_tileSize; x <= painted.right(); x += s_tileSize) {
+            tiles << QRect(x, y, s_tileSize, s_tileSize).intersected(buffer->rect());
+        }
+    }
+
+    const int threads = qMin(m_tilePool->maxThreadCount() + 1, tiles.count());
+    const DisplayList *frame = m_displayList.data();
+    const QTransform fromBuffer = toBuffer.inverted();
+
+    uchar *bits = buffer->bits();
+    const int bytesPerLine = buffer->bytesPerLine();
+    const int bytesPerPixel = buffer->depth() / 8;
+    const QImage::Format format = buffer->format();
+    QAtomicInt next = 0;
+    auto paintTile = [&tiles, &next, frame, toBuffer, fromBuffer, bits, bytesPerLine, bytesPerPixel, format] () {
+        for (int i = next.fetchAndAddRelaxed(1); i < tiles.count(); i = next.fetchAndAddRelaxed(1)) {
+            const QRect &tile = tiles.at(i);
+            // the tile only covers its part of the buffer, nothing is painted outside of it
+            QImage image(bits + tile.y() * bytesPerLine + tile.x() * bytesPerPixel,
+                         tile.width(), tile.height(), bytesPerLine, format);
+            QPainter painter(&image);
+            painter.translate(-tile.topLeft());
+            painter.setTransform(toBuffer, true);
+            frame->replay(&painter, fromBuffer.mapRect(QRectF(tile)).toAlignedRect());
+        }
+    };
+
+    QVector<QFuture<void>> workers;
+    workers.reserve(threads - 1);
+    for (int i = 1; i < threads; ++i) {
+        workers << QtConcurrent::run(m_tilePool.data(), paintTile);
+    }
+    paintTile();
+    for (QFuture<void> &worker : workers) {
+        worker.waitForFinished();
+    }
+    // release the images referenced by the frame
+    m_displayList->reset(QRect());
+}
+
 void SceneQPainter::paintBackground(QRegion region)
 {
     m_painter->setBrush(Qt::black);
@@ -190,6 +285,24 @@ void SceneQPainter::screenGeometryChanged(const QSize &size)
 {
     Scene::screenGeometryChanged(size);
     m_backend->screenGeometryChanged(size);
+    m_scratchImages.clear();
+}
+
+QImage &SceneQPainter::scratchImage(const QSize &size)
+{
+    if (m_scratchImagesUsed == m_scratchImages.count()) {
+        m_scratchImages << QImage();
+    }
+    QImage &image = m_scratchImages[m_scratchImagesUsed++];
+    const bool tooSmall = image.width() < size.width() || image.height() < size.height();
+    // a window which shrank a lot does not keep the memory of its largest size
+    const bool tooLarge = qint64(image.width()) * image.height() > 4 * qint64(size.width()) * size.height();
+    if (tooSmall) {
+        image = QImage(size.expandedTo(image.size()), QImage::Format_ARGB32_Premultiplied);
+    } else if (tooLarge) {
+        image = QImage(size, QImage::Format_ARGB32_Premultiplied);
+    }
+    return image;
 }
 
 QImage *SceneQPainter::qpainterRenderBuffer() const
@@ -231,7 +344,8 @@ static void paintSubSurface(QPainter *painter, const QPoint &pos, QPainterWindow
 
 void SceneQPainter::Window::performPaint(int mask, QRegion region, WindowPaintData data)
 {
-    if (!(mask & (PAINT_WINDOW_TRANSFORMED | PAINT_SCREEN_TRANSFORMED)))
+    const bool transformed = mask & (PAINT_WINDOW_TRANSFORMED | PAINT_SCREEN_TRANSFORMED);
+    if (!transformed)
         region &= toplevel->visibleRect();
 
     if (region.isEmpty())
@@ -257,20 +371,40 @@ void SceneQPainter::Window::performPaint(int mask, QRegion region, WindowPaintDa
         painter->scale(data.xScale(), data.yScale());
     }
 
+    const auto &children = pixmap->children();
+    auto isMapped = [](WindowPixmap *pixmap) {
+        return !pixmap->subSurface().isNull() && !pixmap->subSurface()->surface().isNull() && pixmap->subSurface()->surface()->isMapped();
+    };
     const bool opaque = qFuzzyCompare(1.0, data.opacity());
-    QImage tempImage;
+    // the decoration and the content do not overlap, unlike the shadow and sub-surfaces, so
+    // without those each pixel is painted once and the opacity can be applied while painting
+    const bool layered = toplevel->shadow() || std::any_of(children.begin(), children.end(), isMapped);
     QPainter tempPainter;
-    if (!opaque) {
-        // need a temp render target which we later on blit to the screen
-        tempImage = QImage(toplevel->visibleRect().size(), QImage::Format_ARGB32_Premultiplied);
-        tempImage.fill(Qt::transparent);
-        tempPainter.begin(&tempImage);
+    QImage *tempImage = nullptr;
+    QRect tempRect;
+    if (!opaque && layered) {
+        // need a temp render target which we later on blit to the screen, only the part
+        // which is going to be painted, in window coordinates
+        tempRect = toplevel->visibleRect().translated(-toplevel->pos());
+        if (!transformed) {
+            tempRect &= region.boundingRect().translated(-toplevel->pos());
+        }
+        tempImage = &m_scene->scratchImage(tempRect.size());
+        tempPainter.begin(tempImage);
+        tempPainter.setClipRect(QRect(QPoint(0, 0), tempRect.size()));
+        tempPainter.setCompositionMode(QPainter::CompositionMode_Source);
+        tempPainter.fillRect(QRect(QPoint(0, 0), tempRect.size()), Qt::transparent);
+        tempPainter.setCompositionMode(QPainter::CompositionMode_SourceOver);
         tempPainter.save();
-        tempPainter.translate(toplevel->geometry().topLeft() - toplevel->visibleRect().topLeft());
+        tempPainter.translate(-tempRect.topLeft());
         painter = &tempPainter;
+    } else if (!opaque) {
+        painter->setOpacity(data.opacity());
+    }
+    updateDecorationCache();
+    for (const DecorationCachePiece &piece : qAsConst(m_decorationCache)) {
+        painter->drawImage(piece.rect, piece.image);
     }
-    renderShadow(painter);
-    renderWindowDecorations(painter);
 
     // render content
     const QRect target = QRect(toplevel->clientPos(), toplevel->clientSize());
@@ -283,23 +417,22 @@ void SceneQPainter::Window::performPaint(int mask, QRegion region, WindowPaintDa
     painter->drawImage(target, pixmap->image(), src);
 
     // render subsurfaces
-    const auto &children = pixmap->children();
     for (auto pixmap : children) {
-        if (pixmap->subSurface().isNull() || pixmap->subSurface()->surface().isNull() || !pixmap->subSurface()->surface()->isMapped()) {
+        if (!isMapped(pixmap)) {
             continue;
         }
         paintSubSurface(painter, toplevel->clientPos(), static_cast<QPainterWindowPixmap*>(pixmap));
     }
 
-    if (!opaque) {
+    if (tempImage) {
         tempPainter.restore();
         tempPainter.setCompositionMode(QPainter::CompositionMode_DestinationIn);
         QColor translucent(Qt::transparent);
         translucent.setAlphaF(data.opacity());
-        tempPainter.fillRect(QRect(QPoint(0, 0), toplevel->visibleRect().size()), translucent);
+        tempPainter.fillRect(QRect(QPoint(0, 0), tempRect.size()), translucent);
         tempPainter.end();
         painter = scenePainter;
-        painter->drawImage(toplevel->visibleRect().topLeft() - toplevel->geometry().topLeft(), tempImage);
+        painter->drawImage(tempRect.topLeft(), *tempImage, QRect(QPoint(0, 0), tempRect.size()));
     }
 
     painter->restore();
@@ -328,18 +461,21 @@ void SceneQPainter::Window::renderShadow(QPainter* painter)
     }
 }
 
-void SceneQPainter::Window::renderWindowDecorations(QPainter *painter)
+/**
+ * The up to date decoration renderer of @p toplevel and the decoration rects in the order
+ * left, top, right, bottom, or @c null if it has no decoration.
+ **/
+static const SceneQPainterDecorationRenderer *decorationRenderer(Toplevel *toplevel, QRect *rects)
 {
     // TODO: custom decoration opacity
     AbstractClient *client = dynamic_cast<AbstractClient*>(toplevel);
     Deleted *deleted = dynamic_cast<Deleted*>(toplevel);
     if (!client && !deleted) {
-        return;
+        return nullptr;
     }
 
     bool noBorder = true;
     const SceneQPainterDecorationRenderer *renderer = nullptr;
-    QRect dtr, dlr, drr, dbr;
     if (client && !client->noBorder()) {
         if (client->isDecorated()) {
             if (SceneQPainterDecorationRenderer *r = static_cast<SceneQPainterDecorationRenderer *>(client->decoratedClient()->renderer())) {
@@ -347,21 +483,115 @@ void SceneQPainter::Window::renderWindowDecorations(QPainter *painter)
                 renderer = r;
             }
         }
-        client->layoutDecorationRects(dlr, dtr, drr, dbr);
+        client->layoutDecorationRects(rects[0], rects[1], rects[2], rects[3]);
         noBorder = false;
     } else if (deleted && !deleted->noBorder()) {
         noBorder = false;
-        deleted->layoutDecorationRects(dlr, dtr, drr, dbr);
+        deleted->layoutDecorationRects(rects[0], rects[1], rects[2], rects[3]);
         renderer = static_cast<const SceneQPainterDecorationRenderer *>(deleted->decorationRenderer());
     }
-    if (noBorder || !renderer) {
+    if (noBorder) {
+        return nullptr;
+    }
+    return renderer;
+}
+
+void SceneQPainter::Window::renderWindowDecorations(QPainter *painter)
+{
+    QRect rects[4];
+    const SceneQPainterDecorationRenderer *renderer = decorationRenderer(toplevel, rects);
+    if (!renderer) {
+        return;
+    }
+
+    painter->drawImage(rects[1], renderer->image(SceneQPainterDecorationRenderer::DecorationPart::Top));
+    painter->drawImage(rects[0], renderer->image(SceneQPainterDecorationRenderer::DecorationPart::Left));
+    painter->drawImage(rects[2], renderer->image(SceneQPainterDecorationRenderer::DecorationPart::Right));
+    painter->drawImage(rects[3], renderer->image(SceneQPainterDecorationRenderer::DecorationPart::Bottom));
+}
+
+void SceneQPainter::Window::updateDecorationCache()
+{
+    QRect rects[4];
+    const SceneQPainterDecorationRenderer *renderer = decorationRenderer(toplevel, rects);
+    const SceneQPainterShadow *shadow = static_cast<SceneQPainterShadow *>(toplevel->shadow());
+    const quint64 shadowSerial = shadow ? shadow->serial() : 0;
+    const quint64 decorationSerial = renderer ? renderer->serial() : 0;
+    const QRect clientRect(toplevel->clientPos(), toplevel->clientSize());
+    if (shadowSerial == m_cachedShadowSerial && decorationSerial == m_cachedDecorationSerial &&
+            clientRect == m_cachedClientRect && std::equal(rects, rects + 4, m_cachedDecorationRects)) {
+        return;
+    }
+    m_cachedShadowSerial = shadowSerial;
+    m_cachedDecorationSerial = decorationSerial;
+    m_cachedClientRect = clientRect;
+    std::copy(rects, rects + 4, m_cachedDecorationRects);
+    m_decorationCache.clear();
+
+    QRegion painted;
+    qreal dpr = 1;
+    if (shadow) {
+        for (const WindowQuad &q : shadow->shadowQuads()) {
+            painted |= QRectF(QPointF(q[0].x(), q[0].y()), QPointF(q[2].x(), q[2].y())).toAlignedRect();
+        }
+    }
+    if (renderer) {
+        for (const QRect &rect : rects) {
+            painted |= rect;
+        }
+        for (int i = 0; i < int(SceneQPainterDecorationRenderer::DecorationPart::Count); ++i) {
+            dpr = qMax(dpr, renderer->image(SceneQPainterDecorationRenderer::DecorationPart(i)).devicePixelRatio());
+        }
+    }
+    if (painted.isEmpty()) {
         return;
     }
 
-    painter->drawImage(dtr, renderer->image(SceneQPainterDecorationRenderer::DecorationPart::Top));
-    painter->drawImage(dlr, renderer->image(SceneQPainterDecorationRenderer::DecorationPart::Left));
-    painter->drawImage(drr, renderer->image(SceneQPainterDecorationRenderer::DecorationPart::Right));
-    painter->drawImage(dbr, renderer->image(SceneQPainterDecorationRenderer::DecorationPart::Bottom));
+    // leave out the largest part of the client area nothing is painted in, usually all of it
+    const QRect bounds = painted.boundingRect();
+    QRect hole = clientRect & bounds;
+    for (QRegion inside = painted & hole; !inside.isEmpty(); inside = painted & hole) {
+        const QRect r = *inside.begin();
+        const QRect candidates[] = {
+            QRect(QPoint(hole.left(), r.bottom() + 1), hole.bottomRight()),
+            QRect(hole.topLeft(), QPoint(hole.right(), r.top() - 1)),
+            QRect(QPoint(r.right() + 1, hole.top()), hole.bottomRight()),
+            QRect(hole.topLeft(), QPoint(r.left() - 1, hole.bottom()))
+        };
+        hole = QRect();
+        for (const QRect &candidate : candidates) {
+            if (candidate.isValid() && candidate.width() * candidate.height() > hole.width() * hole.height()) {
+                hole = candidate;
+            }
+        }
+        if (hole.isEmpty()) {
+            break;
+        }
+    }
+
+    QVector<QRect> pieces;
+    if (hole.isEmpty()) {
+        pieces << bounds;
+    } else {
+        pieces << QRect(QPoint(bounds.left(), bounds.top()), QPoint(bounds.right(), hole.top() - 1))
+               << QRect(QPoint(bounds.left(), hole.bottom() + 1), QPoint(bounds.right(), bounds.bottom()))
+               << QRect(QPoint(bounds.left(), hole.top()), QPoint(hole.left() - 1, hole.bottom()))
+               << QRect(QPoint(hole.right() + 1, hole.top()), QPoint(bounds.right(), hole.bottom()));
+    }
+    for (const QRect &rect : qAsConst(pieces)) {
+        if (!rect.isValid() || !painted.intersects(rect)) {
+            continue;
+        }
+        QImage image(rect.size() * dpr, QImage::Format_ARGB32_Premultiplied);
+        image.setDevicePixelRatio(dpr);
+        image.fill(Qt::transparent);
+        QPainter painter(&image);
+        painter.translate(-rect.topLeft());
+        renderShadow(&painter);
+        renderWindowDecorations(&painter);
+        painter.end();
+        m_decorationCache << DecorationCachePiece{rect, image};
+    }
 }
 
 WindowPixmap *SceneQPainter::Window::createWindowPixmap()
@@ -520,6 +750,9 @@ void QPainterEffectFrame::render(QRegion region, double opacity, double frameOpa
 //****************************************
 // QPainterShadow
 //****************************************
+// the serials of the shadows and decoration renderers, only used on the compositor thread
+static quint64 s_nextSerial = 0;
+
 SceneQPainterShadow::SceneQPainterShadow(Toplevel* toplevel)
     : Shadow(toplevel)
 {
@@ -531,6 +764,7 @@ SceneQPainterShadow::~SceneQPainterShadow()
 
 void SceneQPainterShadow::buildQuads()
 {
+    m_serial = ++s_nextSerial;
     // Do not draw shadows if window width or window height is less than
     // 5 px. 5 is an arbitrary choice.
     if (topLevel()->width() < 5 || topLevel()->height() < 5) {
@@ -723,6 +957,7 @@ void SceneQPainterShadow::buildQuads()
 
 bool SceneQPainterShadow::prepareBackend()
 {
+    m_serial = ++s_nextSerial;
     if (hasDecorationShadow()) {
         m_texture = decorationShadowImage();
         return true;
@@ -791,6 +1026,7 @@ void SceneQPainterDecorationRenderer::render()
     if (scheduled.isEmpty()) {
         return;
     }
+    m_serial = ++s_nextSerial;
     if (areImageSizesDirty()) {
         resizeImages();
         resetImageSizesDirty();
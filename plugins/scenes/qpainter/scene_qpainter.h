@@ -26,8 +26,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "decorations/decorationrenderer.h"
 
+class QThreadPool;
+
 namespace KWin {
 
+class DisplayList;
+
 class KWIN_EXPORT SceneQPainter : public Scene
 {
     Q_OBJECT
@@ -65,8 +69,28 @@ protected:
 
 private:
     explicit SceneQPainter(QPainterBackend *backend, QObject *parent = nullptr);
+    /**
+     * Replays the recorded frame into the tiles of @p buffer on the tile pool and the
+     * compositor thread. @p geometry is the area of the screen shown in the buffer.
+     **/
+    void paintTiles(QImage *buffer, const QRect &geometry);
+    /**
+     * @returns an image of at least @p size to paint a translucent window into. It is not
+     * handed out again in the same frame: in the tiled mode the display list only references
+     * the image, so it has to stay untouched until the tiles are painted. Images not used in a
+     * frame are released at its end.
+     **/
+    QImage &scratchImage(const QSize &size);
     QScopedPointer<QPainterBackend> m_backend;
     QScopedPointer<QPainter> m_painter;
+    /**
+     * Only present in the tiled mode, enabled by setting KWIN_QPAINTER_THREADS to more than one thread.
+     **/
+    QScopedPointer<QThreadPool> m_tilePool;
+    // the frame recorded for the tiles, only present in the tiled mode
+    QScopedPointer<DisplayList> m_displayList;
+    QVector<QImage> m_scratchImages;
+    int m_scratchImagesUsed = 0;
     class Window;
 };
 
@@ -81,7 +105,22 @@ protected:
 private:
     void renderShadow(QPainter *painter);
     void renderWindowDecorations(QPainter *painter);
+    void updateDecorationCache();
     SceneQPainter *m_scene;
+    /**
+     * The shadow and the decoration composited into premultiplied images, which are painted
+     * unscaled in one go. Only the border around the client area is cached, split into up to
+     * four pieces. Rebuilt if the shadow, the decoration or the geometry changes.
+     **/
+    struct DecorationCachePiece {
+        QRect rect;
+        QImage image;
+    };
+    QVector<DecorationCachePiece> m_decorationCache;
+    quint64 m_cachedShadowSerial = 0;
+    quint64 m_cachedDecorationSerial = 0;
+    QRect m_cachedDecorationRects[4];
+    QRect m_cachedClientRect;
 };
 
 class QPainterWindowPixmap : public WindowPixmap
@@ -127,6 +166,12 @@ public:
     QImage &shadowTexture() {
         return m_texture;
     }
+    /**
+     * Changes whenever the texture or the quads change, unique among all shadows.
+     **/
+    quint64 serial() const {
+        return m_serial;
+    }
 
 protected:
     virtual void buildQuads() override;
@@ -134,6 +179,7 @@ protected:
 
 private:
     QImage m_texture;
+    quint64 m_serial = 0;
 };
 
 class SceneQPainterDecorationRenderer : public Decoration::Renderer
@@ -154,10 +200,17 @@ public:
     void reparent(Deleted *deleted) override;
 
     QImage image(DecorationPart part) const;
+    /**
+     * Changes whenever the images are painted, unique among all renderers.
+     **/
+    quint64 serial() const {
+        return m_serial;
+    }
 
 private:
     void resizeImages();
     QImage m_images[int(DecorationPart::Count)];
+    quint64 m_serial = 0;
 };
 
 class KWIN_EXPORT QPainterFactory : public SceneFactory
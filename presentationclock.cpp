@@ -0,0 +1,60 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2019 KWin-lowlatency developers
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "presentationclock.h"
+
+#include <algorithm>
+
+namespace KWin
+{
+
+void PresentationClock::setInterval(std::chrono::nanoseconds interval)
+{
+    m_interval = std::max(interval, std::chrono::nanoseconds(1));
+}
+
+void PresentationClock::presented(std::chrono::nanoseconds time)
+{
+    m_lastPresentation = time;
+}
+
+std::chrono::nanoseconds PresentationClock::predict(std::chrono::nanoseconds now)
+{
+    std::chrono::nanoseconds predicted = now + m_interval;
+    if (m_lastPresentation > std::chrono::nanoseconds::zero() && now - m_lastPresentation < std::chrono::seconds(1)) {
+        // the frame is shown at the first vblank after now
+        predicted = m_lastPresentation + ((now - m_lastPresentation) / m_interval + 1) * m_interval;
+    }
+    if (predicted <= m_predicted) {
+        predicted = m_predicted + m_interval;
+    }
+    m_predicted = predicted;
+    return predicted;
+}
+
+int PresentationClock::elapsedMilliseconds(std::chrono::nanoseconds previous, std::chrono::nanoseconds current,
+                                           std::chrono::nanoseconds &remainder)
+{
+    const std::chrono::nanoseconds diff = current - previous + remainder;
+    const std::chrono::milliseconds diffMs = std::chrono::duration_cast<std::chrono::milliseconds>(diff);
+    remainder = diff - diffMs;
+    return diffMs.count();
+}
+
+}
@@ -0,0 +1,80 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2019 KWin-lowlatency developers
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#ifndef KWIN_PRESENTATIONCLOCK_H
+#define KWIN_PRESENTATIONCLOCK_H
+
+#include <kwin_export.h>
+
+#include <chrono>
+
+namespace KWin
+{
+
+/**
+ * @brief Predicts when the frames of the compositor are shown.
+ *
+ * The backends report when a frame got shown, e.g. with the timestamp of the page flip
+ * event. The following vblanks are expected at the refresh interval after it, so a frame
+ * started at a given time is shown at the first of them, and the predictions lie on the
+ * vblank grid instead of jittering with the time the paint pass happens to start.
+ *
+ * All times are in nanoseconds of std::chrono::steady_clock.
+ **/
+class KWIN_EXPORT PresentationClock
+{
+public:
+    std::chrono::nanoseconds interval() const {
+        return m_interval;
+    }
+    void setInterval(std::chrono::nanoseconds interval);
+
+    /**
+     * A frame got shown at @p time.
+     **/
+    void presented(std::chrono::nanoseconds time);
+    /**
+     * @returns when a frame started at @p now is shown. It is at least an interval after
+     * the previous prediction, as two frames are never shown at the same vblank.
+     **/
+    std::chrono::nanoseconds predict(std::chrono::nanoseconds now);
+    /**
+     * @returns the last prediction, zero if there was none yet.
+     **/
+    std::chrono::nanoseconds predicted() const {
+        return m_predicted;
+    }
+
+    /**
+     * @returns the whole milliseconds from @p previous to @p current. The rest is added
+     * to @p remainder and carried over to the next call, so that the results of
+     * consecutive calls add up to the elapsed time without drifting.
+     **/
+    static int elapsedMilliseconds(std::chrono::nanoseconds previous, std::chrono::nanoseconds current,
+                                   std::chrono::nanoseconds &remainder);
+
+private:
+    std::chrono::nanoseconds m_interval = std::chrono::nanoseconds(16666667);
+    std::chrono::nanoseconds m_lastPresentation = std::chrono::nanoseconds::zero();
+    std::chrono::nanoseconds m_predicted = std::chrono::nanoseconds::zero();
+};
+
+}
+
+#endif
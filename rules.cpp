@@ -23,13 +23,15 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <fixx11h.h>
 #include <kconfig.h>
 #include <KXMessages>
-#include <QRegExp>
+#include <QRegularExpression>
 #include <QTemporaryFile>
 #include <QFile>
 #include <QFileInfo>
 #include <QDebug>
 #include <QDir>
 
+#include <algorithm>
+
 #ifndef KCMRULES
 #include "client.h"
 #include "client_machine.h"
@@ -376,6 +378,17 @@ QString Rules::readDecoColor(const KConfigGroup &cfg)
                                   QLatin1String("color-schemes/") + themeName + QLatin1String(".colors"));
 }
 
+// compiled once per pattern instead of on every match, the pattern may still be changed
+// through the public members in the kcm
+static bool matchRegExp(QRegularExpression &regExp, const QString &pattern, const QString &subject)
+{
+    if (regExp.pattern() != pattern) {
+        regExp.setPattern(pattern);
+        regExp.optimize();
+    }
+    return regExp.match(subject).hasMatch();
+}
+
 bool Rules::matchType(NET::WindowType match_type) const
 {
     if (types != NET::AllTypesMask) {
@@ -393,7 +406,7 @@ bool Rules::matchWMClass(const QByteArray& match_class, const QByteArray& match_
         // TODO optimize?
         QByteArray cwmclass = wmclasscomplete
                               ? match_name + ' ' + match_class : match_class;
-        if (wmclassmatch == RegExpMatch && QRegExp(QString::fromUtf8(wmclass)).indexIn(QString::fromUtf8(cwmclass)) == -1)
+        if (wmclassmatch == RegExpMatch && !matchRegExp(wmclassregexp, QString::fromUtf8(wmclass), QString::fromUtf8(cwmclass)))
             return false;
         if (wmclassmatch == ExactMatch && wmclass != cwmclass)
             return false;
@@ -406,7 +419,7 @@ bool Rules::matchWMClass(const QByteArray& match_class, const QByteArray& match_
 bool Rules::matchRole(const QByteArray& match_role) const
 {
     if (windowrolematch != UnimportantMatch) {
-        if (windowrolematch == RegExpMatch && QRegExp(QString::fromUtf8(windowrole)).indexIn(QString::fromUtf8(match_role)) == -1)
+        if (windowrolematch == RegExpMatch && !matchRegExp(windowroleregexp, QString::fromUtf8(windowrole), QString::fromUtf8(match_role)))
             return false;
         if (windowrolematch == ExactMatch && windowrole != match_role)
             return false;
@@ -419,7 +432,7 @@ bool Rules::matchRole(const QByteArray& match_role) const
 bool Rules::matchTitle(const QString& match_title) const
 {
     if (titlematch != UnimportantMatch) {
-        if (titlematch == RegExpMatch && QRegExp(title).indexIn(match_title) == -1)
+        if (titlematch == RegExpMatch && !matchRegExp(titleregexp, title, match_title))
             return false;
         if (titlematch == ExactMatch && title != match_title)
             return false;
@@ -437,7 +450,7 @@ bool Rules::matchClientMachine(const QByteArray& match_machine, bool local) cons
                 && matchClientMachine("localhost", true))
             return true;
         if (clientmachinematch == RegExpMatch
-                && QRegExp(QString::fromUtf8(clientmachine)).indexIn(QString::fromUtf8(match_machine)) == -1)
+                && !matchRegExp(clientmachineregexp, QString::fromUtf8(clientmachine), QString::fromUtf8(match_machine)))
             return false;
         if (clientmachinematch == ExactMatch
                 && clientmachine != match_machine)
@@ -451,6 +464,11 @@ bool Rules::matchClientMachine(const QByteArray& match_machine, bool local) cons
 
 #ifndef KCMRULES
 bool Rules::match(const AbstractClient* c) const
+{
+    return matchProperties(c) && matchCaption(c);
+}
+
+bool Rules::matchProperties(const AbstractClient* c) const
 {
     if (!matchType(c->windowType(true)))
         return false;
@@ -460,14 +478,22 @@ bool Rules::match(const AbstractClient* c) const
         return false;
     if (!matchClientMachine(c->clientMachine()->hostName(), c->clientMachine()->isLocal()))
         return false;
+    return true;
+}
+
+bool Rules::matchCaption(const AbstractClient* c) const
+{
     if (titlematch != UnimportantMatch) // track title changes to rematch rules
         QObject::connect(c, &AbstractClient::captionChanged, c, &AbstractClient::evaluateWindowRules,
                          // QueuedConnection, because title may change before
                          // the client is ready (could segfault!)
                          static_cast<Qt::ConnectionType>(Qt::QueuedConnection|Qt::UniqueConnection));
-    if (!matchTitle(c->captionNormal()))
-        return false;
-    return true;
+    return matchTitle(c->captionNormal());
+}
+
+QByteArray Rules::exactWMClass() const
+{
+    return wmclassmatch == ExactMatch ? wmclass : QByteArray();
 }
 
 #define NOW_REMEMBER(_T_, _V_) ((selection & _T_) && (_V_##rule == (SetRule)Remember))
@@ -1011,29 +1037,92 @@ void RuleBook::deleteAll()
 {
     qDeleteAll(m_rules);
     m_rules.clear();
+    rulesChanged();
 }
 
-WindowRules RuleBook::find(const AbstractClient* c, bool ignore_temporary)
+void RuleBook::rulesChanged()
 {
-    QVector< Rules* > ret;
-    for (QList< Rules* >::Iterator it = m_rules.begin();
-            it != m_rules.end();
-       ) {
-        if (ignore_temporary && (*it)->isTemporary()) {
-            ++it;
+    m_indexValid = false;
+    m_matchCache.clear();
+}
+
+void RuleBook::updateIndex()
+{
+    m_wmclassIndex.clear();
+    m_unindexedRules.clear();
+    for (int i = 0; i < m_rules.count(); ++i) {
+        const QByteArray wmclass = m_rules.at(i)->exactWMClass();
+        if (wmclass.isNull()) {
+            m_unindexedRules.append(i);
+        } else {
+            m_wmclassIndex[wmclass].append(i);
+        }
+    }
+    m_indexValid = true;
+}
+
+QVector<Rules*> RuleBook::matchingRules(const AbstractClient* c, bool ignore_temporary)
+{
+    if (!m_indexValid) {
+        updateIndex();
+    }
+    // a rule for a single window class can only match with either the class alone or
+    // the complete name and class, no matter what else it checks
+    QVector<int> candidates = m_unindexedRules;
+    const QByteArray resourceClass = c->resourceClass();
+    const QByteArray completeClass = c->resourceName() + ' ' + resourceClass;
+    candidates += m_wmclassIndex.value(resourceClass);
+    if (completeClass != resourceClass) {
+        candidates += m_wmclassIndex.value(completeClass);
+    }
+    // in the order of m_rules, which is their priority
+    std::sort(candidates.begin(), candidates.end());
+
+    QVector<Rules*> ret;
+    for (int index : qAsConst(candidates)) {
+        Rules* rule = m_rules.at(index);
+        if (ignore_temporary && rule->isTemporary()) {
             continue;
         }
-        if ((*it)->match(c)) {
-            Rules* rule = *it;
-            qCDebug(KWIN_CORE) << "Rule found:" << rule << ":" << c;
-            if (rule->isTemporary())
-                it = m_rules.erase(it);
-            else
-                ++it;
+        if (rule->matchProperties(c)) {
             ret.append(rule);
+        }
+    }
+    return ret;
+}
+
+WindowRules RuleBook::find(const AbstractClient* c, bool ignore_temporary)
+{
+    QVector< Rules* > candidates;
+    if (ignore_temporary) {
+        // re-evaluation, e.g. on title changes, usually does not change anything else
+        const QByteArray key = QByteArray::number(uint(c->windowType(true))) + '\n'
+            + c->resourceClass() + '\n' + c->resourceName() + '\n' + c->windowRole().toLower() + '\n'
+            + c->clientMachine()->hostName() + '\n' + (c->clientMachine()->isLocal() ? '1' : '0');
+        auto it = m_matchCache.constFind(key);
+        if (it == m_matchCache.constEnd()) {
+            it = m_matchCache.insert(key, matchingRules(c, true));
+        }
+        candidates = it.value();
+    } else {
+        candidates = matchingRules(c, false);
+    }
+
+    QVector< Rules* > ret;
+    bool removedTemporary = false;
+    for (Rules* rule : qAsConst(candidates)) {
+        if (!rule->matchCaption(c)) {
             continue;
         }
-        ++it;
+        qCDebug(KWIN_CORE) << "Rule found:" << rule << ":" << c;
+        if (rule->isTemporary()) {
+            m_rules.removeOne(rule);
+            removedTemporary = true;
+        }
+        ret.append(rule);
+    }
+    if (removedTemporary) {
+        rulesChanged();
     }
     return WindowRules(ret);
 }
@@ -1078,6 +1167,7 @@ void RuleBook::load()
         Rules* rule = new Rules(cg);
         m_rules.append(rule);
     }
+    rulesChanged();
 }
 
 void RuleBook::save()
@@ -1116,6 +1206,7 @@ void RuleBook::temporaryRulesMessage(const QString& message)
             was_temporary = true;
     Rules* rule = new Rules(message, true);
     m_rules.prepend(rule);   // highest priority first
+    rulesChanged();
     if (!was_temporary)
         QTimer::singleShot(60000, this, SLOT(cleanupTemporaryRules()));
 }
@@ -1128,6 +1219,7 @@ void RuleBook::cleanupTemporaryRules()
        ) {
         if ((*it)->discardTemporary(false)) { // deletes (*it)
             it = m_rules.erase(it);
+            rulesChanged();
         } else {
             if ((*it)->isTemporary())
                 has_temporary = true;
@@ -1153,6 +1245,7 @@ void RuleBook::discardUsed(AbstractClient* c, bool withdrawn)
                 Rules* r = *it;
                 it = m_rules.erase(it);
                 delete r;
+                rulesChanged();
                 continue;
             }
         }
@@ -23,7 +23,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 
 #include <netwm_def.h>
+#include <QHash>
 #include <QRect>
+#include <QRegularExpression>
 #include <QVector>
 #include <kconfiggroup.h>
 
@@ -118,6 +120,16 @@ public:
 #ifndef KCMRULES
     bool discardUsed(bool withdrawn);
     bool match(const AbstractClient* c) const;
+    /**
+     * Matches everything but the title, which changes much more often than the other properties.
+     **/
+    bool matchProperties(const AbstractClient* c) const;
+    bool matchCaption(const AbstractClient* c) const;
+    /**
+     * The complete window class this rule is limited to, or a null array if the rule
+     * matches more than a single window class.
+     **/
+    QByteArray exactWMClass() const;
     bool update(AbstractClient*, int selection);
     bool isTemporary() const;
     bool discardTemporary(bool force);   // removes if temporary and forced or too old
@@ -197,6 +209,10 @@ private:
     static ForceRule readForceRule(const KConfigGroup&, const QString& key);
     static NET::WindowType readType(const KConfigGroup&, const QString& key);
     static QString readDecoColor(const KConfigGroup &cfg);
+    mutable QRegularExpression wmclassregexp;
+    mutable QRegularExpression windowroleregexp;
+    mutable QRegularExpression titleregexp;
+    mutable QRegularExpression clientmachineregexp;
 #ifndef KCMRULES
     static bool checkSetRule(SetRule rule, bool init);
     static bool checkForceRule(ForceRule rule);
@@ -316,9 +332,21 @@ private Q_SLOTS:
 private:
     void deleteAll();
     void initWithX11();
+    /**
+     * Has to be called whenever a rule is added to or removed from m_rules.
+     **/
+    void rulesChanged();
+    void updateIndex();
+    QVector<Rules*> matchingRules(const AbstractClient* c, bool ignore_temporary);
     QTimer *m_updateTimer;
     bool m_updatesDisabled;
     QList<Rules*> m_rules;
+    // positions in m_rules of the rules for a single window class and of all others
+    QHash<QByteArray, QVector<int> > m_wmclassIndex;
+    QVector<int> m_unindexedRules;
+    bool m_indexValid = false;
+    // non temporary rules matching all but the title, by the matched properties
+    QHash<QByteArray, QVector<Rules*> > m_matchCache;
     QScopedPointer<KXMessages> m_temporaryRulesMessages;
     KSharedConfig::Ptr m_config;
 
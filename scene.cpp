@@ -72,6 +72,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QVector2D>
 
 #include "client.h"
+#include "composite.h"
 #include "deleted.h"
 #include "effects.h"
 #include "overlaywindow.h"
@@ -95,7 +96,6 @@ namespace KWin
 Scene::Scene(QObject *parent)
     : QObject(parent)
 {
-    last_time.invalidate(); // Initialize the timer
 }
 
 Scene::~Scene()
@@ -165,29 +165,36 @@ void Scene::paintScreen(int* mask, const QRegion &damage, const QRegion &repaint
     Q_ASSERT(!PaintClipper::clip());
 }
 
-// Compute time since the last painting pass.
+// Compute time between the presentation of the last and the current painting pass.
 void Scene::updateTimeDiff()
 {
-    if (!last_time.isValid()) {
+    const std::chrono::nanoseconds presentationTime = Compositor::self()->presentationTime();
+    if (m_lastPresentationTime == std::chrono::nanoseconds::zero()) {
         // Painting has been idle (optimized out) for some time,
         // which means time_diff would be huge and would break animations.
         // Simply set it to one (zero would mean no change at all and could
         // cause problems).
         time_diff = 1;
-        last_time.start();
-    } else
-
-    time_diff = last_time.restart();
-
-    if (time_diff < 0)   // check time rollback
+        m_timeDiffRemainder = std::chrono::nanoseconds::zero();
+        m_lastPresentationTime = presentationTime;
+        return;
+    }
+    if (presentationTime <= m_lastPresentationTime) {
+        // another screen of the same frame, as with a time rollback use one
+        // instead of zero
         time_diff = 1;
+        return;
+    }
+    // carry the sub-millisecond part over so animations don't drift
+    time_diff = PresentationClock::elapsedMilliseconds(m_lastPresentationTime, presentationTime, m_timeDiffRemainder);
+    m_lastPresentationTime = presentationTime;
 }
 
 // Painting pass is optimized away.
 void Scene::idle()
 {
     // Don't break time since last paint for the next pass.
-    last_time.invalidate();
+    m_lastPresentationTime = std::chrono::nanoseconds::zero();
 }
 
 // the function that'll be eventually called by paintScreen() above
@@ -210,6 +217,8 @@ void Scene::paintGenericScreen(int orig_mask, ScreenPaintData)
     phase2.reserve(stacking_order.size());
     foreach (Window * w, stacking_order) { // bottom to top
         Toplevel* topw = w->window();
+        // windows may be painted anywhere, nothing can be considered occluded
+        topw->setOccluded(false);
 
         // Reset the repaint_region.
         // This has to be done here because many effects schedule a repaint for
@@ -306,6 +315,9 @@ void Scene::paintSimpleScreen(int orig_mask, QRegion region)
         }
 #endif
         if (!w->isPaintingEnabled()) {
+            // not painted windows are left out of the occlusion tracking, otherwise they would
+            // stay occluded while effects draw them or once painting gets enabled again
+            topw->setOccluded(false);
             continue;
         }
         dirtyArea |= data.paint;
@@ -327,6 +339,8 @@ void Scene::paintSimpleScreen(int orig_mask, QRegion region)
         fullRepaint = (dirtyArea == displayRegion);
     }
 
+    updateOcclusion(phase2data);
+
     QRegion allclips, upperTranslucentDamage;
     upperTranslucentDamage = repaint_region;
 
@@ -390,6 +404,31 @@ void Scene::paintSimpleScreen(int orig_mask, QRegion region)
     }
 }
 
+void Scene::updateOcclusion(const QVector<Phase2Data> &phase2data)
+{
+    // unlike the occlusion culling pass this looks at the whole screen and not only at
+    // the region which gets repainted
+    QRegion covered;
+    for (int i = phase2data.count() - 1; i >= 0; --i) {
+        const Phase2Data &data = phase2data.at(i);
+        Toplevel *topw = data.window->window();
+        if (data.mask & PAINT_WINDOW_TRANSFORMED) {
+            topw->setOccluded(false);
+            continue;
+        }
+        topw->setOccluded((QRegion(topw->visibleRect()) - covered).isEmpty());
+        covered |= data.clip;
+    }
+}
+
+void Scene::markDrawn(EffectWindowImpl *w)
+{
+    // a window drawn by an effect or as a thumbnail is visible no matter what covers it
+    if (w->sceneWindow() != m_paintedWindow) {
+        w->window()->setOccluded(false);
+    }
+}
+
 void Scene::windowAdded(Toplevel *c)
 {
     assert(!m_windows.contains(c));
@@ -478,7 +517,9 @@ void Scene::paintWindow(Window* w, int mask, QRegion region, WindowQuadList quad
 
     WindowPaintData data(w->window()->effectWindow(), screenProjectionMatrix());
     data.quads = quads;
+    m_paintedWindow = w;
     effects->paintWindow(effectWindow(w), mask, region, data);
+    m_paintedWindow = nullptr;
     // paint thumbnails on top of window
     paintWindowThumbnails(w, region, data.opacity(), data.brightness(), data.saturation());
     // and desktop thumbnails
@@ -615,6 +656,7 @@ void Scene::finalDrawWindow(EffectWindowImpl* w, int mask, QRegion region, Windo
     if (waylandServer() && waylandServer()->isScreenLocked() && !w->window()->isLockScreen() && !w->window()->isInputMethod()) {
         return;
     }
+    markDrawn(w);
     w->sceneWindow()->performPaint(mask, region, data);
 }
 
@@ -680,6 +722,11 @@ QVector<QByteArray> Scene::openGLPlatformInterfaceExtensions() const
     return QVector<QByteArray>{};
 }
 
+QString Scene::supportInformation() const
+{
+    return QString();
+}
+
 //****************************************
 // Scene::Window
 //****************************************
@@ -28,6 +28,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QElapsedTimer>
 #include <QMatrix4x4>
 
+#include <chrono>
+
 class QOpenGLFramebufferObject;
 
 namespace KWayland
@@ -184,6 +186,13 @@ public:
      **/
     virtual QVector<QByteArray> openGLPlatformInterfaceExtensions() const;
 
+    /**
+     * Scene specific information for the debug output of Workspace::supportInformation.
+     *
+     * Default implementation returns an empty string
+     **/
+    virtual QString supportInformation() const;
+
 Q_SIGNALS:
     void frameRendered();
     void resetCompositing();
@@ -234,6 +243,10 @@ protected:
         int mask = 0;
         WindowQuadList quads;
     };
+    // updates which windows are completely covered by the opaque windows above them
+    void updateOcclusion(const QVector<Phase2Data> &phase2data);
+    // to be called from finalDrawWindow(), keeps windows drawn e.g. as thumbnails from being occluded
+    void markDrawn(EffectWindowImpl *w);
     // The region which actually has been painted by paintScreen() and should be
     // copied from the buffer to the screen. I.e. the region returned from Scene::paintScreen().
     // Since prePaintWindow() can extend areas to paint, these changes would have to propagate
@@ -246,13 +259,18 @@ protected:
     QRegion damaged_region;
     // time since last repaint
     int time_diff;
-    QElapsedTimer last_time;
+    // predicted presentation time of the last painting pass, zero when idle
+    std::chrono::nanoseconds m_lastPresentationTime = std::chrono::nanoseconds::zero();
+    // the part of the last interval not yet reported in time_diff
+    std::chrono::nanoseconds m_timeDiffRemainder = std::chrono::nanoseconds::zero();
 private:
     void paintWindowThumbnails(Scene::Window *w, QRegion region, qreal opacity, qreal brightness, qreal saturation);
     void paintDesktopThumbnails(Scene::Window *w);
     QHash< Toplevel*, Window* > m_windows;
     // windows in their stacking order
     QVector< Window* > stacking_order;
+    // the window which paintWindow() is currently painting
+    Window *m_paintedWindow = nullptr;
 };
 
 /**
@@ -51,7 +51,6 @@ Toplevel::Toplevel()
     , effect_window(NULL)
     , m_clientMachine(new ClientMachine(this))
     , wmClientLeaderWin(0)
-    , m_damageReplyPending(false)
     , m_screen(0)
     , m_skipCloseAnimation(false)
 {
@@ -96,15 +95,29 @@ QRect Toplevel::decorationRect() const
     return rect();
 }
 
-void Toplevel::detectShape(Window id)
+Xcb::ShapeExtents Toplevel::fetchShape(Window id) const
+{
+    if (!Xcb::Extensions::self()->isShapeAvailable()) {
+        return Xcb::ShapeExtents();
+    }
+    return Xcb::ShapeExtents(id);
+}
+
+void Toplevel::readShape(Xcb::ShapeExtents &extents)
 {
     const bool wasShape = is_shape;
-    is_shape = Xcb::Extensions::self()->hasShape(id);
+    is_shape = !extents.isNull() && extents->bounding_shaped > 0;
     if (wasShape != is_shape) {
         emit shapedChanged();
     }
 }
 
+void Toplevel::detectShape(Window id)
+{
+    Xcb::ShapeExtents extents = fetchShape(id);
+    readShape(extents);
+}
+
 // used only by Deleted::copy()
 void Toplevel::copyToDeleted(Toplevel* c)
 {
@@ -196,6 +209,11 @@ void Toplevel::getWmClientMachine()
     m_clientMachine->resolve(window(), wmClientLeader());
 }
 
+void Toplevel::readWmClientMachine(const QByteArray &windowMachine)
+{
+    m_clientMachine->resolve(windowMachine, window(), wmClientLeader());
+}
+
 /*!
   Returns client machine for this client,
   taken either from its window or from the leader window.
@@ -333,6 +333,11 @@ public:
     void addWorkspaceRepaint(const QRect& r);
     void addWorkspaceRepaint(int x, int y, int w, int h);
     QRegion repaints() const;
+    /**
+     * The areas of the workspace which have to be repainted because the window changed its
+     * geometry or stacking position, e.g. the areas it uncovered.
+     **/
+    QRegion layerRepaints() const;
     void resetRepaints();
     QRegion damage() const;
     void resetDamage();
@@ -380,20 +385,19 @@ public:
     virtual Layer layer() const = 0;
 
     /**
-     * Resets the damage state and sends a request for the damage region.
-     * A call to this function must be followed by a call to getDamageRegionReply(),
-     * or the reply will be leaked.
+     * Adds the damage reported by damage events since the last call to the damage and
+     * repaints of the window and resets the damage state.
      *
      * Returns true if the window was damaged, and false otherwise.
      */
-    bool resetAndFetchDamage();
+    bool applyPendingDamage();
 
     /**
-     * Gets the reply from a previous call to resetAndFetchDamage().
-     * Calling this function is a no-op if there is no pending reply.
-     * Call damage() to return the fetched region.
-     */
-    void getDamageRegionReply();
+     * Whether the window has been completely covered by opaque windows in the last painted frame.
+     * The damage of an occluded window is not fetched, it stays pending until the window gets exposed.
+     **/
+    bool isOccluded() const;
+    void setOccluded(bool occluded);
 
     bool skipsCloseAnimation() const;
     void setSkipCloseAnimation(bool set);
@@ -548,8 +552,10 @@ protected:
     virtual ~Toplevel();
     void setWindowHandles(xcb_window_t client);
     void detectShape(Window id);
+    Xcb::ShapeExtents fetchShape(Window id) const;
+    void readShape(Xcb::ShapeExtents &extents);
     virtual void propertyNotifyEvent(xcb_property_notify_event_t *e);
-    virtual void damageNotifyEvent();
+    virtual void damageNotifyEvent(const QRect &area);
     virtual void clientMessageEvent(xcb_client_message_event_t *e);
     void discardWindowPixmap();
     void addDamageFull();
@@ -558,6 +564,7 @@ protected:
     void readWmClientLeader(Xcb::Property &p);
     void getWmClientLeader();
     void getWmClientMachine();
+    void readWmClientMachine(const QByteArray &windowMachine);
     /**
      * @returns Whether there is a compositor and it is active.
      **/
@@ -596,6 +603,7 @@ private:
     QUuid m_internalId;
     Xcb::Window m_client;
     xcb_damage_damage_t damage_handle;
+    QRegion m_pendingDamage; // damage reported by damage events, not yet applied
     QRegion damage_region; // damage is really damaged window (XDamage) and texture needs
     bool is_shape;
     EffectWindowImpl* effect_window;
@@ -603,12 +611,11 @@ private:
     QByteArray resource_class;
     ClientMachine *m_clientMachine;
     WId wmClientLeaderWin;
-    bool m_damageReplyPending;
     QRegion opaque_region;
-    xcb_xfixes_fetch_region_cookie_t m_regionCookie;
     int m_screen;
     bool m_skipCloseAnimation;
     quint32 m_surfaceId = 0;
+    bool m_occluded = false;
     KWayland::Server::SurfaceInterface *m_surface = nullptr;
     /**
      * An FBO object KWin internal windows might render to.
@@ -774,6 +781,16 @@ inline QRegion Toplevel::repaints() const
     return repaints_region.translated(pos()) | layer_repaints_region;
 }
 
+inline QRegion Toplevel::layerRepaints() const
+{
+    return layer_repaints_region;
+}
+
+inline bool Toplevel::isOccluded() const
+{
+    return m_occluded;
+}
+
 inline bool Toplevel::shape() const
 {
     return is_shape;
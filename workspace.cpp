@@ -472,10 +472,12 @@ void Workspace::initWithX11()
             } else if (attr->map_state != XCB_MAP_STATE_UNMAPPED) {
                 if (Application::wasCrash()) {
                     fixPositionAfterCrash(wins[i], windowGeometries.at(i).data());
+                    // the geometry got changed, it has to be requested again
+                    createClient(wins[i], true);
+                } else {
+                    Xcb::WindowGeometry geometry(windowGeometries.at(i));
+                    createClient(wins[i], true, attr, geometry);
                 }
-
-                // ### This will request the attributes again
-                createClient(wins[i], true);
             }
         }
 
@@ -582,13 +584,20 @@ void Workspace::setupClientConnections(AbstractClient *c)
 }
 
 Client* Workspace::createClient(xcb_window_t w, bool is_mapped)
+{
+    Xcb::WindowAttributes attributes(w);
+    Xcb::WindowGeometry geometry(w);
+    return createClient(w, is_mapped, attributes, geometry);
+}
+
+Client* Workspace::createClient(xcb_window_t w, bool is_mapped, Xcb::WindowAttributes &attributes, Xcb::WindowGeometry &geometry)
 {
     StackingUpdatesBlocker blocker(this);
     Client* c = new Client();
     setupClientConnections(c);
     connect(c, SIGNAL(blockingCompositingChanged(KWin::Client*)), m_compositor, SLOT(updateCompositeBlocking(KWin::Client*)));
     connect(c, SIGNAL(clientFullScreenSet(KWin::Client*,bool,bool)), ScreenEdges::self(), SIGNAL(checkBlocking()));
-    if (!c->manage(w, is_mapped)) {
+    if (!c->manage(w, is_mapped, attributes, geometry)) {
         Client::deleteClient(c);
         return NULL;
     }
@@ -687,6 +696,7 @@ void Workspace::removeClient(Client* c)
 
     Q_ASSERT(clients.contains(c) || desktops.contains(c));
     // TODO: if marked client is removed, notify the marked list
+    removeEventTarget(c);
     clients.removeAll(c);
     m_allClients.removeAll(c);
     desktops.removeAll(c);
@@ -720,6 +730,7 @@ void Workspace::removeClient(Client* c)
 void Workspace::removeUnmanaged(Unmanaged* c)
 {
     assert(unmanaged.contains(c));
+    removeEventTarget(c);
     unmanaged.removeAll(c);
     emit unmanagedRemoved(c);
     markXStackingOrderAsDirty();
@@ -1581,6 +1592,12 @@ QString Workspace::supportInformation() const
             } else {
                 support.append(QStringLiteral(" no\n"));
             }
+            support.append(QStringLiteral("Compute shaders: "));
+            if (platform->supports(ComputeShaders)) {
+                support.append(QStringLiteral(" yes\n"));
+            } else {
+                support.append(QStringLiteral(" no\n"));
+            }
             support.append(QStringLiteral("Virtual Machine: "));
             if (platform->isVirtualMachine()) {
                 support.append(QStringLiteral(" yes\n"));
@@ -1594,6 +1611,7 @@ QString Workspace::supportInformation() const
                 support.append(QStringLiteral(" yes\n"));
             else
                 support.append(QStringLiteral(" no\n"));
+            support.append(m_compositor->scene()->supportInformation());
             break;
         }
         case XRenderCompositing:
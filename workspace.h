@@ -28,6 +28,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "options.h"
 #include "utils.h"
 // Qt
+#include <QHash>
 #include <QTimer>
 #include <QVector>
 // std
@@ -50,6 +51,8 @@ namespace Xcb
 {
 class Tree;
 class Window;
+class WindowAttributes;
+class WindowGeometry;
 }
 
 class AbstractClient;
@@ -518,6 +521,7 @@ private:
 
     /// This is the right way to create a new client
     Client* createClient(xcb_window_t w, bool is_mapped);
+    Client* createClient(xcb_window_t w, bool is_mapped, Xcb::WindowAttributes &attributes, Xcb::WindowGeometry &geometry);
     void setupClientConnections(AbstractClient *client);
     void addClient(Client* c);
     Unmanaged* createUnmanaged(xcb_window_t w);
@@ -623,8 +627,17 @@ private:
 
     QScopedPointer<KillWindow> m_windowKiller;
 
-    QList<X11EventFilter *> m_eventFilters;
-    QList<X11EventFilter *> m_genericEventFilters;
+    /**
+     * Finds the Client or Unmanaged an event for @p w is routed to.
+     **/
+    Toplevel *findEventTarget(xcb_window_t w);
+    void removeEventTarget(Toplevel *target);
+
+    // event filters by event type, generic event filters by extension and event type
+    QVector<QList<X11EventFilter *>> m_eventFilters;
+    QHash<quint32, QList<X11EventFilter *>> m_genericEventFilters;
+    // event targets by any of their windows, filled on lookup
+    QHash<xcb_window_t, Toplevel *> m_eventTargets;
     QScopedPointer<X11EventFilter> m_movingClientFilter;
 
 private:
@@ -0,0 +1,75 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2019 KWin-lowlatency developers
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "x11framesync.h"
+
+namespace KWin
+{
+
+void X11FrameSync::counterChanged(quint64 value)
+{
+    // an odd value starts a frame, the frame completed before stays pending
+    if (value % 2 != 0) {
+        return;
+    }
+    m_completedFrame = value;
+    m_framePending = true;
+}
+
+bool X11FrameSync::isFramePending() const
+{
+    return m_framePending;
+}
+
+quint64 X11FrameSync::completedFrame() const
+{
+    return m_completedFrame;
+}
+
+bool X11FrameSync::framePainted(bool occluded, std::chrono::milliseconds now)
+{
+    if (!m_framePending) {
+        return false;
+    }
+    if (occluded && now < nextOccludedFrame()) {
+        return false;
+    }
+    m_framePending = false;
+    m_lastAcknowledged = now;
+    return true;
+}
+
+std::chrono::milliseconds X11FrameSync::nextOccludedFrame() const
+{
+    return m_lastAcknowledged + occludedInterval();
+}
+
+void X11FrameSync::reset()
+{
+    m_completedFrame = 0;
+    m_framePending = false;
+    m_lastAcknowledged = std::chrono::milliseconds::zero();
+}
+
+std::chrono::milliseconds X11FrameSync::occludedInterval()
+{
+    return std::chrono::milliseconds(1000);
+}
+
+}
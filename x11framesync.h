@@ -0,0 +1,80 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2019 KWin-lowlatency developers
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#ifndef KWIN_X11FRAMESYNC_H
+#define KWIN_X11FRAMESYNC_H
+
+#include <kwin_export.h>
+
+#include <QtGlobal>
+
+#include <chrono>
+
+namespace KWin
+{
+
+/**
+ * @brief The frames of a client implementing the extended _NET_WM_SYNC_REQUEST protocol.
+ *
+ * The client sets its extended counter to an odd value when it starts drawing a frame and
+ * to an even value when the frame is complete. The compositor acknowledges a completed
+ * frame with _NET_WM_FRAME_DRAWN once it painted it, and the client waits for that
+ * before it draws the next frame.
+ *
+ * The frames of an occluded window are acknowledged at most once per occludedInterval(),
+ * which throttles clients nobody can see. As soon as the window gets exposed its frame is
+ * acknowledged with the next painted frame again.
+ **/
+class KWIN_EXPORT X11FrameSync
+{
+public:
+    /**
+     * The client changed its extended counter to @p value.
+     **/
+    void counterChanged(quint64 value);
+    /**
+     * @returns whether a completed frame waits to be acknowledged.
+     **/
+    bool isFramePending() const;
+    /**
+     * @returns the counter value of the last completed frame.
+     **/
+    quint64 completedFrame() const;
+    /**
+     * The compositor painted a frame at @p now. @returns whether the completed frame is to be
+     * acknowledged now, it is considered acknowledged afterwards.
+     **/
+    bool framePainted(bool occluded, std::chrono::milliseconds now);
+    /**
+     * @returns when an occluded window gets its frame acknowledged at the earliest.
+     **/
+    std::chrono::milliseconds nextOccludedFrame() const;
+    void reset();
+
+    static std::chrono::milliseconds occludedInterval();
+
+private:
+    quint64 m_completedFrame = 0;
+    bool m_framePending = false;
+    std::chrono::milliseconds m_lastAcknowledged = std::chrono::milliseconds::zero();
+};
+
+}
+
+#endif
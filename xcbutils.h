@@ -31,6 +31,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <xcb/xcb.h>
 #include <xcb/composite.h>
 #include <xcb/randr.h>
+#include <xcb/shape.h>
 
 #include <xcb/shm.h>
 
@@ -550,7 +551,14 @@ private:
     XCB_WRAPPER_DATA( __NAME__##Data, __REQUEST__, __VA_ARGS__ ) \
     typedef Wrapper< __NAME__##Data, __VA_ARGS__ > __NAME__;
 
-XCB_WRAPPER(WindowAttributes, xcb_get_window_attributes, xcb_window_t)
+XCB_WRAPPER_DATA(WindowAttributesData, xcb_get_window_attributes, xcb_window_t)
+class WindowAttributes : public Wrapper<WindowAttributesData, xcb_window_t>
+{
+public:
+    WindowAttributes() : Wrapper<WindowAttributesData, xcb_window_t>() {}
+    explicit WindowAttributes(xcb_window_t window) : Wrapper<WindowAttributesData, xcb_window_t>(window) {}
+};
+
 XCB_WRAPPER(OverlayWindow, xcb_composite_get_overlay_window, xcb_window_t)
 
 XCB_WRAPPER_DATA(GeometryData, xcb_get_geometry, xcb_drawable_t)
@@ -589,6 +597,7 @@ public:
 };
 
 XCB_WRAPPER(Pointer, xcb_query_pointer, xcb_window_t)
+XCB_WRAPPER(ShapeExtents, xcb_shape_query_extents, xcb_window_t)
 
 struct CurrentInputData : public WrapperData< xcb_get_input_focus_reply_t, xcb_get_input_focus_cookie_t >
 {